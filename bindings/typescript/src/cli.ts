@@ -27,6 +27,14 @@ export function buildCeracoderArgs(options: CeracoderCliOptions): Array<string>
 		args.push("-r");
 	}
 
+	if (opts.lowLatency) {
+		args.push("-L");
+	}
+
+	if (opts.overlay) {
+		args.push("-O", opts.overlay);
+	}
+
 	if (opts.algorithm) {
 		args.push("-a", opts.algorithm);
 	}
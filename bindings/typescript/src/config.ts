@@ -26,6 +26,17 @@ function applyDefaults(input?: PartialCeracoderConfig): CeracoderConfig {
 			max_bitrate:
 				input?.general?.max_bitrate ?? parsed.general.max_bitrate ?? DEFAULT_MAX_BITRATE,
 			balancer: input?.general?.balancer ?? parsed.general.balancer ?? DEFAULT_BALANCER,
+			// Left to the ceracoder defaults (DEFAULT_SLOW_START / DEFAULT_START_BITRATE) if unset
+			slow_start: parsed.general.slow_start,
+			start_bitrate: parsed.general.start_bitrate,
+			low_latency: parsed.general.low_latency,
+			overlay: parsed.general.overlay,
+			control_fifo: parsed.general.control_fifo,
+			slate: parsed.general.slate,
+			slate_timeout: parsed.general.slate_timeout,
+			zero_copy: parsed.general.zero_copy,
+			scene_detect: parsed.general.scene_detect,
+			content_cap: parsed.general.content_cap,
 		},
 		srt: {
 			latency: input?.srt?.latency ?? parsed.srt.latency ?? DEFAULT_SRT_LATENCY,
@@ -67,6 +78,16 @@ export function serializeCeracoderConfig(config: CeracoderConfig): string {
 		min_bitrate: config.general.min_bitrate,
 		max_bitrate: config.general.max_bitrate,
 		balancer: config.general.balancer,
+		slow_start: config.general.slow_start,
+		start_bitrate: config.general.start_bitrate,
+		low_latency: config.general.low_latency,
+		overlay: config.general.overlay,
+		control_fifo: config.general.control_fifo,
+		slate: config.general.slate,
+		slate_timeout: config.general.slate_timeout,
+		zero_copy: config.general.zero_copy,
+		scene_detect: config.general.scene_detect,
+		content_cap: config.general.content_cap,
 	});
 
 	const srt = formatSection("srt", {
@@ -79,6 +100,8 @@ export function serializeCeracoderConfig(config: CeracoderConfig): string {
 		incr_interval: config.adaptive?.incr_interval,
 		decr_interval: config.adaptive?.decr_interval,
 		loss_threshold: config.adaptive?.loss_threshold,
+		loss_classify: config.adaptive?.loss_classify,
+		rtt_change_detect: config.adaptive?.rtt_change_detect,
 	});
 
 	const aimd = formatSection("aimd", {
@@ -128,6 +151,16 @@ export function parseCeracoderConfig(ini: string): CeracoderConfig {
 			min_bitrate: generalRaw.min_bitrate ? Number(generalRaw.min_bitrate) : undefined,
 			max_bitrate: generalRaw.max_bitrate ? Number(generalRaw.max_bitrate) : undefined,
 			balancer: generalRaw.balancer as z.infer<typeof ceracoderConfigSchema>["general"]["balancer"],
+			slow_start: generalRaw.slow_start ? Number(generalRaw.slow_start) : undefined,
+			start_bitrate: generalRaw.start_bitrate ? Number(generalRaw.start_bitrate) : undefined,
+			low_latency: generalRaw.low_latency ? Number(generalRaw.low_latency) : undefined,
+			overlay: generalRaw.overlay as z.infer<typeof ceracoderConfigSchema>["general"]["overlay"],
+			control_fifo: generalRaw.control_fifo || undefined,
+			slate: generalRaw.slate || undefined,
+			slate_timeout: generalRaw.slate_timeout ? Number(generalRaw.slate_timeout) : undefined,
+			zero_copy: generalRaw.zero_copy as z.infer<typeof ceracoderConfigSchema>["general"]["zero_copy"],
+			scene_detect: generalRaw.scene_detect ? Number(generalRaw.scene_detect) : undefined,
+			content_cap: generalRaw.content_cap ? Number(generalRaw.content_cap) : undefined,
 		},
 		srt: {
 			latency: srtRaw.latency ? Number(srtRaw.latency) : undefined,
@@ -141,6 +174,12 @@ export function parseCeracoderConfig(ini: string): CeracoderConfig {
 					loss_threshold: adaptiveRaw.loss_threshold
 						? Number(adaptiveRaw.loss_threshold)
 						: undefined,
+					loss_classify: adaptiveRaw.loss_classify
+						? Number(adaptiveRaw.loss_classify)
+						: undefined,
+					rtt_change_detect: adaptiveRaw.rtt_change_detect
+						? Number(adaptiveRaw.rtt_change_detect)
+						: undefined,
 				}
 			: undefined,
 		aimd: Object.keys(aimdRaw).length
@@ -2,6 +2,8 @@ export const DEFAULT_MIN_BITRATE = 300; // Kbps
 export const DEFAULT_MAX_BITRATE = 6000; // Kbps
 export const DEFAULT_SRT_LATENCY = 2000; // ms
 export const DEFAULT_BALANCER = "adaptive" as const;
+export const DEFAULT_SLOW_START = 1;
+export const DEFAULT_START_BITRATE = 1000; // Kbps
 
 export const DEFAULT_ADAPTIVE = {
 	incr_step: 30,
@@ -9,6 +11,8 @@ export const DEFAULT_ADAPTIVE = {
 	incr_interval: 500,
 	decr_interval: 200,
 	loss_threshold: 0.5,
+	loss_classify: 1,
+	rtt_change_detect: 1,
 } as const;
 
 export const DEFAULT_AIMD = {
@@ -0,0 +1,95 @@
+import { describe, it, expect } from "bun:test";
+import fs from "node:fs";
+import path from "node:path";
+
+import {
+	BalancerCore,
+	CORE_ABI_MAJOR,
+	getCoreVersion,
+	listCoreAlgorithms,
+} from "./core.js";
+
+// Built by `make lib` in the repository root
+const libPath =
+	process.env.CERACODER_CORE_LIB ??
+	path.resolve(import.meta.dir, `../../../libceracoder-core.so.${CORE_ABI_MAJOR}`);
+
+describe.skipIf(!fs.existsSync(libPath))("BalancerCore (libceracoder-core)", () => {
+	it("reports the version and algorithms", () => {
+		expect(getCoreVersion(libPath)).toStartWith(`${CORE_ABI_MAJOR}.`);
+		expect(listCoreAlgorithms(libPath)).toEqual(["adaptive", "fixed", "aimd"]);
+	});
+
+	it("reduces the bitrate on congestion and exposes the output", () => {
+		const balancer = new BalancerCore({
+			algorithm: "adaptive",
+			minBitrate: 500_000,
+			maxBitrate: 6_000_000,
+			libraryPath: libPath,
+		});
+		expect(balancer.name).toBe("adaptive");
+
+		let bitrate = 0;
+		for (let i = 0; i < 50; i++) {
+			bitrate = balancer.step({
+				bufferSize: 400,
+				rtt: 700,
+				sendRateMbps: 2,
+				timestamp: 1000 + i * 20,
+			});
+		}
+		expect(bitrate).toBeLessThan(6_000_000);
+		const output = balancer.getOutput();
+		expect(output.newBitrate).toBe(bitrate);
+		expect(output.state).toBe("emergency");
+		expect(output.lossCongestive).toBe(0);
+		expect(output.rttChange).toBeDefined();
+		balancer.close();
+	});
+
+	it("keeps the bitrate under the static scene ceiling hint", () => {
+		const balancer = new BalancerCore({
+			algorithm: "adaptive",
+			minBitrate: 500_000,
+			maxBitrate: 6_000_000,
+			libraryPath: libPath,
+		});
+		balancer.setOption("general", "slow_start", 0);
+		balancer.setHints({ motion: 0, ceiling: 2_000_000 });
+		for (let i = 0; i < 10; i++) {
+			expect(
+				balancer.step({ bufferSize: 10, rtt: 40, sendRateMbps: 2, timestamp: 1000 + i * 20 }),
+			).toBeLessThanOrEqual(2_000_000);
+		}
+		balancer.close();
+	});
+
+	it("applies options and bounds", () => {
+		const balancer = new BalancerCore({
+			algorithm: "fixed",
+			minBitrate: 500_000,
+			maxBitrate: 6_000_000,
+			libraryPath: libPath,
+		});
+		balancer.updateBounds(500_000, 3_000_000);
+		expect(balancer.step({ bufferSize: 10, rtt: 40, sendRateMbps: 4, timestamp: 1000 })).toBe(
+			3_000_000,
+		);
+		expect(() => balancer.setOption("aimd", "nope", 1)).toThrow();
+		balancer.setOption("aimd", "decr_mult", 0.5);
+		balancer.close();
+		expect(() => balancer.step({ bufferSize: 0, rtt: 0, sendRateMbps: 0, timestamp: 0 })).toThrow();
+	});
+
+	it("rejects unknown algorithms", () => {
+		expect(
+			() =>
+				new BalancerCore({
+					algorithm: "nope" as never,
+					minBitrate: 500_000,
+					maxBitrate: 6_000_000,
+					libraryPath: libPath,
+				}),
+		).toThrow();
+	});
+});
@@ -0,0 +1,331 @@
+/**
+ * Bun FFI binding for libceracoder-core
+ *
+ * Runs the ceracoder balancer algorithms in-process, using the same C
+ * implementation as the ceracoder binary (see src/core/ceracoder_core.h).
+ * Requires Bun; import from "@ceralive/ceracoder/core".
+ */
+
+import { CString, dlopen, FFIType, type Library, type Pointer } from "bun:ffi";
+
+import type { BalancerAlgorithm } from "./types.js";
+
+/** Major ABI version this binding was written against */
+export const CORE_ABI_MAJOR = 1;
+
+/** Default library name (soname), resolved by the dynamic loader */
+export const DEFAULT_CORE_LIBRARY = `libceracoder-core.so.${CORE_ABI_MAJOR}`;
+
+// sizeof(CeracoderBalancerOutput) in ABI 1.3: double + 13 x int32, padded to
+// 64 bytes (40 bytes in 1.0, 48 in 1.1)
+const OUTPUT_SIZE = 64;
+const OUTPUT_SIZE_1_1 = 48;
+const OUTPUT_SIZE_1_3 = 60;
+
+/** Decision reasons, indexed by BalancerReason (src/balancer.h) */
+export const BALANCER_REASONS = [
+	"hold",
+	"fixed",
+	"increase",
+	"light_rtt",
+	"light_buffer",
+	"heavy_rtt",
+	"heavy_buffer",
+	"heavy_loss",
+	"emergency_rtt",
+	"emergency_buffer",
+	"slow_start",
+	"content_cap",
+] as const;
+export type BalancerReason = (typeof BALANCER_REASONS)[number];
+
+/** Congestion states, indexed by BalancerState (src/balancer.h) */
+export const BALANCER_STATES = ["stable", "light", "heavy", "emergency"] as const;
+export type BalancerState = (typeof BALANCER_STATES)[number];
+
+const baseSymbols = {
+	ceracoder_core_version: { args: [], returns: FFIType.u32 },
+	ceracoder_balancer_algorithm_count: { args: [], returns: FFIType.i32 },
+	ceracoder_balancer_algorithm_name: {
+		args: [FFIType.i32],
+		returns: FFIType.ptr,
+	},
+	ceracoder_balancer_new: {
+		args: [FFIType.ptr, FFIType.i32, FFIType.i32, FFIType.i32, FFIType.i32],
+		returns: FFIType.ptr,
+	},
+	ceracoder_balancer_set_option: {
+		args: [FFIType.ptr, FFIType.ptr, FFIType.ptr, FFIType.ptr],
+		returns: FFIType.i32,
+	},
+	ceracoder_balancer_step: {
+		args: [
+			FFIType.ptr,
+			FFIType.i32,
+			FFIType.f64,
+			FFIType.f64,
+			FFIType.u64,
+			FFIType.i64,
+			FFIType.i64,
+		],
+		returns: FFIType.i32,
+	},
+	ceracoder_balancer_get_output: {
+		args: [FFIType.ptr, FFIType.ptr, FFIType.u32],
+		returns: FFIType.i32,
+	},
+	ceracoder_balancer_get_bitrate: { args: [FFIType.ptr], returns: FFIType.i32 },
+	ceracoder_balancer_update_bounds: {
+		args: [FFIType.ptr, FFIType.i32, FFIType.i32],
+		returns: FFIType.void,
+	},
+	ceracoder_balancer_name: { args: [FFIType.ptr], returns: FFIType.ptr },
+	ceracoder_balancer_free: { args: [FFIType.ptr], returns: FFIType.void },
+} as const;
+
+// Added in ABI 1.3, only bound when the library has them
+const hintSymbols = {
+	ceracoder_balancer_set_hints: {
+		args: [FFIType.ptr, FFIType.i32, FFIType.i32, FFIType.i32],
+		returns: FFIType.void,
+	},
+} as const;
+
+const symbols = { ...baseSymbols, ...hintSymbols } as const;
+
+type CoreLibrary = Library<typeof symbols>;
+
+let loaded: { path: string; lib: CoreLibrary } | undefined;
+
+function cstr(value: string): Buffer {
+	return Buffer.from(`${value}\0`, "utf-8");
+}
+
+/**
+ * Load libceracoder-core.
+ *
+ * Resolution order: explicit path, CERACODER_CORE_LIB, then the soname.
+ * Throws if the library is missing or has an incompatible major version.
+ */
+export function loadCeracoderCore(libraryPath?: string): CoreLibrary {
+	const libPath =
+		libraryPath ?? process.env.CERACODER_CORE_LIB ?? DEFAULT_CORE_LIBRARY;
+	if (loaded && loaded.path === libPath) {
+		return loaded.lib;
+	}
+
+	const base = dlopen(libPath, baseSymbols);
+	const version = base.symbols.ceracoder_core_version();
+	const major = version >>> 16;
+	if (major !== CORE_ABI_MAJOR) {
+		base.close();
+		throw new Error(
+			`${libPath}: ABI version ${major}, expected ${CORE_ABI_MAJOR}`,
+		);
+	}
+	let lib = base as unknown as CoreLibrary;
+	if ((version & 0xffff) >= 3) {
+		base.close();
+		lib = dlopen(libPath, symbols);
+	}
+
+	loaded = { path: libPath, lib };
+	return lib;
+}
+
+/** Library version as "major.minor" */
+export function getCoreVersion(libraryPath?: string): string {
+	const v = loadCeracoderCore(libraryPath).symbols.ceracoder_core_version();
+	return `${v >>> 16}.${v & 0xffff}`;
+}
+
+/** Names of the algorithms built into the library */
+export function listCoreAlgorithms(libraryPath?: string): string[] {
+	const { symbols: fn } = loadCeracoderCore(libraryPath);
+	const names: string[] = [];
+	const count = fn.ceracoder_balancer_algorithm_count();
+	for (let i = 0; i < count; i++) {
+		const p = fn.ceracoder_balancer_algorithm_name(i);
+		if (p) names.push(new CString(p).toString());
+	}
+	return names;
+}
+
+export interface BalancerCoreOptions {
+	algorithm?: BalancerAlgorithm;
+	minBitrate: number; // bps
+	maxBitrate: number; // bps
+	srtLatency?: number; // ms
+	srtPacketSize?: number; // bytes
+	libraryPath?: string;
+}
+
+export interface BalancerCoreInput {
+	bufferSize: number; // packets (SRTO_SNDDATA)
+	rtt: number; // ms
+	sendRateMbps: number;
+	timestamp: number; // ms, monotonic
+	pktLossTotal?: number;
+	pktRetransTotal?: number;
+}
+
+/** Video hints, as ceracoder takes them from its scene detector (ABI 1.3) */
+export interface BalancerCoreHints {
+	/** Scene cut since the last step, applies to the next step only */
+	sceneCut?: boolean;
+	/** Motion score, 0-100 */
+	motion?: number;
+	/** Static scene ceiling (bps) below maxBitrate, 0 = none */
+	ceiling?: number;
+}
+
+export interface BalancerCoreOutput {
+	newBitrate: number; // bps
+	throughput: number;
+	rtt: number;
+	rttThMin: number;
+	rttThMax: number;
+	bs: number;
+	bsTh1: number;
+	bsTh2: number;
+	bsTh3: number;
+	/** Decision taken in the last step (undefined with a 1.0 library) */
+	reason?: BalancerReason;
+	/** Congestion state in the last step (undefined with a 1.0 library) */
+	state?: BalancerState;
+	/** Packets lost in the last step, congestive / random (undefined before 1.3) */
+	lossCongestive?: number;
+	lossRandom?: number;
+	/** +1 / -1: RTT baseline re-set after a path change (undefined before 1.3) */
+	rttChange?: number;
+}
+
+/**
+ * In-process balancer backed by libceracoder-core.
+ *
+ * Call close() when done; the native context is not garbage collected.
+ */
+export class BalancerCore {
+	private handle: Pointer | null;
+	private readonly lib: CoreLibrary;
+	private readonly outBuf = new ArrayBuffer(OUTPUT_SIZE);
+	private readonly outView = new DataView(this.outBuf);
+
+	constructor(options: BalancerCoreOptions) {
+		this.lib = loadCeracoderCore(options.libraryPath);
+		this.handle = this.lib.symbols.ceracoder_balancer_new(
+			options.algorithm ? cstr(options.algorithm) : null,
+			options.minBitrate,
+			options.maxBitrate,
+			options.srtLatency ?? 2000,
+			options.srtPacketSize ?? 1316,
+		);
+		if (!this.handle) {
+			throw new Error(
+				`Failed to create balancer (algorithm=${options.algorithm ?? "default"}, ` +
+					`bounds=${options.minBitrate}-${options.maxBitrate})`,
+			);
+		}
+	}
+
+	private get ptr(): Pointer {
+		if (!this.handle) throw new Error("BalancerCore is closed");
+		return this.handle;
+	}
+
+	/** Algorithm in use */
+	get name(): string {
+		const p = this.lib.symbols.ceracoder_balancer_name(this.ptr);
+		return p ? new CString(p).toString() : "";
+	}
+
+	/** Set a tuning option using config file sections/keys, e.g. ("aimd", "decr_mult", 0.5) */
+	setOption(section: string, key: string, value: string | number): void {
+		const ret = this.lib.symbols.ceracoder_balancer_set_option(
+			this.ptr,
+			cstr(section),
+			cstr(key),
+			cstr(String(value)),
+		);
+		if (ret !== 0) {
+			throw new Error(`Unknown balancer option [${section}] ${key}`);
+		}
+	}
+
+	/** Run one update step, returns the new bitrate (bps) */
+	step(input: BalancerCoreInput): number {
+		return this.lib.symbols.ceracoder_balancer_step(
+			this.ptr,
+			input.bufferSize,
+			input.rtt,
+			input.sendRateMbps,
+			BigInt(Math.trunc(input.timestamp)),
+			BigInt(Math.trunc(input.pktLossTotal ?? 0)),
+			BigInt(Math.trunc(input.pktRetransTotal ?? 0)),
+		);
+	}
+
+	/** Video hints for the following steps; needs a 1.3 library */
+	setHints(hints: BalancerCoreHints): void {
+		const setHints = this.lib.symbols.ceracoder_balancer_set_hints;
+		if (!setHints) {
+			throw new Error("Video hints need libceracoder-core 1.3 or later");
+		}
+		setHints(
+			this.ptr,
+			hints.sceneCut ? 1 : 0,
+			Math.trunc(hints.motion ?? 0),
+			Math.trunc(hints.ceiling ?? 0),
+		);
+	}
+
+	/** Output of the last step */
+	getOutput(): BalancerCoreOutput {
+		const copied = this.lib.symbols.ceracoder_balancer_get_output(
+			this.ptr,
+			new Uint8Array(this.outBuf),
+			OUTPUT_SIZE,
+		);
+		const v = this.outView;
+		const hasReason = copied >= OUTPUT_SIZE_1_1;
+		const hasLoss = copied >= OUTPUT_SIZE_1_3;
+		return {
+			throughput: v.getFloat64(0, true),
+			newBitrate: v.getInt32(8, true),
+			rtt: v.getInt32(12, true),
+			rttThMin: v.getInt32(16, true),
+			rttThMax: v.getInt32(20, true),
+			bs: v.getInt32(24, true),
+			bsTh1: v.getInt32(28, true),
+			bsTh2: v.getInt32(32, true),
+			bsTh3: v.getInt32(36, true),
+			reason: hasReason ? BALANCER_REASONS[v.getInt32(40, true)] : undefined,
+			state: hasReason ? BALANCER_STATES[v.getInt32(44, true)] : undefined,
+			lossCongestive: hasLoss ? v.getInt32(48, true) : undefined,
+			lossRandom: hasLoss ? v.getInt32(52, true) : undefined,
+			rttChange: hasLoss ? v.getInt32(56, true) : undefined,
+		};
+	}
+
+	/** Current bitrate (bps), before the first step the one to open the encoder with */
+	get bitrate(): number {
+		return this.lib.symbols.ceracoder_balancer_get_bitrate(this.ptr);
+	}
+
+	/** Change the bitrate bounds (bps), resets the algorithm state */
+	updateBounds(minBitrate: number, maxBitrate: number): void {
+		this.lib.symbols.ceracoder_balancer_update_bounds(
+			this.ptr,
+			minBitrate,
+			maxBitrate,
+		);
+	}
+
+	/** Free the native context */
+	close(): void {
+		if (this.handle) {
+			this.lib.symbols.ceracoder_balancer_free(this.handle);
+			this.handle = null;
+		}
+	}
+}
@@ -69,7 +69,8 @@ export function buildAudioPipeline(
 
 	let encoderPipeline: string;
 	if (codec === "opus") {
-		encoderPipeline = `audioresample quality=10 sinc-filter-mode=1 ! opusenc bitrate=${bitrate} ! opusparse !`;
+		// Named aenc: ceracoder adjusts the Opus bitrate with the balancer target
+		encoderPipeline = `audioconvert ! audioresample quality=10 sinc-filter-mode=1 ! opusenc name=aenc bitrate=${bitrate} ! opusparse !`;
 	} else {
 		// AAC - use avenc_aac for generic, voaacenc for hardware platforms
 		if (hardware === "generic") {
@@ -84,7 +85,7 @@ export function buildAudioPipeline(
 
 export function buildTestAudioPipeline(codec: AudioCodec = "aac", bitrate = 128000): string {
 	if (codec === "opus") {
-		return `audiotestsrc ! audio/x-raw,channels=2,rate=48000 ! audioresample quality=10 sinc-filter-mode=1 ! opusenc bitrate=${bitrate} ! opusparse ! queue max-size-time=10000000000 max-size-buffers=1000 ! mux. `;
+		return `audiotestsrc ! audio/x-raw,channels=2,rate=48000 ! audioresample quality=10 sinc-filter-mode=1 ! opusenc name=aenc bitrate=${bitrate} ! opusparse ! queue max-size-time=10000000000 max-size-buffers=1000 ! mux. `;
 	}
 	return `audiotestsrc ! audio/x-raw,channels=2,rate=48000 ! voaacenc bitrate=${bitrate} ! aacparse ! queue max-size-time=10000000000 max-size-buffers=1000 ! mux. `;
 }
@@ -196,7 +196,7 @@ describe("PipelineBuilder", () => {
 					source: "camlink",
 					overrides: { audioCodec: "opus" },
 				});
-				expect(result.pipeline).toContain("opusenc");
+				expect(result.pipeline).toContain("opusenc name=aenc");
 			});
 
 			it("applies audio device override", () => {
@@ -0,0 +1,70 @@
+import { describe, it, expect } from "bun:test";
+
+import {
+	parseNotifyMessage,
+	spawnCeracoderMonitored,
+	type CeracoderMonitor,
+} from "./process.js";
+
+function waitExit(monitor: CeracoderMonitor) {
+	return new Promise<void>((resolve) => monitor.process.on("close", () => resolve()));
+}
+
+describe("parseNotifyMessage", () => {
+	it("parses the known assignments", () => {
+		expect(parseNotifyMessage("READY=1")).toEqual({ type: "ready" });
+		expect(parseNotifyMessage("WATCHDOG=1")).toEqual({ type: "watchdog" });
+		expect(parseNotifyMessage("STOPPING=1")).toEqual({ type: "stopping" });
+		expect(parseNotifyMessage("STATUS=Streaming at 6000 Kbps")).toEqual({
+			type: "status",
+			status: "Streaming at 6000 Kbps",
+		});
+	});
+
+	it("ignores unknown or malformed lines", () => {
+		expect(parseNotifyMessage("")).toBeUndefined();
+		expect(parseNotifyMessage("READY")).toBeUndefined();
+		expect(parseNotifyMessage("READY=0")).toBeUndefined();
+		expect(parseNotifyMessage("MAINPID=1234")).toBeUndefined();
+	});
+});
+
+describe("spawnCeracoderMonitored", () => {
+	it("emits events from the notify fd", async () => {
+		const monitor = spawnCeracoderMonitored({
+			execPath: "/bin/sh",
+			args: [
+				"-c",
+				'[ "$CERACODER_NOTIFY_FD" = 3 ] && printf "STATUS=Connecting\\nREADY=1\\nWATCHDOG=1\\nSTOPPING=1\\n" >&3',
+			],
+			spawnOptions: { stdio: "ignore" },
+			watchdogTimeout: 0,
+		});
+
+		const events: string[] = [];
+		monitor.on("status", (status) => events.push(`status:${status}`));
+		monitor.on("ready", () => events.push("ready"));
+		monitor.on("watchdog", () => events.push("watchdog"));
+		monitor.on("stopping", () => events.push("stopping"));
+
+		await waitExit(monitor);
+		expect(events).toEqual(["status:Connecting", "ready", "watchdog", "stopping"]);
+		expect(monitor.ready).toBe(true);
+		expect(monitor.status).toBe("Connecting");
+	});
+
+	it("reports missing heartbeats", async () => {
+		const monitor = spawnCeracoderMonitored({
+			execPath: "/bin/sh",
+			args: ["-c", 'printf "READY=1\\n" >&3; sleep 0.5'],
+			spawnOptions: { stdio: "ignore" },
+			watchdogTimeout: 100,
+		});
+
+		const timeout = new Promise<number>((resolve) =>
+			monitor.on("watchdogTimeout", (silentMs) => resolve(silentMs)),
+		);
+		expect(await timeout).toBeGreaterThanOrEqual(100);
+		await waitExit(monitor);
+	});
+});
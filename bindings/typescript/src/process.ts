@@ -10,8 +10,10 @@ import {
 	type ChildProcess,
 	type SpawnOptions,
 } from "node:child_process";
+import { EventEmitter } from "node:events";
 import fs from "node:fs";
 import path from "node:path";
+import type { Readable } from "node:stream";
 
 // Default paths
 const DEFAULT_EXEC_NAME = "ceracoder";
@@ -19,6 +21,11 @@ const DEFAULT_SYSTEM_PATH = "/usr/bin/ceracoder";
 const DEFAULT_CONFIG_PATH = "/tmp/ceracoder.conf";
 const DEFAULT_PIPELINE_PATH = "/tmp/ceracoder_pipeline";
 
+// Supervisor notifications (see src/io/notify.h)
+const NOTIFY_FD = 3;
+const NOTIFY_FD_ENV = "CERACODER_NOTIFY_FD";
+const DEFAULT_WATCHDOG_TIMEOUT_MS = 5000;
+
 /**
  * Try to find an executable in the system PATH using 'which' (Unix) or 'where' (Windows).
  * Returns the full path if found, or undefined if not found.
@@ -131,6 +138,180 @@ export function spawnCeracoder(options: SpawnCeracoderOptions): ChildProcess {
 	return spawn(exec, options.args, options.spawnOptions ?? {});
 }
 
+/**
+ * Supervisor notification, as sent by ceracoder over sd_notify or the notify fd
+ */
+export type CeracoderNotification =
+	| { type: "ready" }
+	| { type: "watchdog" }
+	| { type: "status"; status: string }
+	| { type: "stopping" };
+
+/**
+ * Parse one "KEY=value" notification line
+ *
+ * Returns undefined for unknown or malformed assignments.
+ */
+export function parseNotifyMessage(line: string): CeracoderNotification | undefined {
+	const eq = line.indexOf("=");
+	if (eq <= 0) return undefined;
+
+	const key = line.slice(0, eq);
+	const value = line.slice(eq + 1);
+	switch (key) {
+		case "READY":
+			return value === "1" ? { type: "ready" } : undefined;
+		case "WATCHDOG":
+			return value === "1" ? { type: "watchdog" } : undefined;
+		case "STOPPING":
+			return value === "1" ? { type: "stopping" } : undefined;
+		case "STATUS":
+			return { type: "status", status: value };
+		default:
+			return undefined;
+	}
+}
+
+/**
+ * Events emitted by a monitored ceracoder process
+ */
+export interface CeracoderMonitorEvents {
+	/** The first SRT payload was sent */
+	ready: [];
+	/** Media is still flowing over SRT */
+	watchdog: [];
+	/** Human readable status */
+	status: [status: string];
+	/** ceracoder is shutting down */
+	stopping: [];
+	/** No watchdog heartbeat for watchdogTimeout ms after becoming ready */
+	watchdogTimeout: [silentMs: number];
+}
+
+/**
+ * A ceracoder process with readiness / liveness events
+ */
+export class CeracoderMonitor extends EventEmitter<CeracoderMonitorEvents> {
+	/** The spawned process */
+	readonly process: ChildProcess;
+	/** Set once "ready" was received */
+	ready = false;
+	/** Last status text */
+	status: string | undefined;
+	/** Time (ms since epoch) of the last heartbeat */
+	lastHeartbeat: number | undefined;
+
+	private readonly watchdogTimeout: number;
+	private timer: ReturnType<typeof setTimeout> | undefined;
+	private buffer = "";
+
+	constructor(proc: ChildProcess, notifyStream: Readable, watchdogTimeout: number) {
+		super();
+		this.process = proc;
+		this.watchdogTimeout = watchdogTimeout;
+
+		notifyStream.setEncoding("utf-8");
+		notifyStream.on("data", (chunk: string) => this.onData(chunk));
+		notifyStream.on("error", () => {
+			// The notify pipe closes with the process
+		});
+		proc.on("exit", () => this.clearTimer());
+	}
+
+	private onData(chunk: string): void {
+		this.buffer += chunk;
+		const lines = this.buffer.split("\n");
+		this.buffer = lines.pop() ?? "";
+
+		for (const line of lines) {
+			const msg = parseNotifyMessage(line);
+			if (!msg) continue;
+
+			switch (msg.type) {
+				case "ready":
+					this.ready = true;
+					this.heartbeat();
+					this.emit("ready");
+					break;
+				case "watchdog":
+					this.heartbeat();
+					this.emit("watchdog");
+					break;
+				case "status":
+					this.status = msg.status;
+					this.emit("status", msg.status);
+					break;
+				case "stopping":
+					this.clearTimer();
+					this.emit("stopping");
+					break;
+			}
+		}
+	}
+
+	private heartbeat(): void {
+		this.lastHeartbeat = Date.now();
+		if (this.watchdogTimeout <= 0) return;
+
+		this.clearTimer();
+		this.timer = setTimeout(() => {
+			this.timer = undefined;
+			this.emit("watchdogTimeout", Date.now() - (this.lastHeartbeat ?? 0));
+		}, this.watchdogTimeout);
+	}
+
+	private clearTimer(): void {
+		if (this.timer) {
+			clearTimeout(this.timer);
+			this.timer = undefined;
+		}
+	}
+}
+
+/**
+ * Options for spawning a monitored ceracoder
+ */
+export interface SpawnMonitoredOptions extends SpawnCeracoderOptions {
+	/**
+	 * Emit "watchdogTimeout" if no heartbeat arrives for this long once ready
+	 * (ms, default: 5000, 0 disables). ceracoder sends a heartbeat every second
+	 * while SRT payloads are being sent.
+	 */
+	watchdogTimeout?: number;
+}
+
+/**
+ * Spawn ceracoder with a notification pipe on fd 3
+ *
+ * The returned monitor emits "ready" once media is flowing over SRT,
+ * "watchdog" heartbeats, "status" updates and "stopping".
+ * spawnOptions.stdio may be a string or an array of up to 3 entries.
+ */
+export function spawnCeracoderMonitored(options: SpawnMonitoredOptions): CeracoderMonitor {
+	const exec = getCeracoderExec(options);
+	const spawnOptions = options.spawnOptions ?? {};
+
+	const baseStdio = spawnOptions.stdio ?? "pipe";
+	const stdio = Array.isArray(baseStdio)
+		? [...baseStdio.slice(0, NOTIFY_FD)]
+		: [baseStdio, baseStdio, baseStdio];
+	while (stdio.length < NOTIFY_FD) stdio.push("pipe");
+	stdio.push("pipe");
+
+	const proc = spawn(exec, options.args, {
+		...spawnOptions,
+		stdio: stdio as SpawnOptions["stdio"],
+		env: { ...(spawnOptions.env ?? process.env), [NOTIFY_FD_ENV]: String(NOTIFY_FD) },
+	});
+
+	const notifyStream = proc.stdio[NOTIFY_FD] as Readable;
+	return new CeracoderMonitor(
+		proc,
+		notifyStream,
+		options.watchdogTimeout ?? DEFAULT_WATCHDOG_TIMEOUT_MS,
+	);
+}
+
 /**
  * Options for sending signals to ceracoder
  */
@@ -84,4 +84,42 @@ describe("buildCeracoderRunArtifacts", () => {
 		expect(config.general.max_bitrate).toBe(4000);
 		expect(config.aimd?.decr_mult).toBe(DEFAULT_AIMD.decr_mult);
 	});
+
+	it("passes the low latency profile through the config and CLI", () => {
+		const { config, ini, args } = buildCeracoderRunArtifacts({
+			pipelineFile: "p",
+			host: "h",
+			port: 1,
+			configFile: "/tmp/none",
+			config: {
+				general: { min_bitrate: 300, max_bitrate: 4000, balancer: "aimd", low_latency: 1 },
+				srt: { latency: 2000 },
+				aimd: { ...DEFAULT_AIMD },
+			},
+			fullOverride: true,
+			lowLatency: true,
+		});
+		expect(config.general.low_latency).toBe(1);
+		expect(ini).toContain("low_latency = 1");
+		expect(args).toContain("-L");
+	});
+
+	it("passes the overlay mode through the config and CLI", () => {
+		const { config, ini, args } = buildCeracoderRunArtifacts({
+			pipelineFile: "p",
+			host: "h",
+			port: 1,
+			configFile: "/tmp/none",
+			config: {
+				general: { min_bitrate: 300, max_bitrate: 4000, balancer: "aimd", overlay: "auto" },
+				srt: { latency: 2000 },
+				aimd: { ...DEFAULT_AIMD },
+			},
+			fullOverride: true,
+			overlay: "source",
+		});
+		expect(config.general.overlay).toBe("auto");
+		expect(ini).toContain("overlay = auto");
+		expect(args.join(" ")).toContain("-O source");
+	});
 });
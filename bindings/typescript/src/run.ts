@@ -18,6 +18,8 @@ export type CeracoderRunInput = {
 	streamId?: string;
 	latencyMs?: number;
 	reducedPacketSize?: boolean;
+	lowLatency?: boolean;
+	overlay?: CeracoderCliOptions["overlay"];
 	algorithm?: CeracoderCliOptions["algorithm"];
 };
 
@@ -97,6 +99,8 @@ export function buildCeracoderRunArtifacts(
 		streamId: input.streamId,
 		latencyMs: input.latencyMs ?? config.srt.latency,
 		reducedPacketSize: input.reducedPacketSize,
+		lowLatency: input.lowLatency,
+		overlay: input.overlay,
 		algorithm: input.algorithm ?? config.general.balancer,
 	});
 
@@ -18,6 +18,8 @@ export const adaptiveSchema = z
 		incr_interval: z.number().int().positive(),
 		decr_interval: z.number().int().positive(),
 		loss_threshold: z.number().positive(),
+		loss_classify: z.number().int().min(0).max(1).optional(),
+		rtt_change_detect: z.number().int().min(0).max(1).optional(),
 	})
 	.optional();
 
@@ -30,11 +32,26 @@ export const aimdSchema = z
 	})
 	.optional();
 
+export const overlayModeSchema = z.enum(["off", "auto", "source"]);
+export type OverlayMode = z.infer<typeof overlayModeSchema>;
+export const zeroCopyModeSchema = z.enum(["off", "auto"]);
+export type ZeroCopyMode = z.infer<typeof zeroCopyModeSchema>;
+
 export const ceracoderConfigSchema = z.object({
 	general: z.object({
 		min_bitrate: z.number().int().min(1).default(DEFAULT_MIN_BITRATE),
 		max_bitrate: z.number().int().min(1).default(DEFAULT_MAX_BITRATE),
 		balancer: balancerAlgorithmSchema.default(DEFAULT_BALANCER),
+		slow_start: z.number().int().min(0).max(1).optional(),
+		start_bitrate: z.number().int().min(1).optional(),
+		low_latency: z.number().int().min(0).max(1).optional(),
+		overlay: overlayModeSchema.optional(),
+		control_fifo: z.string().min(1).optional(),
+		slate: z.string().min(1).optional(),
+		slate_timeout: z.number().int().min(100).optional(),
+		zero_copy: zeroCopyModeSchema.optional(),
+		scene_detect: z.number().int().min(0).max(1).optional(),
+		content_cap: z.number().int().min(0).max(1).optional(),
 	}),
 	srt: z
 		.object({
@@ -63,6 +80,8 @@ export const cliOptionsSchema = z.object({
 	streamId: z.string().optional(),
 	latencyMs: z.number().int().min(100).max(10_000).optional(),
 	reducedPacketSize: z.boolean().optional(),
+	lowLatency: z.boolean().optional(),
+	overlay: overlayModeSchema.optional(),
 	algorithm: balancerAlgorithmSchema.optional(),
 });
 
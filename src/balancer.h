@@ -31,11 +31,17 @@ typedef struct {
     int srt_latency;      // Configured SRT latency (ms)
     int srt_pkt_size;     // SRT packet size (bytes)
 
+    // Startup policy
+    int slow_start;       // Ramp up from start_bitrate instead of starting at max_bitrate (bool)
+    int start_bitrate;    // Slow start initial bitrate (bps, default: 1000000)
+
     // Adaptive algorithm tuning (bps for bitrate values, ms for intervals)
     int adaptive_incr_step;      // Bitrate increase step (bps, default: 30000)
     int adaptive_decr_step;      // Bitrate decrease step (bps, default: 100000)
     int adaptive_incr_interval;  // Min interval between increases (ms, default: 500)
     int adaptive_decr_interval;  // Min interval between decreases (ms, default: 200)
+    int adaptive_loss_classify;  // Ignore random (non-congestive) loss (bool, default: 1)
+    int adaptive_rtt_change_detect; // Re-baseline the RTT after path changes (bool, default: 1)
 
     // AIMD algorithm tuning
     int aimd_incr_step;          // Additive increase (bps, default: 50000)
@@ -54,8 +60,58 @@ typedef struct {
     uint64_t timestamp;   // Current timestamp (ms)
     int64_t pkt_loss_total;  // Total packets lost (cumulative)
     int64_t pkt_retrans_total; // Total packets retransmitted (cumulative)
+    int scene_cut;        // Scene cut in the video since the last step (bool), see scene_detect.h
+    int motion;           // Video motion score (0-100), 0 without a scene detector
+    int ceiling;          // Static scene ceiling (bps) below max_bitrate, 0 = none, see content_cap.h
 } BalancerInput;
 
+/*
+ * Scene hints: after a scene cut the encoder burst is still on its way, so
+ * increases wait for BALANCER_SCENE_HOLD and a decrease due to congestion
+ * in that window skips its rate limit once, to drain the queue ahead of
+ * the burst. High motion (BALANCER_MOTION_HIGH) halves the increase steps.
+ *
+ * Ceiling: while set, the bitrate is held at or below it (never below
+ * min_bitrate). The bitrate it was lowered from is restored in one step
+ * once the ceiling lifts, unless a congestion signal was seen in between.
+ */
+#define BALANCER_SCENE_HOLD     1000    // ms
+#define BALANCER_MOTION_HIGH    50
+
+/*
+ * Decision reason - which branch of the algorithm fired this step
+ *
+ * Decreases record the signal that triggered them, so drops can be told
+ * apart as RTT-, buffer- or loss-triggered.
+ */
+typedef enum {
+    BALANCER_REASON_HOLD = 0,          // No change: no signal, or rate limited
+    BALANCER_REASON_FIXED,             // Fixed bitrate, no adaptation
+    BALANCER_REASON_INCREASE,          // Stable conditions, increasing
+    BALANCER_REASON_LIGHT_RTT,         // Light congestion, RTT above its threshold
+    BALANCER_REASON_LIGHT_BUFFER,      // Light congestion, send buffer filling
+    BALANCER_REASON_HEAVY_RTT,         // Heavy congestion (multiplicative decrease), RTT
+    BALANCER_REASON_HEAVY_BUFFER,      // Heavy congestion, send buffer
+    BALANCER_REASON_HEAVY_LOSS,        // Heavy congestion, packet loss
+    BALANCER_REASON_EMERGENCY_RTT,     // Drop to the minimum, RTT close to the latency
+    BALANCER_REASON_EMERGENCY_BUFFER,  // Drop to the minimum, send buffer overflowing
+    BALANCER_REASON_SLOW_START,        // Startup ramp, see slow_start.h
+    BALANCER_REASON_CONTENT_CAP,       // Lowered to the static scene ceiling
+    BALANCER_REASON_COUNT
+} BalancerReason;
+
+/*
+ * Congestion state - the worst congestion signal seen this step,
+ * regardless of whether the bitrate was changed
+ */
+typedef enum {
+    BALANCER_STATE_STABLE = 0,
+    BALANCER_STATE_LIGHT,
+    BALANCER_STATE_HEAVY,
+    BALANCER_STATE_EMERGENCY,
+    BALANCER_STATE_COUNT
+} BalancerState;
+
 /*
  * Balancer output - returned from step()
  */
@@ -69,15 +125,21 @@ typedef struct {
     int bs_th1;           // Buffer threshold 1 (for overlay)
     int bs_th2;           // Buffer threshold 2 (for overlay)
     int bs_th3;           // Buffer threshold 3 (for overlay)
+    BalancerReason reason; // Decision taken this step
+    BalancerState state;  // Congestion state this step
+    int loss_congestive;  // Packets lost this step, classified as congestive
+    int loss_random;      // Packets lost this step, classified as random (not congestive)
+    int rtt_change;       // +1 / -1: RTT baseline re-set after a path change up / down
 } BalancerOutput;
 
 /*
  * Balancer algorithm interface
  *
- * Each algorithm implements these three functions:
- * - init:    Allocate and initialize algorithm state
- * - step:    Compute new bitrate based on current network stats
- * - cleanup: Free algorithm state
+ * Each algorithm implements these functions:
+ * - init:        Allocate and initialize algorithm state
+ * - step:        Compute new bitrate based on current network stats
+ * - cleanup:     Free algorithm state
+ * - get_bitrate: Current bitrate, before the first step too
  */
 typedef struct {
     const char *name;        // Algorithm name (e.g., "adaptive", "fixed", "aimd")
@@ -91,6 +153,9 @@ typedef struct {
 
     // Clean up algorithm state
     void (*cleanup)(void *state);
+
+    // Current bitrate (bps, rounded to 100 Kbps)
+    int (*get_bitrate)(void *state);
 } BalancerAlgorithm;
 
 /*
@@ -109,4 +174,8 @@ const BalancerAlgorithm* const* balancer_list_all(void);
 // Print list of available algorithms to stderr
 void balancer_print_available(void);
 
+// Short names for reasons and states, e.g. "heavy_loss", or "unknown"
+const char* balancer_reason_name(BalancerReason reason);
+const char* balancer_state_name(BalancerState state);
+
 #endif /* BALANCER_H */
@@ -40,14 +40,32 @@
 #include "pipeline_loader.h"
 #include "encoder_control.h"
 #include "overlay_ui.h"
+#include "zero_copy.h"
 #include "balancer_runner.h"
 #include "bitrate_control.h"
+#include "content_cap.h"
+#include "ts_mux.h"
+#include "ts_index.h"
+#include "ts_cc.h"
+#include "ts_slate.h"
+#include "mux_monitor.h"
+#include "video_tap.h"
+#include "stats.h"
+#include "notify.h"
+#include "control_thread.h"
+#include "timer_monitor.h"
+#include "perf_counters.h"
+#include "live_stats.h"
+#include "control_fifo.h"
+#include "trace.h"
 
 // SRT ACK timeout
 #define SRT_ACK_TIMEOUT 6000 // maximum interval between received ACKs before the connection is TOed
 
-// Packet size constants
-#define TS_PKT_SIZE 188
+// Interval for collecting and writing the runtime stats
+#define STATS_UPDATE_INT 1000 // ms
+
+// Packet size constants (TS_PKT_SIZE is defined in ts_mux.h)
 #define REDUCED_SRT_PKT_SIZE ((TS_PKT_SIZE)*6)
 #define DEFAULT_SRT_PKT_SIZE ((TS_PKT_SIZE)*7)
 
@@ -63,16 +81,131 @@
   #define debug(...)
 #endif
 
+// Max wait for the first keyframe of a swapped in pipeline
+#define SWAP_KEYFRAME_TIMEOUT 10000 // ms
+
 // Global state
-static GstPipeline *gst_pipeline = NULL;
 static GMainLoop *loop;
 static SrtClient srt_client;
-static EncoderControl encoder_ctrl;
-static OverlayUi overlay_ui;
 static BalancerRunner balancer_runner;
+static GMutex balancer_lock;  // balancer_runner: control thread tick vs. main loop reloads / stats
+static ContentCap content_cap;  // Under balancer_lock
+static int content_cap_enabled = 0;
+static ControlThread control_thread;
+static TimerMonitor timer_monitor;
 static int quit = 0;
 static int av_delay = 0;
 static int srt_pkt_size = DEFAULT_SRT_PKT_SIZE;
+static int low_latency = 0;   // Low latency profile: also flush partial SRT packets
+
+// Per-stage latency, reported once the pipeline is playing
+static struct {
+  int valid;
+  int encode_ms;      // Capture and encoding (latency query on the encoder src pad)
+  int mux_ms;         // Mux latency property, -1 if unknown
+  int pipeline_ms;    // Whole pipeline (latency query)
+  int queue_ms;       // Queue limit, only reached while backed up
+  int srt_ms;
+} latency_budget;
+
+// In-tree TS muxer, used when the pipeline ends in elementary stream appsinks
+enum { TS_INPUT_VIDEO, TS_INPUT_AUDIO, TS_INPUT_COUNT };
+typedef struct Feed Feed;
+typedef struct {
+  GstElement *sink;
+  Feed *owner;
+  int stream;        // ts_mux stream index, -1 until the caps are known
+  int waiting_key;   // drop video until the first keyframe
+} TsMuxInput;
+static TsMux ts_mux;
+static int ts_streams[TS_INPUT_COUNT] = {-1, -1};  // ts_mux stream per input, kept across swaps
+static int ts_mux_enabled = 0;
+
+// PTS jitter smoothing state of the ptsfixup element
+typedef struct {
+  unsigned long pts;
+  long period;
+  long prev_pts;
+} PtsFixup;
+
+/*
+  A pipeline and the state tied to its elements. The active feed streams over
+  SRT; a pipeline hot-swap ("swap <file>" on the control FIFO) starts a second
+  feed on the same clock and base time, which takes over at its first keyframe
+  while the SRT connection, the balancer and the TS continuity counters carry on
+*/
+struct Feed {
+  GstPipeline *pipeline;
+  PipelineFile pfile;
+  char name[256];             // Pipeline file
+  EncoderControl encoder;
+  AudioControl audio;
+  OverlayUi overlay;
+  ZeroCopy zero_copy;
+  MuxMonitor mux_monitor;
+  VideoTap video_tap;
+  PtsFixup ptsfixup;
+  GstElement *appsink;        // mpegtsmux output, NULL with the in-tree muxer
+  TsMuxInput ts_inputs[TS_INPUT_COUNT];
+};
+static Feed feeds[2];
+static Feed *feed = &feeds[0];   // Active, switched by the streaming thread of next_feed
+static Feed *next_feed = NULL;   // Being swapped in, until its first keyframe
+static GMutex feed_lock;         // feed / next_feed vs. the control thread
+static GMutex output_lock;       // SRT output (packetizer, in-tree muxer) and the feed switch
+static guint swap_timeout_id = 0;
+static GThread *teardown_thread = NULL;
+static Feed *teardown_feed = NULL;
+static Feed *swap_held = NULL;   // Stopped before next_feed starts, to free a shared device
+static GstClock *swap_clock = NULL;
+static GstClockTime swap_base_time;
+static uint64_t swaps_total = 0;
+static ControlFifo control_fifo = { .fd = -1 };
+
+// Continuity counters of the mpegtsmux output, restamped after a swap
+static TsCc ts_cc;
+
+// Slate sent instead of the pipeline output while the input is lost
+#define SLATE_CHECK_INT    100     // ms
+#define SLATE_SEND_INT     10      // ms
+#define SLATE_RESTART_INT  10000   // ms between pipeline restarts while on the slate
+#define SLATE_BATCH_PKTS   64
+static TsSlate slate;
+static int slate_loaded = 0;
+static gint slate_active = 0;           // Changed with output_lock held
+static uint64_t slate_started_ms;
+static uint64_t slate_start_pcr;
+static uint64_t slate_restart_ms;
+static guint slate_send_id = 0;
+static uint64_t slate_engaged_total = 0;
+// Last PCR and output of the pipeline, with output_lock held
+static uint64_t live_pcr;
+static uint64_t live_pcr_ms = 0;
+static uint64_t live_output_ms = 0;
+
+// Index of the mpegtsmux output, rebuilt for each appsink sample
+static TsIndex ts_index;
+static GMutex ts_index_lock;
+static struct {
+  uint64_t packets;
+  uint64_t null_packets;
+  uint64_t sync_errors;
+} ts_index_stats;
+
+// Runtime stats
+static Stats runtime_stats;
+
+// CPU counters of the threads sending to SRT and running the balancer, if enabled
+static PerfCounters stream_counters;
+static PerfCounters control_counters;
+
+// Per-tick samples for ceratop, written from the control thread only
+static LiveStats live_stats;
+
+// Supervisor notifications; the watchdog only fires while SRT payloads are being sent
+static Notifier notifier;
+static gint srt_payloads_sent = 0;
+static gint notify_ready = 0;
 
 // Configuration
 static BelacoderConfig g_config;
@@ -122,10 +255,20 @@ static int parse_long(const char *str, long *result, long min_val, long max_val)
 // Forward declaration
 int read_bitrate_file(void);
 
+static EncoderPolicyConfig encoder_policy_config(const BelacoderConfig *cfg) {
+  EncoderPolicyConfig policy = {
+    .min_interval = cfg->encoder.min_interval,
+    .min_delta = config_bitrate_bps(cfg->encoder.min_delta),
+    .max_hold = cfg->encoder.max_hold
+  };
+  return policy;
+}
+
 /* Attempts to stop the gstreamer pipeline cleanly */
 void stop() {
   if (!quit) {
     quit = 1;
+    notify_send(&notifier, "STOPPING=1");
     alarm(3);
     g_main_loop_quit(loop);
   }
@@ -137,13 +280,52 @@ void sighup_handler(int sig) {
   reload_config_flag = 1;
 }
 
-// GLib signal handler for SIGTERM/SIGINT (called from main loop, not signal context)
+// GLib signal handler for SIGTERM/SIGINT (called from main loop, not signal context),
+// also invoked on the main loop by the control thread
 gboolean stop_from_signal(gpointer user_data) {
   (void)user_data;
   stop();
   return G_SOURCE_REMOVE;
 }
 
+// The active feed, from the main loop
+static Feed *active_feed(void) {
+  return g_atomic_pointer_get(&feed);
+}
+
+// The feed being swapped in, if any, from the main loop
+static Feed *pending_feed(void) {
+  g_mutex_lock(&feed_lock);
+  Feed *fd = next_feed;
+  g_mutex_unlock(&feed_lock);
+  return fd;
+}
+
+static gint64 stall_prev_pos = -1;
+
+/*
+  Last sign of input (monotonic ms, 0 = none yet): the encoder output, or the
+  pipeline output when the encoder isn't known
+*/
+static uint64_t input_last_ms(Feed *fd) {
+  if (fd->encoder.src_pad == NULL) {
+    g_mutex_lock(&output_lock);
+    uint64_t last = live_output_ms;
+    g_mutex_unlock(&output_lock);
+    return last;
+  }
+  g_mutex_lock(&fd->encoder.lock);
+  int64_t last = fd->encoder.last_output;
+  g_mutex_unlock(&fd->encoder.lock);
+  return (uint64_t)(last / 1000);
+}
+
+// The encoder of a feed has output something since the slate was engaged
+static int input_resumed(Feed *fd) {
+  if (fd->encoder.src_pad == NULL) return 1;
+  return input_last_ms(fd) > slate_started_ms;
+}
+
 /*
   This checks periodically for pipeline stalls. The alsasrc element tends to stall rather
   than error out when the input resolution changes for a live input into a Camlink 4K
@@ -170,7 +352,13 @@ gboolean stall_check(gpointer data) {
       if (config_load(&g_config, config_filename) == 0) {
         min_bitrate = config_bitrate_bps(g_config.min_bitrate);
         max_bitrate = config_bitrate_bps(g_config.max_bitrate);
+        g_mutex_lock(&balancer_lock);
         balancer_runner_update_bounds(&balancer_runner, min_bitrate, max_bitrate);
+        g_mutex_unlock(&balancer_lock);
+        active_feed()->encoder.policy.config = encoder_policy_config(&g_config);
+        audio_control_configure(&active_feed()->audio, config_bitrate_bps(g_config.audio.min_bitrate),
+                                g_config.audio.complexity);
+        timer_monitor.warn_ms = g_config.timer_warn_ms;
         fprintf(stderr, "Config reloaded: %d - %d Kbps\n",
                 min_bitrate / 1000, max_bitrate / 1000);
         reloaded = 1;
@@ -185,17 +373,33 @@ gboolean stall_check(gpointer data) {
     }
   }
 
-  static gint64 prev_pos = -1;
+  // A lost input is covered by the slate rather than exiting
+  if (slate_loaded) {
+    uint64_t last = input_last_ms(active_feed());
+    if (g_atomic_int_get(&slate_active) || (last != 0 && getms() - last > 500)) {
+      stall_prev_pos = -1;
+      return TRUE;
+    }
+  }
+
+  // Stopped while a swap starts the pipeline replacing it
+  if (swap_held != NULL) {
+    stall_prev_pos = -1;
+    return TRUE;
+  }
+
   gint64 pos;
-  if (!gst_element_query_position((GstElement *)gst_pipeline, GST_FORMAT_TIME, &pos))
+  if (!gst_element_query_position((GstElement *)active_feed()->pipeline, GST_FORMAT_TIME, &pos))
     return TRUE;
 
-  if (pos != -1 && pos == prev_pos) {
+  if (pos != -1 && pos == stall_prev_pos) {
+    TRACE1(stall, pos);
     fprintf(stderr, "Pipeline stall detected. Will exit now\n");
+    notify_send(&notifier, "STATUS=Pipeline stall detected");
     stop();
   }
 
-  prev_pos = pos;
+  stall_prev_pos = pos;
   return TRUE;
 }
 
@@ -225,7 +429,9 @@ int read_bitrate_file() {
   free(buf);
   fclose(f);
   
+  g_mutex_lock(&balancer_lock);
   balancer_runner_update_bounds(&balancer_runner, br[0], br[1]);
+  g_mutex_unlock(&balancer_lock);
   return 0;
 
 ret_err:
@@ -234,6 +440,52 @@ ret_err:
   return -2;
 }
 
+/*
+  The latest balancer output, applied to the encoder and the overlay from the
+  main loop: both are GObject property sets that can block on element locks
+  (and Pango layout for the overlay), so the control thread doesn't wait for
+  them. Outputs produced while an apply is pending replace each other
+*/
+static GMutex apply_lock;
+static BalancerOutput apply_output;
+static int apply_pending = 0;
+
+static gboolean apply_balancer_output(gpointer data) {
+  (void)data;
+  g_mutex_lock(&apply_lock);
+  BalancerOutput output = apply_output;
+  apply_pending = 0;
+  g_mutex_unlock(&apply_lock);
+
+  // Set encoder bitrate, also on a pipeline being swapped in
+  Feed *fd = active_feed();
+  Feed *next = pending_feed();
+  encoder_control_set_bitrate(&fd->encoder, output.new_bitrate);
+  audio_control_set_bitrate(&fd->audio, output.new_bitrate);
+  if (next != NULL) {
+    encoder_control_set_bitrate(&next->encoder, output.new_bitrate);
+    audio_control_set_bitrate(&next->audio, output.new_bitrate);
+  }
+
+  // Update the overlay display
+  overlay_ui_update(&fd->overlay, output.new_bitrate, output.throughput,
+                    output.rtt, output.rtt_th_min, output.rtt_th_max,
+                    output.bs, output.bs_th1, output.bs_th2, output.bs_th3);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void apply_balancer_output_async(const BalancerOutput *output) {
+  g_mutex_lock(&apply_lock);
+  apply_output = *output;
+  if (!apply_pending) {
+    apply_pending = 1;
+    g_idle_add_full(G_PRIORITY_HIGH, apply_balancer_output, NULL, NULL);
+  }
+  g_mutex_unlock(&apply_lock);
+}
+
+// Called from the control thread
 void do_bitrate_update(SRT_TRACEBSTATS *stats, uint64_t ctime) {
   // Get send buffer size from SRT
   int bs = -1;
@@ -251,24 +503,79 @@ void do_bitrate_update(SRT_TRACEBSTATS *stats, uint64_t ctime) {
     .pkt_retrans_total = stats->pktRetransTotal
   };
 
-  // Call the balancer algorithm
-  BalancerOutput output = balancer_runner_step(&balancer_runner, &input);
+  // Scene cuts and motion from the raw video, ahead of the encoder output
+  g_mutex_lock(&feed_lock);
+  int scene_active = video_tap_take(&feed->video_tap, &input.scene_cut, &input.motion);
+  g_mutex_lock(&feed->encoder.lock);
+  int output_bps = feed->encoder.output_bps;
+  g_mutex_unlock(&feed->encoder.lock);
+  g_mutex_unlock(&feed_lock);
 
-  // Update the overlay display
-  overlay_ui_update(&overlay_ui, output.new_bitrate, output.throughput,
-                    output.rtt, output.rtt_th_min, output.rtt_th_max,
-                    output.bs, output.bs_th1, output.bs_th2, output.bs_th3);
+  TRACE4(balancer_input, (int)input.rtt, input.buffer_size,
+         (int)(input.send_rate_mbps * 1000), input.timestamp);
 
-  // Set encoder bitrate
-  encoder_control_set_bitrate(&encoder_ctrl, output.new_bitrate);
+  // Call the balancer algorithm
+  g_mutex_lock(&balancer_lock);
+  if (content_cap_enabled) {
+    // Without frames to analyze the motion is unknown, which lifts the ceiling
+    input.ceiling = content_cap_update(&content_cap, input.motion, input.scene_cut,
+                                       scene_active ? output_bps : 0,
+                                       balancer_runner_get_bitrate(&balancer_runner), ctime);
+  }
+  BalancerOutput output = balancer_runner_step(&balancer_runner, &input);
+  int min_bps = balancer_runner.config.min_bitrate;
+  int max_bps = balancer_runner.config.max_bitrate;
+  g_mutex_unlock(&balancer_lock);
+
+  TRACE4(balancer_output, output.new_bitrate, (int)output.throughput,
+         output.state, output.reason);
+
+  apply_balancer_output_async(&output);
+
+  if (live_stats.shm != NULL) {
+    LiveStatsSample sample = {
+      .target_bps = output.new_bitrate,
+      .send_bps = (int32_t)(stats->mbpsSendRate * 1000000),
+      .min_bps = min_bps,
+      .max_bps = max_bps,
+      .rtt_ms = (float)input.rtt,
+      .rtt_th_min_ms = (float)output.rtt_th_min,
+      .rtt_th_max_ms = (float)output.rtt_th_max,
+      .bs = bs,
+      .bs_th1 = output.bs_th1,
+      .bs_th2 = output.bs_th2,
+      .bs_th3 = output.bs_th3,
+      .state = output.state,
+      .reason = output.reason,
+      .pkt_loss_total = stats->pktSndLossTotal,
+      .pkt_retrans_total = stats->pktRetransTotal
+    };
+    int lag_ms, delay_ms, latency_ms;
+    g_mutex_lock(&feed_lock);
+    g_mutex_lock(&feed->encoder.lock);
+    sample.encoder_bps = feed->encoder.current_bitrate;
+    sample.output_bps = feed->encoder.output_bps;
+    g_mutex_unlock(&feed->encoder.lock);
+    mux_monitor_get_latency(&feed->mux_monitor, &lag_ms, &delay_ms, &latency_ms);
+    g_mutex_unlock(&feed_lock);
+    sample.mux_lag_ms = lag_ms;
+    sample.mux_delay_ms = delay_ms;
+    sample.mux_latency_ms = latency_ms;
+    live_stats_publish(&live_stats, &sample, ctime);
+  }
 }
 
+/*
+  The balancer tick, run every BITRATE_UPDATE_INT ms on the control thread
+*/
 gboolean connection_housekeeping(gpointer user_data) {
   (void)user_data;
   uint64_t ctime = getms();
   static uint64_t prev_ack_ts = 0;
   static uint64_t prev_ack_count = 0;
 
+  perf_counters_sample(&control_counters, ctime);
+
   // SRT stats
   SRT_TRACEBSTATS stats;
   int ret = srt_client_get_stats(&srt_client, &stats);
@@ -282,21 +589,148 @@ gboolean connection_housekeeping(gpointer user_data) {
   /* Manual check for connection timeout */
   if (prev_ack_count != 0 && (ctime - prev_ack_ts) > SRT_ACK_TIMEOUT) {
     fprintf(stderr, "The SRT connection timed out, exiting\n");
-    stop();
+    notify_send(&notifier, "STATUS=SRT connection timed out");
+    g_main_context_invoke(NULL, stop_from_signal, NULL);
   }
 
   // Update bitrate when we have a configurable encoder
-  if (encoder_control_available(&encoder_ctrl)) {
+  g_mutex_lock(&feed_lock);
+  int available = encoder_control_available(&feed->encoder);
+  g_mutex_unlock(&feed_lock);
+  if (available) {
     do_bitrate_update(&stats, ctime);
   }
 
 r:
+  // Ready once media is actually flowing over SRT, not just when connected
+  if (g_atomic_int_get(&srt_payloads_sent) > 0 &&
+      g_atomic_int_compare_and_exchange(&notify_ready, 0, 1)) {
+    notify_send(&notifier, "READY=1\nSTATUS=Streaming");
+  }
   return TRUE;
 }
 
-GstFlowReturn new_buf_cb(GstAppSink *sink, gpointer user_data) {
+// Sends one SRT payload, counting it for the readiness and watchdog notifications
+static int srt_send_payload(const void *data, int len) {
+  TRACE1(pkt_send_start, len);
+  int nb = srt_client_send(&srt_client, data, len);
+  TRACE2(pkt_send_done, len, nb);
+  if (nb == len) {
+    g_atomic_int_inc(&srt_payloads_sent);
+  }
+  return nb;
+}
+
+/*
+  Indexes an mpegtsmux sample in one pass; only called with output_lock held,
+  the counters are read by stats_update
+*/
+static int ts_index_sample(const uint8_t *data, int len) {
+  static int warned = 0;
+  if (ts_index_build(&ts_index, data, len) < 0) return -1;
+
+  int null_pkts = 0;
+  for (int i = 0; i < ts_index.count; i++) {
+    null_pkts += ts_index.pkts[i].pid == TS_INDEX_NULL_PID;
+  }
+
+  if ((ts_index.sync_errors > 0 || ts_index.tail > 0) && !warned) {
+    fprintf(stderr, "Warning: misaligned MPEG-TS sample (%d bad sync bytes, %d trailing bytes)\n",
+            ts_index.sync_errors, ts_index.tail);
+    warned = 1;
+  }
+
+  g_mutex_lock(&ts_index_lock);
+  ts_index_stats.packets += ts_index.count;
+  ts_index_stats.null_packets += null_pkts;
+  ts_index_stats.sync_errors += ts_index.sync_errors;
+  g_mutex_unlock(&ts_index_lock);
+  return 0;
+}
+
+/*
+  Continuity counters of an indexed sample: tracked, and after a pipeline swap
+  rewritten in a copy of the sample so they carry on from the previous muxer
+*/
+static const uint8_t *ts_cc_sample(const uint8_t *data, int len) {
+  static uint8_t *restamped = NULL;
+  static int restamped_size = 0;
+
+  if (!ts_cc.restamp) {
+    ts_cc_process(&ts_cc, &ts_index, NULL);
+    return data;
+  }
+  if (len > restamped_size) {
+    restamped = g_realloc(restamped, len);
+    restamped_size = len;
+  }
+  memcpy(restamped, data, len);
+  ts_cc_process(&ts_cc, &ts_index, restamped);
+  return restamped;
+}
+
+/*
+  Packs TS data into srt_pkt_size SRT payloads, merging and splitting the
+  samples as needed; with flush (or in low latency mode) the tail is sent
+  right away rather than held back until the next call fills the payload.
+  Only called with output_lock held
+
+  Returns 0 on success, -1 if the SRT connection failed
+*/
+static int srt_output_write(const uint8_t *data, int len, int flush) {
   static char pkt[DEFAULT_SRT_PKT_SIZE];
   static int pkt_len = 0;
+
+  int remaining = len;
+  do {
+    int copy_sz = MIN(srt_pkt_size - pkt_len, remaining);
+    if (copy_sz > 0) memcpy((void *)pkt + pkt_len, data + (len - remaining), copy_sz);
+    pkt_len += copy_sz;
+    remaining -= copy_sz;
+
+    if (pkt_len == srt_pkt_size || (flush && remaining == 0 && pkt_len > 0)) {
+      int nb = srt_send_payload(pkt, pkt_len);
+      if (nb != pkt_len) return -1;
+      pkt_len = 0;
+    }
+  } while (remaining);
+
+  return 0;
+}
+
+static void srt_output_failed(void) {
+  if (!quit) {
+    fprintf(stderr, "The SRT connection failed, exiting\n");
+    notify_send(&notifier, "STATUS=SRT connection failed");
+    stop();
+  }
+}
+
+// Last PCR of the indexed sample, to carry on from it on the slate
+static void live_pcr_update(const uint8_t *data, uint64_t now) {
+  for (int i = ts_index.count - 1; i >= 0; i--) {
+    if ((ts_index.pkts[i].flags & TS_PKT_PCR) &&
+        ts_packet_pcr(data + i * TS_INDEX_PKT_SIZE, &live_pcr) == 0) {
+      live_pcr_ms = now;
+      return;
+    }
+  }
+}
+
+static gboolean slate_stopped(gpointer data) {
+  (void)data;
+  fprintf(stderr, "Input back after %.1f s on the slate\n",
+          (getms() - slate_started_ms) / 1000.0);
+  notify_send(&notifier, "STATUS=Streaming");
+  stall_prev_pos = -1;
+  return G_SOURCE_REMOVE;
+}
+
+// Forward declaration
+static void feed_promote(Feed *fd);
+
+GstFlowReturn new_buf_cb(GstAppSink *sink, gpointer user_data) {
+  Feed *fd = (Feed *)user_data;
   GstFlowReturn code = GST_FLOW_OK;
 
   GstSample *sample = gst_app_sink_pull_sample(sink);
@@ -306,38 +740,352 @@ GstFlowReturn new_buf_cb(GstAppSink *sink, gpointer user_data) {
   GstMapInfo map = {0};
 
   buffer = gst_sample_get_buffer(sample);
+
+  g_mutex_lock(&output_lock);
+
+  // A pipeline being swapped in takes over from its first keyframe (mpegtsmux
+  // clears DELTA_UNIT on the sample that starts one), any other is dropped
+  if (fd != feed) {
+    if (fd != next_feed || GST_BUFFER_FLAG_IS_SET(buffer, GST_BUFFER_FLAG_DELTA_UNIT)) {
+      g_mutex_unlock(&output_lock);
+      gst_sample_unref(sample);
+      return GST_FLOW_OK;
+    }
+    feed_promote(fd);
+  }
+
+  // Back from the slate at the first keyframe of the restored input, the
+  // samples still flushed out of the pipeline before that are dropped
+  if (g_atomic_int_get(&slate_active)) {
+    if (GST_BUFFER_FLAG_IS_SET(buffer, GST_BUFFER_FLAG_DELTA_UNIT) || !input_resumed(fd)) {
+      g_mutex_unlock(&output_lock);
+      gst_sample_unref(sample);
+      return GST_FLOW_OK;
+    }
+    g_atomic_int_set(&slate_active, 0);
+    ts_cc_new_source(&ts_cc);
+    g_idle_add(slate_stopped, NULL);
+  }
+
   gst_buffer_map(buffer, &map, GST_MAP_READ);
+  TRACE2(sample_start, map.size, GST_BUFFER_PTS(buffer));
+  uint64_t now = getms();
+  perf_counters_sample(&stream_counters, now);
+
+  const uint8_t *data = map.data;
+  if (ts_index_sample(map.data, (int)map.size) == 0) {
+    if (slate_loaded) live_pcr_update(map.data, now);
+    data = ts_cc_sample(map.data, (int)map.size);
+  }
+  live_output_ms = now;
 
-  // Send srt_pkt_size packets, splitting and merging samples if needed
-  int sample_sz = (int)map.size;
-  do {
-    int copy_sz = MIN(srt_pkt_size - pkt_len, sample_sz);
-    memcpy((void *)pkt + pkt_len, map.data, copy_sz);
-    pkt_len += copy_sz;
+  if (srt_output_write(data, (int)map.size, low_latency) != 0) {
+    srt_output_failed();
+    code = GST_FLOW_ERROR;
+  }
 
-    if (pkt_len == srt_pkt_size) {
-      int nb = srt_client_send(&srt_client, pkt, srt_pkt_size);
-      if (nb != srt_pkt_size) {
-        if (!quit) {
-          fprintf(stderr, "The SRT connection failed, exiting\n");
-          stop();
-        }
-        code = GST_FLOW_ERROR;
-        goto ret;
-      }
-      pkt_len = 0;
+  TRACE2(sample_done, map.size, code);
+  g_mutex_unlock(&output_lock);
+  gst_buffer_unmap(buffer, &map);
+  gst_sample_unref(sample);
+
+  return code;
+}
+
+/*
+  In-tree TS muxer path: elementary stream samples from appsink_video / appsink_audio
+  are packetized straight into the SRT payload, bypassing mpegtsmux
+*/
+static int ts_mux_output(const uint8_t *data, int len, void *user_data) {
+  (void)user_data;
+  int nb = srt_send_payload(data, len);
+  return (nb == len) ? nb : -1;
+}
+
+static int ts_codec_from_caps(GstCaps *caps, TsMuxCodec *codec) {
+  if (caps == NULL) return -1;
+
+  const GstStructure *str = gst_caps_get_structure(caps, 0);
+  if (gst_structure_has_name(str, "video/x-h264")) {
+    *codec = TS_CODEC_H264;
+  } else if (gst_structure_has_name(str, "video/x-h265")) {
+    *codec = TS_CODEC_H265;
+  } else if (gst_structure_has_name(str, "audio/mpeg")) {
+    *codec = TS_CODEC_AAC;
+  } else if (gst_structure_has_name(str, "audio/x-opus")) {
+    *codec = TS_CODEC_OPUS;
+  } else {
+    return -1;
+  }
+  return 0;
+}
+
+static int ts_mux_ready(const Feed *fd) {
+  for (int i = 0; i < TS_INPUT_COUNT; i++) {
+    if (fd->ts_inputs[i].sink != NULL && fd->ts_inputs[i].stream < 0) return 0;
+  }
+  return 1;
+}
+
+static int64_t ts_running_time_90k(GstSegment *segment, GstClockTime ts) {
+  if (!GST_CLOCK_TIME_IS_VALID(ts)) return -1;
+  GstClockTime rt = gst_segment_to_running_time(segment, GST_FORMAT_TIME, ts);
+  if (!GST_CLOCK_TIME_IS_VALID(rt)) return -1;
+  return (int64_t)gst_util_uint64_scale(rt, 90000, GST_SECOND);
+}
+
+GstFlowReturn ts_mux_buf_cb(GstAppSink *sink, gpointer user_data) {
+  TsMuxInput *input = (TsMuxInput *)user_data;
+  Feed *fd = input->owner;
+  GstFlowReturn code = GST_FLOW_OK;
+
+  GstSample *sample = gst_app_sink_pull_sample(sink);
+  if (!sample) return GST_FLOW_ERROR;
+
+  GstBuffer *buffer = gst_sample_get_buffer(sample);
+  GstMapInfo map = {0};
+  int keyframe = !GST_BUFFER_FLAG_IS_SET(buffer, GST_BUFFER_FLAG_DELTA_UNIT);
+
+  g_mutex_lock(&output_lock);
+  if (!ts_mux_enabled || (fd != feed && fd != next_feed)) goto ret;
+
+  // Register the stream with the codec from its first sample. A swapped in
+  // pipeline carries on with the streams of the first one
+  if (input->stream < 0) {
+    TsMuxCodec codec;
+    int kind = input - fd->ts_inputs;
+    if (ts_codec_from_caps(gst_sample_get_caps(sample), &codec) != 0) {
+      fprintf(stderr, "Unsupported caps for the in-tree TS muxer\n");
+      code = GST_FLOW_NOT_NEGOTIATED;
+      goto ret;
     }
+    if (ts_streams[kind] < 0) {
+      ts_streams[kind] = ts_mux_add_stream(&ts_mux, codec);
+    } else if (ts_mux.streams[ts_streams[kind]].codec != codec) {
+      fprintf(stderr, "The %s codec differs from the current pipeline's\n",
+              kind == TS_INPUT_VIDEO ? "video" : "audio");
+      code = GST_FLOW_NOT_NEGOTIATED;
+      goto ret;
+    }
+    input->stream = ts_streams[kind];
+  }
 
-    sample_sz -= copy_sz;
-  } while(sample_sz);
+  // Drop samples until every input is known and video has reached a keyframe
+  if (!ts_mux_ready(fd)) goto ret;
+  if (input->waiting_key) {
+    if (!keyframe) goto ret;
+    input->waiting_key = 0;
+  }
 
-ret:
+  // A pipeline being swapped in takes over at that keyframe
+  if (fd != feed) {
+    if (input != &fd->ts_inputs[TS_INPUT_VIDEO]) goto ret;
+    feed_promote(fd);
+  }
+
+  // With the in-tree muxer, most of the packetization and SRT sends run on the
+  // active feed's video streaming thread
+  if (input == &fd->ts_inputs[TS_INPUT_VIDEO]) {
+    perf_counters_sample(&stream_counters, getms());
+  }
+
+  GstSegment *segment = gst_sample_get_segment(sample);
+  int64_t pts = ts_running_time_90k(segment, GST_BUFFER_PTS(buffer));
+  int64_t dts = ts_running_time_90k(segment, GST_BUFFER_DTS(buffer));
+  if (pts < 0) goto ret;
+
+  gst_buffer_map(buffer, &map, GST_MAP_READ);
+  int ret = ts_mux_write_frame(&ts_mux, input->stream, map.data, (int)map.size,
+                               pts, dts, keyframe);
   gst_buffer_unmap(buffer, &map);
+  if (ret == 0 && low_latency) ret = ts_mux_flush(&ts_mux);
+
+  if (ret != 0) {
+    srt_output_failed();
+    code = GST_FLOW_ERROR;
+  }
+
+ret:
+  g_mutex_unlock(&output_lock);
   gst_sample_unref(sample);
 
   return code;
 }
 
+// Connects the elementary stream appsinks of a feed, returns the number found
+static int ts_inputs_setup(Feed *fd) {
+  static const char *sink_names[TS_INPUT_COUNT] = {"appsink_video", "appsink_audio"};
+  int found = 0;
+
+  GstAppSinkCallbacks callbacks = {NULL, NULL, ts_mux_buf_cb};
+  for (int i = 0; i < TS_INPUT_COUNT; i++) {
+    TsMuxInput *input = &fd->ts_inputs[i];
+    input->owner = fd;
+    input->stream = -1;
+    input->waiting_key = (i == TS_INPUT_VIDEO);
+    input->sink = gst_bin_get_by_name(GST_BIN(fd->pipeline), sink_names[i]);
+    if (!GST_IS_ELEMENT(input->sink)) {
+      input->sink = NULL;
+      continue;
+    }
+    gst_app_sink_set_callbacks(GST_APP_SINK(input->sink), &callbacks, input, NULL);
+    found++;
+  }
+  return found;
+}
+
+static int ts_mux_setup(void) {
+  if (ts_mux_init(&ts_mux, srt_pkt_size, ts_mux_output, NULL) != 0) {
+    fprintf(stderr, "Failed to initialize the in-tree TS muxer\n");
+    return -1;
+  }
+
+  fprintf(stderr, "Using the in-tree MPEG-TS muxer\n");
+  return 0;
+}
+
+static void ts_mux_print_stats(void) {
+  for (int i = 0; i < ts_mux.n_streams; i++) {
+    TsMuxStream *s = &ts_mux.streams[i];
+    fprintf(stderr, "TS PID 0x%04x: %lu frames (%lu key), %lu packets, %lu bytes\n",
+            s->pid, (unsigned long)s->frames, (unsigned long)s->keyframes,
+            (unsigned long)s->packets, (unsigned long)s->bytes);
+  }
+  fprintf(stderr, "TS mux: %lu payloads, %lu PSI, %lu PCR, %lu stuffing bytes\n",
+          (unsigned long)ts_mux.payloads, (unsigned long)ts_mux.psi_count,
+          (unsigned long)ts_mux.pcr_count, (unsigned long)ts_mux.stuffing_bytes);
+}
+
+static void ts_mux_publish_stats(Stats *st) {
+  char name[STATS_NAME_LEN];
+
+  g_mutex_lock(&output_lock);
+  for (int i = 0; i < ts_mux.n_streams; i++) {
+    TsMuxStream *s = &ts_mux.streams[i];
+    snprintf(name, sizeof(name), "ceracoder_ts_frames_total{pid=\"%d\"}", s->pid);
+    stats_set(st, name, STATS_COUNTER, "Access units written by the TS muxer", s->frames);
+    snprintf(name, sizeof(name), "ceracoder_ts_packets_total{pid=\"%d\"}", s->pid);
+    stats_set(st, name, STATS_COUNTER, "TS packets written by the TS muxer", s->packets);
+  }
+  stats_set(st, "ceracoder_ts_payloads_total", STATS_COUNTER,
+            "SRT payloads written by the TS muxer", ts_mux.payloads);
+  g_mutex_unlock(&output_lock);
+}
+
+static void ts_index_publish_stats(Stats *st) {
+  g_mutex_lock(&ts_index_lock);
+  stats_set(st, "ceracoder_mpegts_packets_total", STATS_COUNTER,
+            "TS packets received from mpegtsmux", ts_index_stats.packets);
+  stats_set(st, "ceracoder_mpegts_null_packets_total", STATS_COUNTER,
+            "Null (PID 0x1fff) packets received from mpegtsmux", ts_index_stats.null_packets);
+  stats_set(st, "ceracoder_mpegts_sync_errors_total", STATS_COUNTER,
+            "TS packets from mpegtsmux with a bad sync byte", ts_index_stats.sync_errors);
+  g_mutex_unlock(&ts_index_lock);
+
+  g_mutex_lock(&output_lock);
+  stats_set(st, "ceracoder_ts_cc_restamped_total", STATS_COUNTER,
+            "TS packets with their continuity counter rewritten after a pipeline swap",
+            ts_cc.restamped);
+  g_mutex_unlock(&output_lock);
+}
+
+/*
+  Collects the runtime stats and writes them to the stats file, if configured
+*/
+gboolean stats_update(gpointer data) {
+  (void)data;
+  uint64_t ctime = getms();
+  Feed *fd = active_feed();
+
+  mux_monitor_update(&fd->mux_monitor, ctime, &runtime_stats);
+  video_tap_update(&fd->video_tap, &runtime_stats);
+  if (ts_mux_enabled) {
+    ts_mux_publish_stats(&runtime_stats);
+  } else {
+    ts_index_publish_stats(&runtime_stats);
+  }
+  encoder_control_publish_stats(&fd->encoder, &runtime_stats);
+  audio_control_publish_stats(&fd->audio, &runtime_stats);
+  g_mutex_lock(&balancer_lock);
+  balancer_telemetry_publish(&balancer_runner.telemetry, &runtime_stats);
+  if (content_cap_enabled) content_cap_publish(&content_cap, &runtime_stats);
+  g_mutex_unlock(&balancer_lock);
+  timer_monitor_update(&timer_monitor, ctime, &runtime_stats);
+  perf_counters_publish(&stream_counters, &runtime_stats);
+  perf_counters_publish(&control_counters, &runtime_stats);
+  stats_set(&runtime_stats, "ceracoder_av_delay_ms", STATS_GAUGE,
+            "Configured audio-video delay", av_delay);
+  if (latency_budget.valid) {
+    static const char *help = "Latency budget per stage";
+    if (latency_budget.encode_ms >= 0) {
+      stats_set(&runtime_stats, "ceracoder_latency_budget_ms{stage=\"encode\"}", STATS_GAUGE,
+                help, latency_budget.encode_ms);
+    }
+    stats_set(&runtime_stats, "ceracoder_latency_budget_ms{stage=\"pipeline\"}", STATS_GAUGE,
+              help, latency_budget.pipeline_ms);
+    stats_set(&runtime_stats, "ceracoder_latency_budget_ms{stage=\"srt\"}", STATS_GAUGE,
+              help, latency_budget.srt_ms);
+  }
+  stats_set(&runtime_stats, "ceracoder_low_latency", STATS_GAUGE,
+            "Low latency profile enabled", low_latency);
+  stats_set(&runtime_stats, "ceracoder_overlay_placement", STATS_GAUGE,
+            "Overlay placement (0 none, 1 source, 2 post-scale)", fd->overlay.placement);
+  stats_set(&runtime_stats, "ceracoder_pipeline_swaps_total", STATS_COUNTER,
+            "Pipeline hot-swaps completed", swaps_total);
+  stats_set(&runtime_stats, "ceracoder_capture_zero_copy", STATS_GAUGE,
+            "Captured frames reach the encoder without a copy",
+            active_feed()->zero_copy.path != ZERO_COPY_NONE);
+  if (slate_loaded) {
+    g_mutex_lock(&output_lock);
+    uint64_t slate_packets = slate.packets;
+    g_mutex_unlock(&output_lock);
+    stats_set(&runtime_stats, "ceracoder_slate_active", STATS_GAUGE,
+              "Sending the slate instead of the input", g_atomic_int_get(&slate_active));
+    stats_set(&runtime_stats, "ceracoder_slate_engaged_total", STATS_COUNTER,
+              "Input losses covered by the slate", slate_engaged_total);
+    stats_set(&runtime_stats, "ceracoder_slate_packets_total", STATS_COUNTER,
+              "TS packets sent from the slate", slate_packets);
+  }
+
+  if (g_config.stats_file[0] != '\0') {
+    static int write_failed = 0;
+    if (stats_write_file(&runtime_stats, g_config.stats_file) != 0) {
+      if (!write_failed) {
+        fprintf(stderr, "Failed to write the stats file %s\n", g_config.stats_file);
+      }
+      write_failed = 1;
+    } else {
+      write_failed = 0;
+    }
+  }
+
+  return TRUE;
+}
+
+/*
+  Supervisor watchdog: WATCHDOG=1 is only sent if SRT payloads went out since the
+  previous tick, so a wedged pipeline or a stuck SRT send is restarted by systemd
+  even though the main loop itself is still running
+*/
+gboolean notify_watchdog(gpointer data) {
+  (void)data;
+  static gint prev_sent = 0;
+
+  gint sent = g_atomic_int_get(&srt_payloads_sent);
+  if (!g_atomic_int_get(&notify_ready) || sent == prev_sent) return TRUE;
+  prev_sent = sent;
+
+  Feed *fd = active_feed();
+  if (encoder_control_available(&fd->encoder)) {
+    notify_send(&notifier, "WATCHDOG=1\nSTATUS=Streaming at %d Kbps",
+                fd->encoder.current_bitrate / 1000);
+  } else {
+    notify_send(&notifier, "WATCHDOG=1");
+  }
+
+  return TRUE;
+}
+
 static void cb_delay (GstElement *identity, GstBuffer *buffer, gpointer data) {
   buffer = gst_buffer_make_writable(buffer);
   GST_BUFFER_PTS (buffer) += GST_SECOND * abs(av_delay) / 1000;
@@ -367,24 +1115,22 @@ static int get_sink_framerate(GstElement *element, gint *numerator, gint *denomi
   return ret;
 }
 
-unsigned long pts = 0;
 static void cb_ptsfixup(GstElement *identity, GstBuffer *buffer, gpointer data) {
-  static long period = 0;
-  static long prev_pts = 0;
+  PtsFixup *fixup = (PtsFixup *)data;
   long input_pts = GST_BUFFER_PTS(buffer);
 
   // get rid of the DTS, the following elements should use the PTS
   GST_BUFFER_DTS(buffer) = 0;
 
   // First frame, obtain the framerate and initial PTS
-  if (pts == 0) {
+  if (fixup->pts == 0) {
     int fr_numerator = 0;
     int fr_denominator = 0;
     if (get_sink_framerate(identity, &fr_numerator, &fr_denominator) == 0) {
-      pts = input_pts;
-      period = GST_SECOND * fr_denominator / fr_numerator;
+      fixup->pts = input_pts;
+      fixup->period = GST_SECOND * fr_denominator / fr_numerator;
       fprintf(stderr, "%s: framerate: %d / %d, period is %ld\n",
-              __FUNCTION__, fr_numerator, fr_denominator, period);
+              __FUNCTION__, fr_numerator, fr_denominator, fixup->period);
     }
 
   // Subsequent frames, adjust the PTS
@@ -397,33 +1143,109 @@ static void cb_ptsfixup(GstElement *identity, GstBuffer *buffer, gpointer data)
        and even slight drifting over time due to temperature or voltage variation
        Have to add AVG_ROUNDING to avoid precision loss due to dividing by AVG_MULT
     */
-    period = ((period * AVG_PREV + AVG_ROUNDING) / AVG_MULT) +
-             (((input_pts - prev_pts) * AVG_WEIGHT + AVG_ROUNDING) / AVG_MULT);
+    fixup->period = ((fixup->period * AVG_PREV + AVG_ROUNDING) / AVG_MULT) +
+                    (((input_pts - fixup->prev_pts) * AVG_WEIGHT + AVG_ROUNDING) / AVG_MULT);
 
     /* As long as the input PTS is within 0 to 2.0 periods of the previous
        output PTS, assume that it was a continuous read at period ns from
        the previous frame and increment the PTS accordingly. Otherwise, handle
        the discontinuity by either dropping an input buffer or skipping an
        output period, as needed. */
-    long diff = (long)(input_pts - pts);
-    long incr = (diff/2 + period) / period * period;
+    long diff = (long)(input_pts - fixup->pts);
+    long incr = (diff/2 + fixup->period) / fixup->period * fixup->period;
     if (incr > 0) {
-      pts += incr;
+      fixup->pts += incr;
       debug("%s: in pts: %lu, out pts: %lu, incr %ld, diff %ld, period %ld\n",
-             __FUNCTION__, GST_BUFFER_PTS(buffer), pts, incr, diff, period);
-      GST_BUFFER_PTS(buffer) = pts;
+             __FUNCTION__, GST_BUFFER_PTS(buffer), fixup->pts, incr, diff, fixup->period);
+      GST_BUFFER_PTS(buffer) = fixup->pts;
+      TRACE3(pts_adjust, input_pts, fixup->pts, incr);
     } else {
       debug("skipping frame: pts %lu, prev pts %lu, output pts: %lu, diff %ld\n",
-             input_pts, prev_pts, pts, diff);
+             input_pts, fixup->prev_pts, fixup->pts, diff);
       GST_BUFFER_FLAG_SET(buffer, GST_BUFFER_FLAG_DROPPABLE);
+      TRACE3(pts_drop, input_pts, fixup->pts, diff);
     }
   }
 
-  prev_pts = input_pts;
+  fixup->prev_pts = input_pts;
 }
 
+/*
+  Per-stage latency budget, from the latency queries once the pipeline is playing.
+  The network adds half the RTT on top
+*/
+static void report_latency_budget(void) {
+  Feed *fd = active_feed();
+  GstClockTime min_lat, max_lat;
+  gboolean live;
+
+  latency_budget.encode_ms = -1;
+  if (fd->encoder.src_pad != NULL) {
+    GstQuery *query = gst_query_new_latency();
+    if (gst_pad_query(fd->encoder.src_pad, query)) {
+      gst_query_parse_latency(query, &live, &min_lat, &max_lat);
+      latency_budget.encode_ms = (int)(min_lat / GST_MSECOND);
+    }
+    gst_query_unref(query);
+  }
+
+  if (!gst_element_query_latency(GST_ELEMENT(fd->pipeline), &live, &min_lat, &max_lat)) {
+    fprintf(stderr, "Failed to query the pipeline latency\n");
+    return;
+  }
+  latency_budget.pipeline_ms = (int)(min_lat / GST_MSECOND);
+
+  int lag_ms, delay_ms;
+  mux_monitor_get_latency(&fd->mux_monitor, &lag_ms, &delay_ms, &latency_budget.mux_ms);
+  latency_budget.queue_ms = low_latency ? LOW_LATENCY_QUEUE_MS : -1;
+  latency_budget.srt_ms = balancer_runner.config.srt_latency;
+  latency_budget.valid = 1;
+
+  fprintf(stderr, "Latency budget%s:\n", low_latency ? " (low latency profile)" : "");
+  if (latency_budget.encode_ms >= 0) {
+    fprintf(stderr, "  capture + encode  %5d ms\n", latency_budget.encode_ms);
+  }
+  if (latency_budget.mux_ms >= 0) {
+    fprintf(stderr, "  mux               %5d ms\n", latency_budget.mux_ms);
+  }
+  fprintf(stderr, "  pipeline          %5d ms\n", latency_budget.pipeline_ms);
+  if (low_latency) {
+    fprintf(stderr, "  queues            <= %d ms each when backed up\n", LOW_LATENCY_QUEUE_MS);
+    fprintf(stderr, "  SRT packetizer        0 ms (flushed after each sample)\n");
+  } else {
+    fprintf(stderr, "  SRT packetizer    up to one sample\n");
+  }
+  fprintf(stderr, "  SRT latency       %5d ms\n", latency_budget.srt_ms);
+  fprintf(stderr, "  total             %5d ms + RTT / 2\n",
+          latency_budget.pipeline_ms + latency_budget.srt_ms);
+}
+
+// Forward declaration
+static void feed_abort_swap(const char *reason);
+
 void cb_pipeline (GstBus *bus, GstMessage *message, gpointer user_data) {
+  Feed *fd = (Feed *)user_data;
+
+  // Only the active pipeline stops ceracoder: a failing swap keeps the current
+  // one, and a replaced one is being torn down
+  if (fd != active_feed()) {
+    if (fd == pending_feed() && (GST_MESSAGE_TYPE(message) == GST_MESSAGE_ERROR ||
+                            GST_MESSAGE_TYPE(message) == GST_MESSAGE_EOS)) {
+      fprintf(stderr, "gstreamer %s from %s\n",
+              GST_MESSAGE_TYPE(message) == GST_MESSAGE_EOS ? "eos" : "error", message->src->name);
+      feed_abort_swap("pipeline error");
+    }
+    return;
+  }
+
   switch(GST_MESSAGE_TYPE(message)) {
+    case GST_MESSAGE_STATE_CHANGED:
+      if (GST_MESSAGE_SRC(message) == GST_OBJECT(fd->pipeline) && !latency_budget.valid) {
+        GstState new_state;
+        gst_message_parse_state_changed(message, NULL, &new_state, NULL);
+        if (new_state == GST_STATE_PLAYING) report_latency_budget();
+      }
+      break;
     case GST_MESSAGE_ERROR:
       fprintf(stderr, "gstreamer error from %s\n", message->src->name);
       stop();
@@ -437,6 +1259,474 @@ void cb_pipeline (GstBus *bus, GstMessage *message, gpointer user_data) {
   }
 }
 
+/*
+  Builds a feed from a pipeline file: the elements ceracoder controls, and the
+  SRT output (the mpegtsmux appsink or the in-tree muxer inputs). The caller
+  releases the feed on failure. Blocking probes only run at startup, before
+  the main loop
+*/
+static int feed_setup(Feed *fd, const char *pipeline_file, int startup) {
+  memset(fd, 0, sizeof(*fd));
+  snprintf(fd->name, sizeof(fd->name), "%s", pipeline_file);
+
+  if (pipeline_file_load(&fd->pfile, pipeline_file) != 0) return -1;
+  fd->pipeline = pipeline_create(&fd->pfile);
+  if (fd->pipeline == NULL) {
+    pipeline_file_unload(&fd->pfile);
+    return -1;
+  }
+
+  GstBus *bus = gst_pipeline_get_bus(fd->pipeline);
+  gst_bus_add_signal_watch(bus);
+  g_signal_connect(bus, "message", (GCallback)cb_pipeline, fd);
+  gst_object_unref(bus);
+
+  if (low_latency) {
+    int queues = pipeline_limit_queues(fd->pipeline, LOW_LATENCY_QUEUE_MS);
+    fprintf(stderr, "Low latency profile: %d queues limited to %d ms\n",
+            queues, LOW_LATENCY_QUEUE_MS);
+  }
+
+  // Initialize encoder control
+  EncoderPolicyConfig policy = encoder_policy_config(&g_config);
+  encoder_control_init(&fd->encoder, fd->pipeline, &policy);
+  if (low_latency) encoder_control_tune_low_latency(&fd->encoder);
+  if (encoder_control_available(&fd->encoder)) {
+    // Start where the balancer is (the slow start bitrate, or max, initially)
+    g_mutex_lock(&balancer_lock);
+    int bitrate = balancer_runner_get_bitrate(&balancer_runner);
+    g_mutex_unlock(&balancer_lock);
+    encoder_control_set_bitrate(&fd->encoder, bitrate);
+  }
+  if (audio_control_init(&fd->audio, fd->pipeline, g_config.audio.frame_size, low_latency) == 0) {
+    audio_control_configure(&fd->audio, config_bitrate_bps(g_config.audio.min_bitrate),
+                            g_config.audio.complexity);
+  }
+
+  // Initialize overlay, removed unless requested
+  if (overlay_ui_init(&fd->overlay, fd->pipeline) == 0) {
+    if (overlay_ui_place(&fd->overlay, fd->pipeline, g_config.overlay) != 0) return -1;
+    fprintf(stderr, "Overlay: %s\n", overlay_ui_placement_name(fd->overlay.placement));
+  }
+  overlay_ui_update(&fd->overlay, 0,0,0,0,0,0,0,0,0);
+
+  // DMABuf from the capture into the encoder, once the overlay is out of the way
+  if (g_config.zero_copy == ZERO_COPY_AUTO) {
+    zero_copy_setup(&fd->zero_copy, fd->pipeline, startup);
+    if (fd->zero_copy.path == ZERO_COPY_NONE) {
+      fprintf(stderr, "Zero-copy capture: none (%s)\n", fd->zero_copy.reason);
+    } else {
+      fprintf(stderr, "Zero-copy capture: %s\n", zero_copy_path_name(fd->zero_copy.path));
+    }
+  }
+
+  // Optional sound delay via identity element
+  fprintf(stderr, "A-V delay: %d ms\n", av_delay);
+  GstElement *identity_elem = gst_bin_get_by_name(GST_BIN(fd->pipeline),
+                                                   av_delay >= 0 ? "a_delay" : "v_delay");
+  if (GST_IS_ELEMENT(identity_elem)) {
+    g_object_set(G_OBJECT(identity_elem), "signal-handoffs", TRUE, NULL);
+    g_signal_connect(identity_elem, "handoff", G_CALLBACK(cb_delay), NULL);
+    gst_object_unref(identity_elem);
+  } else {
+    fprintf(stderr, "Failed to get a delay element from the pipeline, not applying a delay\n");
+  }
+
+  // Optional video PTS interval fixup
+  identity_elem = gst_bin_get_by_name(GST_BIN(fd->pipeline), "ptsfixup");
+  if (GST_IS_ELEMENT(identity_elem)) {
+    g_object_set(G_OBJECT(identity_elem), "signal-handoffs", TRUE, NULL);
+    g_signal_connect(identity_elem, "handoff", G_CALLBACK(cb_ptsfixup), &fd->ptsfixup);
+    gst_object_unref(identity_elem);
+  } else {
+    fprintf(stderr, "Failed to get a ptsfixup element from the pipeline, "
+                    "not removing PTS jitter\n");
+  }
+
+  // Optional mux interleave monitoring and latency trimming
+  if (mux_monitor_init(&fd->mux_monitor, fd->pipeline, g_config.mux.auto_latency,
+                       g_config.mux.latency_margin) == 0) {
+    fprintf(stderr, "Monitoring the mux interleave latency%s\n",
+            fd->mux_monitor.auto_latency ? ", auto-trimming the mux latency" : "");
+  }
+
+  // Optional scene cut / motion detection for the balancer
+  if (g_config.scene_detect && video_tap_init(&fd->video_tap, fd->pipeline) == 0) {
+    fprintf(stderr, "Scene detection on the raw video (%s)\n", scene_detect_impl());
+  }
+
+  // SRT output via appsink, or via the in-tree TS muxer
+  GstAppSinkCallbacks callbacks = {NULL, NULL, new_buf_cb};
+  fd->appsink = gst_bin_get_by_name(GST_BIN(fd->pipeline), "appsink");
+  if (GST_IS_ELEMENT(fd->appsink)) {
+    gst_app_sink_set_callbacks(GST_APP_SINK(fd->appsink), &callbacks, fd, NULL);
+  } else {
+    fd->appsink = NULL;
+    ts_inputs_setup(fd);
+  }
+
+  return 0;
+}
+
+static int feed_has_output(const Feed *fd) {
+  if (fd->appsink != NULL) return 1;
+  for (int i = 0; i < TS_INPUT_COUNT; i++) {
+    if (fd->ts_inputs[i].sink != NULL) return 1;
+  }
+  return 0;
+}
+
+// Same kind of SRT output, so the receiver sees the same streams after a swap
+static int feed_same_output(const Feed *a, const Feed *b) {
+  if ((a->appsink != NULL) != (b->appsink != NULL)) return 0;
+  for (int i = 0; i < TS_INPUT_COUNT; i++) {
+    if ((a->ts_inputs[i].sink != NULL) != (b->ts_inputs[i].sink != NULL)) return 0;
+  }
+  return 1;
+}
+
+// Releases a feed whose pipeline is in the NULL state
+static void feed_release(Feed *fd) {
+  if (fd->pipeline == NULL) return;
+
+  GstBus *bus = gst_pipeline_get_bus(fd->pipeline);
+  gst_bus_remove_signal_watch(bus);
+  gst_object_unref(bus);
+
+  mux_monitor_cleanup(&fd->mux_monitor);
+  video_tap_cleanup(&fd->video_tap);
+  encoder_control_cleanup(&fd->encoder);
+  audio_control_cleanup(&fd->audio);
+  g_clear_object(&fd->overlay.element);
+  g_clear_object(&fd->appsink);
+  for (int i = 0; i < TS_INPUT_COUNT; i++) {
+    g_clear_object(&fd->ts_inputs[i].sink);
+  }
+  gst_object_unref(fd->pipeline);
+  fd->pipeline = NULL;
+  pipeline_file_unload(&fd->pfile);
+}
+
+static void feed_stop(Feed *fd) {
+  if (fd->pipeline == NULL) return;
+  gst_element_set_state(GST_ELEMENT(fd->pipeline), GST_STATE_NULL);
+  feed_release(fd);
+}
+
+static gboolean feed_swap_timeout(gpointer data);
+
+/*
+  Starts a feed on the clock and base time of the one it replaces, so its
+  timestamps (and the PTS / PCR sent) carry on from the current ones
+*/
+static GstStateChangeReturn feed_play(Feed *fd) {
+  if (swap_clock != NULL) gst_pipeline_use_clock(fd->pipeline, swap_clock);
+  gst_element_set_start_time(GST_ELEMENT(fd->pipeline), GST_CLOCK_TIME_NONE);
+  gst_element_set_base_time(GST_ELEMENT(fd->pipeline), swap_base_time);
+  return gst_element_set_state(GST_ELEMENT(fd->pipeline), GST_STATE_PLAYING);
+}
+
+static void feed_swap_start(void) {
+  swap_timeout_id = g_timeout_add(SWAP_KEYFRAME_TIMEOUT, feed_swap_timeout, NULL);
+  if (feed_play(pending_feed()) == GST_STATE_CHANGE_FAILURE) {
+    feed_abort_swap("failed to start");
+  }
+}
+
+static void feed_swap_finish(void) {
+  swap_held = NULL;
+  g_clear_object(&swap_clock);
+}
+
+/*
+  Stopping a pipeline waits for its streaming threads and can take a while
+  (e.g. a capture device closing), so a replaced or failed feed is stopped on
+  a thread of its own and released on the main loop afterwards. A feed held
+  for a swap is only stopped: the new pipeline is started once its devices
+  are free, and if that one fails the held feed is restarted instead
+*/
+static gboolean feed_teardown_done(gpointer data) {
+  Feed *fd = (Feed *)data;
+  g_thread_join(teardown_thread);
+  teardown_thread = NULL;
+  teardown_feed = NULL;
+
+  if (fd == swap_held) {
+    feed_swap_start();
+    return G_SOURCE_REMOVE;
+  }
+  feed_release(fd);
+
+  if (swap_held != NULL) {
+    Feed *held = swap_held;
+    feed_swap_finish();
+    fprintf(stderr, "Restarting the pipeline %s\n", held->name);
+    if (feed_play(held) == GST_STATE_CHANGE_FAILURE) {
+      fprintf(stderr, "Failed to restart the pipeline %s, exiting\n", held->name);
+      stop();
+    }
+  }
+  return G_SOURCE_REMOVE;
+}
+
+static gpointer feed_teardown_run(gpointer data) {
+  Feed *fd = (Feed *)data;
+  gst_element_set_state(GST_ELEMENT(fd->pipeline), GST_STATE_NULL);
+  g_idle_add(feed_teardown_done, fd);
+  return NULL;
+}
+
+static void feed_teardown(Feed *fd) {
+  teardown_feed = fd;
+  teardown_thread = g_thread_new("teardown", feed_teardown_run, fd);
+}
+
+static gboolean feed_swap_done(gpointer data) {
+  Feed *old = (Feed *)data;
+  Feed *fd = active_feed();
+
+  if (swap_timeout_id != 0) {
+    g_source_remove(swap_timeout_id);
+    swap_timeout_id = 0;
+  }
+  swaps_total++;
+  stall_prev_pos = -1;
+  fprintf(stderr, "Switched to the pipeline %s\n", fd->name);
+  notify_send(&notifier, "STATUS=Switched to the pipeline %s", fd->name);
+  latency_budget.valid = 0;
+  report_latency_budget();
+
+  // A held feed is already stopped
+  if (old == swap_held) {
+    feed_release(old);
+  } else {
+    feed_teardown(old);
+  }
+  feed_swap_finish();
+  return G_SOURCE_REMOVE;
+}
+
+// Called with output_lock held, on the streaming thread of next_feed
+static void feed_promote(Feed *fd) {
+  Feed *old = feed;
+
+  g_mutex_lock(&feed_lock);
+  g_atomic_pointer_set(&feed, fd);
+  next_feed = NULL;
+  g_mutex_unlock(&feed_lock);
+
+  // The in-tree muxer keeps its counters, the new mpegtsmux starts its own
+  if (ts_mux_enabled) {
+    ts_mux.psi_pending = 1;
+  } else {
+    ts_cc_new_source(&ts_cc);
+  }
+
+  g_idle_add(feed_swap_done, old);
+}
+
+static void feed_abort_swap(const char *reason) {
+  g_mutex_lock(&output_lock);
+  g_mutex_lock(&feed_lock);
+  Feed *fd = next_feed;
+  next_feed = NULL;
+  g_mutex_unlock(&feed_lock);
+  g_mutex_unlock(&output_lock);
+
+  // Already switched over
+  if (fd == NULL) return;
+
+  if (swap_timeout_id != 0) {
+    g_source_remove(swap_timeout_id);
+    swap_timeout_id = 0;
+  }
+  fprintf(stderr, "Failed to switch to the pipeline %s: %s, keeping %s\n",
+          fd->name, reason, active_feed()->name);
+  notify_send(&notifier, "STATUS=Pipeline swap failed: %s", reason);
+  feed_teardown(fd);
+  if (swap_held == NULL) feed_swap_finish();
+}
+
+static gboolean feed_swap_timeout(gpointer data) {
+  (void)data;
+  swap_timeout_id = 0;
+  feed_abort_swap("no keyframe");
+  return G_SOURCE_REMOVE;
+}
+
+static int slate_engage(uint64_t now);
+
+/*
+  Pipeline hot-swap: the new pipeline runs on the clock and base time of the
+  current one. Its output is dropped until its first keyframe, where the
+  streaming thread switches the SRT output over; the current pipeline is then
+  torn down. The SRT connection and the balancer are left alone.
+
+  Both can't run at once when they capture from the same device (the new one
+  would find it busy), or with stop_first, so the current pipeline is then
+  stopped first, with the slate (if loaded) covering the gap until the new
+  one's first keyframe
+*/
+static void feed_swap(const char *pipeline_file, int stop_first) {
+  Feed *cur = active_feed();
+
+  if (pending_feed() != NULL || teardown_feed != NULL) {
+    fprintf(stderr, "Not switching to the pipeline %s: a swap is in progress\n", pipeline_file);
+    return;
+  }
+
+  fprintf(stderr, "Switching to the pipeline %s\n", pipeline_file);
+  Feed *fd = (cur == &feeds[0]) ? &feeds[1] : &feeds[0];
+  if (feed_setup(fd, pipeline_file, 0) != 0) {
+    feed_release(fd);
+    fprintf(stderr, "Failed to switch to the pipeline %s\n", pipeline_file);
+    return;
+  }
+  if (!feed_same_output(fd, cur)) {
+    feed_release(fd);
+    fprintf(stderr, "Not switching to the pipeline %s: its output differs from the current one\n",
+            pipeline_file);
+    return;
+  }
+
+  swap_clock = gst_pipeline_get_clock(cur->pipeline);
+  swap_base_time = gst_element_get_base_time(GST_ELEMENT(cur->pipeline));
+
+  g_mutex_lock(&output_lock);
+  g_mutex_lock(&feed_lock);
+  next_feed = fd;
+  g_mutex_unlock(&feed_lock);
+  g_mutex_unlock(&output_lock);
+
+  if (!stop_first && !pipeline_shares_device(fd->pipeline, cur->pipeline)) {
+    feed_swap_start();
+    return;
+  }
+
+  fprintf(stderr, "The pipeline %s uses a capture device of %s, stopping %s first\n",
+          pipeline_file, cur->name, cur->name);
+  if (slate_loaded && !g_atomic_int_get(&slate_active) && slate_engage(getms()) == 0) {
+    fprintf(stderr, "Sending the slate during the swap\n");
+  }
+  swap_held = cur;
+  feed_teardown(cur);
+}
+
+// Commands from the control FIFO, on the main loop
+static gboolean control_fifo_cb(gint fd, GIOCondition condition, gpointer user_data) {
+  (void)fd;
+  (void)condition;
+  (void)user_data;
+  ControlCmd cmds[4];
+  int n;
+
+  // Commands past the array stay buffered, they may already be out of the FIFO
+  do {
+    n = control_fifo_read(&control_fifo, cmds, 4);
+    if (n < 0) {
+      fprintf(stderr, "Failed to read the control FIFO %s, closing it\n", control_fifo.path);
+      control_fifo_close(&control_fifo);
+      return G_SOURCE_REMOVE;
+    }
+    for (int i = 0; i < n; i++) {
+      switch (cmds[i].type) {
+        case CONTROL_CMD_SWAP:
+          feed_swap(cmds[i].arg, 0);
+          break;
+      }
+    }
+  } while (n == 4);
+  return G_SOURCE_CONTINUE;
+}
+
+/*
+  Slate failover: the slate is sent once the input has been lost for
+  slate_timeout ms, and until the pipeline outputs a keyframe again. While on
+  the slate the pipeline is also rebuilt from the same file every
+  SLATE_RESTART_INT, in case the capture doesn't come back by itself: the
+  stalled pipeline is stopped first so that its devices are free
+*/
+static gboolean slate_send(gpointer data) {
+  (void)data;
+  static uint8_t buf[SLATE_BATCH_PKTS * TS_INDEX_PKT_SIZE];
+
+  g_mutex_lock(&output_lock);
+  if (!g_atomic_int_get(&slate_active)) {
+    g_mutex_unlock(&output_lock);
+    slate_send_id = 0;
+    return G_SOURCE_REMOVE;
+  }
+
+  uint64_t now = slate_start_pcr + (getms() - slate_started_ms) * (TS_PCR_HZ / 1000);
+  int n, new_loop, ret = 0;
+  while (ret == 0 && (n = ts_slate_read(&slate, now, buf, SLATE_BATCH_PKTS, &new_loop)) > 0) {
+    if (new_loop) ts_cc_new_source(&ts_cc);
+    if (ts_index_build(&ts_index, buf, n * TS_INDEX_PKT_SIZE) >= 0) {
+      ts_cc_process(&ts_cc, &ts_index, buf);
+    }
+    ret = srt_output_write(buf, n * TS_INDEX_PKT_SIZE, low_latency);
+  }
+  g_mutex_unlock(&output_lock);
+
+  if (ret != 0) {
+    srt_output_failed();
+    slate_send_id = 0;
+    return G_SOURCE_REMOVE;
+  }
+  return G_SOURCE_CONTINUE;
+}
+
+// Returns 0 once the slate is being sent
+static int slate_engage(uint64_t now) {
+  g_mutex_lock(&output_lock);
+  // Nothing to carry on from
+  if (live_pcr_ms == 0) {
+    g_mutex_unlock(&output_lock);
+    return -1;
+  }
+  slate_start_pcr = live_pcr + (now - live_pcr_ms) * (TS_PCR_HZ / 1000);
+  slate_started_ms = now;
+  ts_slate_start(&slate, slate_start_pcr);
+  g_atomic_int_set(&slate_active, 1);
+  int ret = srt_output_write(NULL, 0, 1);
+  g_mutex_unlock(&output_lock);
+
+  if (ret != 0) {
+    srt_output_failed();
+    return -1;
+  }
+
+  slate_engaged_total++;
+  slate_restart_ms = now;
+  if (slate_send_id == 0) {
+    slate_send_id = g_timeout_add(SLATE_SEND_INT, slate_send, NULL);
+  }
+  return 0;
+}
+
+static gboolean slate_check(gpointer data) {
+  (void)data;
+  uint64_t now = getms();
+  Feed *fd = active_feed();
+
+  if (g_atomic_int_get(&slate_active)) {
+    if (now - slate_restart_ms >= SLATE_RESTART_INT) {
+      slate_restart_ms = now;
+      feed_swap(fd->name, 1);
+    }
+    return TRUE;
+  }
+
+  uint64_t last = input_last_ms(fd);
+  if (last != 0 && now - last >= (uint64_t)MAX(g_config.slate_timeout, SLATE_CHECK_INT)) {
+    if (slate_engage(now) == 0) {
+      fprintf(stderr, "No input for %d ms, sending the slate\n", g_config.slate_timeout);
+      notify_send(&notifier, "STATUS=Input lost, sending the slate");
+    }
+  }
+  return TRUE;
+}
+
 // Only called if the pipeline failed to stop
 void cb_sigalarm(int signum) {
   _exit(EXIT_SUCCESS); // exiting deliberately following SIGINT or SIGTERM
@@ -445,34 +1735,22 @@ void cb_sigalarm(int signum) {
 #define FIXED_ARGS 3
 int main(int argc, char** argv) {
   CliOptions opts;
-  PipelineFile pfile;
-  
+
   // Parse command-line options
   cli_options_parse(&opts, argc, argv);
 
+  // Optional readiness / liveness notifications for systemd or another supervisor
+  if (notify_init(&notifier) == 0) {
+    fprintf(stderr, "Sending supervisor notifications, watchdog interval %d ms\n",
+            notifier.watchdog_interval);
+  }
+
   // Set global state from options
   av_delay = opts.av_delay;
   srt_pkt_size = opts.reduced_pkt_size ? REDUCED_SRT_PKT_SIZE : DEFAULT_SRT_PKT_SIZE;
   config_filename = opts.config_file;
   bitrate_filename = opts.bitrate_file;
 
-  // Load pipeline file
-  if (pipeline_file_load(&pfile, opts.pipeline_file) != 0) {
-    exit(EXIT_FAILURE);
-  }
-
-  // Initialize GStreamer and create pipeline
-  gst_init(&argc, &argv);
-  gst_pipeline = pipeline_create(&pfile);
-  if (gst_pipeline == NULL) {
-    pipeline_file_unload(&pfile);
-    return -1;
-  }
-
-  GstBus *bus = gst_pipeline_get_bus(GST_PIPELINE(gst_pipeline));
-  gst_bus_add_signal_watch(bus);
-  g_signal_connect(bus, "message", (GCallback)cb_pipeline, gst_pipeline);
-
   // Initialize configuration with defaults
   config_init_defaults(&g_config);
 
@@ -499,62 +1777,98 @@ int main(int argc, char** argv) {
     }
   }
 
+  // Low latency profile (-L or config), before the SRT latency is resolved
+  if (opts.low_latency) g_config.low_latency = 1;
+  if (g_config.low_latency) {
+    config_apply_low_latency(&g_config);
+    low_latency = 1;
+  }
+
+  // Initialize GStreamer
+  gst_init(&argc, &argv);
+
   // Determine SRT latency (CLI -l takes precedence over config)
   int srt_latency = (opts.srt_latency != 2000) ? opts.srt_latency : 
                     (g_config.srt_latency > 0 ? g_config.srt_latency : 2000);
 
+  // Lateness / runtime stats of the periodic timers
+  timer_monitor_init(&timer_monitor, g_config.timer_warn_ms);
+
+  PerfMode perf_mode = g_config.perf_counters ? PERF_MODE_AUTO : PERF_MODE_OFF;
+  perf_counters_init(&stream_counters, "streaming", perf_mode);
+  perf_counters_init(&control_counters, "control", perf_mode);
+
   // Initialize balancer
   if (balancer_runner_init(&balancer_runner, &g_config, opts.balancer_name, 
                            srt_latency, srt_pkt_size) != 0) {
     exit(EXIT_FAILURE);
   }
+  content_cap_init(&content_cap);
+  content_cap_enabled = g_config.scene_detect && g_config.content_cap;
+
+  if (g_config.live_stats[0] != '\0') {
+    if (live_stats_create(&live_stats, g_config.live_stats,
+                          balancer_runner_get_name(&balancer_runner), srt_latency) != 0) {
+      fprintf(stderr, "Failed to create the live stats feed %s: %s\n",
+              g_config.live_stats, strerror(errno));
+    }
+  }
   signal(SIGHUP, sighup_handler);
 
-  // Initialize encoder control
-  encoder_control_init(&encoder_ctrl, gst_pipeline);
-  if (encoder_control_available(&encoder_ctrl)) {
-    // Start at max bitrate
-    encoder_control_set_bitrate(&encoder_ctrl, config_bitrate_bps(g_config.max_bitrate));
+  // Overlay mode (-O overrides the config)
+  if (opts.overlay != NULL &&
+      config_set_value(&g_config, "general", "overlay", opts.overlay) != 0) {
+    exit(EXIT_FAILURE);
   }
 
-  // Initialize overlay
-  overlay_ui_init(&overlay_ui, gst_pipeline);
-  overlay_ui_update(&overlay_ui, 0,0,0,0,0,0,0,0,0);
+  // Create the pipeline and hook up the elements ceracoder controls
+  stats_init(&runtime_stats);
+  ts_cc_init(&ts_cc);
+  if (feed_setup(feed, opts.pipeline_file, 1) != 0) {
+    exit(EXIT_FAILURE);
+  }
 
-  // Optional sound delay via identity element
-  fprintf(stderr, "A-V delay: %d ms\n", av_delay);
-  GstElement *identity_elem = gst_bin_get_by_name(GST_BIN(gst_pipeline), 
-                                                   av_delay >= 0 ? "a_delay" : "v_delay");
-  if (GST_IS_ELEMENT(identity_elem)) {
-    g_object_set(G_OBJECT(identity_elem), "signal-handoffs", TRUE, NULL);
-    g_signal_connect(identity_elem, "handoff", G_CALLBACK(cb_delay), NULL);
-  } else {
-    fprintf(stderr, "Failed to get a delay element from the pipeline, not applying a delay\n");
+  // Setup SRT streaming via appsink, or via the in-tree TS muxer
+  if (feed->appsink == NULL && feed_has_output(feed) && ts_mux_setup() == 0) {
+    ts_mux_enabled = 1;
+  }
+  int srt_output = feed->appsink != NULL || ts_mux_enabled;
+
+  // Slate sent while the input is lost, in place of the mpegtsmux output
+  if (srt_output && g_config.slate[0] != '\0') {
+    if (feed->appsink == NULL) {
+      fprintf(stderr, "The slate needs a pipeline ending in an appsink, not using it\n");
+    } else if (ts_slate_load(&slate, g_config.slate) == 0) {
+      slate_loaded = 1;
+      fprintf(stderr, "Slate: %s (%.1f s loop), after %d ms without input\n", g_config.slate,
+              (double)slate.duration / TS_PCR_HZ, g_config.slate_timeout);
+    }
   }
 
-  // Optional video PTS interval fixup
-  identity_elem = gst_bin_get_by_name(GST_BIN(gst_pipeline), "ptsfixup");
-  if (GST_IS_ELEMENT(identity_elem)) {
-    g_object_set(G_OBJECT(identity_elem), "signal-handoffs", TRUE, NULL);
-    g_signal_connect(identity_elem, "handoff", G_CALLBACK(cb_ptsfixup), NULL);
-  } else {
-    fprintf(stderr, "Failed to get a ptsfixup element from the pipeline, "
-                    "not removing PTS jitter\n");
+  // Runtime commands, e.g. pipeline swaps
+  if (srt_output && g_config.control_fifo[0] != '\0') {
+    if (control_fifo_open(&control_fifo, g_config.control_fifo) == 0) {
+      g_unix_fd_add(control_fifo.fd, G_IO_IN, control_fifo_cb, NULL);
+      fprintf(stderr, "Reading commands from %s\n", control_fifo.path);
+    } else {
+      fprintf(stderr, "Failed to open the control FIFO %s: %s\n",
+              g_config.control_fifo, strerror(errno));
+    }
   }
 
-  // Setup SRT streaming via appsink
-  GstAppSinkCallbacks callbacks = {NULL, NULL, new_buf_cb};
-  GstElement *srt_app_sink = gst_bin_get_by_name(GST_BIN(gst_pipeline), "appsink");
-  if (GST_IS_ELEMENT(srt_app_sink)) {
-    gst_app_sink_set_callbacks(GST_APP_SINK(srt_app_sink), &callbacks, NULL, NULL);
-    
+  if (srt_output) {
     // Initialize SRT and connect
     srt_client_init();
+    notify_send(&notifier, "STATUS=Connecting to %s:%s", opts.srt_host, opts.srt_port);
     
     int ret_srt;
+    int attempt = 0;
     do {
+      TRACE1(srt_connect_start, attempt);
       ret_srt = srt_client_connect(&srt_client, opts.srt_host, opts.srt_port,
                                     opts.stream_id, srt_latency, srt_pkt_size);
+      TRACE2(srt_connect_done, attempt, ret_srt);
+      attempt++;
       if (ret_srt != 0) {
         char *reason = NULL;
         switch (ret_srt) {
@@ -581,15 +1895,29 @@ int main(int argc, char** argv) {
             break;
         }
         fprintf(stderr, "Failed to establish an SRT connection: %s. Retrying...\n", reason);
+        notify_send(&notifier, "STATUS=SRT connection failed: %s, retrying", reason);
         struct timespec retry_delay = { .tv_sec = 0, .tv_nsec = 500L * 1000L * 1000L };
         nanosleep(&retry_delay, NULL);
       }
     } while(ret_srt != 0);
   }
 
-  // Monitor connection when using appsink
-  if (GST_IS_ELEMENT(srt_app_sink)) {
-    g_timeout_add(BITRATE_UPDATE_INT, connection_housekeeping, NULL);
+  // Monitor connection when streaming over SRT; the balancer tick runs on its own thread
+  if (srt_output) {
+    if (control_thread_start(&control_thread) != 0) {
+      fprintf(stderr, "Failed to start the control thread\n");
+      exit(EXIT_FAILURE);
+    }
+    timer_monitor_add(&timer_monitor, control_thread.context, "housekeeping",
+                      BITRATE_UPDATE_INT, G_PRIORITY_HIGH, connection_housekeeping, NULL);
+    if (notify_enabled(&notifier)) {
+      timer_monitor_add(&timer_monitor, NULL, "watchdog", notifier.watchdog_interval,
+                        G_PRIORITY_DEFAULT, notify_watchdog, NULL);
+    }
+    if (slate_loaded) {
+      timer_monitor_add(&timer_monitor, NULL, "slate", SLATE_CHECK_INT, G_PRIORITY_DEFAULT,
+                        slate_check, NULL);
+    }
   }
 
   // Setup main loop
@@ -597,18 +1925,40 @@ int main(int argc, char** argv) {
   g_unix_signal_add(SIGTERM, stop_from_signal, NULL);
   g_unix_signal_add(SIGINT, stop_from_signal, NULL);
   signal(SIGALRM, cb_sigalarm);
-  g_timeout_add(1000, stall_check, NULL);
+  timer_monitor_add(&timer_monitor, NULL, "stall_check", 1000, G_PRIORITY_DEFAULT,
+                    stall_check, NULL);
+  timer_monitor_add(&timer_monitor, NULL, "stats", STATS_UPDATE_INT, G_PRIORITY_DEFAULT,
+                    stats_update, NULL);
 
   // Start pipeline
-  gst_element_set_state((GstElement*)gst_pipeline, GST_STATE_PLAYING);
+  gst_element_set_state((GstElement*)feed->pipeline, GST_STATE_PLAYING);
   g_main_loop_run(loop);
 
   // Cleanup
+  control_thread_stop(&control_thread);
   srt_client_close(&srt_client);
-  gst_element_set_state((GstElement*)gst_pipeline, GST_STATE_NULL);
+  control_fifo_close(&control_fifo);
+  if (teardown_thread != NULL) {
+    g_thread_join(teardown_thread);
+    feed_release(teardown_feed);
+  }
+  if (next_feed != NULL) feed_stop(next_feed);
+  feed_stop(feed);
+  if (ts_mux_enabled) {
+    ts_mux_print_stats();
+    ts_mux_cleanup(&ts_mux);
+  }
+  ts_index_cleanup(&ts_index);
+  ts_slate_cleanup(&slate);
   srt_client_cleanup();
   balancer_runner_cleanup(&balancer_runner);
-  pipeline_file_unload(&pfile);
+  notify_cleanup(&notifier);
+  timer_monitor_cleanup(&timer_monitor);
+  perf_counters_report(&stream_counters);
+  perf_counters_report(&control_counters);
+  perf_counters_cleanup(&stream_counters);
+  perf_counters_cleanup(&control_counters);
+  live_stats_close(&live_stats);
 
   return 0;
 }
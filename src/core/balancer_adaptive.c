@@ -58,6 +58,12 @@ static void* adaptive_init(const BalancerConfig *config) {
                          config->adaptive_decr_step,
                          config->adaptive_incr_interval,
                          config->adaptive_decr_interval);
+    state->ctx.loss_classify = config->adaptive_loss_classify;
+    state->ctx.rtt_change_detect = config->adaptive_rtt_change_detect;
+
+    slow_start_init(&state->ctx.slow_start, config->slow_start, config->start_bitrate,
+                    config->min_bitrate, config->max_bitrate);
+    state->ctx.cur_bitrate = state->ctx.slow_start.bitrate;
 
     return state;
 }
@@ -71,6 +77,8 @@ static BalancerOutput adaptive_step(void *state_ptr, const BalancerInput *input)
 
     // Use existing bitrate_update with a temporary BitrateResult
     BitrateResult result;
+    bitrate_scene_hint(&state->ctx, input->scene_cut, input->motion, input->timestamp);
+    bitrate_set_ceiling(&state->ctx, input->ceiling);
     int new_bitrate = bitrate_update(&state->ctx,
                                      input->buffer_size,
                                      input->rtt,
@@ -90,10 +98,23 @@ static BalancerOutput adaptive_step(void *state_ptr, const BalancerInput *input)
     output.bs_th1 = result.bs_th1;
     output.bs_th2 = result.bs_th2;
     output.bs_th3 = result.bs_th3;
+    output.reason = result.reason;
+    output.state = result.state;
+    output.loss_congestive = result.loss_congestive;
+    output.loss_random = result.loss_random;
+    output.rtt_change = result.rtt_change;
 
     return output;
 }
 
+/*
+ * Current bitrate, rounded like the step output
+ */
+static int adaptive_get_bitrate(void *state_ptr) {
+    AdaptiveState *state = (AdaptiveState *)state_ptr;
+    return state->ctx.cur_bitrate / (100 * 1000) * (100 * 1000);
+}
+
 /*
  * Clean up adaptive balancer state
  */
@@ -110,4 +131,5 @@ const BalancerAlgorithm balancer_adaptive = {
     .init = adaptive_init,
     .step = adaptive_step,
     .cleanup = adaptive_cleanup,
+    .get_bitrate = adaptive_get_bitrate,
 };
@@ -29,6 +29,7 @@
  */
 
 #include "balancer.h"
+#include "slow_start.h"
 #include <stdlib.h>
 #include <glib.h>  // for MIN/MAX
 
@@ -64,6 +65,13 @@ typedef struct {
     // Timing
     uint64_t next_incr;
     uint64_t next_decr;
+    uint64_t scene_drain_until;
+
+    // Static scene ceiling, see BalancerInput.ceiling
+    int ceiling_from;
+
+    // Startup ramp
+    SlowStart slow_start;
 } AimdState;
 
 /*
@@ -77,7 +85,9 @@ static void* aimd_init(const BalancerConfig *config) {
 
     state->min_bitrate = config->min_bitrate;
     state->max_bitrate = config->max_bitrate;
-    state->cur_bitrate = config->max_bitrate;  // Start optimistic
+    slow_start_init(&state->slow_start, config->slow_start, config->start_bitrate,
+                    config->min_bitrate, config->max_bitrate);
+    state->cur_bitrate = state->slow_start.bitrate;  // max_bitrate without slow start
     state->srt_latency = config->srt_latency;
 
     // Tuning parameters (use defaults if 0)
@@ -93,6 +103,8 @@ static void* aimd_init(const BalancerConfig *config) {
     state->rtt_baseline = 0.0;
     state->next_incr = 0;
     state->next_decr = 0;
+    state->scene_drain_until = 0;
+    state->ceiling_from = 0;
 
     return state;
 }
@@ -115,34 +127,90 @@ static BalancerOutput aimd_step(void *state_ptr, const BalancerInput *input) {
                               (input->rtt * (1.0 - AIMD_RTT_BASELINE_EMA));
     }
 
+    // Hold increases while a scene cut's burst goes out
+    if (input->scene_cut) {
+        state->next_incr = MAX(state->next_incr, input->timestamp + BALANCER_SCENE_HOLD);
+        state->scene_drain_until = input->timestamp + BALANCER_SCENE_HOLD;
+    }
+    int scene_drain = input->timestamp <= state->scene_drain_until;
+
     // Detect congestion
     int congested = 0;
     int rtt_threshold = (int)(state->rtt_baseline * AIMD_RTT_MULT);
+    int rtt_congested = input->rtt > rtt_threshold;
+    BalancerState cong_state = BALANCER_STATE_STABLE;
+    BalancerReason reason = BALANCER_REASON_HOLD;
 
     // Emergency: RTT exceeds latency/3
     if (input->rtt >= state->srt_latency / 3) {
         state->cur_bitrate = state->min_bitrate;
         state->next_decr = input->timestamp + state->decr_interval;
         congested = 1;
+        cong_state = BALANCER_STATE_EMERGENCY;
+        reason = BALANCER_REASON_EMERGENCY_RTT;
+        state->slow_start.active = 0;
     }
     // Congestion: RTT exceeds threshold or buffer too full
-    else if (input->rtt > rtt_threshold || input->buffer_size > AIMD_BS_THRESHOLD) {
+    else if (rtt_congested || input->buffer_size > AIMD_BS_THRESHOLD) {
         congested = 1;
+        cong_state = BALANCER_STATE_HEAVY;
     }
 
-    if (congested && input->timestamp > state->next_decr) {
+    // Effective maximum under a static scene ceiling
+    int max_bitrate = state->max_bitrate;
+    if (input->ceiling > 0 && input->ceiling < max_bitrate) {
+        max_bitrate = MAX(input->ceiling, state->min_bitrate);
+    }
+    if (congested) {
+        state->ceiling_from = 0;
+    }
+    int prev_bitrate = state->cur_bitrate;
+
+    if (state->slow_start.active) {
+        // Startup ramp until the first congestion signal
+        state->cur_bitrate = slow_start_step(&state->slow_start, congested, input->rtt,
+                                             input->timestamp, max_bitrate);
+        reason = BALANCER_REASON_SLOW_START;
+        if (!state->slow_start.active) {
+            state->next_incr = input->timestamp + state->incr_interval;
+        }
+
+    } else if (congested && (input->timestamp > state->next_decr || scene_drain)) {
         // Multiplicative decrease
         state->cur_bitrate = (int)(state->cur_bitrate * state->decr_mult);
         state->next_decr = input->timestamp + state->decr_interval;
+        state->scene_drain_until = 0;
+        if (reason == BALANCER_REASON_HOLD) {
+            reason = rtt_congested ? BALANCER_REASON_HEAVY_RTT : BALANCER_REASON_HEAVY_BUFFER;
+        }
+
+    } else if (state->ceiling_from > state->cur_bitrate && state->cur_bitrate < max_bitrate &&
+               !scene_drain) {
+        // Ceiling lifted (or raised): back to where the link had been
+        state->cur_bitrate = MIN(state->ceiling_from, max_bitrate);
+        if (state->ceiling_from <= max_bitrate) state->ceiling_from = 0;
+        state->next_incr = input->timestamp + state->incr_interval;
+        reason = BALANCER_REASON_INCREASE;
 
     } else if (!congested && input->timestamp > state->next_incr) {
         // Additive increase
-        state->cur_bitrate += state->incr_step;
+        state->cur_bitrate += input->motion >= BALANCER_MOTION_HIGH ?
+                              state->incr_step / 2 : state->incr_step;
         state->next_incr = input->timestamp + state->incr_interval;
+        reason = BALANCER_REASON_INCREASE;
+    }
+
+    // Lowered by the ceiling rather than by the link
+    if (state->cur_bitrate > max_bitrate && prev_bitrate > max_bitrate &&
+        (reason == BALANCER_REASON_HOLD || reason == BALANCER_REASON_INCREASE)) {
+        if (!congested) {
+            state->ceiling_from = MAX(state->ceiling_from, prev_bitrate);
+        }
+        reason = BALANCER_REASON_CONTENT_CAP;
     }
 
     // Clamp to valid range
-    state->cur_bitrate = MAX(state->min_bitrate, MIN(state->max_bitrate, state->cur_bitrate));
+    state->cur_bitrate = MAX(state->min_bitrate, MIN(max_bitrate, state->cur_bitrate));
 
     // Round to 100 kbps
     int rounded_br = state->cur_bitrate / (100 * 1000) * (100 * 1000);
@@ -156,12 +224,22 @@ static BalancerOutput aimd_step(void *state_ptr, const BalancerInput *input) {
         .bs = input->buffer_size,
         .bs_th1 = AIMD_BS_THRESHOLD,
         .bs_th2 = AIMD_BS_THRESHOLD,
-        .bs_th3 = AIMD_BS_THRESHOLD
+        .bs_th3 = AIMD_BS_THRESHOLD,
+        .reason = reason,
+        .state = cong_state
     };
 
     return output;
 }
 
+/*
+ * Current bitrate, rounded like the step output
+ */
+static int aimd_get_bitrate(void *state_ptr) {
+    AimdState *state = (AimdState *)state_ptr;
+    return state->cur_bitrate / (100 * 1000) * (100 * 1000);
+}
+
 /*
  * Clean up AIMD balancer state
  */
@@ -178,4 +256,5 @@ const BalancerAlgorithm balancer_aimd = {
     .init = aimd_init,
     .step = aimd_step,
     .cleanup = aimd_cleanup,
+    .get_bitrate = aimd_get_bitrate,
 };
@@ -71,12 +71,21 @@ static BalancerOutput fixed_step(void *state_ptr, const BalancerInput *input) {
         .bs = input->buffer_size,
         .bs_th1 = 0,
         .bs_th2 = 0,
-        .bs_th3 = 0
+        .bs_th3 = 0,
+        .reason = BALANCER_REASON_FIXED,
+        .state = BALANCER_STATE_STABLE
     };
 
     return output;
 }
 
+/*
+ * The fixed bitrate
+ */
+static int fixed_get_bitrate(void *state_ptr) {
+    return ((FixedState *)state_ptr)->fixed_bitrate;
+}
+
 /*
  * Clean up fixed balancer state
  */
@@ -93,4 +102,5 @@ const BalancerAlgorithm balancer_fixed = {
     .init = fixed_init,
     .step = fixed_step,
     .cleanup = fixed_cleanup,
+    .get_bitrate = fixed_get_bitrate,
 };
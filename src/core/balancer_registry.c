@@ -85,3 +85,38 @@ void balancer_print_available(void) {
                 algorithms[i]->description);
     }
 }
+
+/*
+ * Reason and state names, used as stats labels
+ */
+static const char* const reason_names[BALANCER_REASON_COUNT] = {
+    [BALANCER_REASON_HOLD] = "hold",
+    [BALANCER_REASON_FIXED] = "fixed",
+    [BALANCER_REASON_INCREASE] = "increase",
+    [BALANCER_REASON_LIGHT_RTT] = "light_rtt",
+    [BALANCER_REASON_LIGHT_BUFFER] = "light_buffer",
+    [BALANCER_REASON_HEAVY_RTT] = "heavy_rtt",
+    [BALANCER_REASON_HEAVY_BUFFER] = "heavy_buffer",
+    [BALANCER_REASON_HEAVY_LOSS] = "heavy_loss",
+    [BALANCER_REASON_EMERGENCY_RTT] = "emergency_rtt",
+    [BALANCER_REASON_EMERGENCY_BUFFER] = "emergency_buffer",
+    [BALANCER_REASON_SLOW_START] = "slow_start",
+    [BALANCER_REASON_CONTENT_CAP] = "content_cap",
+};
+
+static const char* const state_names[BALANCER_STATE_COUNT] = {
+    [BALANCER_STATE_STABLE] = "stable",
+    [BALANCER_STATE_LIGHT] = "light",
+    [BALANCER_STATE_HEAVY] = "heavy",
+    [BALANCER_STATE_EMERGENCY] = "emergency",
+};
+
+const char* balancer_reason_name(BalancerReason reason) {
+    if ((int)reason < 0 || reason >= BALANCER_REASON_COUNT) return "unknown";
+    return reason_names[reason];
+}
+
+const char* balancer_state_name(BalancerState state) {
+    if ((int)state < 0 || state >= BALANCER_STATE_COUNT) return "unknown";
+    return state_names[state];
+}
@@ -21,10 +21,12 @@
 #include <stdio.h>
 #include <stdlib.h>
 
-int balancer_runner_init(BalancerRunner *runner, const BelacoderConfig *cfg,
-                         const char *algo_name_override, int srt_latency, int srt_pkt_size) {
+static int runner_init(BalancerRunner *runner, const BelacoderConfig *cfg,
+                       const char *algo_name_override, int srt_latency, int srt_pkt_size,
+                       int quiet) {
     runner->algo = NULL;
     runner->state = NULL;
+    balancer_telemetry_init(&runner->telemetry);
 
     // Select algorithm (CLI override takes precedence)
     const char *algo_name = algo_name_override ? algo_name_override : cfg->balancer;
@@ -33,14 +35,16 @@ int balancer_runner_init(BalancerRunner *runner, const BelacoderConfig *cfg,
     if (runner->algo == NULL) {
         // Try default if config had invalid name
         if (algo_name_override != NULL) {
-            fprintf(stderr, "Unknown balancer algorithm: %s\n\n", algo_name_override);
-            balancer_print_available();
+            if (!quiet) {
+                fprintf(stderr, "Unknown balancer algorithm: %s\n\n", algo_name_override);
+                balancer_print_available();
+            }
             return -1;
         }
         runner->algo = balancer_get_default();
     }
 
-    fprintf(stderr, "Balancer: %s\n", runner->algo->name);
+    if (!quiet) fprintf(stderr, "Balancer: %s\n", runner->algo->name);
 
     // Initialize balancer config
     runner->config.min_bitrate = config_bitrate_bps(cfg->min_bitrate);
@@ -48,11 +52,17 @@ int balancer_runner_init(BalancerRunner *runner, const BelacoderConfig *cfg,
     runner->config.srt_latency = srt_latency;
     runner->config.srt_pkt_size = srt_pkt_size;
 
+    // Startup policy
+    runner->config.slow_start = cfg->slow_start;
+    runner->config.start_bitrate = config_bitrate_bps(cfg->start_bitrate);
+
     // Adaptive algorithm tuning
     runner->config.adaptive_incr_step = config_bitrate_bps(cfg->adaptive.incr_step);
     runner->config.adaptive_decr_step = config_bitrate_bps(cfg->adaptive.decr_step);
     runner->config.adaptive_incr_interval = cfg->adaptive.incr_interval;
     runner->config.adaptive_decr_interval = cfg->adaptive.decr_interval;
+    runner->config.adaptive_loss_classify = cfg->adaptive.loss_classify;
+    runner->config.adaptive_rtt_change_detect = cfg->adaptive.rtt_change_detect;
 
     // AIMD algorithm tuning
     runner->config.aimd_incr_step = config_bitrate_bps(cfg->aimd.incr_step);
@@ -63,31 +73,55 @@ int balancer_runner_init(BalancerRunner *runner, const BelacoderConfig *cfg,
     // Initialize the algorithm
     runner->state = runner->algo->init(&runner->config);
     if (runner->state == NULL) {
-        fprintf(stderr, "Failed to initialize balancer algorithm\n");
+        if (!quiet) fprintf(stderr, "Failed to initialize balancer algorithm\n");
         return -2;
     }
 
+    if (quiet) return 0;
     fprintf(stderr, "Bitrate range: %d - %d Kbps\n",
             runner->config.min_bitrate / 1000, runner->config.max_bitrate / 1000);
+    if (balancer_runner_get_bitrate(runner) < runner->config.max_bitrate) {
+        fprintf(stderr, "Slow start from %d Kbps\n", balancer_runner_get_bitrate(runner) / 1000);
+    }
 
     return 0;
 }
 
+int balancer_runner_init(BalancerRunner *runner, const BelacoderConfig *cfg,
+                         const char *algo_name_override, int srt_latency, int srt_pkt_size) {
+    return runner_init(runner, cfg, algo_name_override, srt_latency, srt_pkt_size, 0);
+}
+
+int balancer_runner_init_quiet(BalancerRunner *runner, const BelacoderConfig *cfg,
+                               const char *algo_name_override, int srt_latency, int srt_pkt_size) {
+    return runner_init(runner, cfg, algo_name_override, srt_latency, srt_pkt_size, 1);
+}
+
 BalancerOutput balancer_runner_step(BalancerRunner *runner, const BalancerInput *input) {
-    return runner->algo->step(runner->state, input);
+    BalancerOutput output = runner->algo->step(runner->state, input);
+    balancer_telemetry_update(&runner->telemetry, &output, input->timestamp);
+    return output;
 }
 
 void balancer_runner_update_bounds(BalancerRunner *runner, int min_bitrate, int max_bitrate) {
     runner->config.min_bitrate = min_bitrate;
     runner->config.max_bitrate = max_bitrate;
 
-    // Reinitialize algorithm with new config (loses accumulated state)
+    // Reinitialize algorithm with new config (loses accumulated state). With
+    // slow start, ramp on from the current bitrate rather than restarting
     if (runner->algo != NULL && runner->state != NULL) {
+        BalancerConfig config = runner->config;
+        config.start_bitrate = runner->algo->get_bitrate(runner->state);
         runner->algo->cleanup(runner->state);
-        runner->state = runner->algo->init(&runner->config);
+        runner->state = runner->algo->init(&config);
     }
 }
 
+int balancer_runner_get_bitrate(const BalancerRunner *runner) {
+    if (runner->algo == NULL || runner->state == NULL) return 0;
+    return runner->algo->get_bitrate(runner->state);
+}
+
 const char* balancer_runner_get_name(const BalancerRunner *runner) {
     return runner->algo ? runner->algo->name : "none";
 }
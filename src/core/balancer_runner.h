@@ -23,6 +23,7 @@
 #include "balancer.h"
 #include "config.h"
 #include <stdint.h>
+#include "balancer_telemetry.h"
 
 /*
  * Balancer runner module - orchestrates balancer algorithm execution
@@ -35,6 +36,7 @@ typedef struct {
     const BalancerAlgorithm *algo;
     void *state;
     BalancerConfig config;
+    BalancerTelemetry telemetry;  // Kept across config reloads
 } BalancerRunner;
 
 /*
@@ -45,6 +47,13 @@ typedef struct {
 int balancer_runner_init(BalancerRunner *runner, const BelacoderConfig *cfg,
                          const char *algo_name_override, int srt_latency, int srt_pkt_size);
 
+/*
+ * Same as balancer_runner_init, without printing the selection and errors
+ * to stderr (for libceracoder-core, whose host owns stderr)
+ */
+int balancer_runner_init_quiet(BalancerRunner *runner, const BelacoderConfig *cfg,
+                               const char *algo_name_override, int srt_latency, int srt_pkt_size);
+
 /*
  * Update bitrate based on network statistics
  *
@@ -58,6 +67,11 @@ BalancerOutput balancer_runner_step(BalancerRunner *runner, const BalancerInput
  */
 void balancer_runner_update_bounds(BalancerRunner *runner, int min_bitrate, int max_bitrate);
 
+/*
+ * Get the current bitrate (bps), also before the first step
+ */
+int balancer_runner_get_bitrate(const BalancerRunner *runner);
+
 /*
  * Get current algorithm name
  */
@@ -0,0 +1,141 @@
+/*
+    ceracoder - live video encoder with dynamic bitrate control
+    Copyright (C) 2020 BELABOX project
+    Copyright (C) 2026 CERALIVE
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "balancer_telemetry.h"
+#include <stdio.h>
+#include <string.h>
+
+const double balancer_telemetry_bounds[BALANCER_TELEMETRY_BUCKETS] = {
+    0.1, 0.25, 0.5, 1, 2.5, 5, 10, 30, 60
+};
+
+void balancer_telemetry_init(BalancerTelemetry *t) {
+    memset(t, 0, sizeof(*t));
+    t->state = BALANCER_STATE_STABLE;
+}
+
+static void end_episode(BalancerTelemetry *t, uint64_t timestamp) {
+    uint64_t dur_ms = timestamp - t->state_since;
+    int bucket = 0;
+    while (bucket < BALANCER_TELEMETRY_BUCKETS &&
+           (double)dur_ms > balancer_telemetry_bounds[bucket] * 1000.0) {
+        bucket++;
+    }
+    t->state_hist[t->state][bucket]++;
+    t->state_hist_sum_ms[t->state] += dur_ms;
+}
+
+void balancer_telemetry_update(BalancerTelemetry *t, const BalancerOutput *output,
+                               uint64_t timestamp) {
+    if ((int)output->reason >= 0 && output->reason < BALANCER_REASON_COUNT) {
+        t->reason_count[output->reason]++;
+    }
+
+    if (output->loss_congestive > 0) {
+        t->loss_congestive_pkts += output->loss_congestive;
+        t->loss_congestive_events++;
+    } else if (output->loss_random > 0) {
+        t->loss_random_events++;
+    }
+    if (output->loss_random > 0) {
+        t->loss_random_pkts += output->loss_random;
+    }
+    if (output->rtt_change > 0) {
+        t->rtt_changes_up++;
+    } else if (output->rtt_change < 0) {
+        t->rtt_changes_down++;
+    }
+
+    BalancerState state = output->state;
+    if ((int)state < 0 || state >= BALANCER_STATE_COUNT) {
+        state = BALANCER_STATE_STABLE;
+    }
+
+    // First update, or the clock went backwards: restart the current episode
+    if (!t->started || timestamp < t->prev_ts) {
+        t->started = 1;
+        t->state = state;
+        t->state_since = timestamp;
+        t->state_entries[state]++;
+        t->prev_ts = timestamp;
+        return;
+    }
+
+    // The time since the previous update is spent in the previous state
+    t->state_time_ms[t->state] += timestamp - t->prev_ts;
+    t->prev_ts = timestamp;
+
+    if (state != t->state) {
+        end_episode(t, timestamp);
+        t->state = state;
+        t->state_since = timestamp;
+        t->state_entries[state]++;
+    }
+}
+
+void balancer_telemetry_publish(const BalancerTelemetry *t, Stats *stats) {
+    char name[STATS_NAME_LEN];
+    char labels[48];
+
+    for (int i = 0; i < BALANCER_REASON_COUNT; i++) {
+        snprintf(name, sizeof(name), "ceracoder_balancer_decisions_total{reason=\"%s\"}",
+                 balancer_reason_name((BalancerReason)i));
+        stats_set(stats, name, STATS_COUNTER, "Balancer decisions by reason",
+                  (double)t->reason_count[i]);
+    }
+
+    for (int i = 0; i < BALANCER_STATE_COUNT; i++) {
+        const char *state = balancer_state_name((BalancerState)i);
+        snprintf(name, sizeof(name), "ceracoder_balancer_state_seconds_total{state=\"%s\"}", state);
+        stats_set(stats, name, STATS_COUNTER, "Time spent in each congestion state",
+                  (double)t->state_time_ms[i] / 1000.0);
+        snprintf(name, sizeof(name), "ceracoder_balancer_state_entries_total{state=\"%s\"}", state);
+        stats_set(stats, name, STATS_COUNTER, "Times each congestion state was entered",
+                  (double)t->state_entries[i]);
+    }
+
+    for (int i = 0; i < BALANCER_STATE_COUNT; i++) {
+        snprintf(labels, sizeof(labels), "state=\"%s\"", balancer_state_name((BalancerState)i));
+        stats_set_histogram(stats, "ceracoder_balancer_state_duration_seconds", labels,
+                            "Duration of completed congestion state episodes",
+                            balancer_telemetry_bounds, BALANCER_TELEMETRY_BUCKETS,
+                            t->state_hist[i], (double)t->state_hist_sum_ms[i] / 1000.0);
+    }
+
+    const char *classes[] = { "congestive", "random" };
+    const uint64_t pkts[] = { t->loss_congestive_pkts, t->loss_random_pkts };
+    const uint64_t events[] = { t->loss_congestive_events, t->loss_random_events };
+    for (int i = 0; i < 2; i++) {
+        snprintf(name, sizeof(name), "ceracoder_balancer_loss_packets_total{class=\"%s\"}", classes[i]);
+        stats_set(stats, name, STATS_COUNTER, "Lost and retransmitted packets by loss class",
+                  (double)pkts[i]);
+        snprintf(name, sizeof(name), "ceracoder_balancer_loss_events_total{class=\"%s\"}", classes[i]);
+        stats_set(stats, name, STATS_COUNTER, "Balancer updates with loss, by loss class",
+                  (double)events[i]);
+    }
+
+    stats_set(stats, "ceracoder_balancer_rtt_changes_total{direction=\"up\"}", STATS_COUNTER,
+              "RTT baseline re-sets after a path change", (double)t->rtt_changes_up);
+    stats_set(stats, "ceracoder_balancer_rtt_changes_total{direction=\"down\"}", STATS_COUNTER,
+              "RTT baseline re-sets after a path change", (double)t->rtt_changes_down);
+
+    stats_set(stats, "ceracoder_balancer_state", STATS_GAUGE,
+              "Current congestion state (0 stable, 1 light, 2 heavy, 3 emergency)",
+              (double)t->state);
+}
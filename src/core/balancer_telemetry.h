@@ -0,0 +1,81 @@
+/*
+    ceracoder - live video encoder with dynamic bitrate control
+    Copyright (C) 2020 BELABOX project
+    Copyright (C) 2026 CERALIVE
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef BALANCER_TELEMETRY_H
+#define BALANCER_TELEMETRY_H
+
+#include <stdint.h>
+#include "balancer.h"
+#include "stats.h"
+
+/*
+ * Balancer telemetry - decision reasons and congestion state over time
+ *
+ * Fed with every BalancerOutput, independent of the algorithm. Counts
+ * the decisions per reason, the time spent in each congestion state, and
+ * keeps a histogram of how long each congestion state lasted, plus the
+ * packet loss classified as congestive / random and the RTT path changes.
+ */
+
+#define BALANCER_TELEMETRY_BUCKETS 9
+
+typedef struct {
+    uint64_t reason_count[BALANCER_REASON_COUNT];
+    uint64_t state_time_ms[BALANCER_STATE_COUNT];
+    uint64_t state_entries[BALANCER_STATE_COUNT];
+    // Completed episodes per state, by duration (see balancer_telemetry_bounds)
+    uint64_t state_hist[BALANCER_STATE_COUNT][BALANCER_TELEMETRY_BUCKETS + 1];
+    uint64_t state_hist_sum_ms[BALANCER_STATE_COUNT];
+
+    // Loss classification (algorithms that classify loss)
+    uint64_t loss_congestive_pkts;
+    uint64_t loss_random_pkts;
+    uint64_t loss_congestive_events;    // Updates with congestive loss
+    uint64_t loss_random_events;        // Updates with random loss only
+
+    // RTT baseline re-set after path changes (adaptive)
+    uint64_t rtt_changes_up;
+    uint64_t rtt_changes_down;
+
+    BalancerState state;        // Current state
+    uint64_t state_since;       // Timestamp (ms) the current state was entered
+    uint64_t prev_ts;           // Timestamp (ms) of the previous update
+    int started;                // Set after the first update
+} BalancerTelemetry;
+
+// Upper bounds of the episode duration buckets (s)
+extern const double balancer_telemetry_bounds[BALANCER_TELEMETRY_BUCKETS];
+
+/*
+ * Reset all counters
+ */
+void balancer_telemetry_init(BalancerTelemetry *t);
+
+/*
+ * Account one balancer step at timestamp (ms)
+ */
+void balancer_telemetry_update(BalancerTelemetry *t, const BalancerOutput *output,
+                               uint64_t timestamp);
+
+/*
+ * Publish as ceracoder_balancer_* metrics
+ */
+void balancer_telemetry_publish(const BalancerTelemetry *t, Stats *stats);
+
+#endif /* BALANCER_TELEMETRY_H */
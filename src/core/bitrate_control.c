@@ -45,8 +45,9 @@ void bitrate_context_init(BitrateContext *ctx, int min_br, int max_br,
     ctx->decr_interval = (decr_interval > 0) ? decr_interval : BITRATE_DECR_INT;
     ctx->decr_fast_interval = BITRATE_DECR_FAST_INT;  // Not configurable yet
 
-    // Start at max bitrate
+    // Start at max bitrate, balancers opt into slow start after init
     ctx->cur_bitrate = max_br;
+    slow_start_init(&ctx->slow_start, 0, 0, min_br, max_br);
 
     // Buffer size tracking
     ctx->bs_avg = 0.0;
@@ -56,6 +57,7 @@ void bitrate_context_init(BitrateContext *ctx, int min_br, int max_br,
     // RTT tracking
     ctx->rtt_avg = 0.0;
     ctx->rtt_min = RTT_MIN_INITIAL;
+    windowed_min_init(&ctx->rtt_min_filter, RTT_MIN_WINDOW);
     ctx->rtt_jitter = 0.0;
     ctx->rtt_avg_delta = 0.0;
     ctx->prev_rtt = RTT_INITIAL;
@@ -68,9 +70,43 @@ void bitrate_context_init(BitrateContext *ctx, int min_br, int max_br,
     ctx->prev_pkt_retrans = 0;
     ctx->loss_rate = 0.0;
 
+    // Loss classification
+    ctx->loss_classify = 1;
+    ctx->congestive_loss_rate = 0.0;
+    ctx->delay_signal_until = 0;
+    ctx->loss_congestive = 0;
+    ctx->loss_random = 0;
+
+    // RTT change detection
+    ctx->rtt_change_detect = 1;
+    rtt_change_init(&ctx->rtt_change);
+    ctx->rtt_rebaselines = 0;
+
     // Timing
     ctx->next_bitrate_incr = 0;
     ctx->next_bitrate_decr = 0;
+
+    // Scene hints
+    ctx->scene_drain_until = 0;
+    ctx->motion = 0;
+    ctx->scene_cuts = 0;
+
+    // Static scene ceiling
+    ctx->ceiling = 0;
+    ctx->ceiling_from = 0;
+}
+
+void bitrate_scene_hint(BitrateContext *ctx, int scene_cut, int motion, uint64_t timestamp) {
+    ctx->motion = motion;
+    if (!scene_cut) return;
+
+    ctx->scene_cuts++;
+    ctx->scene_drain_until = timestamp + BALANCER_SCENE_HOLD;
+    ctx->next_bitrate_incr = max(ctx->next_bitrate_incr, timestamp + BALANCER_SCENE_HOLD);
+}
+
+void bitrate_set_ceiling(BitrateContext *ctx, int ceiling) {
+    ctx->ceiling = ceiling;
 }
 
 // Packet loss detection threshold
@@ -94,15 +130,8 @@ int bitrate_update(BitrateContext *ctx, int buffer_size, double rtt,
     ctx->prev_pkt_retrans = pkt_retrans_total;
 
     // Smooth the loss rate (packet losses per update interval)
-    if (loss_delta > 0 || retrans_delta > 0) {
-        double new_loss = (double)(loss_delta + retrans_delta);
-        ctx->loss_rate = ctx->loss_rate * EMA_LOSS + new_loss * EMA_LOSS_NEW;
-    } else {
-        ctx->loss_rate *= EMA_LOSS;  // Decay when no loss
-    }
-
-    // Flag for packet loss congestion
-    int pkt_loss_congestion = (ctx->loss_rate > LOSS_RATE_THRESHOLD);
+    int64_t lost = max(loss_delta, 0) + max(retrans_delta, 0);
+    ctx->loss_rate = ctx->loss_rate * EMA_LOSS + (double)lost * EMA_LOSS_NEW;
 
     /*
      * Send buffer size stats
@@ -117,6 +146,35 @@ int bitrate_update(BitrateContext *ctx, int buffer_size, double rtt,
         ctx->bs_jitter = (double)delta_bs;
     }
     ctx->prev_bs = bs;
+    // Light congestion threshold, also needed by the RTT change detection
+    int bs_th1 = max(BS_TH_MIN, ctx->bs_avg + ctx->bs_jitter * BS_TH1_JITTER_MULT);
+
+    /*
+     * RTT step changes
+     *
+     * A path change, e.g. a cellular handover, moves the RTT in a step that
+     * stays flat, and the queue-based thresholds below would take it for
+     * congestion (or block increases) until the averages catch up. Once
+     * the change detector confirms a step while the send buffer isn't
+     * growing and loss isn't congestive, re-baseline the RTT stats.
+     */
+    int rtt_change = 0;
+    if (ctx->rtt_change_detect && rtt_int != RTT_IGNORE_VALUE) {
+        if (bs > bs_th1 || ctx->congestive_loss_rate > LOSS_RATE_THRESHOLD) {
+            rtt_change_reset(&ctx->rtt_change);
+        } else {
+            rtt_change = rtt_change_update(&ctx->rtt_change, rtt, ctx->rtt_jitter);
+        }
+    }
+    if (rtt_change != 0) {
+        windowed_min_reset(&ctx->rtt_min_filter);
+        windowed_min_update(&ctx->rtt_min_filter, ctx->rtt_change.min, timestamp);
+        ctx->rtt_avg = ctx->rtt_change.level;
+        ctx->rtt_jitter = ctx->rtt_change.spread;
+        ctx->rtt_avg_delta = 0.0;
+        ctx->prev_rtt = rtt_int;
+        ctx->rtt_rebaselines++;
+    }
 
     /*
      * RTT stats
@@ -134,10 +192,10 @@ int bitrate_update(BitrateContext *ctx, int buffer_size, double rtt,
     ctx->prev_rtt = rtt_int;
 
     // Update the minimum RTT
-    ctx->rtt_min *= RTT_MIN_DRIFT;
-    if (rtt_int != RTT_IGNORE_VALUE && rtt < ctx->rtt_min && ctx->rtt_avg_delta < 1.0) {
-        ctx->rtt_min = rtt;
+    if (rtt_int != RTT_IGNORE_VALUE) {
+        windowed_min_update(&ctx->rtt_min_filter, rtt, timestamp);
     }
+    ctx->rtt_min = windowed_min_get(&ctx->rtt_min_filter, RTT_MIN_INITIAL);
 
     // Update the RTT jitter
     ctx->rtt_jitter *= EMA_SLOW;
@@ -157,49 +215,156 @@ int bitrate_update(BitrateContext *ctx, int buffer_size, double rtt,
     int bs_th3 = (ctx->bs_avg + ctx->bs_jitter) * BS_TH3_MULT;
     int bs_th2 = max(BS_TH_MIN, ctx->bs_avg + max(ctx->bs_jitter * BS_TH2_JITTER_MULT, ctx->bs_avg));
     bs_th2 = min(bs_th2, (int)RTT_TO_BS(ctx, ctx->srt_latency / 2));
-    int bs_th1 = max(BS_TH_MIN, ctx->bs_avg + ctx->bs_jitter * BS_TH1_JITTER_MULT);
     int rtt_th_max = ctx->rtt_avg + max(ctx->rtt_jitter * RTT_JITTER_MULT, ctx->rtt_avg * RTT_AVG_PERCENT / 100);
     int rtt_th_min = ctx->rtt_min + max(RTT_MIN_JITTER, ctx->rtt_jitter * 2);
 
     /*
-     * Bitrate decision logic
+     * Loss classification
      *
+     * Loss that comes with a growing queue (RTT above its threshold or rising,
+     * or the send buffer filling) is congestive. Loss without delay growth is
+     * random loss, e.g. on Wi-Fi or cellular links, which SRT's ARQ recovers
+     * within the latency budget, so reducing the bitrate only wastes bandwidth.
+     * Loss reports lag the queue build-up, so a delay signal keeps loss
+     * congestive for LOSS_DELAY_WINDOW.
+     */
+    if (rtt_int > rtt_th_max || ctx->rtt_avg_delta >= LOSS_RTT_RISING || bs > bs_th1) {
+        ctx->delay_signal_until = timestamp + LOSS_DELAY_WINDOW;
+    }
+    int loss_congestive = 0;
+    int loss_random = 0;
+    if (lost > 0) {
+        if (!ctx->loss_classify || timestamp <= ctx->delay_signal_until) {
+            loss_congestive = (int)lost;
+        } else {
+            loss_random = (int)lost;
+        }
+        ctx->loss_congestive += loss_congestive;
+        ctx->loss_random += loss_random;
+    }
+    ctx->congestive_loss_rate = ctx->congestive_loss_rate * EMA_LOSS +
+                                (double)loss_congestive * EMA_LOSS_NEW;
+
+    // Random loss is still acted on once ARQ can't keep up with it
+    double pkts_per_update = RTT_TO_BS(ctx, BITRATE_UPDATE_INT);
+    int random_loss_excessive = ctx->loss_rate > LOSS_RATE_THRESHOLD &&
+                                ctx->loss_rate > pkts_per_update * LOSS_RANDOM_MAX_RATIO;
+
+    // Flag for packet loss congestion
+    int pkt_loss_congestion = ctx->congestive_loss_rate > LOSS_RATE_THRESHOLD ||
+                              random_loss_excessive;
+
+    /*
      * Congestion signals (in priority order):
      * 1. Emergency: RTT >= latency/3 OR buffer > bs_th3
      * 2. Heavy: RTT > latency/5 OR buffer > bs_th2 OR packet loss
      * 3. Light: RTT > rtt_th_max OR buffer > bs_th1
      * 4. Stable: RTT < rtt_th_min AND RTT not rising AND no packet loss
      */
+    int emergency_rtt = rtt_int >= (ctx->srt_latency / 3);
+    int emergency_bs = bs > bs_th3;
+    int heavy_rtt = rtt_int > (ctx->srt_latency / 5);
+    int heavy_bs = bs > bs_th2;
+    int light_rtt = rtt_int > rtt_th_max;
+    int light_bs = bs > bs_th1;
+
+    BalancerState state = BALANCER_STATE_STABLE;
+    if (emergency_rtt || emergency_bs) {
+        state = BALANCER_STATE_EMERGENCY;
+    } else if (heavy_rtt || heavy_bs || pkt_loss_congestion) {
+        state = BALANCER_STATE_HEAVY;
+    } else if (light_rtt || light_bs) {
+        state = BALANCER_STATE_LIGHT;
+    }
+
+    /*
+     * Bitrate decision logic
+     */
     // Use int64_t for bitrate calculations to prevent overflow at high bitrates
     int64_t bitrate = ctx->cur_bitrate;
+    BalancerReason reason = BALANCER_REASON_HOLD;
+    int scene_drain = timestamp <= ctx->scene_drain_until;
 
-    if (bitrate > ctx->min_bitrate && (rtt_int >= (ctx->srt_latency / 3) || bs > bs_th3)) {
+    // Effective maximum under a static scene ceiling
+    int max_bitrate = ctx->max_bitrate;
+    if (ctx->ceiling > 0 && ctx->ceiling < max_bitrate) {
+        max_bitrate = max(ctx->ceiling, ctx->min_bitrate);
+    }
+    // The bitrate from before the ceiling is only trusted without congestion since
+    if (state != BALANCER_STATE_STABLE) {
+        ctx->ceiling_from = 0;
+    }
+
+    // An emergency during slow start is handled like any other emergency
+    if (state == BALANCER_STATE_EMERGENCY) {
+        ctx->slow_start.active = 0;
+    }
+
+    if (ctx->slow_start.active) {
+        // Startup ramp, other congestion signals end it at the last good bitrate.
+        // heavy_bs is left out: bs_th2 is capped by the throughput average,
+        // which lags far behind while the bitrate doubles
+        int congested = light_rtt || light_bs || heavy_rtt || pkt_loss_congestion;
+        bitrate = slow_start_step(&ctx->slow_start, congested, rtt, timestamp,
+                                  max_bitrate);
+        reason = BALANCER_REASON_SLOW_START;
+        if (!ctx->slow_start.active) {
+            ctx->next_bitrate_incr = timestamp + ctx->incr_interval;
+        }
+
+    } else if (bitrate > ctx->min_bitrate && (emergency_rtt || emergency_bs)) {
         // Emergency: drop to minimum
         bitrate = ctx->min_bitrate;
         ctx->next_bitrate_decr = timestamp + ctx->decr_interval;
+        reason = emergency_rtt ? BALANCER_REASON_EMERGENCY_RTT : BALANCER_REASON_EMERGENCY_BUFFER;
 
-    } else if (timestamp > ctx->next_bitrate_decr &&
-               (rtt_int > (ctx->srt_latency / 5) || bs > bs_th2 || pkt_loss_congestion)) {
+    } else if ((timestamp > ctx->next_bitrate_decr || scene_drain) &&
+               (heavy_rtt || heavy_bs || pkt_loss_congestion)) {
         // Heavy congestion: fast decrease (now includes packet loss)
         bitrate -= ctx->decr_step + bitrate / BITRATE_DECR_SCALE;
         ctx->next_bitrate_decr = timestamp + ctx->decr_fast_interval;
+        reason = heavy_rtt ? BALANCER_REASON_HEAVY_RTT :
+                 heavy_bs ? BALANCER_REASON_HEAVY_BUFFER : BALANCER_REASON_HEAVY_LOSS;
 
-    } else if (timestamp > ctx->next_bitrate_decr &&
-               (rtt_int > rtt_th_max || bs > bs_th1)) {
+    } else if ((timestamp > ctx->next_bitrate_decr || scene_drain) && (light_rtt || light_bs)) {
         // Light congestion: slow decrease
         bitrate -= ctx->decr_step;
         ctx->next_bitrate_decr = timestamp + ctx->decr_interval;
+        reason = light_rtt ? BALANCER_REASON_LIGHT_RTT : BALANCER_REASON_LIGHT_BUFFER;
+
+    } else if (ctx->ceiling_from > bitrate && bitrate < max_bitrate && !scene_drain) {
+        // Ceiling lifted (or raised): back to where the link had been, after a scene cut's hold
+        bitrate = min(ctx->ceiling_from, max_bitrate);
+        if (ctx->ceiling_from <= max_bitrate) ctx->ceiling_from = 0;
+        ctx->next_bitrate_incr = timestamp + ctx->incr_interval;
+        reason = BALANCER_REASON_INCREASE;
 
     } else if (timestamp > ctx->next_bitrate_incr &&
                rtt_int < rtt_th_min && ctx->rtt_avg_delta < RTT_STABLE_DELTA &&
                !pkt_loss_congestion) {
-        // Stable: increase (only if no packet loss)
-        bitrate += ctx->incr_step + bitrate / BITRATE_INCR_SCALE;
+        // Stable: increase (only if no packet loss), by less with high motion
+        int64_t step = ctx->incr_step + bitrate / BITRATE_INCR_SCALE;
+        bitrate += ctx->motion >= BALANCER_MOTION_HIGH ? step / 2 : step;
         ctx->next_bitrate_incr = timestamp + ctx->incr_interval;
+        reason = BALANCER_REASON_INCREASE;
+    }
+
+    // One drain step per scene cut
+    if (scene_drain && bitrate < ctx->cur_bitrate) {
+        ctx->scene_drain_until = 0;
+    }
+
+    // Lowered by the ceiling rather than by the link
+    if (bitrate > max_bitrate && ctx->cur_bitrate > max_bitrate &&
+        (reason == BALANCER_REASON_HOLD || reason == BALANCER_REASON_INCREASE)) {
+        if (state == BALANCER_STATE_STABLE) {
+            ctx->ceiling_from = max(ctx->ceiling_from, ctx->cur_bitrate);
+        }
+        reason = BALANCER_REASON_CONTENT_CAP;
     }
 
     // Clamp to valid range
-    bitrate = min_max(bitrate, (int64_t)ctx->min_bitrate, (int64_t)ctx->max_bitrate);
+    bitrate = min_max(bitrate, (int64_t)ctx->min_bitrate, (int64_t)max_bitrate);
     ctx->cur_bitrate = (int)bitrate;
 
     // Round to 100 kbps
@@ -216,6 +381,11 @@ int bitrate_update(BitrateContext *ctx, int buffer_size, double rtt,
         result->bs_th1 = bs_th1;
         result->bs_th2 = bs_th2;
         result->bs_th3 = bs_th3;
+        result->reason = reason;
+        result->state = state;
+        result->loss_congestive = loss_congestive;
+        result->loss_random = loss_random;
+        result->rtt_change = rtt_change;
     }
 
     return rounded_br;
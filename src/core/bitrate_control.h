@@ -21,6 +21,9 @@
 #define BITRATE_CONTROL_H
 
 #include <stdint.h>
+#include "balancer.h"
+#include "slow_start.h"
+#include "rtt_filter.h"
 
 /*
  * Bitrate control constants
@@ -52,10 +55,14 @@
 #define EMA_THROUGHPUT_NEW 0.03   // complement (1 - 0.97)
 
 // RTT tracking constants
-#define RTT_MIN_DRIFT      1.001  // per-sample drift rate for min RTT tracking
 #define RTT_IGNORE_VALUE   100    // RTT value that indicates no valid measurement
 #define RTT_INITIAL        300    // initial prev_rtt value
-#define RTT_MIN_INITIAL    200.0  // initial rtt_min value
+#define RTT_MIN_INITIAL    200.0  // rtt_min until the first valid RTT sample
+
+// Loss classification
+#define LOSS_DELAY_WINDOW      500    // ms a queue build-up signal keeps loss classed as congestive
+#define LOSS_RTT_RISING        1.0    // rtt_avg_delta (ms per update) above which the RTT is rising
+#define LOSS_RANDOM_MAX_RATIO  0.15   // random loss above this ratio of sent packets still reduces
 
 // Threshold multipliers for congestion detection
 #define BS_TH3_MULT        4      // heavy congestion: (bs_avg + bs_jitter) * 4
@@ -87,6 +94,9 @@ typedef struct {
     // Current bitrate
     int cur_bitrate;
 
+    // Startup ramp (inactive unless enabled after bitrate_context_init)
+    SlowStart slow_start;
+
     // Buffer size tracking
     double bs_avg;
     double bs_jitter;
@@ -94,7 +104,8 @@ typedef struct {
 
     // RTT tracking
     double rtt_avg;
-    double rtt_min;
+    double rtt_min;             // Minimum RTT over RTT_MIN_WINDOW
+    WindowedMin rtt_min_filter;
     double rtt_jitter;
     double rtt_avg_delta;
     int prev_rtt;
@@ -107,9 +118,30 @@ typedef struct {
     int64_t prev_pkt_retrans;   // Previous retrans count (for delta)
     double loss_rate;           // Smoothed packet loss rate (packets/interval)
 
+    // Loss classification: only loss with queue build-up is congestive
+    int loss_classify;          // 0 = treat all loss as congestive
+    double congestive_loss_rate; // Smoothed congestive loss rate (packets/interval)
+    uint64_t delay_signal_until; // Loss until this timestamp is congestive
+    uint64_t loss_congestive;   // Lost + retransmitted packets classed as congestive
+    uint64_t loss_random;       // ... classed as random
+
+    // RTT step changes (path changes), see rtt_filter.h
+    int rtt_change_detect;      // 0 = disabled
+    RttChangeDetector rtt_change;
+    uint64_t rtt_rebaselines;
+
     // Timing for rate limiting bitrate changes
     uint64_t next_bitrate_incr;
     uint64_t next_bitrate_decr;
+
+    // Scene hints from the video, see BALANCER_SCENE_HOLD
+    uint64_t scene_drain_until; // One decrease before this timestamp skips the rate limit
+    int motion;                 // Video motion score (0-100)
+    uint64_t scene_cuts;
+
+    // Static scene ceiling, see BalancerInput.ceiling
+    int ceiling;                // 0 = none
+    int ceiling_from;           // Bitrate before the ceiling lowered it, 0 = none
 } BitrateContext;
 
 /*
@@ -125,6 +157,11 @@ typedef struct {
     int bs_th1;           // Buffer threshold 1 (light congestion)
     int bs_th2;           // Buffer threshold 2 (medium congestion)
     int bs_th3;           // Buffer threshold 3 (heavy congestion)
+    BalancerReason reason; // Decision branch taken
+    BalancerState state;  // Worst congestion signal
+    int loss_congestive;  // Packets lost / retransmitted this update, congestive
+    int loss_random;      // ... random
+    int rtt_change;       // +1 / -1: RTT baseline re-set after a step up / down
 } BitrateResult;
 
 /*
@@ -165,4 +202,19 @@ int bitrate_update(BitrateContext *ctx, int buffer_size, double rtt,
                    int64_t pkt_loss_total, int64_t pkt_retrans_total,
                    BitrateResult *result);
 
+/*
+ * Pass the scene detector's view of the video, before bitrate_update()
+ *
+ * Parameters:
+ *   scene_cut - A scene cut was seen since the last update (bool)
+ *   motion    - Motion score (0-100)
+ *   timestamp - Current timestamp in milliseconds
+ */
+void bitrate_scene_hint(BitrateContext *ctx, int scene_cut, int motion, uint64_t timestamp);
+
+/*
+ * Set the static scene ceiling (bps, 0 = none), before bitrate_update()
+ */
+void bitrate_set_ceiling(BitrateContext *ctx, int ceiling);
+
 #endif /* BITRATE_CONTROL_H */
@@ -0,0 +1,209 @@
+/*
+    ceracoder - live video encoder with dynamic bitrate control
+    Copyright (C) 2020 BELABOX project
+    Copyright (C) 2026 CERALIVE
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "ceracoder_core.h"
+#include "balancer_runner.h"
+#include "config.h"
+#include <stdlib.h>
+#include <string.h>
+
+struct CeracoderBalancer {
+    BelacoderConfig config;
+    char algorithm[32];         // Empty for the default
+    int srt_latency;
+    int srt_pkt_size;
+    BalancerRunner runner;
+    BalancerOutput output;      // Output of the last step
+
+    // Video hints for the next steps
+    int scene_cut;
+    int motion;
+    int ceiling;
+};
+
+// Bounds are kept in Kbps like the config file
+static int bps_to_kbps(int32_t bps) {
+    return (int)(((int64_t)bps + 500) / 1000);
+}
+
+// (Re)create the algorithm state from the stored config
+static int balancer_start(CeracoderBalancer *b) {
+    balancer_runner_cleanup(&b->runner);
+    memset(&b->output, 0, sizeof(b->output));
+    return balancer_runner_init_quiet(&b->runner, &b->config,
+                                      b->algorithm[0] ? b->algorithm : NULL,
+                                      b->srt_latency, b->srt_pkt_size);
+}
+
+uint32_t ceracoder_core_version(void) {
+    return ((uint32_t)CERACODER_CORE_VERSION_MAJOR << 16) | CERACODER_CORE_VERSION_MINOR;
+}
+
+int32_t ceracoder_balancer_algorithm_count(void) {
+    const BalancerAlgorithm* const* algos = balancer_list_all();
+    int32_t count = 0;
+    while (algos[count] != NULL) count++;
+    return count;
+}
+
+const char *ceracoder_balancer_algorithm_name(int32_t index) {
+    if (index < 0 || index >= ceracoder_balancer_algorithm_count()) return NULL;
+    return balancer_list_all()[index]->name;
+}
+
+CeracoderBalancer *ceracoder_balancer_new(const char *algorithm,
+                                          int32_t min_bitrate,
+                                          int32_t max_bitrate,
+                                          int32_t srt_latency,
+                                          int32_t srt_pkt_size) {
+    if (bps_to_kbps(min_bitrate) <= 0 || max_bitrate < min_bitrate) return NULL;
+    if (algorithm != NULL && strlen(algorithm) >= sizeof(((CeracoderBalancer *)0)->algorithm)) {
+        return NULL;
+    }
+
+    CeracoderBalancer *b = calloc(1, sizeof(*b));
+    if (b == NULL) return NULL;
+
+    config_init_defaults(&b->config);
+    b->config.min_bitrate = bps_to_kbps(min_bitrate);
+    b->config.max_bitrate = bps_to_kbps(max_bitrate);
+    if (algorithm != NULL) {
+        strcpy(b->algorithm, algorithm);
+    }
+    b->srt_latency = srt_latency;
+    b->srt_pkt_size = srt_pkt_size;
+
+    if (balancer_start(b) != 0) {
+        free(b);
+        return NULL;
+    }
+    return b;
+}
+
+int32_t ceracoder_balancer_set_option(CeracoderBalancer *balancer,
+                                      const char *section,
+                                      const char *key,
+                                      const char *value) {
+    // Bounds and the algorithm are fixed by the constructor / update_bounds
+    if (strcmp(section, "general") == 0 &&
+        strcmp(key, "slow_start") != 0 && strcmp(key, "start_bitrate") != 0) {
+        return -1;
+    }
+
+    BelacoderConfig prev = balancer->config;
+    if (config_set_value(&balancer->config, section, key, value) != 0) return -1;
+
+    if (balancer_start(balancer) != 0) {
+        balancer->config = prev;
+        balancer_start(balancer);
+        return -1;
+    }
+    return 0;
+}
+
+int32_t ceracoder_balancer_step(CeracoderBalancer *balancer,
+                                int32_t buffer_size,
+                                double rtt,
+                                double send_rate_mbps,
+                                uint64_t timestamp,
+                                int64_t pkt_loss_total,
+                                int64_t pkt_retrans_total) {
+    BalancerInput input = {
+        .buffer_size = buffer_size,
+        .rtt = rtt,
+        .send_rate_mbps = send_rate_mbps,
+        .timestamp = timestamp,
+        .pkt_loss_total = pkt_loss_total,
+        .pkt_retrans_total = pkt_retrans_total,
+        .scene_cut = balancer->scene_cut,
+        .motion = balancer->motion,
+        .ceiling = balancer->ceiling
+    };
+    balancer->output = balancer_runner_step(&balancer->runner, &input);
+    balancer->scene_cut = 0;
+    return balancer->output.new_bitrate;
+}
+
+void ceracoder_balancer_set_hints(CeracoderBalancer *balancer,
+                                  int32_t scene_cut,
+                                  int32_t motion,
+                                  int32_t ceiling) {
+    balancer->scene_cut = scene_cut != 0;
+    balancer->motion = motion < 0 ? 0 : (motion > 100 ? 100 : motion);
+    balancer->ceiling = ceiling > 0 ? ceiling : 0;
+}
+
+int32_t ceracoder_balancer_get_output(const CeracoderBalancer *balancer,
+                                      CeracoderBalancerOutput *output,
+                                      uint32_t size) {
+    const BalancerOutput *o = &balancer->output;
+    CeracoderBalancerOutput out = {
+        .throughput = o->throughput,
+        .new_bitrate = o->new_bitrate,
+        .rtt = o->rtt,
+        .rtt_th_min = o->rtt_th_min,
+        .rtt_th_max = o->rtt_th_max,
+        .bs = o->bs,
+        .bs_th1 = o->bs_th1,
+        .bs_th2 = o->bs_th2,
+        .bs_th3 = o->bs_th3,
+        .reason = o->reason,
+        .state = o->state,
+        .loss_congestive = o->loss_congestive,
+        .loss_random = o->loss_random,
+        .rtt_change = o->rtt_change
+    };
+
+    if (size > sizeof(out)) size = sizeof(out);
+    memcpy(output, &out, size);
+    return (int32_t)size;
+}
+
+int32_t ceracoder_balancer_get_bitrate(const CeracoderBalancer *balancer) {
+    return balancer_runner_get_bitrate(&balancer->runner);
+}
+
+void ceracoder_balancer_update_bounds(CeracoderBalancer *balancer,
+                                      int32_t min_bitrate,
+                                      int32_t max_bitrate) {
+    balancer->config.min_bitrate = bps_to_kbps(min_bitrate);
+    balancer->config.max_bitrate = bps_to_kbps(max_bitrate);
+    balancer_runner_update_bounds(&balancer->runner,
+                                  config_bitrate_bps(balancer->config.min_bitrate),
+                                  config_bitrate_bps(balancer->config.max_bitrate));
+    memset(&balancer->output, 0, sizeof(balancer->output));
+}
+
+const char *ceracoder_balancer_reason_name(int32_t reason) {
+    return balancer_reason_name((BalancerReason)reason);
+}
+
+const char *ceracoder_balancer_state_name(int32_t state) {
+    return balancer_state_name((BalancerState)state);
+}
+
+const char *ceracoder_balancer_name(const CeracoderBalancer *balancer) {
+    return balancer_runner_get_name(&balancer->runner);
+}
+
+void ceracoder_balancer_free(CeracoderBalancer *balancer) {
+    if (balancer == NULL) return;
+    balancer_runner_cleanup(&balancer->runner);
+    free(balancer);
+}
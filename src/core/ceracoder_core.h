@@ -0,0 +1,197 @@
+/*
+    ceracoder - live video encoder with dynamic bitrate control
+    Copyright (C) 2020 BELABOX project
+    Copyright (C) 2026 CERALIVE
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef CERACODER_CORE_H
+#define CERACODER_CORE_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * libceracoder-core - public C ABI of the bitrate control core
+ *
+ * Runs the same balancer algorithms as ceracoder in other processes
+ * (srtla sender, UI simulator, FFI bindings) without spawning ceracoder.
+ *
+ * ABI rules:
+ * - contexts are opaque, only created / freed by the library
+ * - arguments are fixed-width scalars or C strings, so FFI callers
+ *   don't need to mirror any structs, except CeracoderBalancerOutput
+ * - CeracoderBalancerOutput only grows at the end; callers pass its
+ *   size so older callers keep working
+ * - incompatible changes bump CERACODER_CORE_VERSION_MAJOR, which is
+ *   also the shared library soname version
+ *
+ * Not thread-safe per context; separate contexts are independent.
+ */
+
+#define CERACODER_CORE_VERSION_MAJOR 1
+#define CERACODER_CORE_VERSION_MINOR 3
+
+#if defined(__GNUC__)
+#define CERACODER_CORE_API __attribute__((visibility("default")))
+#else
+#define CERACODER_CORE_API
+#endif
+
+typedef struct CeracoderBalancer CeracoderBalancer;
+
+/*
+ * Balancer output, same fields as the on-screen overlay plus the decision
+ *
+ * Layout: 8-byte double first, then int32 fields (40 bytes in version 1.0,
+ * 48 bytes since 1.1, 64 bytes with the trailing padding since 1.3).
+ */
+typedef struct {
+    double throughput;      // Smoothed throughput
+    int32_t new_bitrate;    // Computed bitrate (bps)
+    int32_t rtt;            // Current RTT (ms)
+    int32_t rtt_th_min;     // RTT threshold min (ms)
+    int32_t rtt_th_max;     // RTT threshold max (ms)
+    int32_t bs;             // Current buffer size (packets)
+    int32_t bs_th1;         // Buffer threshold 1
+    int32_t bs_th2;         // Buffer threshold 2
+    int32_t bs_th3;         // Buffer threshold 3
+    int32_t reason;         // Decision reason, see ceracoder_balancer_reason_name() (1.1)
+    int32_t state;          // Congestion state, see ceracoder_balancer_state_name() (1.1)
+    int32_t loss_congestive; // Packets lost in the step, classified as congestive (1.3)
+    int32_t loss_random;    // Packets lost in the step, classified as random (1.3)
+    int32_t rtt_change;     // +1 / -1: RTT baseline re-set after a path change up / down (1.3)
+} CeracoderBalancerOutput;
+
+/*
+ * Library version: (major << 16) | minor
+ */
+CERACODER_CORE_API uint32_t ceracoder_core_version(void);
+
+/*
+ * Number of algorithms and their names ("adaptive", "fixed", "aimd", ...)
+ *
+ * Returns NULL if index is out of range.
+ */
+CERACODER_CORE_API int32_t ceracoder_balancer_algorithm_count(void);
+CERACODER_CORE_API const char *ceracoder_balancer_algorithm_name(int32_t index);
+
+/*
+ * Create a balancer
+ *
+ * algorithm may be NULL for the default. Bitrates in bps, rounded to whole
+ * Kbps like the config file values, latency in ms, packet size in bytes. Algorithm tuning uses the ceracoder defaults and
+ * can be changed with ceracoder_balancer_set_option().
+ * Returns NULL on error (unknown algorithm, invalid bounds).
+ */
+CERACODER_CORE_API CeracoderBalancer *ceracoder_balancer_new(const char *algorithm,
+                                                             int32_t min_bitrate,
+                                                             int32_t max_bitrate,
+                                                             int32_t srt_latency,
+                                                             int32_t srt_pkt_size);
+
+/*
+ * Set a tuning option, using the config file sections, keys and units
+ * (e.g. "aimd", "decr_mult", "0.5"). Resets the algorithm state. Of
+ * [general], only slow_start and start_bitrate are options.
+ *
+ * Returns 0 on success, -1 for unknown options.
+ */
+CERACODER_CORE_API int32_t ceracoder_balancer_set_option(CeracoderBalancer *balancer,
+                                                         const char *section,
+                                                         const char *key,
+                                                         const char *value);
+
+/*
+ * Run one update step with the current SRT statistics
+ *
+ * timestamp is in ms (monotonic); loss and retransmission counters are
+ * cumulative. Returns the new bitrate in bps.
+ */
+CERACODER_CORE_API int32_t ceracoder_balancer_step(CeracoderBalancer *balancer,
+                                                   int32_t buffer_size,
+                                                   double rtt,
+                                                   double send_rate_mbps,
+                                                   uint64_t timestamp,
+                                                   int64_t pkt_loss_total,
+                                                   int64_t pkt_retrans_total);
+
+/*
+ * Video hints for the following steps, as ceracoder takes them from its
+ * scene detector and static scene ceiling (docs/bitrate-control.md, Scene
+ * Hints and Static Scene Ceiling) (1.3)
+ *
+ * scene_cut (bool) applies to the next step only; motion (0-100) and
+ * ceiling (bps below max_bitrate, 0 = none) apply until changed. The
+ * ceiling itself is computed by the caller: the library has no access to
+ * the video or the encoder output. Without hints, the balancer runs as
+ * ceracoder does without a scene detector.
+ */
+CERACODER_CORE_API void ceracoder_balancer_set_hints(CeracoderBalancer *balancer,
+                                                     int32_t scene_cut,
+                                                     int32_t motion,
+                                                     int32_t ceiling);
+
+/*
+ * Copy the output of the last step
+ *
+ * size is sizeof(CeracoderBalancerOutput) as known to the caller.
+ * Returns the number of bytes copied.
+ */
+CERACODER_CORE_API int32_t ceracoder_balancer_get_output(const CeracoderBalancer *balancer,
+                                                         CeracoderBalancerOutput *output,
+                                                         uint32_t size);
+
+/*
+ * Current bitrate (bps), also before the first step: the bitrate to open
+ * the encoder with (the slow start bitrate, or max_bitrate)
+ */
+CERACODER_CORE_API int32_t ceracoder_balancer_get_bitrate(const CeracoderBalancer *balancer);
+
+/*
+ * Change the bitrate bounds (bps, rounded to whole Kbps), resets the
+ * algorithm state. With slow start, the ramp resumes from the current
+ * bitrate
+ */
+CERACODER_CORE_API void ceracoder_balancer_update_bounds(CeracoderBalancer *balancer,
+                                                         int32_t min_bitrate,
+                                                         int32_t max_bitrate);
+
+/*
+ * Names of decision reasons / congestion states, e.g. "heavy_loss" / "heavy"
+ *
+ * Returns "unknown" for out of range values.
+ */
+CERACODER_CORE_API const char *ceracoder_balancer_reason_name(int32_t reason);
+CERACODER_CORE_API const char *ceracoder_balancer_state_name(int32_t state);
+
+/*
+ * Name of the algorithm in use
+ */
+CERACODER_CORE_API const char *ceracoder_balancer_name(const CeracoderBalancer *balancer);
+
+/*
+ * Free a balancer (NULL is ignored)
+ */
+CERACODER_CORE_API void ceracoder_balancer_free(CeracoderBalancer *balancer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CERACODER_CORE_H */
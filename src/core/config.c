@@ -28,6 +28,17 @@
 #define DEF_MAX_BITRATE     6000    // Kbps
 #define DEF_SRT_LATENCY     2000    // ms
 #define DEF_BALANCER        "adaptive"
+#define DEF_SLOW_START      1
+#define DEF_START_BITRATE   1000    // Kbps
+#define DEF_TIMER_WARN      10      // ms
+#define DEF_PERF_COUNTERS   0       // bool
+#define DEF_LIVE_STATS      ""
+#define DEF_LOW_LATENCY     0       // bool
+#define DEF_OVERLAY         OVERLAY_OFF
+#define DEF_SLATE_TIMEOUT   1000    // ms
+#define DEF_ZERO_COPY       ZERO_COPY_AUTO
+#define DEF_SCENE_DETECT    1       // bool
+#define DEF_CONTENT_CAP     1       // bool
 
 // Adaptive defaults
 #define DEF_ADAPTIVE_INCR_STEP      30      // Kbps
@@ -35,6 +46,8 @@
 #define DEF_ADAPTIVE_INCR_INT       500     // ms
 #define DEF_ADAPTIVE_DECR_INT       200     // ms
 #define DEF_ADAPTIVE_LOSS_TH        0.5
+#define DEF_ADAPTIVE_LOSS_CLASSIFY  1
+#define DEF_ADAPTIVE_RTT_CHANGE     1
 
 // AIMD defaults
 #define DEF_AIMD_INCR_STEP          50      // Kbps
@@ -42,6 +55,20 @@
 #define DEF_AIMD_INCR_INT           500     // ms
 #define DEF_AIMD_DECR_INT           200     // ms
 
+// Encoder defaults
+#define DEF_ENCODER_MIN_INTERVAL    1000    // ms
+#define DEF_ENCODER_MIN_DELTA       100     // Kbps
+#define DEF_ENCODER_MAX_HOLD        2000    // ms
+
+// Mux defaults
+#define DEF_MUX_AUTO_LATENCY        1
+#define DEF_MUX_LATENCY_MARGIN      20      // ms
+
+// Audio encoder defaults
+#define DEF_AUDIO_MIN_BITRATE       32      // Kbps
+#define DEF_AUDIO_COMPLEXITY        -1      // As in the pipeline
+#define DEF_AUDIO_FRAME_SIZE        20      // ms
+
 void config_init_defaults(BelacoderConfig *cfg) {
     memset(cfg, 0, sizeof(*cfg));
 
@@ -49,6 +76,17 @@ void config_init_defaults(BelacoderConfig *cfg) {
     cfg->min_bitrate = DEF_MIN_BITRATE;
     cfg->max_bitrate = DEF_MAX_BITRATE;
     strncpy(cfg->balancer, DEF_BALANCER, sizeof(cfg->balancer) - 1);
+    cfg->slow_start = DEF_SLOW_START;
+    cfg->start_bitrate = DEF_START_BITRATE;
+    cfg->timer_warn_ms = DEF_TIMER_WARN;
+    cfg->perf_counters = DEF_PERF_COUNTERS;
+    strncpy(cfg->live_stats, DEF_LIVE_STATS, sizeof(cfg->live_stats) - 1);
+    cfg->low_latency = DEF_LOW_LATENCY;
+    cfg->overlay = DEF_OVERLAY;
+    cfg->slate_timeout = DEF_SLATE_TIMEOUT;
+    cfg->zero_copy = DEF_ZERO_COPY;
+    cfg->scene_detect = DEF_SCENE_DETECT;
+    cfg->content_cap = DEF_CONTENT_CAP;
 
     // SRT
     cfg->srt_latency = DEF_SRT_LATENCY;
@@ -59,12 +97,47 @@ void config_init_defaults(BelacoderConfig *cfg) {
     cfg->adaptive.incr_interval = DEF_ADAPTIVE_INCR_INT;
     cfg->adaptive.decr_interval = DEF_ADAPTIVE_DECR_INT;
     cfg->adaptive.loss_threshold = DEF_ADAPTIVE_LOSS_TH;
+    cfg->adaptive.loss_classify = DEF_ADAPTIVE_LOSS_CLASSIFY;
+    cfg->adaptive.rtt_change_detect = DEF_ADAPTIVE_RTT_CHANGE;
 
     // AIMD
     cfg->aimd.incr_step = DEF_AIMD_INCR_STEP;
     cfg->aimd.decr_mult = DEF_AIMD_DECR_MULT;
     cfg->aimd.incr_interval = DEF_AIMD_INCR_INT;
     cfg->aimd.decr_interval = DEF_AIMD_DECR_INT;
+
+    // Encoder
+    cfg->encoder.min_interval = DEF_ENCODER_MIN_INTERVAL;
+    cfg->encoder.min_delta = DEF_ENCODER_MIN_DELTA;
+    cfg->encoder.max_hold = DEF_ENCODER_MAX_HOLD;
+
+    // Mux
+    cfg->mux.auto_latency = DEF_MUX_AUTO_LATENCY;
+    cfg->mux.latency_margin = DEF_MUX_LATENCY_MARGIN;
+
+    cfg->audio.min_bitrate = DEF_AUDIO_MIN_BITRATE;
+    cfg->audio.complexity = DEF_AUDIO_COMPLEXITY;
+    cfg->audio.frame_size = DEF_AUDIO_FRAME_SIZE;
+}
+
+void config_apply_low_latency(BelacoderConfig *cfg) {
+    if (cfg->srt_latency == DEF_SRT_LATENCY) {
+        cfg->srt_latency = LOW_LATENCY_SRT_LATENCY;
+    }
+    // The RTT and send buffer thresholds of the adaptive balancer scale with
+    // the SRT latency; also react to them sooner
+    if (cfg->adaptive.decr_interval == DEF_ADAPTIVE_DECR_INT) {
+        cfg->adaptive.decr_interval = LOW_LATENCY_DECR_INTERVAL;
+    }
+    if (cfg->aimd.decr_interval == DEF_AIMD_DECR_INT) {
+        cfg->aimd.decr_interval = LOW_LATENCY_DECR_INTERVAL;
+    }
+    if (cfg->mux.latency_margin == DEF_MUX_LATENCY_MARGIN) {
+        cfg->mux.latency_margin = LOW_LATENCY_MUX_MARGIN;
+    }
+    if (cfg->audio.frame_size == DEF_AUDIO_FRAME_SIZE) {
+        cfg->audio.frame_size = LOW_LATENCY_AUDIO_FRAME;
+    }
 }
 
 // Trim whitespace from both ends
@@ -79,23 +152,87 @@ static char* trim(char *str) {
     return str;
 }
 
-// Parse a single key=value line within a section
-static void parse_line(BelacoderConfig *cfg, const char *section,
-                       const char *key, const char *value) {
+int config_set_value(BelacoderConfig *cfg, const char *section,
+                     const char *key, const char *value) {
     // [general] section
     if (strcmp(section, "general") == 0) {
         if (strcmp(key, "min_bitrate") == 0) {
             cfg->min_bitrate = atoi(value);
+            return 0;
         } else if (strcmp(key, "max_bitrate") == 0) {
             cfg->max_bitrate = atoi(value);
+            return 0;
         } else if (strcmp(key, "balancer") == 0) {
             strncpy(cfg->balancer, value, sizeof(cfg->balancer) - 1);
+            return 0;
+        } else if (strcmp(key, "stats_file") == 0) {
+            strncpy(cfg->stats_file, value, sizeof(cfg->stats_file) - 1);
+            return 0;
+        } else if (strcmp(key, "slow_start") == 0) {
+            cfg->slow_start = atoi(value);
+            return 0;
+        } else if (strcmp(key, "start_bitrate") == 0) {
+            cfg->start_bitrate = atoi(value);
+            return 0;
+        } else if (strcmp(key, "timer_warn_ms") == 0) {
+            cfg->timer_warn_ms = atoi(value);
+            return 0;
+        } else if (strcmp(key, "perf_counters") == 0) {
+            cfg->perf_counters = atoi(value);
+            return 0;
+        } else if (strcmp(key, "low_latency") == 0) {
+            cfg->low_latency = atoi(value);
+            return 0;
+        } else if (strcmp(key, "overlay") == 0) {
+            if (strcmp(value, "off") == 0 || strcmp(value, "0") == 0) {
+                cfg->overlay = OVERLAY_OFF;
+            } else if (strcmp(value, "auto") == 0 || strcmp(value, "1") == 0) {
+                cfg->overlay = OVERLAY_AUTO;
+            } else if (strcmp(value, "source") == 0) {
+                cfg->overlay = OVERLAY_SOURCE;
+            } else {
+                fprintf(stderr, "Unknown overlay mode '%s' (off, auto or source)\n", value);
+                return -1;
+            }
+            return 0;
+        } else if (strcmp(key, "control_fifo") == 0) {
+            memset(cfg->control_fifo, 0, sizeof(cfg->control_fifo));
+            strncpy(cfg->control_fifo, value, sizeof(cfg->control_fifo) - 1);
+            return 0;
+        } else if (strcmp(key, "slate") == 0) {
+            memset(cfg->slate, 0, sizeof(cfg->slate));
+            strncpy(cfg->slate, value, sizeof(cfg->slate) - 1);
+            return 0;
+        } else if (strcmp(key, "slate_timeout") == 0) {
+            cfg->slate_timeout = atoi(value);
+            return 0;
+        } else if (strcmp(key, "scene_detect") == 0) {
+            cfg->scene_detect = atoi(value);
+            return 0;
+        } else if (strcmp(key, "content_cap") == 0) {
+            cfg->content_cap = atoi(value);
+            return 0;
+        } else if (strcmp(key, "zero_copy") == 0) {
+            if (strcmp(value, "off") == 0 || strcmp(value, "0") == 0) {
+                cfg->zero_copy = ZERO_COPY_OFF;
+            } else if (strcmp(value, "auto") == 0 || strcmp(value, "1") == 0) {
+                cfg->zero_copy = ZERO_COPY_AUTO;
+            } else {
+                fprintf(stderr, "Unknown zero_copy mode '%s' (off or auto)\n", value);
+                return -1;
+            }
+            return 0;
+        } else if (strcmp(key, "live_stats") == 0) {
+            memset(cfg->live_stats, 0, sizeof(cfg->live_stats));
+            strncpy(cfg->live_stats, value, sizeof(cfg->live_stats) - 1);
+            return 0;
         }
     }
     // [srt] section
     else if (strcmp(section, "srt") == 0) {
         if (strcmp(key, "latency") == 0) {
             cfg->srt_latency = atoi(value);
+            return 0;
         }
         // Note: stream_id is CLI-only (-s flag), not in config
     }
@@ -103,28 +240,93 @@ static void parse_line(BelacoderConfig *cfg, const char *section,
     else if (strcmp(section, "adaptive") == 0) {
         if (strcmp(key, "incr_step") == 0) {
             cfg->adaptive.incr_step = atoi(value);
+            return 0;
         } else if (strcmp(key, "decr_step") == 0) {
             cfg->adaptive.decr_step = atoi(value);
+            return 0;
         } else if (strcmp(key, "incr_interval") == 0) {
             cfg->adaptive.incr_interval = atoi(value);
+            return 0;
         } else if (strcmp(key, "decr_interval") == 0) {
             cfg->adaptive.decr_interval = atoi(value);
+            return 0;
         } else if (strcmp(key, "loss_threshold") == 0) {
             cfg->adaptive.loss_threshold = atof(value);
+            return 0;
+        } else if (strcmp(key, "loss_classify") == 0) {
+            cfg->adaptive.loss_classify = atoi(value);
+            return 0;
+        } else if (strcmp(key, "rtt_change_detect") == 0) {
+            cfg->adaptive.rtt_change_detect = atoi(value);
+            return 0;
         }
     }
     // [aimd] section
     else if (strcmp(section, "aimd") == 0) {
         if (strcmp(key, "incr_step") == 0) {
             cfg->aimd.incr_step = atoi(value);
+            return 0;
         } else if (strcmp(key, "decr_mult") == 0) {
             cfg->aimd.decr_mult = atof(value);
+            return 0;
         } else if (strcmp(key, "incr_interval") == 0) {
             cfg->aimd.incr_interval = atoi(value);
+            return 0;
         } else if (strcmp(key, "decr_interval") == 0) {
             cfg->aimd.decr_interval = atoi(value);
+            return 0;
+        }
+    }
+    // [encoder] section
+    else if (strcmp(section, "encoder") == 0) {
+        if (strcmp(key, "min_interval") == 0) {
+            cfg->encoder.min_interval = atoi(value);
+            return 0;
+        } else if (strcmp(key, "min_delta") == 0) {
+            cfg->encoder.min_delta = atoi(value);
+            return 0;
+        } else if (strcmp(key, "max_hold") == 0) {
+            cfg->encoder.max_hold = atoi(value);
+            return 0;
+        }
+    }
+    // [mux] section
+    else if (strcmp(section, "mux") == 0) {
+        if (strcmp(key, "auto_latency") == 0) {
+            cfg->mux.auto_latency = atoi(value);
+            return 0;
+        } else if (strcmp(key, "latency_margin") == 0) {
+            cfg->mux.latency_margin = atoi(value);
+            return 0;
         }
     }
+    // [audio] section
+    else if (strcmp(section, "audio") == 0) {
+        if (strcmp(key, "min_bitrate") == 0) {
+            cfg->audio.min_bitrate = atoi(value);
+            return 0;
+        } else if (strcmp(key, "complexity") == 0) {
+            int complexity = atoi(value);
+            if (complexity < -1 || complexity > 10) {
+                fprintf(stderr, "Invalid audio complexity %d (0-10, or -1)\n", complexity);
+                return -1;
+            }
+            cfg->audio.complexity = complexity;
+            return 0;
+        } else if (strcmp(key, "frame_size") == 0) {
+            int frame_size = atoi(value);
+            if (frame_size != 5 && frame_size != 10 && frame_size != 20 &&
+                frame_size != 40 && frame_size != 60) {
+                fprintf(stderr, "Invalid audio frame_size %d (5, 10, 20, 40 or 60 ms)\n",
+                        frame_size);
+                return -1;
+            }
+            cfg->audio.frame_size = frame_size;
+            return 0;
+        }
+    }
+
+    return -1;
 }
 
 int config_load(BelacoderConfig *cfg, const char *filename) {
@@ -160,7 +362,7 @@ int config_load(BelacoderConfig *cfg, const char *filename) {
             *eq = '\0';
             char *key = trim(trimmed);
             char *value = trim(eq + 1);
-            parse_line(cfg, section, key, value);
+            config_set_value(cfg, section, key, value);
         }
     }
 
@@ -36,6 +36,8 @@ typedef struct {
     int incr_interval;      // Min interval between increases (ms, default: 500)
     int decr_interval;      // Min interval between decreases (ms, default: 200)
     double loss_threshold;  // Packet loss threshold (default: 0.5)
+    int loss_classify;      // Only react to congestive loss (bool, default: 1)
+    int rtt_change_detect;  // Re-baseline the RTT after path changes (bool, default: 1)
 } AdaptiveConfig;
 
 // AIMD algorithm tuning
@@ -46,12 +48,70 @@ typedef struct {
     int decr_interval;      // Min interval between decreases (ms, default: 200)
 } AimdConfig;
 
+// Encoder bitrate change coalescing
+typedef struct {
+    int min_interval;       // Min interval between increases (ms, default: 1000)
+    int min_delta;          // Min change applied at once (Kbps, default: 100)
+    int max_hold;           // Max time a smaller change is held back (ms, default: 2000)
+} EncoderConfig;
+
+// Opus audio encoder ("aenc") control
+typedef struct {
+    int min_bitrate;        // Lowest bitrate the balancer target maps to (Kbps, default: 32)
+    int complexity;         // Encoder complexity (0-10), -1 = as in the pipeline (default: -1)
+    int frame_size;         // Frame size (ms: 5, 10, 20, 40 or 60, default: 20)
+} AudioConfig;
+
+// MPEG-TS mux (mpegtsmux) latency handling
+typedef struct {
+    int auto_latency;       // Auto-trim the mux latency property (bool, default: 1)
+    int latency_margin;     // Margin kept over the worst input lag (ms, default: 20)
+} MuxConfig;
+
+/*
+ * Low latency profile (low_latency = 1 or -L)
+ *
+ * Replaces the defaults that trade latency for robustness: the SRT latency,
+ * the balancer decrease intervals, the mux latency margin and the Opus frame
+ * size here, and the queue limits, encoder tuning and SRT packet flushing in
+ * the pipeline.
+ * Values set explicitly (to something other than the default) are kept.
+ */
+#define LOW_LATENCY_SRT_LATENCY     300     // ms
+#define LOW_LATENCY_QUEUE_MS        200     // max-size-time of the pipeline queues
+#define LOW_LATENCY_DECR_INTERVAL   100     // ms, adaptive and aimd
+#define LOW_LATENCY_MUX_MARGIN      10      // ms
+#define LOW_LATENCY_AUDIO_FRAME     10      // ms, Opus frame size
+
+// Overlay modes (overlay = off|auto|source)
+#define OVERLAY_OFF     0   // Taken out of the pipeline
+#define OVERLAY_AUTO    1   // After the downscale when possible
+#define OVERLAY_SOURCE  2   // Where the template put it
+
+// Zero-copy capture modes (zero_copy = off|auto)
+#define ZERO_COPY_OFF   0   // Pipeline as written
+#define ZERO_COPY_AUTO  1   // DMABuf capture when the probe succeeds
+
 // Main configuration
 typedef struct {
     // General settings
     int min_bitrate;        // Minimum bitrate (Kbps, default: 300)
     int max_bitrate;        // Maximum bitrate (Kbps, default: 6000)
     char balancer[32];      // Algorithm name (default: "adaptive")
+    char stats_file[256];   // Runtime stats export path (default: "", disabled)
+    int slow_start;         // Ramp up from start_bitrate at startup (bool, default: 1)
+    int start_bitrate;      // Slow start initial bitrate (Kbps, default: 1000)
+    int timer_warn_ms;      // Log timers with a p99 lateness / runtime above this (ms, default: 10)
+    int perf_counters;      // Per-thread CPU counters in the stats (bool, default: 0)
+    char live_stats[256];   // Live stats feed for ceratop, one path per instance (default: "", off)
+    int low_latency;        // Low latency profile (bool, default: 0)
+    int overlay;            // Stats overlay, OVERLAY_* (default: OVERLAY_OFF)
+    char control_fifo[256]; // Control command FIFO, e.g. pipeline swaps (default: "", off)
+    char slate[256];        // Pre-encoded TS clip sent while the input is lost (default: "", off)
+    int slate_timeout;      // Encoder output gap that switches to the slate (ms, default: 1000)
+    int zero_copy;          // DMABuf capture into the encoder, ZERO_COPY_* (default: ZERO_COPY_AUTO)
+    int scene_detect;       // Scene cut / motion hints to the balancer (bool, default: 1)
+    int content_cap;        // Lower the bitrate ceiling on static scenes (bool, default: 1)
 
     // SRT settings
     int srt_latency;        // SRT latency (ms, default: 2000)
@@ -60,6 +120,15 @@ typedef struct {
     // Algorithm-specific settings
     AdaptiveConfig adaptive;
     AimdConfig aimd;
+
+    // Encoder settings
+    EncoderConfig encoder;
+
+    // Mux settings
+    MuxConfig mux;
+
+    // Audio encoder settings
+    AudioConfig audio;
 } BelacoderConfig;
 
 /*
@@ -73,6 +142,18 @@ void config_init_defaults(BelacoderConfig *cfg);
  */
 int config_load(BelacoderConfig *cfg, const char *filename);
 
+/*
+ * Set a single value, as if read from the given section of a config file
+ * Returns 0 on success, -1 if the section / key is unknown
+ */
+int config_set_value(BelacoderConfig *cfg, const char *section,
+                     const char *key, const char *value);
+
+/*
+ * Apply the low latency profile to the settings still at their defaults
+ */
+void config_apply_low_latency(BelacoderConfig *cfg);
+
 /*
  * Get bitrate in bps (converts from Kbps)
  */
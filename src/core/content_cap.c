@@ -0,0 +1,76 @@
+/*
+    ceracoder - live video encoder with dynamic bitrate control
+    Copyright (C) 2020 BELABOX project
+    Copyright (C) 2026 CERALIVE
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#include "content_cap.h"
+#include <string.h>
+
+void content_cap_init(ContentCap *cc) {
+    memset(cc, 0, sizeof(*cc));
+}
+
+static void content_cap_lift(ContentCap *cc) {
+    cc->ceiling = 0;
+    cc->output_peak = 0;
+    cc->static_since = 0;
+}
+
+int content_cap_update(ContentCap *cc, int motion, int scene_cut, int output_bps,
+                       int target_bps, uint64_t timestamp) {
+    if (cc->ceiling > 0 && cc->prev_ts > 0 && timestamp > cc->prev_ts) {
+        cc->capped_ms += timestamp - cc->prev_ts;
+    }
+    cc->prev_ts = timestamp;
+
+    // Moving, or a new scene: the encoder may need every bit again
+    if (motion > CONTENT_CAP_STATIC_MOTION || scene_cut || output_bps <= 0) {
+        content_cap_lift(cc);
+        return 0;
+    }
+
+    if (cc->static_since == 0) {
+        cc->static_since = timestamp;
+    }
+    if (output_bps > cc->output_peak) {
+        cc->output_peak = output_bps;
+    }
+
+    int64_t ceiling = (int64_t)cc->output_peak * CONTENT_CAP_HEADROOM / 100;
+    if (cc->ceiling > 0) {
+        // Once set, only the output peak moves it
+        cc->ceiling = (int)ceiling;
+    } else if (timestamp - cc->static_since >= CONTENT_CAP_HOLD &&
+               (int64_t)cc->output_peak * 100 < (int64_t)target_bps * CONTENT_CAP_UNDERSHOOT) {
+        cc->ceiling = (int)ceiling;
+        cc->engaged++;
+    }
+
+    return cc->ceiling;
+}
+
+void content_cap_publish(const ContentCap *cc, Stats *stats) {
+    if (stats == NULL) return;
+
+    stats_set(stats, "ceracoder_content_cap_bps", STATS_GAUGE,
+              "Bitrate ceiling for a static scene (bps), 0 if none", cc->ceiling);
+    stats_set(stats, "ceracoder_content_cap_engaged_total", STATS_COUNTER,
+              "Times a static scene ceiling was set", (double)cc->engaged);
+    stats_set(stats, "ceracoder_content_cap_seconds_total", STATS_COUNTER,
+              "Time spent with a static scene ceiling", cc->capped_ms / 1000.0);
+}
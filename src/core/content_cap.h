@@ -0,0 +1,84 @@
+/*
+    ceracoder - live video encoder with dynamic bitrate control
+    Copyright (C) 2020 BELABOX project
+    Copyright (C) 2026 CERALIVE
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef CONTENT_CAP_H
+#define CONTENT_CAP_H
+
+#include <stdint.h>
+#include "stats.h"
+
+/*
+ * Content cap - a bitrate ceiling for static scenes
+ *
+ * On a static scene (slides, a fixed wide shot) a rate-controlled encoder
+ * reaches its quality target far below max_bitrate and stops using the
+ * bits it's given, while the balancer keeps raising the target as long as
+ * the link takes it. This module lowers the balancer's ceiling to what
+ * the encoder actually uses, plus headroom:
+ *
+ * - the scene counts as static once the motion score (scene_detect.h) has
+ *   stayed at or below CONTENT_CAP_STATIC_MOTION for CONTENT_CAP_HOLD ms
+ * - the encoder is undershooting when its peak output rate over that time
+ *   is below CONTENT_CAP_UNDERSHOOT percent of the target
+ * - the ceiling is then CONTENT_CAP_HEADROOM percent of the peak output,
+ *   and follows the peak up while the scene stays static
+ *
+ * Motion above the threshold or a scene cut lifts the ceiling at once.
+ * Encoders filling the target (CBR with filler data) never undershoot, so
+ * they are never capped.
+ */
+
+#define CONTENT_CAP_STATIC_MOTION   5       // Motion score (0-100)
+#define CONTENT_CAP_HOLD            3000    // ms
+#define CONTENT_CAP_UNDERSHOOT      70      // % of the target
+#define CONTENT_CAP_HEADROOM        150     // % of the peak output
+
+typedef struct {
+    int ceiling;            // Current ceiling (bps), 0 = none
+    int output_peak;        // Peak encoder output in the static stretch (bps)
+    uint64_t static_since;  // Start of the static stretch (ms), 0 while moving
+
+    // Counters
+    uint64_t engaged;       // Times the ceiling was set
+    uint64_t capped_ms;     // Time spent with a ceiling
+    uint64_t prev_ts;
+} ContentCap;
+
+/*
+ * Reset, without a ceiling
+ */
+void content_cap_init(ContentCap *cc);
+
+/*
+ * Account one balancer tick at timestamp (ms)
+ *
+ * motion and scene_cut come from the scene detector, output_bps is the
+ * measured encoder output (0 if unknown, which lifts the ceiling), target_bps the balancer's last
+ * target. Returns the ceiling (bps), 0 for none.
+ */
+int content_cap_update(ContentCap *cc, int motion, int scene_cut, int output_bps,
+                       int target_bps, uint64_t timestamp);
+
+/*
+ * Publish as ceracoder_content_cap_* metrics
+ */
+void content_cap_publish(const ContentCap *cc, Stats *stats);
+
+#endif /* CONTENT_CAP_H */
@@ -0,0 +1,89 @@
+/*
+    ceracoder - live video encoder with dynamic bitrate control
+    Copyright (C) 2020 BELABOX project
+    Copyright (C) 2026 CERALIVE
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "encoder_policy.h"
+#include <stdlib.h>
+#include <string.h>
+
+void encoder_policy_init(EncoderPolicy *policy, const EncoderPolicyConfig *config) {
+    memset(policy, 0, sizeof(*policy));
+    policy->config = *config;
+}
+
+static EncoderPolicyDecision hold(EncoderPolicy *policy, int target, uint64_t now) {
+    if (policy->held == 0) {
+        policy->held_since = now;
+    }
+    if (target != policy->held) {
+        policy->held = target;
+        policy->coalesced++;
+    }
+    return ENCODER_POLICY_HOLD;
+}
+
+EncoderPolicyDecision encoder_policy_decide(EncoderPolicy *policy, int target, uint64_t now) {
+    if (target == policy->applied) {
+        policy->held = 0;
+        return ENCODER_POLICY_NONE;
+    }
+
+    EncoderPolicyDecision decision = ENCODER_POLICY_APPLY;
+
+    // Always apply the first bitrate
+    if (policy->applied != 0) {
+        int delta = target - policy->applied;
+
+        // Small changes wait, unless they have been held back for long enough
+        if (abs(delta) < policy->config.min_delta &&
+            (policy->held == 0 || now - policy->held_since < (uint64_t)policy->config.max_hold)) {
+            return hold(policy, target, now);
+        }
+
+        if (delta < 0) {
+            decision = ENCODER_POLICY_APPLY_FAST;
+        } else if (now - policy->last_change < (uint64_t)policy->config.min_interval) {
+            return hold(policy, target, now);
+        }
+    }
+
+    policy->applied = target;
+    policy->last_change = now;
+    policy->held = 0;
+    policy->changes++;
+    if (decision == ENCODER_POLICY_APPLY_FAST) {
+        policy->fast_changes++;
+    }
+
+    return decision;
+}
+
+int encoder_passthrough_select(int transcoding, int target, int camera_min) {
+    if (camera_min <= 0) return 0;
+    if (transcoding) {
+        return target < camera_min * ENCODER_PASSTHROUGH_HYSTERESIS;
+    }
+    return target < camera_min;
+}
+
+int audio_bitrate_select(int video_bps, int min_bps, int max_bps) {
+    int bitrate = video_bps / AUDIO_BITRATE_DIV / AUDIO_BITRATE_STEP * AUDIO_BITRATE_STEP;
+    if (bitrate > max_bps) bitrate = max_bps;
+    if (bitrate < min_bps) bitrate = min_bps;
+    return bitrate;
+}
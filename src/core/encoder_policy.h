@@ -0,0 +1,109 @@
+/*
+    ceracoder - live video encoder with dynamic bitrate control
+    Copyright (C) 2020 BELABOX project
+    Copyright (C) 2026 CERALIVE
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef ENCODER_POLICY_H
+#define ENCODER_POLICY_H
+
+#include <stdint.h>
+
+/*
+ * Encoder policy module - coalesces encoder bitrate changes
+ *
+ * The balancer produces a new target every BITRATE_UPDATE_INT ms, but some
+ * hardware encoders (nvv4l2, mpp) take internal locks or reset their rate
+ * control on every bitrate change. This policy decides which targets are
+ * worth applying:
+ *
+ * - decreases are applied at once (fast path, congestion must be relieved)
+ * - increases are applied at most once per min_interval
+ * - changes smaller than min_delta are held back for up to max_hold
+ *
+ * Held targets are not lost: the caller offers the latest target on every
+ * update, so the encoder converges once the hold expires.
+ */
+
+typedef struct {
+    int min_interval;       // Min ms between increases
+    int min_delta;          // Min change worth applying at once (bps)
+    int max_hold;           // Max ms a small change is held back
+} EncoderPolicyConfig;
+
+typedef enum {
+    ENCODER_POLICY_NONE,        // Target already applied
+    ENCODER_POLICY_HOLD,        // Change held back (coalesced)
+    ENCODER_POLICY_APPLY,       // Apply the change
+    ENCODER_POLICY_APPLY_FAST,  // Apply a decrease via the fast path
+} EncoderPolicyDecision;
+
+typedef struct {
+    EncoderPolicyConfig config;
+
+    int applied;            // Last applied bitrate (bps), 0 if none
+    uint64_t last_change;   // Time of the last applied change (ms)
+    int held;               // Target currently held back, 0 if none
+    uint64_t held_since;    // Time the first held target was seen (ms)
+
+    // Counters
+    uint64_t changes;       // Changes applied
+    uint64_t fast_changes;  // ... of which via the decrease fast path
+    uint64_t coalesced;     // Distinct targets held back
+} EncoderPolicy;
+
+/*
+ * Initialize the policy
+ */
+void encoder_policy_init(EncoderPolicy *policy, const EncoderPolicyConfig *config);
+
+/*
+ * Decide what to do with a new target bitrate (bps) at time now (ms)
+ *
+ * On APPLY / APPLY_FAST the target is recorded as applied.
+ */
+EncoderPolicyDecision encoder_policy_decide(EncoderPolicy *policy, int target, uint64_t now);
+
+/*
+ * H.264 passthrough: camera encoder or transcode fallback
+ *
+ * With a UVC camera as the actuator, the stream falls back to decoding and
+ * re-encoding once the target drops below the lowest bitrate the camera
+ * accepts, and returns to passthrough once the target is back above it by
+ * ENCODER_PASSTHROUGH_HYSTERESIS, so a target hovering at the camera's
+ * minimum doesn't flip between the two.
+ */
+#define ENCODER_PASSTHROUGH_HYSTERESIS  1.2
+
+/*
+ * Returns 1 to transcode, 0 for passthrough; camera_min <= 0 (unknown)
+ * always selects passthrough
+ */
+int encoder_passthrough_select(int transcoding, int target, int camera_min);
+
+/*
+ * Audio bitrate from the video target
+ *
+ * An Opus encoder gets 1/AUDIO_BITRATE_DIV of the video target, between
+ * min_bps and the bitrate set in the pipeline (max_bps), rounded down to
+ * AUDIO_BITRATE_STEP so that small target moves don't reconfigure it.
+ */
+#define AUDIO_BITRATE_DIV   16
+#define AUDIO_BITRATE_STEP  8000    // bps
+
+int audio_bitrate_select(int video_bps, int min_bps, int max_bps);
+
+#endif /* ENCODER_POLICY_H */
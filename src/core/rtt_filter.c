@@ -0,0 +1,158 @@
+/*
+    ceracoder - live video encoder with dynamic bitrate control
+    Copyright (C) 2020 BELABOX project
+    Copyright (C) 2026 CERALIVE
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "rtt_filter.h"
+
+/*
+ * Windowed minimum
+ */
+void windowed_min_init(WindowedMin *wm, uint64_t window) {
+    wm->window = window;
+    windowed_min_reset(wm);
+}
+
+void windowed_min_reset(WindowedMin *wm) {
+    wm->head = 0;
+    wm->count = 0;
+}
+
+double windowed_min_update(WindowedMin *wm, double value, uint64_t timestamp) {
+    // Samples no smaller than the new one can never be the minimum again
+    while (wm->count > 0) {
+        int tail = (wm->head + wm->count - 1) % WINDOWED_MIN_SIZE;
+        if (wm->samples[tail].value < value) break;
+        wm->count--;
+    }
+
+    // Expire samples that left the window
+    while (wm->count > 0 && wm->samples[wm->head].timestamp + wm->window <= timestamp) {
+        wm->head = (wm->head + 1) % WINDOWED_MIN_SIZE;
+        wm->count--;
+    }
+
+    if (wm->count == WINDOWED_MIN_SIZE) {
+        wm->head = (wm->head + 1) % WINDOWED_MIN_SIZE;
+        wm->count--;
+    }
+    int tail = (wm->head + wm->count) % WINDOWED_MIN_SIZE;
+    wm->samples[tail].value = value;
+    wm->samples[tail].timestamp = timestamp;
+    wm->count++;
+
+    return wm->samples[wm->head].value;
+}
+
+double windowed_min_get(const WindowedMin *wm, double fallback) {
+    return wm->count > 0 ? wm->samples[wm->head].value : fallback;
+}
+
+/*
+ * RTT change detector
+ */
+void rtt_change_init(RttChangeDetector *det) {
+    rtt_change_reset(det);
+    det->prev = 0.0;
+    det->level = 0.0;
+    det->min = 0.0;
+    det->spread = 0.0;
+}
+
+void rtt_change_reset(RttChangeDetector *det) {
+    det->ref = 0.0;
+    det->slack = 0.0;
+    det->s_hi = 0.0;
+    det->s_lo = 0.0;
+    det->tracked = 0;
+    det->flat_count = 0;
+    det->flat_sum = 0.0;
+    det->flat_min = 0.0;
+    det->flat_max = 0.0;
+}
+
+static void flat_restart(RttChangeDetector *det, double rtt) {
+    det->flat_count = 1;
+    det->flat_sum = rtt;
+    det->flat_min = rtt;
+    det->flat_max = rtt;
+}
+
+int rtt_change_update(RttChangeDetector *det, double rtt, double jitter) {
+    double prev = det->prev;
+    det->prev = rtt;
+    if (det->tracked == 0) {
+        if (prev <= 0.0) return 0;
+        det->ref = prev;
+        det->slack = jitter * RTT_CHANGE_SLACK_JITTER;
+        if (det->slack < RTT_CHANGE_SLACK_MIN) det->slack = RTT_CHANGE_SLACK_MIN;
+    }
+
+    double s_hi = det->s_hi + rtt - det->ref - det->slack;
+    double s_lo = det->s_lo + det->ref - rtt - det->slack;
+    det->s_hi = s_hi > 0.0 ? s_hi : 0.0;
+    det->s_lo = s_lo > 0.0 ? s_lo : 0.0;
+    if (det->s_hi == 0.0 && det->s_lo == 0.0) {
+        rtt_change_reset(det);
+        return 0;
+    }
+
+    det->tracked++;
+    if (det->tracked > RTT_CHANGE_MAX_SAMPLES) {
+        rtt_change_reset(det);
+        return 0;
+    }
+
+    // Only abrupt steps cross the threshold in time, a queue building up
+    // raises the RTT gradually
+    if (det->flat_count == 0) {
+        double h = det->slack * RTT_CHANGE_THRESHOLD;
+        if (det->s_hi <= h && det->s_lo <= h) {
+            if (det->tracked >= RTT_CHANGE_MAX_RISE) rtt_change_reset(det);
+            return 0;
+        }
+        flat_restart(det, rtt);
+        return 0;
+    }
+
+    // Past the threshold: wait for the RTT to stay within the slack
+    double flat_min = rtt < det->flat_min ? rtt : det->flat_min;
+    double flat_max = rtt > det->flat_max ? rtt : det->flat_max;
+    if (flat_max - flat_min > 2.0 * det->slack) {
+        flat_restart(det, rtt);
+        return 0;
+    }
+    det->flat_min = flat_min;
+    det->flat_max = flat_max;
+    det->flat_sum += rtt;
+    det->flat_count++;
+    if (det->flat_count < RTT_CHANGE_CONFIRM) return 0;
+
+    // A spike that settled back at the baseline is not a change
+    double level = det->flat_sum / det->flat_count;
+    int dir = det->s_hi > det->s_lo ? 1 : -1;
+    if (dir * (level - det->ref) <= det->slack) {
+        rtt_change_reset(det);
+        return 0;
+    }
+
+    det->level = level;
+    det->min = det->flat_min;
+    det->spread = det->flat_max - det->flat_min;
+    rtt_change_reset(det);
+    return dir;
+}
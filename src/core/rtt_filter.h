@@ -0,0 +1,113 @@
+/*
+    ceracoder - live video encoder with dynamic bitrate control
+    Copyright (C) 2020 BELABOX project
+    Copyright (C) 2026 CERALIVE
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef RTT_FILTER_H
+#define RTT_FILTER_H
+
+#include <stdint.h>
+
+/*
+ * RTT baseline tracking for the adaptive balancer
+ *
+ * WindowedMin: minimum RTT over a sliding time window, kept in a monotonic
+ * deque (each sample is pushed once and popped at most once, so updates are
+ * amortized O(1)). Unlike a minimum that drifts up per sample, it follows
+ * an increase of the path RTT exactly one window later, and never during
+ * congestion shorter than the window.
+ *
+ * RttChangeDetector: two-sided CUSUM on the RTT against the RTT just before
+ * it started to move. A path change (e.g. a cellular handover) is a step
+ * in the RTT that stays flat afterwards, while a queue building up raises
+ * the RTT gradually. A step must cross the CUSUM threshold within
+ * RTT_CHANGE_MAX_RISE samples, and is reported once the RTT has been flat
+ * for RTT_CHANGE_CONFIRM samples; the caller then re-baselines.
+ */
+
+#define RTT_MIN_WINDOW          10000   // ms
+#define WINDOWED_MIN_SIZE       1024    // Deque capacity (samples), oldest dropped when full
+
+#define RTT_CHANGE_SLACK_MIN    5.0     // ms, minimum CUSUM slack (k)
+#define RTT_CHANGE_SLACK_JITTER 2.0     // slack = max(SLACK_MIN, jitter * this)
+#define RTT_CHANGE_THRESHOLD    8.0     // CUSUM decision threshold, h = slack * this
+#define RTT_CHANGE_MAX_RISE     5       // Samples (20 ms each) a step may take to cross the threshold
+#define RTT_CHANGE_CONFIRM      10      // Flat samples confirming a step
+#define RTT_CHANGE_MAX_SAMPLES  250     // Give up on a step not confirmed within this
+
+typedef struct {
+    double value;
+    uint64_t timestamp;
+} WindowedMinSample;
+
+typedef struct {
+    WindowedMinSample samples[WINDOWED_MIN_SIZE];
+    int head;           // Index of the oldest sample (the minimum)
+    int count;
+    uint64_t window;    // ms
+} WindowedMin;
+
+void windowed_min_init(WindowedMin *wm, uint64_t window);
+void windowed_min_reset(WindowedMin *wm);
+
+/*
+ * Add a sample and return the minimum over the window (the sample itself
+ * if it is the only one)
+ */
+double windowed_min_update(WindowedMin *wm, double value, uint64_t timestamp);
+
+/*
+ * Current minimum, or fallback if there are no samples
+ */
+double windowed_min_get(const WindowedMin *wm, double fallback);
+
+typedef struct {
+    double prev;        // Previous sample (ms), 0 before the first one
+    double ref;         // RTT before the change, frozen while it is tracked
+    double slack;       // CUSUM slack k (ms), frozen like ref
+    double s_hi;        // CUSUM of increases
+    double s_lo;        // CUSUM of decreases
+    int tracked;        // Samples since the CUSUM left zero
+
+    // Samples since the threshold was crossed, or since the RTT last moved
+    int flat_count;
+    double flat_sum;
+    double flat_min;
+    double flat_max;
+
+    // Result of the last confirmed change
+    double level;       // Mean RTT after the step
+    double min;         // Minimum RTT after the step
+    double spread;      // Max - min RTT after the step
+} RttChangeDetector;
+
+void rtt_change_init(RttChangeDetector *det);
+
+/*
+ * Feed an RTT sample
+ *
+ * jitter is the caller's RTT jitter estimate, sampled into the slack while
+ * no change is being tracked. Returns +1 / -1 when a step up / down is
+ * confirmed (det->level, min and spread describe the new baseline), 0
+ * otherwise. The caller must not feed steps that come with other
+ * congestion signals; rtt_change_reset() drops a tracked change.
+ */
+int rtt_change_update(RttChangeDetector *det, double rtt, double jitter);
+
+void rtt_change_reset(RttChangeDetector *det);
+
+#endif /* RTT_FILTER_H */
@@ -0,0 +1,142 @@
+/*
+    ceracoder - live video encoder with dynamic bitrate control
+    Copyright (C) 2020 BELABOX project
+    Copyright (C) 2026 CERALIVE
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#include "scene_detect.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define SCENE_SSE2
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define SCENE_NEON
+#endif
+
+#define EMA_SAD         0.9
+#define EMA_MOTION      0.8
+
+uint32_t scene_sad_scalar(const uint8_t *a, const uint8_t *b, int len) {
+    uint32_t sum = 0;
+    for (int i = 0; i < len; i++) {
+        sum += (uint32_t)abs((int)a[i] - (int)b[i]);
+    }
+    return sum;
+}
+
+uint32_t scene_sad(const uint8_t *a, const uint8_t *b, int len) {
+    int i = 0;
+    uint32_t sum = 0;
+#if defined(SCENE_SSE2)
+    __m128i acc = _mm_setzero_si128();
+    for (; i + 16 <= len; i += 16) {
+        __m128i va = _mm_loadu_si128((const __m128i *)(a + i));
+        __m128i vb = _mm_loadu_si128((const __m128i *)(b + i));
+        acc = _mm_add_epi64(acc, _mm_sad_epu8(va, vb));
+    }
+    sum = (uint32_t)(_mm_cvtsi128_si32(acc) + _mm_cvtsi128_si32(_mm_srli_si128(acc, 8)));
+#elif defined(SCENE_NEON)
+    uint32x4_t acc = vdupq_n_u32(0);
+    for (; i + 16 <= len; i += 16) {
+        // Sums of two differences fit in 16 bits
+        uint8x16_t d = vabdq_u8(vld1q_u8(a + i), vld1q_u8(b + i));
+        acc = vpadalq_u16(acc, vpaddlq_u8(d));
+    }
+    uint64x2_t s = vpaddlq_u32(acc);
+    sum = (uint32_t)(vgetq_lane_u64(s, 0) + vgetq_lane_u64(s, 1));
+#endif
+    return sum + scene_sad_scalar(a + i, b + i, len - i);
+}
+
+const char *scene_detect_impl(void) {
+#if defined(SCENE_SSE2)
+    return "sse2";
+#elif defined(SCENE_NEON)
+    return "neon";
+#else
+    return "scalar";
+#endif
+}
+
+void scene_detect_init(SceneDetect *sd) {
+    memset(sd, 0, sizeof(*sd));
+}
+
+// Point-sample the luma plane into the thumbnail, with its histogram
+static void sample(const uint8_t *luma, int width, int height, int stride, int pixel_stride,
+                   uint8_t *thumb, uint32_t *hist) {
+    int cols[SCENE_THUMB_W];
+    for (int x = 0; x < SCENE_THUMB_W; x++) {
+        cols[x] = (x * width / SCENE_THUMB_W + width / (2 * SCENE_THUMB_W)) * pixel_stride;
+    }
+
+    memset(hist, 0, SCENE_HIST_BINS * sizeof(*hist));
+    for (int y = 0; y < SCENE_THUMB_H; y++) {
+        const uint8_t *row = luma + (size_t)(y * height / SCENE_THUMB_H +
+                                             height / (2 * SCENE_THUMB_H)) * stride;
+        uint8_t *out = thumb + y * SCENE_THUMB_W;
+        for (int x = 0; x < SCENE_THUMB_W; x++) {
+            out[x] = row[cols[x]];
+            hist[out[x] / (256 / SCENE_HIST_BINS)]++;
+        }
+    }
+}
+
+int scene_detect_frame(SceneDetect *sd, const uint8_t *luma, int width, int height,
+                       int stride, int pixel_stride) {
+    if (luma == NULL || width <= 0 || height <= 0) return 0;
+
+    int next = sd->cur ^ 1;
+    sample(luma, width, height, stride, pixel_stride, sd->thumb[next], sd->hist[next]);
+    sd->frames++;
+
+    if (!sd->have_prev) {
+        sd->cur = next;
+        sd->have_prev = 1;
+        return 0;
+    }
+
+    uint32_t sad = scene_sad(sd->thumb[next], sd->thumb[sd->cur], SCENE_THUMB_SIZE);
+    uint32_t moved = 0;
+    for (int i = 0; i < SCENE_HIST_BINS; i++) {
+        moved += (uint32_t)abs((int)sd->hist[next][i] - (int)sd->hist[sd->cur][i]);
+    }
+    sd->cur = next;
+
+    sd->sad = (int)(sad / SCENE_THUMB_SIZE);
+    sd->hist_diff = (int)(moved * 100 / (2 * SCENE_THUMB_SIZE));
+
+    double sad_th = sd->sad_avg * SCENE_CUT_SAD_MULT;
+    if (sad_th < SCENE_CUT_SAD_MIN) sad_th = SCENE_CUT_SAD_MIN;
+    sd->cut = sd->sad >= sad_th && sd->hist_diff >= SCENE_CUT_HIST_MIN;
+
+    if (sd->cut) {
+        sd->cuts++;
+    } else {
+        // A cut would inflate the average and hide the next one
+        sd->sad_avg = sd->sad_avg * EMA_SAD + sd->sad * (1.0 - EMA_SAD);
+        int score = sd->sad * 100 / SCENE_MOTION_FULL;
+        if (score > 100) score = 100;
+        sd->motion_avg = sd->motion_avg * EMA_MOTION + score * (1.0 - EMA_MOTION);
+        sd->motion = (int)(sd->motion_avg + 0.5);
+    }
+
+    return sd->cut;
+}
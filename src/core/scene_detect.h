@@ -0,0 +1,102 @@
+/*
+    ceracoder - live video encoder with dynamic bitrate control
+    Copyright (C) 2020 BELABOX project
+    Copyright (C) 2026 CERALIVE
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef SCENE_DETECT_H
+#define SCENE_DETECT_H
+
+#include <stdint.h>
+
+/*
+ * Scene detector - scene cuts and motion from the raw video, before encoding
+ *
+ * A scene cut makes the encoder emit a burst several times the average frame
+ * size (often a keyframe), and high motion raises the frame sizes for as
+ * long as it lasts. The balancer only sees these once the send buffer has
+ * filled; this module sees them a frame or more ahead, from the luma plane
+ * on its way into the encoder.
+ *
+ * Each frame is point-sampled to a SCENE_THUMB_W x SCENE_THUMB_H luma
+ * thumbnail and compared with the previous one:
+ *
+ * - SAD: mean absolute difference of the samples, the motion measure
+ * - histogram difference: share of samples that moved between luma bins,
+ *   which stays low for motion and lighting drift but jumps on a cut
+ *
+ * A frame is a cut when both jump: its SAD is SCENE_CUT_SAD_MULT times the
+ * recent average (and at least SCENE_CUT_SAD_MIN) and its histogram
+ * difference is at least SCENE_CUT_HIST_MIN percent. The SAD runs on
+ * SSE2 / NEON where available; sampling costs a few tens of µs at 4K.
+ */
+
+#define SCENE_THUMB_W           160
+#define SCENE_THUMB_H           90
+#define SCENE_THUMB_SIZE        (SCENE_THUMB_W * SCENE_THUMB_H)
+#define SCENE_HIST_BINS         32
+#define SCENE_CUT_SAD_MULT      3       // x the average SAD
+#define SCENE_CUT_SAD_MIN       12      // mean absolute difference (0-255)
+#define SCENE_CUT_HIST_MIN      30      // % of samples changing bin
+#define SCENE_MOTION_FULL       24      // mean absolute difference scored 100
+
+typedef struct {
+    uint8_t thumb[2][SCENE_THUMB_SIZE];
+    uint32_t hist[2][SCENE_HIST_BINS];
+    int cur;                // Thumbnail of the last frame
+    int have_prev;
+    double sad_avg;         // Recent mean SAD, cuts excluded
+    double motion_avg;
+
+    // Last frame
+    int sad;                // Mean absolute difference to the previous frame (0-255)
+    int hist_diff;          // % of samples that changed histogram bin
+    int motion;             // Smoothed motion score (0-100)
+    int cut;                // Scene cut (bool)
+
+    uint64_t frames;
+    uint64_t cuts;
+} SceneDetect;
+
+/*
+ * Reset, the next frame only primes the comparison
+ */
+void scene_detect_init(SceneDetect *sd);
+
+/*
+ * Analyze a frame's luma plane
+ *
+ * pixel_stride is the distance between two luma samples of a row (1 for
+ * planar formats, 2 for YUY2 / UYVY with luma pointing at the first Y).
+ * Returns 1 if the frame is a scene cut, 0 otherwise.
+ */
+int scene_detect_frame(SceneDetect *sd, const uint8_t *luma, int width, int height,
+                       int stride, int pixel_stride);
+
+/*
+ * Sum of absolute differences of two byte arrays, and the scalar version
+ * (for tests and benchmarks)
+ */
+uint32_t scene_sad(const uint8_t *a, const uint8_t *b, int len);
+uint32_t scene_sad_scalar(const uint8_t *a, const uint8_t *b, int len);
+
+/*
+ * Name of the SAD implementation ("sse2", "neon" or "scalar")
+ */
+const char *scene_detect_impl(void);
+
+#endif /* SCENE_DETECT_H */
@@ -0,0 +1,68 @@
+/*
+    ceracoder - live video encoder with dynamic bitrate control
+    Copyright (C) 2020 BELABOX project
+    Copyright (C) 2026 CERALIVE
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "slow_start.h"
+
+static uint64_t round_length(double rtt) {
+    return rtt > SLOW_START_MIN_ROUND ? (uint64_t)rtt : SLOW_START_MIN_ROUND;
+}
+
+void slow_start_init(SlowStart *ss, int enabled, int start_bitrate,
+                     int min_bitrate, int max_bitrate) {
+    if (start_bitrate <= 0) start_bitrate = SLOW_START_DEF_BITRATE;
+    if (start_bitrate < min_bitrate) start_bitrate = min_bitrate;
+    if (start_bitrate > max_bitrate) start_bitrate = max_bitrate;
+
+    ss->active = enabled ? 1 : 0;
+    ss->bitrate = enabled ? start_bitrate : max_bitrate;
+    ss->stable_bitrate = ss->bitrate;
+    ss->round_end = 0;
+    ss->started = 0;
+}
+
+int slow_start_step(SlowStart *ss, int congested, double rtt, uint64_t timestamp,
+                    int max_bitrate) {
+    if (!ss->active) return ss->bitrate;
+
+    if (!ss->started) {
+        ss->started = 1;
+        ss->round_end = timestamp + round_length(rtt);
+    }
+
+    // Congestion: fall back to the last bitrate that was fine and hand over
+    if (congested) {
+        ss->active = 0;
+        ss->bitrate = ss->stable_bitrate;
+        return ss->bitrate;
+    }
+
+    if (timestamp >= ss->round_end) {
+        ss->stable_bitrate = ss->bitrate;
+        if (ss->bitrate >= max_bitrate) {
+            ss->active = 0;
+            return ss->bitrate;
+        }
+
+        int64_t next = (int64_t)ss->bitrate * 2;
+        ss->bitrate = next > max_bitrate ? max_bitrate : (int)next;
+        ss->round_end = timestamp + round_length(rtt);
+    }
+
+    return ss->bitrate;
+}
@@ -0,0 +1,65 @@
+/*
+    ceracoder - live video encoder with dynamic bitrate control
+    Copyright (C) 2020 BELABOX project
+    Copyright (C) 2026 CERALIVE
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef SLOW_START_H
+#define SLOW_START_H
+
+#include <stdint.h>
+
+/*
+ * Slow start - startup ramp shared by the balancer algorithms
+ *
+ * Instead of opening every session at max_bitrate, start from a
+ * conservative bitrate and double it after every round (one RTT, but at
+ * least SLOW_START_MIN_ROUND) without congestion signals. The first
+ * congestion signal ends slow start at the last bitrate that completed a
+ * round without congestion, and the algorithm continues from there in its
+ * steady state. Slow start also ends once max_bitrate completes a round.
+ */
+
+#define SLOW_START_MIN_ROUND    500     // ms, encoders take a few hundred ms to reach a new rate
+#define SLOW_START_DEF_BITRATE  (1000 * 1000)   // bps
+
+typedef struct {
+    int active;
+    int bitrate;            // Current bitrate (bps)
+    int stable_bitrate;     // Last bitrate that completed a round without congestion
+    uint64_t round_end;     // End of the current round (ms)
+    int started;            // Set after the first step
+} SlowStart;
+
+/*
+ * Initialize, starting at start_bitrate clamped to [min_bitrate, max_bitrate]
+ *
+ * If enabled is 0, slow start is inactive and the bitrate is max_bitrate.
+ */
+void slow_start_init(SlowStart *ss, int enabled, int start_bitrate,
+                     int min_bitrate, int max_bitrate);
+
+/*
+ * Advance slow start by one update
+ *
+ * congested is set if the algorithm saw any congestion signal. Returns the
+ * bitrate to use; once ss->active is cleared the algorithm takes over from
+ * the returned bitrate.
+ */
+int slow_start_step(SlowStart *ss, int congested, double rtt, uint64_t timestamp,
+                    int max_bitrate);
+
+#endif /* SLOW_START_H */
@@ -0,0 +1,216 @@
+/*
+    ceracoder - live video encoder with dynamic bitrate control
+    Copyright (C) 2020 BELABOX project
+    Copyright (C) 2026 CERALIVE
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "stats.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define STATS_FILE_BUF_SIZE (STATS_MAX_METRICS * 256)
+
+void stats_init(Stats *stats) {
+    memset(stats, 0, sizeof(*stats));
+}
+
+static StatsMetric *stats_lookup(Stats *stats, const char *name,
+                                 StatsType type, const char *help) {
+    for (int i = 0; i < stats->n_metrics; i++) {
+        if (strcmp(stats->metrics[i].name, name) == 0) {
+            return &stats->metrics[i];
+        }
+    }
+
+    if (stats->n_metrics >= STATS_MAX_METRICS) return NULL;
+    if (strlen(name) >= STATS_NAME_LEN) return NULL;
+
+    StatsMetric *m = &stats->metrics[stats->n_metrics++];
+    strcpy(m->name, name);
+    m->help = help;
+    m->type = type;
+    m->value = 0;
+    return m;
+}
+
+int stats_set(Stats *stats, const char *name, StatsType type,
+              const char *help, double value) {
+    StatsMetric *m = stats_lookup(stats, name, type, help);
+    if (m == NULL) return -1;
+    m->value = value;
+    return 0;
+}
+
+int stats_add(Stats *stats, const char *name, StatsType type,
+              const char *help, double delta) {
+    StatsMetric *m = stats_lookup(stats, name, type, help);
+    if (m == NULL) return -1;
+    m->value += delta;
+    return 0;
+}
+
+int stats_set_histogram(Stats *stats, const char *name, const char *labels,
+                        const char *help, const double *bounds, int n_bounds,
+                        const uint64_t *counts, double sum) {
+    char metric[STATS_NAME_LEN];
+    const char *sep = (labels != NULL && labels[0] != '\0') ? "," : "";
+    if (labels == NULL) labels = "";
+    uint64_t total = 0;
+    int ret = 0;
+
+    for (int i = 0; i <= n_bounds; i++) {
+        total += counts[i];
+        char le[32];
+        if (i < n_bounds) {
+            snprintf(le, sizeof(le), "%g", bounds[i]);
+        } else {
+            strcpy(le, "+Inf");
+        }
+        int len = snprintf(metric, sizeof(metric), "%s_bucket{%s%sle=\"%s\"}",
+                           name, labels, sep, le);
+        if (len < 0 || (size_t)len >= sizeof(metric)) return -1;
+        ret |= stats_set(stats, metric, STATS_HISTOGRAM, help, (double)total);
+    }
+
+    const char *suffixes[] = { "_sum", "_count" };
+    double values[] = { sum, (double)total };
+    for (int i = 0; i < 2; i++) {
+        int len = labels[0] != '\0' ?
+            snprintf(metric, sizeof(metric), "%s%s{%s}", name, suffixes[i], labels) :
+            snprintf(metric, sizeof(metric), "%s%s", name, suffixes[i]);
+        if (len < 0 || (size_t)len >= sizeof(metric)) return -1;
+        ret |= stats_set(stats, metric, STATS_HISTOGRAM, help, values[i]);
+    }
+
+    return ret;
+}
+
+double stats_get(const Stats *stats, const char *name) {
+    for (int i = 0; i < stats->n_metrics; i++) {
+        if (strcmp(stats->metrics[i].name, name) == 0) {
+            return stats->metrics[i].value;
+        }
+    }
+    return 0;
+}
+
+// Length of the metric name without its labels
+static size_t base_name_len(const char *name) {
+    const char *brace = strchr(name, '{');
+    return brace ? (size_t)(brace - name) : strlen(name);
+}
+
+// Length of the metric family name: without labels, and for histograms
+// without the _bucket / _sum / _count suffix
+static size_t family_name_len(const StatsMetric *m) {
+    size_t len = base_name_len(m->name);
+    if (m->type != STATS_HISTOGRAM) return len;
+
+    const char *suffixes[] = { "_bucket", "_sum", "_count" };
+    for (int i = 0; i < 3; i++) {
+        size_t slen = strlen(suffixes[i]);
+        if (len > slen && strncmp(m->name + len - slen, suffixes[i], slen) == 0) {
+            return len - slen;
+        }
+    }
+    return len;
+}
+
+// HELP / TYPE are only emitted for the first metric of a family
+static int family_seen(const Stats *stats, int idx) {
+    const StatsMetric *m = &stats->metrics[idx];
+    size_t len = family_name_len(m);
+    for (int i = 0; i < idx; i++) {
+        const StatsMetric *other = &stats->metrics[i];
+        if (family_name_len(other) == len && strncmp(other->name, m->name, len) == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static const char *type_name(StatsType type) {
+    switch (type) {
+        case STATS_COUNTER:
+            return "counter";
+        case STATS_HISTOGRAM:
+            return "histogram";
+        default:
+            return "gauge";
+    }
+}
+
+int stats_format(const Stats *stats, char *buf, size_t size) {
+    size_t off = 0;
+
+    for (int i = 0; i < stats->n_metrics; i++) {
+        const StatsMetric *m = &stats->metrics[i];
+        int len = (int)family_name_len(m);
+        int ret;
+
+        if (!family_seen(stats, i)) {
+            if (m->help != NULL) {
+                ret = snprintf(buf + off, size - off, "# HELP %.*s %s\n", len, m->name, m->help);
+                if (ret < 0 || (size_t)ret >= size - off) return -1;
+                off += ret;
+            }
+            ret = snprintf(buf + off, size - off, "# TYPE %.*s %s\n", len, m->name,
+                           type_name(m->type));
+            if (ret < 0 || (size_t)ret >= size - off) return -1;
+            off += ret;
+        }
+
+        ret = snprintf(buf + off, size - off, "%s %.17g\n", m->name, m->value);
+        if (ret < 0 || (size_t)ret >= size - off) return -1;
+        off += ret;
+    }
+
+    if (size > 0) buf[off] = '\0';
+    return (int)off;
+}
+
+int stats_write_file(const Stats *stats, const char *filename) {
+    char *buf = malloc(STATS_FILE_BUF_SIZE);
+    if (buf == NULL) return -1;
+
+    int len = stats_format(stats, buf, STATS_FILE_BUF_SIZE);
+    if (len < 0) goto ret_err;
+
+    char tmp_filename[4096];
+    int ret = snprintf(tmp_filename, sizeof(tmp_filename), "%s.tmp", filename);
+    if (ret < 0 || (size_t)ret >= sizeof(tmp_filename)) goto ret_err;
+
+    FILE *f = fopen(tmp_filename, "w");
+    if (f == NULL) goto ret_err;
+    size_t written = fwrite(buf, 1, len, f);
+    if (fclose(f) != 0 || written != (size_t)len) {
+        remove(tmp_filename);
+        goto ret_err;
+    }
+
+    if (rename(tmp_filename, filename) != 0) {
+        remove(tmp_filename);
+        goto ret_err;
+    }
+
+    free(buf);
+    return 0;
+
+ret_err:
+    free(buf);
+    return -1;
+}
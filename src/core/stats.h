@@ -0,0 +1,113 @@
+/*
+    ceracoder - live video encoder with dynamic bitrate control
+    Copyright (C) 2020 BELABOX project
+    Copyright (C) 2026 CERALIVE
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef STATS_H
+#define STATS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Stats module - named runtime metrics exported as a text file
+ *
+ * Modules publish gauges and counters by name; the main loop periodically
+ * writes them to the file set with stats_file in the config, in the
+ * Prometheus text exposition format (node_exporter textfile collector,
+ * or just `cat`). Names may carry labels, e.g.
+ * "ceracoder_mux_input_lag_ms{input=\"sink_65\"}".
+ *
+ * Not thread-safe: update from the main loop only.
+ */
+
+#define STATS_MAX_METRICS   384
+#define STATS_NAME_LEN      96
+
+typedef enum {
+    STATS_GAUGE,
+    STATS_COUNTER,
+    STATS_HISTOGRAM,    // _bucket / _sum / _count series, see stats_set_histogram()
+} StatsType;
+
+typedef struct {
+    char name[STATS_NAME_LEN];
+    const char *help;       // Static string, may be NULL
+    StatsType type;
+    double value;
+} StatsMetric;
+
+typedef struct {
+    StatsMetric metrics[STATS_MAX_METRICS];
+    int n_metrics;
+} Stats;
+
+/*
+ * Initialize an empty metric set
+ */
+void stats_init(Stats *stats);
+
+/*
+ * Set a gauge / counter, creating it on first use
+ *
+ * Returns 0 on success, -1 if the table is full or the name too long.
+ */
+int stats_set(Stats *stats, const char *name, StatsType type,
+              const char *help, double value);
+
+/*
+ * Add to a counter (or gauge), creating it on first use
+ *
+ * Returns 0 on success, -1 on error.
+ */
+int stats_add(Stats *stats, const char *name, StatsType type,
+              const char *help, double delta);
+
+/*
+ * Set a histogram from per-bucket (non-cumulative) counts
+ *
+ * bounds holds the n_bounds upper bucket bounds in increasing order; counts
+ * holds n_bounds + 1 entries, the last one for values above the last bound.
+ * labels is NULL or a label list without braces, e.g. "state=\"heavy\"".
+ * Creates name_bucket{...,le="..."}, name_sum and name_count.
+ *
+ * Returns 0 on success, -1 on error.
+ */
+int stats_set_histogram(Stats *stats, const char *name, const char *labels,
+                        const char *help, const double *bounds, int n_bounds,
+                        const uint64_t *counts, double sum);
+
+/*
+ * Get a metric value, or 0 if it doesn't exist
+ */
+double stats_get(const Stats *stats, const char *name);
+
+/*
+ * Format all metrics in the Prometheus text format
+ *
+ * Returns the formatted length (excluding the NUL), or -1 if buf is too small.
+ */
+int stats_format(const Stats *stats, char *buf, size_t size);
+
+/*
+ * Write all metrics to filename, atomically (via a temporary file + rename)
+ *
+ * Returns 0 on success, -1 on error.
+ */
+int stats_write_file(const Stats *stats, const char *filename);
+
+#endif /* STATS_H */
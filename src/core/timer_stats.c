@@ -0,0 +1,108 @@
+/*
+    ceracoder - live video encoder with dynamic bitrate control
+    Copyright (C) 2020 BELABOX project
+    Copyright (C) 2026 CERALIVE
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "timer_stats.h"
+#include <stdio.h>
+#include <string.h>
+
+const double timer_stats_bounds[TIMER_STATS_BUCKETS] = {
+    0.5, 1, 2, 5, 10, 20, 50, 100, 200, 500
+};
+
+void timer_hist_add(TimerHist *hist, double value) {
+    if (value < 0) value = 0;
+
+    int bucket = 0;
+    while (bucket < TIMER_STATS_BUCKETS && value > timer_stats_bounds[bucket]) {
+        bucket++;
+    }
+    hist->counts[bucket]++;
+    hist->count++;
+    hist->sum += value;
+    if (value > hist->max) hist->max = value;
+}
+
+double timer_hist_quantile(const TimerHist *hist, double q) {
+    if (hist->count == 0) return 0;
+
+    double rank = q * hist->count;
+    uint64_t seen = 0;
+    for (int i = 0; i <= TIMER_STATS_BUCKETS; i++) {
+        if (hist->counts[i] == 0 || seen + hist->counts[i] < rank) {
+            seen += hist->counts[i];
+            continue;
+        }
+
+        double lower = i > 0 ? timer_stats_bounds[i - 1] : 0;
+        double upper = i < TIMER_STATS_BUCKETS ? timer_stats_bounds[i] : hist->max;
+        if (upper > hist->max) upper = hist->max;
+        if (upper < lower) return upper;
+        return lower + (upper - lower) * (rank - seen) / hist->counts[i];
+    }
+    return hist->max;
+}
+
+void timer_stats_init(TimerStats *ts, const char *name, int interval_ms) {
+    memset(ts, 0, sizeof(*ts));
+    snprintf(ts->name, sizeof(ts->name), "%s", name);
+    ts->interval_ms = interval_ms;
+}
+
+void timer_stats_record(TimerStats *ts, double lateness_ms, double runtime_ms) {
+    timer_hist_add(&ts->lateness, lateness_ms);
+    timer_hist_add(&ts->runtime, runtime_ms);
+    timer_hist_add(&ts->win_lateness, lateness_ms);
+    timer_hist_add(&ts->win_runtime, runtime_ms);
+}
+
+int timer_stats_check(TimerStats *ts, double threshold_ms,
+                      double *lateness_p99, double *runtime_p99) {
+    int empty = ts->win_lateness.count == 0;
+    *lateness_p99 = timer_hist_quantile(&ts->win_lateness, 0.99);
+    *runtime_p99 = timer_hist_quantile(&ts->win_runtime, 0.99);
+
+    memset(&ts->win_lateness, 0, sizeof(ts->win_lateness));
+    memset(&ts->win_runtime, 0, sizeof(ts->win_runtime));
+
+    if (empty) return 0;
+    return *lateness_p99 > threshold_ms || *runtime_p99 > threshold_ms;
+}
+
+void timer_stats_publish(const TimerStats *ts, Stats *stats) {
+    char labels[48];
+    char name[STATS_NAME_LEN];
+    snprintf(labels, sizeof(labels), "timer=\"%s\"", ts->name);
+
+    stats_set_histogram(stats, "ceracoder_timer_lateness_ms", labels,
+                        "Timer callback time minus its scheduled time",
+                        timer_stats_bounds, TIMER_STATS_BUCKETS,
+                        ts->lateness.counts, ts->lateness.sum);
+    stats_set_histogram(stats, "ceracoder_timer_runtime_ms", labels,
+                        "Time spent in the timer callback",
+                        timer_stats_bounds, TIMER_STATS_BUCKETS,
+                        ts->runtime.counts, ts->runtime.sum);
+
+    snprintf(name, sizeof(name), "ceracoder_timer_lateness_ms_max{%s}", labels);
+    stats_set(stats, name, STATS_GAUGE, "Latest timer callback relative to its schedule",
+              ts->lateness.max);
+    snprintf(name, sizeof(name), "ceracoder_timer_runtime_ms_max{%s}", labels);
+    stats_set(stats, name, STATS_GAUGE, "Slowest timer callback", ts->runtime.max);
+    snprintf(name, sizeof(name), "ceracoder_timer_interval_ms{%s}", labels);
+    stats_set(stats, name, STATS_GAUGE, "Nominal timer interval", ts->interval_ms);
+}
@@ -0,0 +1,101 @@
+/*
+    ceracoder - live video encoder with dynamic bitrate control
+    Copyright (C) 2020 BELABOX project
+    Copyright (C) 2026 CERALIVE
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef TIMER_STATS_H
+#define TIMER_STATS_H
+
+#include <stdint.h>
+
+#include "stats.h"
+
+/*
+ * Timer stats - lateness and runtime histograms of a periodic callback
+ *
+ * Lateness is the actual fire time minus the scheduled fire time, runtime
+ * the time spent in the callback. Both are kept since startup (exported)
+ * and over a check window, whose p99 is compared against a threshold and
+ * then reset.
+ *
+ * Not thread-safe: the caller serializes record / check / publish.
+ */
+
+#define TIMER_STATS_BUCKETS     10
+#define TIMER_STATS_NAME_LEN    32
+
+typedef struct {
+    uint64_t counts[TIMER_STATS_BUCKETS + 1];  // Last entry: above the last bound
+    uint64_t count;
+    double sum;
+    double max;
+} TimerHist;
+
+typedef struct {
+    char name[TIMER_STATS_NAME_LEN];
+    int interval_ms;
+
+    TimerHist lateness;         // Since startup
+    TimerHist runtime;
+    TimerHist win_lateness;     // Since the last timer_stats_check()
+    TimerHist win_runtime;
+} TimerStats;
+
+/*
+ * Upper bucket bounds shared by all histograms (ms)
+ */
+extern const double timer_stats_bounds[TIMER_STATS_BUCKETS];
+
+/*
+ * Add a value (ms)
+ */
+void timer_hist_add(TimerHist *hist, double value);
+
+/*
+ * Estimate a quantile (0-1), interpolating linearly inside the bucket
+ *
+ * Values in the overflow bucket are interpolated up to the max seen.
+ * Returns 0 for an empty histogram.
+ */
+double timer_hist_quantile(const TimerHist *hist, double q);
+
+/*
+ * Initialize the stats of the named timer
+ */
+void timer_stats_init(TimerStats *ts, const char *name, int interval_ms);
+
+/*
+ * Record one callback run
+ */
+void timer_stats_record(TimerStats *ts, double lateness_ms, double runtime_ms);
+
+/*
+ * Close the check window
+ *
+ * Stores the window p99 lateness / runtime, then resets the window.
+ * Returns 1 if either p99 exceeds threshold_ms, 0 otherwise (or if the
+ * window is empty).
+ */
+int timer_stats_check(TimerStats *ts, double threshold_ms,
+                      double *lateness_p99, double *runtime_p99);
+
+/*
+ * Publish the lateness and runtime histograms, labelled timer="name"
+ */
+void timer_stats_publish(const TimerStats *ts, Stats *stats);
+
+#endif /* TIMER_STATS_H */
@@ -18,12 +18,184 @@
 */
 
 #include "encoder_control.h"
+#include "trace.h"
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
-int encoder_control_init(EncoderControl *enc, GstPipeline *pipeline) {
-    enc->element = NULL;
+/*
+  Measures the encoder output rate over ENCODER_SETTLE_WINDOW_MS windows. After a
+  bitrate change, the first window that starts after the change and is within the
+  tolerance of the target gives the settling time
+*/
+static GstPadProbeReturn output_probe(GstPad *pad, GstPadProbeInfo *info, gpointer user_data) {
+    (void)pad;
+    EncoderControl *enc = (EncoderControl *)user_data;
+    GstBuffer *buf = GST_PAD_PROBE_INFO_BUFFER(info);
+    int64_t now = g_get_monotonic_time();
+
+    g_mutex_lock(&enc->lock);
+
+    enc->window_bytes += gst_buffer_get_size(buf);
+    enc->last_output = now;
+    int64_t elapsed = now - enc->window_start;
+    if (elapsed >= ENCODER_SETTLE_WINDOW_MS * 1000) {
+        enc->output_bps = (int)(enc->window_bytes * 8 * 1000000 / elapsed);
+
+        if (enc->settle_pending && enc->window_start >= enc->change_time) {
+            int target = enc->current_bitrate;
+            uint64_t settle_ms = (now - enc->change_time) / 1000;
+            if (abs(enc->output_bps - target) <= target * ENCODER_SETTLE_TOLERANCE) {
+                enc->settle_pending = 0;
+                enc->settle_count++;
+                enc->settle_total_ms += settle_ms;
+                enc->settle_last_ms = settle_ms;
+                if (settle_ms > enc->settle_max_ms) enc->settle_max_ms = settle_ms;
+            } else if (settle_ms >= ENCODER_SETTLE_TIMEOUT_MS) {
+                enc->settle_pending = 0;
+                enc->settle_timeouts++;
+            }
+        }
+
+        enc->window_start = now;
+        enc->window_bytes = 0;
+    }
+
+    g_mutex_unlock(&enc->lock);
+
+    return GST_PAD_PROBE_OK;
+}
+
+/*
+  H.264 passthrough: branch switching. A switch opens the valve of the branch
+  switched to and waits for its first keyframe at the selector before making
+  it the active pad and closing the other valve
+*/
+static GstPadProbeReturn switch_probe(GstPad *pad, GstPadProbeInfo *info, gpointer user_data) {
+    EncoderControl *enc = (EncoderControl *)user_data;
+    GstBuffer *buf = GST_PAD_PROBE_INFO_BUFFER(info);
+    if (GST_BUFFER_FLAG_IS_SET(buf, GST_BUFFER_FLAG_DELTA_UNIT)) {
+        return GST_PAD_PROBE_OK;
+    }
+
+    g_mutex_lock(&enc->switch_lock);
+    if (enc->switch_pad == pad) {
+        int to_transcode = (pad == enc->transcode_pad);
+        g_object_set(G_OBJECT(enc->selector), "active-pad", pad, NULL);
+        g_object_set(G_OBJECT(to_transcode ? enc->pass_valve : enc->transcode_valve),
+                     "drop", TRUE, NULL);
+        enc->switch_probe_id = 0;
+        enc->switch_pad = NULL;
+        fprintf(stderr, "Encoder: switched to %s\n", to_transcode ? "transcoding" : "passthrough");
+    }
+    g_mutex_unlock(&enc->switch_lock);
+
+    return GST_PAD_PROBE_REMOVE;
+}
+
+static void switch_branch(EncoderControl *enc, int transcode) {
+    g_mutex_lock(&enc->switch_lock);
+
+    enc->transcoding = transcode;
+    if (enc->switch_probe_id != 0) {
+        // Reverting a switch that hasn't happened yet: the branch asked for is still active
+        gst_pad_remove_probe(enc->switch_pad, enc->switch_probe_id);
+        g_object_set(G_OBJECT(transcode ? enc->pass_valve : enc->transcode_valve),
+                     "drop", TRUE, NULL);
+        enc->switch_probe_id = 0;
+        enc->switch_pad = NULL;
+    } else {
+        g_object_set(G_OBJECT(transcode ? enc->transcode_valve : enc->pass_valve),
+                     "drop", FALSE, NULL);
+        enc->switch_pad = transcode ? enc->transcode_pad : enc->pass_pad;
+        enc->switch_probe_id = gst_pad_add_probe(enc->switch_pad, GST_PAD_PROBE_TYPE_BUFFER,
+                                                 switch_probe, enc, NULL);
+        fprintf(stderr, "Encoder: target %s the camera minimum, switching to %s at the next keyframe\n",
+                transcode ? "below" : "back above", transcode ? "transcoding" : "passthrough");
+    }
+    if (transcode) {
+        enc->transcode_switches++;
+    } else {
+        enc->passthrough_switches++;
+    }
+
+    g_mutex_unlock(&enc->switch_lock);
+}
+
+// The selector sink pad a valve feeds
+static GstPad *valve_peer(GstElement *valve) {
+    GstPad *src = gst_element_get_static_pad(valve, "src");
+    if (src == NULL) return NULL;
+    GstPad *peer = gst_pad_get_peer(src);
+    gst_object_unref(src);
+    return peer;
+}
+
+static void passthrough_init(EncoderControl *enc, GstPipeline *pipeline) {
+    enc->selector = gst_bin_get_by_name(GST_BIN(pipeline), "venc_select");
+    enc->pass_valve = gst_bin_get_by_name(GST_BIN(pipeline), "venc_pass");
+    enc->transcode_valve = gst_bin_get_by_name(GST_BIN(pipeline), "venc_transcode");
+    if (enc->selector != NULL && enc->pass_valve != NULL && enc->transcode_valve != NULL) {
+        enc->pass_pad = valve_peer(enc->pass_valve);
+        enc->transcode_pad = valve_peer(enc->transcode_valve);
+    }
+
+    if (enc->pass_pad == NULL || enc->transcode_pad == NULL || enc->element == NULL) {
+        fprintf(stderr, "H.264 passthrough without a transcode fallback\n");
+        g_clear_object(&enc->pass_pad);
+        g_clear_object(&enc->transcode_pad);
+        g_clear_object(&enc->selector);
+        g_clear_object(&enc->pass_valve);
+        g_clear_object(&enc->transcode_valve);
+        return;
+    }
+
+    g_object_set(G_OBJECT(enc->pass_valve), "drop", FALSE, NULL);
+    g_object_set(G_OBJECT(enc->transcode_valve), "drop", TRUE, NULL);
+    g_object_set(G_OBJECT(enc->selector), "active-pad", enc->pass_pad, NULL);
+    fprintf(stderr, "H.264 passthrough, transcoding below the camera's minimum bitrate\n");
+}
+
+// The camera only reports its range once it is streaming
+static void camera_query_range(EncoderControl *enc) {
+    gint min = 0, def = 0, max = 0;
+    gboolean ok = FALSE;
+    g_signal_emit_by_name(enc->camera, "get-int-setting", "average-bitrate", &min, &def, &max, &ok);
+    if (!ok) return;
+
+    enc->camera_range_known = 1;
+    enc->camera_min_bps = min;
+    enc->camera_max_bps = max;
+    fprintf(stderr, "UVC camera bitrate range: %d - %d Kbps\n", min / 1000, max / 1000);
+}
+
+static void camera_set_bitrate(EncoderControl *enc, int bitrate_bps) {
+    if (!enc->camera_range_known) camera_query_range(enc);
+
+    if (enc->selector != NULL) {
+        int transcode = encoder_passthrough_select(enc->transcoding, bitrate_bps,
+                                                   enc->camera_min_bps);
+        if (transcode != enc->transcoding) switch_branch(enc, transcode);
+    }
+
+    int camera_bps = bitrate_bps;
+    if (enc->camera_min_bps > 0 && camera_bps < enc->camera_min_bps) camera_bps = enc->camera_min_bps;
+    if (enc->camera_max_bps > 0 && camera_bps > enc->camera_max_bps) camera_bps = enc->camera_max_bps;
+    g_object_set(G_OBJECT(enc->camera), "average-bitrate", camera_bps,
+                 "peak-bitrate", camera_bps, NULL);
+
+    if (enc->transcoding) {
+        g_object_set(G_OBJECT(enc->element), enc->bitrate_prop, bitrate_bps / enc->bitrate_div, NULL);
+    }
+}
+
+int encoder_control_init(EncoderControl *enc, GstPipeline *pipeline,
+                         const EncoderPolicyConfig *policy) {
+    memset(enc, 0, sizeof(*enc));
     enc->bitrate_div = 1;
-    enc->current_bitrate = 0;
+    g_mutex_init(&enc->lock);
+    g_mutex_init(&enc->switch_lock);
+    encoder_policy_init(&enc->policy, policy);
 
     // Try to find encoder by name (bps first, then kbps)
     enc->element = gst_bin_get_by_name(GST_BIN(pipeline), "venc_bps");
@@ -31,31 +203,282 @@ int encoder_control_init(EncoderControl *enc, GstPipeline *pipeline) {
         enc->element = gst_bin_get_by_name(GST_BIN(pipeline), "venc_kbps");
         enc->bitrate_div = 1000;
     }
-
     if (!GST_IS_ELEMENT(enc->element)) {
+        enc->element = NULL;
+    } else {
+        GObjectClass *klass = G_OBJECT_GET_CLASS(enc->element);
+        enc->bitrate_prop = g_object_class_find_property(klass, "bps") ? "bps" : "bitrate";
+    }
+
+    enc->camera = gst_bin_get_by_name(GST_BIN(pipeline), "venc_uvc");
+    if (!GST_IS_ELEMENT(enc->camera)) {
+        enc->camera = NULL;
+    }
+
+    if (enc->element == NULL && enc->camera == NULL) {
         fprintf(stderr, "Failed to get an encoder element from the pipeline, "
                         "no dynamic bitrate control\n");
-        enc->element = NULL;
         return -1;
     }
 
+    GstElement *named = enc->camera != NULL ? enc->camera : enc->element;
+    GstElementFactory *factory = gst_element_get_factory(named);
+    snprintf(enc->factory, sizeof(enc->factory), "%s",
+             factory ? gst_plugin_feature_get_name(GST_PLUGIN_FEATURE(factory)) : "unknown");
+
+    // The output rate is measured where the stream leaves the encoder (or the selector)
+    if (enc->camera != NULL) {
+        passthrough_init(enc, pipeline);
+        enc->src_pad = enc->selector != NULL ?
+                       gst_element_get_static_pad(enc->selector, "src") :
+                       gst_element_get_static_pad(enc->camera, "vidsrc");
+    } else {
+        enc->src_pad = gst_element_get_static_pad(enc->element, "src");
+    }
+
+    enc->window_start = g_get_monotonic_time();
+    if (enc->src_pad != NULL) {
+        enc->probe_id = gst_pad_add_probe(enc->src_pad, GST_PAD_PROBE_TYPE_BUFFER,
+                                          output_probe, enc, NULL);
+    }
+
     return 0;
 }
 
+// Low latency settings per encoder factory, applied in order
+static const struct {
+    const char *factory;
+    const char *property;
+    const char *value;
+} low_latency_tuning[] = {
+    {"x264enc", "tune", "zerolatency"},
+    {"x264enc", "bframes", "0"},
+    {"x264enc", "rc-lookahead", "0"},
+    {"x264enc", "sync-lookahead", "0"},
+    {"x264enc", "sliced-threads", "true"},
+    {"x265enc", "tune", "zerolatency"},
+    {"nvv4l2h264enc", "num-B-Frames", "0"},
+    {"nvv4l2h264enc", "maxperf-enable", "true"},
+    {"nvv4l2h265enc", "num-B-Frames", "0"},
+    {"nvv4l2h265enc", "maxperf-enable", "true"},
+    {"qsvh264enc", "b-frames", "0"},
+    {"qsvh264enc", "low-latency", "true"},
+    {"qsvh265enc", "b-frames", "0"},
+    {"qsvh265enc", "low-latency", "true"},
+};
+
+int encoder_control_tune_low_latency(EncoderControl *enc) {
+    if (enc->element == NULL) return 0;
+
+    // enc->factory is the camera's in passthrough
+    GstElementFactory *factory = gst_element_get_factory(enc->element);
+    if (factory == NULL) return 0;
+    const char *name = gst_plugin_feature_get_name(GST_PLUGIN_FEATURE(factory));
+
+    int count = 0;
+    GObjectClass *klass = G_OBJECT_GET_CLASS(enc->element);
+    for (size_t i = 0; i < sizeof(low_latency_tuning) / sizeof(low_latency_tuning[0]); i++) {
+        if (strcmp(low_latency_tuning[i].factory, name) != 0) continue;
+        if (g_object_class_find_property(klass, low_latency_tuning[i].property) == NULL) continue;
+
+        gst_util_set_object_arg(G_OBJECT(enc->element), low_latency_tuning[i].property,
+                                low_latency_tuning[i].value);
+        fprintf(stderr, "Low latency: %s %s=%s\n", name,
+                low_latency_tuning[i].property, low_latency_tuning[i].value);
+        count++;
+    }
+    return count;
+}
+
 int encoder_control_set_bitrate(EncoderControl *enc, int bitrate_bps) {
-    if (!GST_IS_ELEMENT(enc->element)) {
+    if (!encoder_control_available(enc)) {
         return -1;
     }
 
-    // Only update if changed
-    if (bitrate_bps != enc->current_bitrate) {
-        enc->current_bitrate = bitrate_bps;
-        g_object_set(G_OBJECT(enc->element), "bps", bitrate_bps / enc->bitrate_div, NULL);
+    int64_t now = g_get_monotonic_time();
+    EncoderPolicyDecision decision = encoder_policy_decide(&enc->policy, bitrate_bps,
+                                                           (uint64_t)(now / 1000));
+    if (decision != ENCODER_POLICY_APPLY && decision != ENCODER_POLICY_APPLY_FAST) {
+        return 0;
     }
 
+    TRACE1(encoder_set_start, bitrate_bps);
+    if (enc->camera != NULL) {
+        camera_set_bitrate(enc, bitrate_bps);
+    } else {
+        g_object_set(G_OBJECT(enc->element), enc->bitrate_prop, bitrate_bps / enc->bitrate_div, NULL);
+    }
+    TRACE1(encoder_set_done, bitrate_bps);
+    uint64_t cost_us = (uint64_t)(g_get_monotonic_time() - now);
+
+    enc->set_count++;
+    enc->set_total_us += cost_us;
+    enc->set_last_us = cost_us;
+    if (cost_us > enc->set_max_us) enc->set_max_us = cost_us;
+
+    g_mutex_lock(&enc->lock);
+    enc->current_bitrate = bitrate_bps;
+    enc->change_time = now;
+    enc->settle_pending = 1;
+    g_mutex_unlock(&enc->lock);
+
     return 0;
 }
 
 int encoder_control_available(const EncoderControl *enc) {
-    return GST_IS_ELEMENT(enc->element) ? 1 : 0;
+    return (enc->element != NULL || enc->camera != NULL) ? 1 : 0;
+}
+
+void encoder_control_publish_stats(EncoderControl *enc, Stats *stats) {
+    if (!encoder_control_available(enc)) return;
+
+    char name[STATS_NAME_LEN];
+#define ENC_STAT(metric, type, help, value) \
+    snprintf(name, sizeof(name), "ceracoder_encoder_" metric "{factory=\"%s\"}", enc->factory); \
+    stats_set(stats, name, type, help, value)
+
+    ENC_STAT("reconfig_total", STATS_COUNTER, "Encoder bitrate changes applied", enc->set_count);
+    ENC_STAT("reconfig_fast_total", STATS_COUNTER, "Bitrate decreases applied via the fast path",
+             enc->policy.fast_changes);
+    ENC_STAT("reconfig_coalesced_total", STATS_COUNTER, "Bitrate targets held back by the policy",
+             enc->policy.coalesced);
+    ENC_STAT("reconfig_cost_us_total", STATS_COUNTER, "Time spent setting the encoder bitrate",
+             enc->set_total_us);
+    ENC_STAT("reconfig_cost_us_max", STATS_GAUGE, "Slowest encoder bitrate set", enc->set_max_us);
+    ENC_STAT("reconfig_cost_us_last", STATS_GAUGE, "Last encoder bitrate set", enc->set_last_us);
+    if (enc->camera != NULL) {
+        ENC_STAT("camera_min_bps", STATS_GAUGE, "Lowest bitrate the camera accepts",
+                 enc->camera_min_bps);
+        if (enc->selector != NULL) {
+            ENC_STAT("transcoding", STATS_GAUGE, "Transcode fallback selected", enc->transcoding);
+            ENC_STAT("transcode_switches_total", STATS_COUNTER,
+                     "Switches from passthrough to transcoding", enc->transcode_switches);
+            ENC_STAT("passthrough_switches_total", STATS_COUNTER,
+                     "Switches from transcoding back to passthrough", enc->passthrough_switches);
+        }
+    }
+
+    g_mutex_lock(&enc->lock);
+    ENC_STAT("bitrate_bps", STATS_GAUGE, "Bitrate applied to the encoder", enc->current_bitrate);
+    ENC_STAT("output_bps", STATS_GAUGE, "Measured encoder output rate", enc->output_bps);
+    ENC_STAT("settle_total", STATS_COUNTER, "Bitrate changes the output rate settled after",
+             enc->settle_count);
+    ENC_STAT("settle_timeouts_total", STATS_COUNTER, "Bitrate changes the output rate did not settle after",
+             enc->settle_timeouts);
+    ENC_STAT("settle_ms_total", STATS_COUNTER, "Total output rate settling time", enc->settle_total_ms);
+    ENC_STAT("settle_ms_max", STATS_GAUGE, "Slowest output rate settling time", enc->settle_max_ms);
+    ENC_STAT("settle_ms_last", STATS_GAUGE, "Last output rate settling time", enc->settle_last_ms);
+    g_mutex_unlock(&enc->lock);
+
+#undef ENC_STAT
+}
+
+void encoder_control_cleanup(EncoderControl *enc) {
+    if (enc->src_pad != NULL) {
+        gst_pad_remove_probe(enc->src_pad, enc->probe_id);
+        gst_object_unref(enc->src_pad);
+        enc->src_pad = NULL;
+    }
+    if (enc->switch_probe_id != 0) {
+        gst_pad_remove_probe(enc->switch_pad, enc->switch_probe_id);
+        enc->switch_probe_id = 0;
+    }
+    g_clear_object(&enc->pass_pad);
+    g_clear_object(&enc->transcode_pad);
+    g_clear_object(&enc->selector);
+    g_clear_object(&enc->pass_valve);
+    g_clear_object(&enc->transcode_valve);
+    g_clear_object(&enc->camera);
+    if (enc->element != NULL) {
+        gst_object_unref(enc->element);
+        enc->element = NULL;
+    }
+    g_mutex_clear(&enc->switch_lock);
+    g_mutex_clear(&enc->lock);
+}
+
+// Set an enum property by nick if the element's version has that value
+static int set_enum_nick(GstElement *element, const char *property, const char *nick) {
+    GParamSpec *spec = g_object_class_find_property(G_OBJECT_GET_CLASS(element), property);
+    if (spec == NULL || !G_IS_PARAM_SPEC_ENUM(spec) ||
+        g_enum_get_value_by_nick(G_PARAM_SPEC_ENUM(spec)->enum_class, nick) == NULL) {
+        return -1;
+    }
+    gst_util_set_object_arg(G_OBJECT(element), property, nick);
+    return 0;
+}
+
+int audio_control_init(AudioControl *ac, GstPipeline *pipeline, int frame_ms, int low_latency) {
+    memset(ac, 0, sizeof(*ac));
+
+    ac->element = gst_bin_get_by_name(GST_BIN(pipeline), "aenc");
+    if (!GST_IS_ELEMENT(ac->element)) {
+        ac->element = NULL;
+        return -1;
+    }
+
+    GstElementFactory *factory = gst_element_get_factory(ac->element);
+    snprintf(ac->factory, sizeof(ac->factory), "%s",
+             factory ? gst_plugin_feature_get_name(GST_PLUGIN_FEATURE(factory)) : "unknown");
+    ac->opus = strcmp(ac->factory, "opusenc") == 0;
+    if (!ac->opus) {
+        fprintf(stderr, "Audio encoder: %s, bitrate as in the pipeline\n", ac->factory);
+        return 0;
+    }
+
+    gint bitrate = 0;
+    g_object_get(G_OBJECT(ac->element), "bitrate", &bitrate, NULL);
+    ac->max_bitrate = bitrate;
+    ac->current_bitrate = bitrate;
+
+    char frame[8];
+    snprintf(frame, sizeof(frame), "%d", frame_ms);
+    if (set_enum_nick(ac->element, "frame-size", frame) != 0) {
+        fprintf(stderr, "Audio encoder: frame size %d ms not supported\n", frame_ms);
+    }
+    int low_delay = low_latency && set_enum_nick(ac->element, "audio-type",
+                                                 "restricted-lowdelay") == 0;
+
+    fprintf(stderr, "Audio encoder: opusenc, up to %d Kbps, %d ms frames%s\n",
+            ac->max_bitrate / 1000, frame_ms, low_delay ? ", low delay" : "");
+    return 0;
+}
+
+void audio_control_configure(AudioControl *ac, int min_bitrate, int complexity) {
+    if (!ac->opus) return;
+
+    ac->min_bitrate = min_bitrate;
+    if (complexity >= 0) {
+        g_object_set(G_OBJECT(ac->element), "complexity", complexity, NULL);
+    }
+}
+
+int audio_control_set_bitrate(AudioControl *ac, int video_bps) {
+    if (!ac->opus) return 0;
+
+    int bitrate = audio_bitrate_select(video_bps, ac->min_bitrate, ac->max_bitrate);
+    if (bitrate == ac->current_bitrate) return 0;
+
+    g_object_set(G_OBJECT(ac->element), "bitrate", bitrate, NULL);
+    ac->current_bitrate = bitrate;
+    ac->set_count++;
+    return 1;
+}
+
+void audio_control_publish_stats(AudioControl *ac, Stats *stats) {
+    if (!ac->opus) return;
+
+    char name[STATS_NAME_LEN];
+    snprintf(name, sizeof(name), "ceracoder_audio_bitrate_bps{factory=\"%s\"}", ac->factory);
+    stats_set(stats, name, STATS_GAUGE, "Bitrate applied to the audio encoder", ac->current_bitrate);
+    snprintf(name, sizeof(name), "ceracoder_audio_reconfig_total{factory=\"%s\"}", ac->factory);
+    stats_set(stats, name, STATS_COUNTER, "Audio encoder bitrate changes applied", ac->set_count);
+}
+
+void audio_control_cleanup(AudioControl *ac) {
+    if (ac->element != NULL) {
+        gst_object_unref(ac->element);
+        ac->element = NULL;
+    }
+    ac->opus = 0;
 }
@@ -20,40 +20,179 @@
 #ifndef ENCODER_CONTROL_H
 #define ENCODER_CONTROL_H
 
+#include <stdint.h>
 #include <gst/gst.h>
 
+#include "encoder_policy.h"
+#include "stats.h"
+
 /*
  * Encoder control module - manages video encoder bitrate updates
  *
  * This module provides an abstraction over GStreamer encoder elements,
  * allowing the balancer to update bitrate without knowing GStreamer details.
+ *
+ * Bitrate changes go through an EncoderPolicy that coalesces them. Each
+ * applied change is profiled: the time spent in the property set, and the
+ * settling time until the encoder output rate (measured on its src pad)
+ * is within ENCODER_SETTLE_TOLERANCE of the new target.
+ *
+ * H.264 passthrough: with a uvch264src named "venc_uvc", the camera's own
+ * encoder is the actuator (average-bitrate / peak-bitrate, UVC extension
+ * controls) and its stream is muxed as is. If the pipeline also has an
+ * "input-selector" named "venc_select" fed by the valves "venc_pass"
+ * (camera stream) and "venc_transcode" (decoder and venc_bps / venc_kbps),
+ * the stream is switched to the transcode branch while the target is
+ * below the camera's minimum bitrate (see encoder_passthrough_select()).
+ * Switches take effect on the next keyframe of the branch switched to.
  */
 
+#define ENCODER_SETTLE_WINDOW_MS    1000    // Output rate measurement window
+#define ENCODER_SETTLE_TOLERANCE    0.2     // Settled when within 20% of the target
+#define ENCODER_SETTLE_TIMEOUT_MS   5000    // Give up measuring after this long
+
 typedef struct {
     GstElement *element;
     int bitrate_div;         // Divisor: 1 for bps, 1000 for kbps
+    const char *bitrate_prop; // "bps" or "bitrate", whichever the encoder has
     int current_bitrate;     // Cached current bitrate (bps)
+    char factory[64];        // Encoder factory name, e.g. "x264enc"
+
+    // H.264 passthrough, camera NULL otherwise
+    GstElement *camera;      // uvch264src
+    int camera_range_known;  // Queried once the camera is streaming
+    int camera_min_bps;
+    int camera_max_bps;
+    GstElement *selector;    // Optional transcode fallback
+    GstElement *pass_valve;
+    GstElement *transcode_valve;
+    GstPad *pass_pad;        // Selector sink pads
+    GstPad *transcode_pad;
+    GMutex switch_lock;
+    gulong switch_probe_id;  // Pending switch, waiting for a keyframe
+    GstPad *switch_pad;
+    int transcoding;         // Transcode branch selected (or being switched to)
+    uint64_t transcode_switches;
+    uint64_t passthrough_switches;
+
+    EncoderPolicy policy;
+
+    // Property set cost
+    uint64_t set_count;
+    uint64_t set_total_us;
+    uint64_t set_max_us;
+    uint64_t set_last_us;
+
+    // Output rate and settling time, updated from the src pad probe
+    GMutex lock;
+    GstPad *src_pad;
+    gulong probe_id;
+    int64_t window_start;    // Monotonic time (us) of the measurement window start
+    uint64_t window_bytes;
+    int output_bps;          // Output rate over the last full window
+    int64_t last_output;     // Monotonic time (us) of the last output buffer, 0 = none yet
+    int settle_pending;
+    int64_t change_time;     // Monotonic time (us) of the last applied change
+    uint64_t settle_count;
+    uint64_t settle_timeouts;
+    uint64_t settle_total_ms;
+    uint64_t settle_max_ms;
+    uint64_t settle_last_ms;
 } EncoderControl;
 
 /*
  * Initialize encoder control from pipeline
  *
- * Looks for "venc_bps" or "venc_kbps" elements and determines units.
+ * Looks for "venc_bps" or "venc_kbps" elements and determines units, and
+ * for a "venc_uvc" camera for passthrough.
  * Returns 0 on success, -1 if no encoder found.
  */
-int encoder_control_init(EncoderControl *enc, GstPipeline *pipeline);
+int encoder_control_init(EncoderControl *enc, GstPipeline *pipeline,
+                         const EncoderPolicyConfig *policy);
 
 /*
  * Set encoder bitrate
  *
- * Only updates if the bitrate has changed from last call.
+ * Changes are coalesced by the encoder policy; the latest target is
+ * applied once the policy allows it.
  * Returns 0 on success, -1 if encoder not available.
  */
 int encoder_control_set_bitrate(EncoderControl *enc, int bitrate_bps);
 
+/*
+ * Apply the zero-latency tuning known for the encoder factory
+ *
+ * Disables lookahead and B-frames (x264enc, x265enc, nvv4l2*enc, qsv*enc);
+ * properties the element doesn't have are skipped. Must be called before
+ * the pipeline starts. Returns the number of properties set.
+ */
+int encoder_control_tune_low_latency(EncoderControl *enc);
+
 /*
  * Check if encoder is available
  */
 int encoder_control_available(const EncoderControl *enc);
 
+/*
+ * Publish reconfiguration counts and costs to stats
+ */
+void encoder_control_publish_stats(EncoderControl *enc, Stats *stats);
+
+/*
+ * Remove the output probe and release the encoder
+ */
+void encoder_control_cleanup(EncoderControl *enc);
+
+/*
+ * Audio encoder control - Opus bitrate and complexity at runtime
+ *
+ * An opusenc named "aenc" follows the balancer: its bitrate is derived
+ * from the video target with audio_bitrate_select(), up to the bitrate
+ * set in the pipeline. The frame size (and in low latency mode the
+ * restricted low delay application, 2.5 ms less lookahead) are set
+ * before the pipeline starts; the complexity can change on a config
+ * reload. Other "aenc" elements (e.g. AAC) are left as they are.
+ */
+
+typedef struct {
+    GstElement *element;     // "aenc", NULL without one
+    char factory[64];
+    int opus;                // opusenc: bitrate and complexity are adjusted
+    int min_bitrate;         // bps
+    int max_bitrate;         // Bitrate set in the pipeline (bps)
+    int current_bitrate;     // bps
+    uint64_t set_count;
+} AudioControl;
+
+/*
+ * Find "aenc"; for opusenc set the frame size (ms) and, in low latency
+ * mode, the low delay application
+ *
+ * Must be called before the pipeline starts. Returns 0 on success, -1
+ * without an "aenc" element.
+ */
+int audio_control_init(AudioControl *ac, GstPipeline *pipeline, int frame_ms, int low_latency);
+
+/*
+ * Set the minimum bitrate (bps) and the complexity (0-10, -1 = unchanged)
+ */
+void audio_control_configure(AudioControl *ac, int min_bitrate, int complexity);
+
+/*
+ * Follow a new video target (bps)
+ *
+ * Returns 1 if the audio bitrate was changed, 0 otherwise.
+ */
+int audio_control_set_bitrate(AudioControl *ac, int video_bps);
+
+/*
+ * Publish the audio bitrate and its changes to stats
+ */
+void audio_control_publish_stats(AudioControl *ac, Stats *stats);
+
+/*
+ * Release the encoder
+ */
+void audio_control_cleanup(AudioControl *ac);
+
 #endif /* ENCODER_CONTROL_H */
@@ -0,0 +1,343 @@
+/*
+    ceracoder - live video encoder with dynamic bitrate control
+    Copyright (C) 2020 BELABOX project
+    Copyright (C) 2026 CERALIVE
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "mux_monitor.h"
+#include <stdio.h>
+#include <string.h>
+
+// Current running time of the mux, or GST_CLOCK_TIME_NONE without a clock
+static GstClockTime mux_clock_running_time(GstElement *mux) {
+    GstClock *clock = gst_element_get_clock(mux);
+    if (clock == NULL) return GST_CLOCK_TIME_NONE;
+
+    GstClockTime now = gst_clock_get_time(clock);
+    GstClockTime base = gst_element_get_base_time(mux);
+    gst_object_unref(clock);
+
+    if (now < base) return GST_CLOCK_TIME_NONE;
+    return now - base;
+}
+
+// Running time of a buffer in the given segment
+static GstClockTime buffer_running_time(GstSegment *segment, GstBuffer *buf) {
+    GstClockTime ts = GST_BUFFER_DTS_OR_PTS(buf);
+    if (!GST_CLOCK_TIME_IS_VALID(ts) || segment->format != GST_FORMAT_TIME) {
+        return GST_CLOCK_TIME_NONE;
+    }
+    return gst_segment_to_running_time(segment, GST_FORMAT_TIME, ts);
+}
+
+static inline int64_t clock_diff_ms(GstClockTime a, GstClockTime b) {
+    return ((int64_t)a - (int64_t)b) / (int64_t)GST_MSECOND;
+}
+
+static GstPadProbeReturn input_probe(GstPad *pad, GstPadProbeInfo *info, gpointer user_data) {
+    (void)pad;
+    MuxMonitorInput *input = (MuxMonitorInput *)user_data;
+    MuxMonitor *mon = input->mon;
+
+    if (GST_PAD_PROBE_INFO_TYPE(info) & GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM) {
+        GstEvent *ev = GST_PAD_PROBE_INFO_EVENT(info);
+        if (GST_EVENT_TYPE(ev) == GST_EVENT_SEGMENT) {
+            g_mutex_lock(&mon->lock);
+            gst_event_copy_segment(ev, &input->segment);
+            g_mutex_unlock(&mon->lock);
+        }
+        return GST_PAD_PROBE_OK;
+    }
+
+    GstBuffer *buf = GST_PAD_PROBE_INFO_BUFFER(info);
+    GstClockTime now = mux_clock_running_time(mon->mux);
+
+    g_mutex_lock(&mon->lock);
+    GstClockTime rt = buffer_running_time(&input->segment, buf);
+    if (GST_CLOCK_TIME_IS_VALID(rt)) {
+        input->last_rt = rt;
+        input->buffers++;
+
+        if (GST_CLOCK_TIME_IS_VALID(now)) {
+            input->lag_ms = clock_diff_ms(now, rt);
+            if (input->lag_ms > input->lag_max_ms) {
+                input->lag_max_ms = input->lag_ms;
+            }
+            // The aggregator times out at running time + upstream + latency
+            if (input->lag_ms > mon->upstream_ms + mon->latency_ms) {
+                input->late_buffers++;
+            }
+        }
+    }
+    g_mutex_unlock(&mon->lock);
+
+    return GST_PAD_PROBE_OK;
+}
+
+static GstPadProbeReturn output_probe(GstPad *pad, GstPadProbeInfo *info, gpointer user_data) {
+    (void)pad;
+    MuxMonitor *mon = (MuxMonitor *)user_data;
+
+    if (GST_PAD_PROBE_INFO_TYPE(info) & GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM) {
+        GstEvent *ev = GST_PAD_PROBE_INFO_EVENT(info);
+        if (GST_EVENT_TYPE(ev) == GST_EVENT_SEGMENT) {
+            g_mutex_lock(&mon->lock);
+            gst_event_copy_segment(ev, &mon->src_segment);
+            g_mutex_unlock(&mon->lock);
+        }
+        return GST_PAD_PROBE_OK;
+    }
+
+    GstBuffer *buf = GST_PAD_PROBE_INFO_BUFFER(info);
+    GstClockTime now = mux_clock_running_time(mon->mux);
+
+    g_mutex_lock(&mon->lock);
+    GstClockTime rt = buffer_running_time(&mon->src_segment, buf);
+    if (GST_CLOCK_TIME_IS_VALID(rt) && GST_CLOCK_TIME_IS_VALID(now)) {
+        mon->out_delay_ms = clock_diff_ms(now, rt);
+        if (mon->out_delay_ms > mon->out_delay_max_ms) {
+            mon->out_delay_max_ms = mon->out_delay_ms;
+        }
+    }
+    mon->outputs++;
+    g_mutex_unlock(&mon->lock);
+
+    return GST_PAD_PROBE_OK;
+}
+
+static gboolean add_input(GstElement *element, GstPad *pad, gpointer user_data) {
+    (void)element;
+    MuxMonitor *mon = (MuxMonitor *)user_data;
+    if (mon->n_inputs >= MUX_MONITOR_MAX_INPUTS) return FALSE;
+
+    MuxMonitorInput *input = &mon->inputs[mon->n_inputs++];
+    input->pad = gst_object_ref(pad);
+    gchar *name = gst_pad_get_name(pad);
+    snprintf(input->name, sizeof(input->name), "%s", name);
+    g_free(name);
+    gst_segment_init(&input->segment, GST_FORMAT_UNDEFINED);
+    input->last_rt = GST_CLOCK_TIME_NONE;
+
+    input->mon = mon;
+    input->probe_id = gst_pad_add_probe(pad,
+        GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM,
+        input_probe, input, NULL);
+
+    return TRUE;
+}
+
+int mux_monitor_init(MuxMonitor *mon, GstPipeline *pipeline,
+                     int auto_latency, int latency_margin_ms) {
+    memset(mon, 0, sizeof(*mon));
+
+    mon->mux = gst_bin_get_by_name(GST_BIN(pipeline), "mux");
+    if (!GST_IS_ELEMENT(mon->mux)) {
+        mon->mux = NULL;
+        return -1;
+    }
+
+    g_mutex_init(&mon->lock);
+    mon->auto_latency = auto_latency;
+    mon->latency_margin_ms = latency_margin_ms;
+
+    // The latency property comes from GstAggregator
+    if (g_object_class_find_property(G_OBJECT_GET_CLASS(mon->mux), "latency") != NULL) {
+        guint64 latency = 0;
+        g_object_get(G_OBJECT(mon->mux), "latency", &latency, NULL);
+        mon->has_latency_prop = 1;
+        mon->latency_ms = (int64_t)(latency / GST_MSECOND);
+    } else if (auto_latency) {
+        fprintf(stderr, "The mux element has no latency property, not trimming its latency\n");
+        mon->auto_latency = 0;
+    }
+
+    gst_element_foreach_sink_pad(mon->mux, add_input, mon);
+
+    mon->src_pad = gst_element_get_static_pad(mon->mux, "src");
+    gst_segment_init(&mon->src_segment, GST_FORMAT_UNDEFINED);
+    if (mon->src_pad != NULL) {
+        mon->src_probe_id = gst_pad_add_probe(mon->src_pad,
+            GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM,
+            output_probe, mon, NULL);
+    }
+
+    return 0;
+}
+
+// Upstream min latency as seen by the mux, excluding its own latency property
+static int query_upstream_latency(MuxMonitor *mon, int64_t *upstream_ms) {
+    if (mon->src_pad == NULL) return -1;
+
+    GstQuery *query = gst_query_new_latency();
+    int ret = -1;
+    if (gst_pad_query(mon->src_pad, query)) {
+        gboolean live;
+        GstClockTime min_latency, max_latency;
+        gst_query_parse_latency(query, &live, &min_latency, &max_latency);
+        if (live && GST_CLOCK_TIME_IS_VALID(min_latency)) {
+            *upstream_ms = (int64_t)(min_latency / GST_MSECOND) - mon->latency_ms;
+            if (*upstream_ms < 0) *upstream_ms = 0;
+            ret = 0;
+        }
+    }
+    gst_query_unref(query);
+    return ret;
+}
+
+/*
+  Keep the aggregator latency at the worst input lag over the window, minus the
+  upstream latency it already accounts for, plus a margin. Increases are applied
+  at once to avoid gaps, reductions only after a full window and with hysteresis
+  since every change triggers a pipeline latency recalculation. Called with
+  mon->lock held; returns 1 if the property must be set to mon->latency_ms
+*/
+static int adjust_latency(MuxMonitor *mon, uint64_t ctime, int64_t worst_lag_ms) {
+    int64_t target = worst_lag_ms - mon->upstream_ms + mon->latency_margin_ms;
+    if (target < 0) target = 0;
+    if (target > MUX_LATENCY_MAX_MS) target = MUX_LATENCY_MAX_MS;
+
+    if (target > mon->latency_ms) {
+        // raise now
+    } else if (mon->latency_ms - target >= MUX_LATENCY_HYSTERESIS_MS &&
+               ctime - mon->last_reduce >= MUX_LATENCY_TRIM_INTERVAL) {
+        mon->last_reduce = ctime;
+    } else {
+        return 0;
+    }
+
+    fprintf(stderr, "Mux latency: %ld -> %ld ms (worst input lag %ld ms, upstream %ld ms)\n",
+            (long)mon->latency_ms, (long)target, (long)worst_lag_ms, (long)mon->upstream_ms);
+    mon->latency_ms = target;
+    mon->latency_changes++;
+    return 1;
+}
+
+void mux_monitor_update(MuxMonitor *mon, uint64_t ctime, Stats *stats) {
+    if (mon->mux == NULL) return;
+
+    int64_t upstream_ms;
+    int have_upstream = (query_upstream_latency(mon, &upstream_ms) == 0);
+
+    g_mutex_lock(&mon->lock);
+
+    if (have_upstream) mon->upstream_ms = upstream_ms;
+    if (mon->window_start == 0) {
+        mon->window_start = ctime;
+        mon->last_reduce = ctime;
+    }
+
+    // Worst lag over the current and previous window; gap between the inputs
+    int64_t worst_lag_ms = 0;
+    int have_lag = 0;
+    GstClockTime rt_min = GST_CLOCK_TIME_NONE, rt_max = 0;
+    for (int i = 0; i < mon->n_inputs; i++) {
+        MuxMonitorInput *input = &mon->inputs[i];
+        if (input->buffers == 0) continue;
+
+        int64_t lag = MAX(input->lag_max_ms, input->lag_max_prev_ms);
+        if (!have_lag || lag > worst_lag_ms) worst_lag_ms = lag;
+        have_lag = 1;
+
+        if (!GST_CLOCK_TIME_IS_VALID(rt_min) || input->last_rt < rt_min) rt_min = input->last_rt;
+        if (input->last_rt > rt_max) rt_max = input->last_rt;
+    }
+    int64_t gap_ms = GST_CLOCK_TIME_IS_VALID(rt_min) ? clock_diff_ms(rt_max, rt_min) : 0;
+
+    if (stats != NULL) {
+        char name[STATS_NAME_LEN];
+        for (int i = 0; i < mon->n_inputs; i++) {
+            MuxMonitorInput *input = &mon->inputs[i];
+            snprintf(name, sizeof(name), "ceracoder_mux_input_lag_ms{input=\"%s\"}", input->name);
+            stats_set(stats, name, STATS_GAUGE,
+                      "Clock running time minus buffer running time at the mux input", input->lag_ms);
+            snprintf(name, sizeof(name), "ceracoder_mux_input_lag_max_ms{input=\"%s\"}", input->name);
+            stats_set(stats, name, STATS_GAUGE, "Worst mux input lag over the tracking window",
+                      MAX(input->lag_max_ms, input->lag_max_prev_ms));
+            snprintf(name, sizeof(name), "ceracoder_mux_input_buffers_total{input=\"%s\"}", input->name);
+            stats_set(stats, name, STATS_COUNTER, "Buffers received by the mux", input->buffers);
+            snprintf(name, sizeof(name), "ceracoder_mux_input_late_buffers_total{input=\"%s\"}", input->name);
+            stats_set(stats, name, STATS_COUNTER, "Buffers that arrived after the mux deadline",
+                      input->late_buffers);
+        }
+        stats_set(stats, "ceracoder_mux_interleave_gap_ms", STATS_GAUGE,
+                  "Running time gap between the newest and oldest mux input", gap_ms);
+        stats_set(stats, "ceracoder_mux_output_delay_ms", STATS_GAUGE,
+                  "Clock running time minus buffer running time at the mux output", mon->out_delay_ms);
+        stats_set(stats, "ceracoder_mux_output_delay_max_ms", STATS_GAUGE,
+                  "Worst mux output delay over the tracking window", mon->out_delay_max_ms);
+        stats_set(stats, "ceracoder_mux_upstream_latency_ms", STATS_GAUGE,
+                  "Upstream min latency reported to the mux", mon->upstream_ms);
+        stats_set(stats, "ceracoder_mux_latency_ms", STATS_GAUGE,
+                  "Mux (aggregator) latency property", mon->latency_ms);
+        stats_set(stats, "ceracoder_mux_latency_changes_total", STATS_COUNTER,
+                  "Automatic mux latency changes", mon->latency_changes);
+    }
+
+    int set_latency = 0;
+    if (mon->auto_latency && mon->has_latency_prop && have_upstream && have_lag) {
+        set_latency = adjust_latency(mon, ctime, worst_lag_ms);
+    }
+    int64_t latency_ms = mon->latency_ms;
+
+    // Rotate the window
+    if (ctime - mon->window_start >= MUX_MONITOR_WINDOW_MS) {
+        for (int i = 0; i < mon->n_inputs; i++) {
+            mon->inputs[i].lag_max_prev_ms = mon->inputs[i].lag_max_ms;
+            mon->inputs[i].lag_max_ms = mon->inputs[i].lag_ms;
+        }
+        mon->out_delay_max_ms = mon->out_delay_ms;
+        mon->window_start = ctime;
+    }
+
+    g_mutex_unlock(&mon->lock);
+
+    // Not under the lock: the setter takes the aggregator's own lock and posts
+    // a latency message while the pad probes wait for mon->lock
+    if (set_latency) {
+        g_object_set(G_OBJECT(mon->mux), "latency", (guint64)latency_ms * GST_MSECOND, NULL);
+    }
+}
+
+void mux_monitor_get_latency(MuxMonitor *mon, int *lag_ms, int *delay_ms, int *latency_ms) {
+    *lag_ms = *delay_ms = *latency_ms = -1;
+    if (mon->mux == NULL) return;
+
+    g_mutex_lock(&mon->lock);
+    for (int i = 0; i < mon->n_inputs; i++) {
+        if (mon->inputs[i].buffers > 0 && mon->inputs[i].lag_ms > *lag_ms) {
+            *lag_ms = (int)mon->inputs[i].lag_ms;
+        }
+    }
+    *delay_ms = (int)mon->out_delay_ms;
+    *latency_ms = mon->has_latency_prop ? (int)mon->latency_ms : -1;
+    g_mutex_unlock(&mon->lock);
+}
+
+void mux_monitor_cleanup(MuxMonitor *mon) {
+    if (mon->mux == NULL) return;
+
+    for (int i = 0; i < mon->n_inputs; i++) {
+        gst_pad_remove_probe(mon->inputs[i].pad, mon->inputs[i].probe_id);
+        gst_object_unref(mon->inputs[i].pad);
+    }
+    if (mon->src_pad != NULL) {
+        gst_pad_remove_probe(mon->src_pad, mon->src_probe_id);
+        gst_object_unref(mon->src_pad);
+    }
+    g_mutex_clear(&mon->lock);
+    gst_object_unref(mon->mux);
+    mon->mux = NULL;
+}
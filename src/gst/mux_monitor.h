@@ -0,0 +1,119 @@
+/*
+    ceracoder - live video encoder with dynamic bitrate control
+    Copyright (C) 2020 BELABOX project
+    Copyright (C) 2026 CERALIVE
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef MUX_MONITOR_H
+#define MUX_MONITOR_H
+
+#include <stdint.h>
+#include <gst/gst.h>
+
+#include "stats.h"
+
+/*
+ * Mux monitor module - interleave latency of the "mux" element
+ *
+ * mpegtsmux (a GstAggregator) waits for all of its inputs before it
+ * outputs, so a slow or drifting input silently adds latency. Pad probes
+ * on the mux measure, per input, how late buffers arrive relative to the
+ * pipeline clock (the lag), the running-time gap between the inputs and
+ * how late the mux outputs.
+ *
+ * With auto latency enabled, the aggregator "latency" property is kept at
+ * the minimum that covers the worst input lag seen over the last
+ * MUX_MONITOR_WINDOW_MS (plus a margin): raised at once when an input
+ * gets later, lowered with hysteresis when the inputs speed up.
+ */
+
+#define MUX_MONITOR_MAX_INPUTS      4
+#define MUX_MONITOR_WINDOW_MS       10000   // Max lag tracking window
+#define MUX_LATENCY_MAX_MS          2000    // Upper bound for the latency property
+#define MUX_LATENCY_HYSTERESIS_MS   20      // Min reduction worth a latency change
+#define MUX_LATENCY_TRIM_INTERVAL   10000   // Min ms between latency reductions
+
+typedef struct MuxMonitor MuxMonitor;
+
+typedef struct {
+    MuxMonitor *mon;
+    GstPad *pad;
+    gulong probe_id;
+    char name[32];
+    GstSegment segment;         // Last segment seen on the pad
+
+    GstClockTime last_rt;       // Running time of the last buffer
+    int64_t lag_ms;             // Arrival lag of the last buffer
+    int64_t lag_max_ms;         // Max lag in the current window
+    int64_t lag_max_prev_ms;    // Max lag in the previous window
+    uint64_t buffers;
+    uint64_t late_buffers;      // Arrived after the mux deadline
+} MuxMonitorInput;
+
+struct MuxMonitor {
+    GstElement *mux;
+    GMutex lock;
+
+    MuxMonitorInput inputs[MUX_MONITOR_MAX_INPUTS];
+    int n_inputs;
+
+    // Output side
+    GstPad *src_pad;
+    gulong src_probe_id;
+    GstSegment src_segment;
+    int64_t out_delay_ms;       // Clock running time - output running time
+    int64_t out_delay_max_ms;   // Max in the current window
+    uint64_t outputs;
+
+    // Latency property handling
+    int has_latency_prop;
+    int auto_latency;
+    int latency_margin_ms;
+    int64_t latency_ms;         // Current aggregator latency property
+    int64_t upstream_ms;        // Upstream min latency reported to the mux
+    uint64_t last_reduce;
+    uint64_t window_start;
+    uint64_t latency_changes;
+};
+
+/*
+ * Initialize the monitor on the pipeline's "mux" element
+ *
+ * Returns 0 on success, -1 if there is no mux element.
+ */
+int mux_monitor_init(MuxMonitor *mon, GstPipeline *pipeline,
+                     int auto_latency, int latency_margin_ms);
+
+/*
+ * Periodic update from the main loop
+ *
+ * Rotates the lag window, adjusts the mux latency if enabled and
+ * publishes the measurements to stats (may be NULL).
+ */
+void mux_monitor_update(MuxMonitor *mon, uint64_t ctime, Stats *stats);
+
+/*
+ * Current worst input lag (last buffer of each input), output delay and
+ * latency property, for the live stats feed; all -1 without a mux
+ */
+void mux_monitor_get_latency(MuxMonitor *mon, int *lag_ms, int *delay_ms, int *latency_ms);
+
+/*
+ * Remove the probes and release the mux
+ */
+void mux_monitor_cleanup(MuxMonitor *mon);
+
+#endif /* MUX_MONITOR_H */
@@ -19,8 +19,18 @@
 
 #include "overlay_ui.h"
 #include <stdio.h>
+#include <string.h>
+
+// Elements that can change the resolution between the overlay and the encoder
+static const char *scalers[] = {
+    "videoscale", "videoconvertscale", "nvvidconv", "vapostproc", "vaapipostproc",
+    "v4l2convert", "qsvvpp",
+};
+
+#define OVERLAY_MAX_HOPS 16
 
 int overlay_ui_init(OverlayUi *overlay, GstPipeline *pipeline) {
+    overlay->placement = OVERLAY_PLACEMENT_NONE;
     overlay->element = gst_bin_get_by_name(GST_BIN(pipeline), "overlay");
     
     if (!GST_IS_ELEMENT(overlay->element)) {
@@ -28,9 +38,156 @@ int overlay_ui_init(OverlayUi *overlay, GstPipeline *pipeline) {
         return -1;
     }
 
+    overlay->placement = OVERLAY_PLACEMENT_SOURCE;
     return 0;
 }
 
+static const char *factory_name(GstElement *element) {
+    GstElementFactory *factory = gst_element_get_factory(element);
+    return factory ? gst_plugin_feature_get_name(GST_PLUGIN_FEATURE(factory)) : "";
+}
+
+// The element linked to the src pad, NULL at a branch or the end of the chain
+static GstElement *next_element(GstElement *element) {
+    GstPad *src = gst_element_get_static_pad(element, "src");
+    if (src == NULL) return NULL;
+    GstPad *peer = gst_pad_get_peer(src);
+    gst_object_unref(src);
+    if (peer == NULL) return NULL;
+    GstElement *next = gst_pad_get_parent_element(peer);
+    gst_object_unref(peer);
+    return next;
+}
+
+// Take the overlay out of the stream, linking its neighbours directly
+static int overlay_unlink(GstElement *element) {
+    GstPad *sink = gst_element_get_static_pad(element, "video_sink");
+    GstPad *src = gst_element_get_static_pad(element, "src");
+    GstPad *up = sink ? gst_pad_get_peer(sink) : NULL;
+    GstPad *down = src ? gst_pad_get_peer(src) : NULL;
+
+    int ret = -1;
+    if (up != NULL && down != NULL) {
+        gst_pad_unlink(up, sink);
+        gst_pad_unlink(src, down);
+        if (gst_pad_link(up, down) == GST_PAD_LINK_OK) ret = 0;
+    }
+
+    if (up) gst_object_unref(up);
+    if (down) gst_object_unref(down);
+    if (sink) gst_object_unref(sink);
+    if (src) gst_object_unref(src);
+    return ret;
+}
+
+// Insert the (unlinked) overlay in front of the encoder
+static int overlay_link_before(GstElement *element, GstElement *encoder) {
+    GstPad *enc_sink = gst_element_get_static_pad(encoder, "sink");
+    GstPad *up = enc_sink ? gst_pad_get_peer(enc_sink) : NULL;
+    GstPad *sink = gst_element_get_static_pad(element, "video_sink");
+    GstPad *src = gst_element_get_static_pad(element, "src");
+
+    int ret = -1;
+    if (up != NULL && sink != NULL && src != NULL) {
+        gst_pad_unlink(up, enc_sink);
+        if (gst_pad_link(up, sink) == GST_PAD_LINK_OK &&
+            gst_pad_link(src, enc_sink) == GST_PAD_LINK_OK) {
+            ret = 0;
+        }
+    }
+
+    if (up) gst_object_unref(up);
+    if (enc_sink) gst_object_unref(enc_sink);
+    if (sink) gst_object_unref(sink);
+    if (src) gst_object_unref(src);
+    return ret;
+}
+
+static int accepts_system_memory(GstElement *encoder) {
+    GstPad *sink = gst_element_get_static_pad(encoder, "sink");
+    if (sink == NULL) return 0;
+    GstCaps *caps = gst_pad_query_caps(sink, NULL);
+    GstCaps *raw = gst_caps_from_string("video/x-raw");
+    int ret = gst_caps_can_intersect(caps, raw) ? 1 : 0;
+    gst_caps_unref(raw);
+    gst_caps_unref(caps);
+    gst_object_unref(sink);
+    return ret;
+}
+
+/*
+  The encoder downstream of the overlay, if a scaler sits between them.
+  Returns a new reference or NULL
+*/
+static GstElement *find_scaled_encoder(GstElement *element, GstPipeline *pipeline) {
+    GstElement *encoder = gst_bin_get_by_name(GST_BIN(pipeline), "venc_bps");
+    if (encoder == NULL) encoder = gst_bin_get_by_name(GST_BIN(pipeline), "venc_kbps");
+    if (encoder == NULL) return NULL;
+
+    int scaled = 0;
+    GstElement *cur = next_element(element);
+    for (int hops = 0; cur != NULL && cur != encoder && hops < OVERLAY_MAX_HOPS; hops++) {
+        const char *name = factory_name(cur);
+        for (size_t i = 0; i < sizeof(scalers) / sizeof(scalers[0]); i++) {
+            if (strcmp(name, scalers[i]) == 0) scaled = 1;
+        }
+        GstElement *next = next_element(cur);
+        gst_object_unref(cur);
+        cur = next;
+    }
+
+    int found = (cur == encoder);
+    if (cur != NULL) gst_object_unref(cur);
+    if (!found || !scaled) {
+        gst_object_unref(encoder);
+        return NULL;
+    }
+    return encoder;
+}
+
+int overlay_ui_place(OverlayUi *overlay, GstPipeline *pipeline, int mode) {
+    if (overlay->element == NULL) return 0;
+
+    if (mode == OVERLAY_OFF) {
+        if (overlay_unlink(overlay->element) != 0) {
+            fprintf(stderr, "Failed to take the overlay out of the pipeline\n");
+            return -1;
+        }
+        gst_bin_remove(GST_BIN(pipeline), overlay->element);
+        gst_object_unref(overlay->element);
+        overlay->element = NULL;
+        overlay->placement = OVERLAY_PLACEMENT_NONE;
+        return 0;
+    }
+
+    if (mode != OVERLAY_AUTO) return 0;
+
+    GstElement *encoder = find_scaled_encoder(overlay->element, pipeline);
+    if (encoder == NULL) return 0;
+
+    int ret = 0;
+    if (accepts_system_memory(encoder)) {
+        if (overlay_unlink(overlay->element) == 0 &&
+            overlay_link_before(overlay->element, encoder) == 0) {
+            overlay->placement = OVERLAY_PLACEMENT_POST_SCALE;
+        } else {
+            fprintf(stderr, "Failed to move the overlay after the scaler\n");
+            ret = -1;
+        }
+    }
+    gst_object_unref(encoder);
+
+    return ret;
+}
+
+const char *overlay_ui_placement_name(OverlayPlacement placement) {
+    switch (placement) {
+        case OVERLAY_PLACEMENT_SOURCE:     return "source";
+        case OVERLAY_PLACEMENT_POST_SCALE: return "post-scale";
+        default:                           return "none";
+    }
+}
+
 void overlay_ui_update(OverlayUi *overlay,
                        int set_bitrate, double throughput,
                        int rtt, int rtt_th_min, int rtt_th_max,
@@ -21,16 +21,32 @@
 #define OVERLAY_UI_H
 
 #include <gst/gst.h>
+#include "config.h"
 
 /*
  * Overlay UI module - manages on-screen text overlay for stats display
  *
  * This module provides a clean interface for updating the text overlay
  * with bitrate, RTT, and buffer statistics.
+ *
+ * The overlay is off unless requested (overlay = auto|source): the
+ * templates place it on the capture-resolution frames, where blending costs
+ * CPU on every frame and keeps them in system memory, so it is taken out of
+ * the pipeline when not wanted. With overlay = auto it is moved after the
+ * downscale when the frames reach the encoder in system memory again (e.g.
+ * nvvidconv ! x264enc); encoders taking NVMM memory, or scaling internally
+ * (mpp width / height), keep it where the template put it.
  */
 
+typedef enum {
+    OVERLAY_PLACEMENT_NONE = 0,     // Removed, or no overlay in the template
+    OVERLAY_PLACEMENT_SOURCE,       // Where the template put it
+    OVERLAY_PLACEMENT_POST_SCALE,   // Moved after the downscale, before the encoder
+} OverlayPlacement;
+
 typedef struct {
     GstElement *element;
+    OverlayPlacement placement;
 } OverlayUi;
 
 /*
@@ -40,6 +56,22 @@ typedef struct {
  */
 int overlay_ui_init(OverlayUi *overlay, GstPipeline *pipeline);
 
+/*
+ * Place the overlay for the configured mode (OVERLAY_*, config.h)
+ *
+ * Must be called before the pipeline leaves the NULL state. Removing the
+ * overlay drops the element, overlay_ui_update() then does nothing. The
+ * resulting placement is in overlay->placement.
+ *
+ * Returns 0 on success, -1 if relinking failed and the pipeline is unusable.
+ */
+int overlay_ui_place(OverlayUi *overlay, GstPipeline *pipeline, int mode);
+
+/*
+ * Placement name, for logging
+ */
+const char *overlay_ui_placement_name(OverlayPlacement placement);
+
 /*
  * Update overlay with current statistics
  *
@@ -0,0 +1,158 @@
+/*
+    ceracoder - live video encoder with dynamic bitrate control
+    Copyright (C) 2020 BELABOX project
+    Copyright (C) 2026 CERALIVE
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#include "video_tap.h"
+#include <stdio.h>
+#include <string.h>
+
+static void pad_set_caps(VideoTapPad *tp, GstCaps *caps) {
+    tp->usable = 0;
+    if (caps == NULL || !gst_video_info_from_caps(&tp->info, caps)) return;
+
+    GstCapsFeatures *features = gst_caps_get_features(caps, 0);
+    if (features != NULL && !gst_caps_features_is_any(features) &&
+        !gst_caps_features_is_equal(features, GST_CAPS_FEATURES_MEMORY_SYSTEM_MEMORY)) {
+        return;
+    }
+    if (!GST_VIDEO_INFO_IS_YUV(&tp->info) && !GST_VIDEO_INFO_IS_GRAY(&tp->info)) return;
+    if (GST_VIDEO_INFO_COMP_DEPTH(&tp->info, 0) != 8) return;
+    tp->usable = 1;
+}
+
+static GstPadProbeReturn tap_probe(GstPad *pad, GstPadProbeInfo *info, gpointer user_data) {
+    (void)pad;
+    VideoTapPad *tp = (VideoTapPad *)user_data;
+    VideoTap *tap = tp->tap;
+
+    if (GST_PAD_PROBE_INFO_TYPE(info) & GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM) {
+        GstEvent *ev = GST_PAD_PROBE_INFO_EVENT(info);
+        if (GST_EVENT_TYPE(ev) == GST_EVENT_CAPS) {
+            GstCaps *caps = NULL;
+            gst_event_parse_caps(ev, &caps);
+            g_mutex_lock(&tap->lock);
+            pad_set_caps(tp, caps);
+            g_mutex_unlock(&tap->lock);
+        }
+        return GST_PAD_PROBE_OK;
+    }
+
+    // The encoder input is only a fallback for v_delay
+    if (!tp->usable || (tp != &tap->pads[0] && tap->pads[0].usable)) return GST_PAD_PROBE_OK;
+
+    GstVideoFrame frame;
+    if (!gst_video_frame_map(&frame, &tp->info, GST_PAD_PROBE_INFO_BUFFER(info), GST_MAP_READ)) {
+        return GST_PAD_PROBE_OK;
+    }
+
+    gint64 start = g_get_monotonic_time();
+    g_mutex_lock(&tap->lock);
+    int cut = scene_detect_frame(&tap->detect, GST_VIDEO_FRAME_COMP_DATA(&frame, 0),
+                                 GST_VIDEO_FRAME_COMP_WIDTH(&frame, 0),
+                                 GST_VIDEO_FRAME_COMP_HEIGHT(&frame, 0),
+                                 GST_VIDEO_FRAME_COMP_STRIDE(&frame, 0),
+                                 GST_VIDEO_FRAME_COMP_PSTRIDE(&frame, 0));
+    if (cut) tap->cut_pending = 1;
+    tap->busy_us += (uint64_t)(g_get_monotonic_time() - start);
+    tap->analyzed++;
+    g_mutex_unlock(&tap->lock);
+
+    gst_video_frame_unmap(&frame);
+    return GST_PAD_PROBE_OK;
+}
+
+static void add_pad(VideoTap *tap, GstElement *element, const char *pad_name) {
+    if (element == NULL) return;
+    GstPad *pad = gst_element_get_static_pad(element, pad_name);
+    gst_object_unref(element);
+    if (pad == NULL) return;
+
+    VideoTapPad *tp = &tap->pads[tap->n_pads++];
+    tp->tap = tap;
+    tp->pad = pad;
+    gst_video_info_init(&tp->info);
+    tp->probe_id = gst_pad_add_probe(pad,
+        GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM,
+        tap_probe, tp, NULL);
+}
+
+int video_tap_init(VideoTap *tap, GstPipeline *pipeline) {
+    memset(tap, 0, sizeof(*tap));
+    g_mutex_init(&tap->lock);
+    scene_detect_init(&tap->detect);
+
+    add_pad(tap, gst_bin_get_by_name(GST_BIN(pipeline), "v_delay"), "src");
+    GstElement *encoder = gst_bin_get_by_name(GST_BIN(pipeline), "venc_bps");
+    if (encoder == NULL) encoder = gst_bin_get_by_name(GST_BIN(pipeline), "venc_kbps");
+    add_pad(tap, encoder, "sink");
+
+    if (tap->n_pads == 0) {
+        g_mutex_clear(&tap->lock);
+        return -1;
+    }
+    return 0;
+}
+
+int video_tap_take(VideoTap *tap, int *scene_cut, int *motion) {
+    *scene_cut = 0;
+    *motion = 0;
+    if (tap->n_pads == 0) return 0;
+
+    g_mutex_lock(&tap->lock);
+    int active = tap->pads[0].usable || (tap->n_pads > 1 && tap->pads[1].usable);
+    *scene_cut = tap->cut_pending;
+    *motion = tap->detect.motion;
+    tap->cut_pending = 0;
+    g_mutex_unlock(&tap->lock);
+    return active;
+}
+
+void video_tap_update(VideoTap *tap, Stats *stats) {
+    if (tap->n_pads == 0 || stats == NULL) return;
+
+    g_mutex_lock(&tap->lock);
+    int active = tap->pads[0].usable || (tap->n_pads > 1 && tap->pads[1].usable);
+    uint64_t frames = tap->detect.frames;
+    uint64_t cuts = tap->detect.cuts;
+    int motion = tap->detect.motion;
+    double busy_us = tap->analyzed ? (double)tap->busy_us / tap->analyzed : 0.0;
+    g_mutex_unlock(&tap->lock);
+
+    stats_set(stats, "ceracoder_scene_active", STATS_GAUGE,
+              "Scene detection running on the raw video", active);
+    stats_set(stats, "ceracoder_scene_frames_total", STATS_COUNTER,
+              "Frames analyzed by the scene detector", frames);
+    stats_set(stats, "ceracoder_scene_cuts_total", STATS_COUNTER,
+              "Scene cuts detected", cuts);
+    stats_set(stats, "ceracoder_scene_motion", STATS_GAUGE,
+              "Smoothed motion score (0-100)", motion);
+    stats_set(stats, "ceracoder_scene_frame_us", STATS_GAUGE,
+              "Average scene detection time per frame (us)", busy_us);
+}
+
+void video_tap_cleanup(VideoTap *tap) {
+    if (tap->n_pads == 0) return;
+
+    for (int i = 0; i < tap->n_pads; i++) {
+        gst_pad_remove_probe(tap->pads[i].pad, tap->pads[i].probe_id);
+        gst_object_unref(tap->pads[i].pad);
+    }
+    tap->n_pads = 0;
+    g_mutex_clear(&tap->lock);
+}
@@ -0,0 +1,88 @@
+/*
+    ceracoder - live video encoder with dynamic bitrate control
+    Copyright (C) 2020 BELABOX project
+    Copyright (C) 2026 CERALIVE
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef VIDEO_TAP_H
+#define VIDEO_TAP_H
+
+#include <stdint.h>
+#include <gst/gst.h>
+#include <gst/video/video.h>
+
+#include "scene_detect.h"
+#include "stats.h"
+
+/*
+ * Video tap module - feeds the scene detector from the raw video
+ *
+ * A buffer probe on the src pad of "v_delay" maps each frame and runs
+ * scene_detect_frame() on its luma plane, on the streaming thread. Where
+ * v_delay carries something the detector can't read (compressed video
+ * ahead of a decoder, NVMM or other device memory, more than 8 bits per
+ * sample), the sink pad of the encoder (venc_bps / venc_kbps) is used
+ * instead. The balancer picks the results up on its tick with
+ * video_tap_take().
+ */
+
+typedef struct VideoTap VideoTap;
+
+typedef struct {
+    VideoTap *tap;
+    GstPad *pad;
+    gulong probe_id;
+    GstVideoInfo info;
+    int usable;                 // Negotiated caps are 8-bit YUV / gray in system memory
+} VideoTapPad;
+
+struct VideoTap {
+    GMutex lock;
+    VideoTapPad pads[2];        // v_delay src, encoder sink
+    int n_pads;
+
+    SceneDetect detect;
+    int cut_pending;            // Scene cut since the last video_tap_take()
+    uint64_t busy_us;           // Analysis time, for the per-frame average
+    uint64_t analyzed;
+};
+
+/*
+ * Add the probes
+ *
+ * Returns 0 on success, -1 if the pipeline has neither tap point.
+ */
+int video_tap_init(VideoTap *tap, GstPipeline *pipeline);
+
+/*
+ * Scene cut since the last call (cleared) and the current motion score
+ *
+ * Returns 1 if the detector is analyzing frames, 0 otherwise (both zero).
+ */
+int video_tap_take(VideoTap *tap, int *scene_cut, int *motion);
+
+/*
+ * Publish the detector's counters to stats
+ */
+void video_tap_update(VideoTap *tap, Stats *stats);
+
+/*
+ * Remove the probes
+ */
+void video_tap_cleanup(VideoTap *tap);
+
+#endif /* VIDEO_TAP_H */
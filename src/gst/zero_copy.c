@@ -0,0 +1,282 @@
+/*
+    ceracoder - live video encoder with dynamic bitrate control
+    Copyright (C) 2020 BELABOX project
+    Copyright (C) 2026 CERALIVE
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#include "zero_copy.h"
+#include <stdio.h>
+#include <string.h>
+
+#define ZERO_COPY_MAX_HOPS          16
+#define ZERO_COPY_PROBE_FRAMES      4
+#define ZERO_COPY_PROBE_TIMEOUT     3000    // ms, also covers a source without signal
+#define ZERO_COPY_CACHE_SIZE        8
+
+// Encoders importing DMABuf input, and the property asking them to
+typedef struct {
+    const char *factory;
+    const char *import_prop;    // Set to "dmabuf-import", NULL if imported as is
+} DmabufEncoder;
+
+static const DmabufEncoder dmabuf_encoders[] = {
+    { "mpph264enc", NULL },
+    { "mpph265enc", NULL },
+    { "v4l2h264enc", "output-io-mode" },
+    { "v4l2h265enc", "output-io-mode" },
+    { "vah264enc", NULL },
+    { "vah265enc", NULL },
+    { "vah264lpenc", NULL },
+    { "vah265lpenc", NULL },
+};
+
+// Elements passing buffers on without touching the frames
+static const char *passthrough[] = {
+    "identity", "queue", "queue2", "capsfilter", "videorate",
+};
+
+// Elements handing the encoder device memory already
+static const char *device_memory[] = {
+    "nvvidconv", "nvv4l2decoder", "mppvideodec", "mppjpegdec", "vapostproc",
+};
+
+// Probe results, by capture device and encoder
+typedef struct {
+    char device[64];
+    char encoder[32];
+    int ok;
+    char reason[128];
+} ProbeResult;
+
+static ProbeResult probed[ZERO_COPY_CACHE_SIZE];
+static int probed_count = 0;
+
+static const char *factory_name(GstElement *element) {
+    GstElementFactory *factory = gst_element_get_factory(element);
+    return factory ? gst_plugin_feature_get_name(GST_PLUGIN_FEATURE(factory)) : "";
+}
+
+static int in_list(const char *name, const char **list, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        if (strcmp(name, list[i]) == 0) return 1;
+    }
+    return 0;
+}
+
+// The element linked to the sink pad, NULL at a source or an unlinked pad
+static GstElement *prev_element(GstElement *element) {
+    GstPad *sink = gst_element_get_static_pad(element, "sink");
+    if (sink == NULL) return NULL;
+    GstPad *peer = gst_pad_get_peer(sink);
+    gst_object_unref(sink);
+    if (peer == NULL) return NULL;
+    GstElement *prev = gst_pad_get_parent_element(peer);
+    gst_object_unref(peer);
+    return prev;
+}
+
+static const DmabufEncoder *dmabuf_encoder(GstElement *encoder) {
+    const char *name = factory_name(encoder);
+    for (size_t i = 0; i < sizeof(dmabuf_encoders) / sizeof(dmabuf_encoders[0]); i++) {
+        if (strcmp(name, dmabuf_encoders[i].factory) == 0) return &dmabuf_encoders[i];
+    }
+    return NULL;
+}
+
+/*
+  Run the trial pipeline until it has encoded a few frames
+
+  Returns 0 on success, -1 with the reason filled in otherwise
+*/
+static int probe_run(const char *desc, char *reason, size_t len) {
+    GError *error = NULL;
+    GstElement *trial = gst_parse_launch(desc, &error);
+    if (trial == NULL) {
+        snprintf(reason, len, "probe pipeline: %s", error ? error->message : "parse error");
+        if (error) g_error_free(error);
+        return -1;
+    }
+    if (error) g_error_free(error);
+
+    int ret = -1;
+    GstBus *bus = gst_element_get_bus(trial);
+    gst_element_set_state(trial, GST_STATE_PLAYING);
+    GstMessage *msg = gst_bus_timed_pop_filtered(bus, ZERO_COPY_PROBE_TIMEOUT * GST_MSECOND,
+                                                 GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+    if (msg == NULL) {
+        snprintf(reason, len, "probe: no frame within %d ms", ZERO_COPY_PROBE_TIMEOUT);
+    } else if (GST_MESSAGE_TYPE(msg) == GST_MESSAGE_EOS) {
+        ret = 0;
+    } else {
+        GError *err = NULL;
+        gst_message_parse_error(msg, &err, NULL);
+        snprintf(reason, len, "probe: %s", err ? err->message : "error");
+        if (err) g_error_free(err);
+    }
+    if (msg) gst_message_unref(msg);
+
+    gst_element_set_state(trial, GST_STATE_NULL);
+    gst_object_unref(bus);
+    gst_object_unref(trial);
+    return ret;
+}
+
+/*
+  The result for a device and encoder is kept for the process: the trial
+  pipeline blocks for up to ZERO_COPY_PROBE_TIMEOUT, so it only runs when
+  allowed (at startup), and later pipelines reuse what it found
+*/
+static int probe(const char *device, const char *encoder, const char *desc, int allow_probe,
+                 char *reason, size_t len) {
+    for (int i = 0; i < probed_count; i++) {
+        if (strcmp(probed[i].device, device) == 0 && strcmp(probed[i].encoder, encoder) == 0) {
+            if (!probed[i].ok) snprintf(reason, len, "%s", probed[i].reason);
+            return probed[i].ok ? 0 : -1;
+        }
+    }
+    if (!allow_probe) {
+        snprintf(reason, len, "%s with %s not probed at startup", device, encoder);
+        return -1;
+    }
+
+    int ok = (probe_run(desc, reason, len) == 0);
+    if (probed_count < ZERO_COPY_CACHE_SIZE) {
+        ProbeResult *r = &probed[probed_count++];
+        snprintf(r->device, sizeof(r->device), "%s", device);
+        snprintf(r->encoder, sizeof(r->encoder), "%s", encoder);
+        r->ok = ok;
+        snprintf(r->reason, sizeof(r->reason), "%s", ok ? "" : reason);
+    }
+    return ok ? 0 : -1;
+}
+
+/*
+  Trial pipeline: the source device with DMABuf export, the caps filters and
+  rate changes of the chain in order, and the encoder
+*/
+static void probe_desc(GString *desc, const char *device, GList *chain,
+                       GstElement *encoder, const DmabufEncoder *enc) {
+    g_string_append_printf(desc, "v4l2src device=%s io-mode=dmabuf num-buffers=%d",
+                           device, ZERO_COPY_PROBE_FRAMES);
+
+    for (GList *l = chain; l != NULL; l = l->next) {
+        GstElement *element = GST_ELEMENT(l->data);
+        const char *name = factory_name(element);
+        if (strcmp(name, "capsfilter") == 0) {
+            GstCaps *caps = NULL;
+            g_object_get(G_OBJECT(element), "caps", &caps, NULL);
+            if (caps != NULL) {
+                gchar *str = gst_caps_to_string(caps);
+                g_string_append_printf(desc, " ! capsfilter caps=\"%s\"", str);
+                g_free(str);
+                gst_caps_unref(caps);
+            }
+        } else if (strcmp(name, "videorate") == 0) {
+            g_string_append(desc, " ! videorate");
+        }
+    }
+
+    g_string_append_printf(desc, " ! %s", factory_name(encoder));
+    if (enc->import_prop) g_string_append_printf(desc, " %s=dmabuf-import", enc->import_prop);
+    g_string_append(desc, " ! fakesink");
+}
+
+static void zero_copy_try(ZeroCopy *zc, GstElement *encoder, int allow_probe) {
+    // Walk up from the encoder to the capture
+    GList *chain = NULL;
+    GstElement *source = NULL;
+    GstElement *cur = prev_element(encoder);
+    for (int hops = 0; cur != NULL; hops++) {
+        const char *name = factory_name(cur);
+        if (strcmp(name, "v4l2src") == 0) {
+            source = cur;
+            break;
+        }
+        if (in_list(name, device_memory, sizeof(device_memory) / sizeof(device_memory[0]))) {
+            zc->path = ZERO_COPY_NATIVE;
+            gst_object_unref(cur);
+            goto out;
+        }
+        if (hops == ZERO_COPY_MAX_HOPS ||
+            !in_list(name, passthrough, sizeof(passthrough) / sizeof(passthrough[0]))) {
+            snprintf(zc->reason, sizeof(zc->reason), "%s between the capture and the encoder",
+                     name[0] ? name : GST_ELEMENT_NAME(cur));
+            gst_object_unref(cur);
+            goto out;
+        }
+        chain = g_list_prepend(chain, cur);
+        cur = prev_element(cur);
+    }
+
+    if (source == NULL) {
+        snprintf(zc->reason, sizeof(zc->reason), "no v4l2src capture");
+        goto out;
+    }
+
+    const DmabufEncoder *enc = dmabuf_encoder(encoder);
+    if (enc == NULL) {
+        snprintf(zc->reason, sizeof(zc->reason), "%s doesn't import DMABuf", factory_name(encoder));
+        goto out;
+    }
+
+    int io_mode = 0;
+    g_object_get(G_OBJECT(source), "io-mode", &io_mode, NULL);
+    if (io_mode != 0) {
+        snprintf(zc->reason, sizeof(zc->reason), "io-mode set by the template");
+        goto out;
+    }
+
+    gchar *device = NULL;
+    g_object_get(G_OBJECT(source), "device", &device, NULL);
+    GString *desc = g_string_new(NULL);
+    probe_desc(desc, device ? device : "/dev/video0", chain, encoder, enc);
+    if (probe(device ? device : "/dev/video0", factory_name(encoder), desc->str, allow_probe,
+              zc->reason, sizeof(zc->reason)) == 0) {
+        gst_util_set_object_arg(G_OBJECT(source), "io-mode", "dmabuf");
+        if (enc->import_prop) gst_util_set_object_arg(G_OBJECT(encoder), enc->import_prop, "dmabuf-import");
+        zc->path = ZERO_COPY_DMABUF;
+    }
+    g_string_free(desc, TRUE);
+    g_free(device);
+
+out:
+    if (source) gst_object_unref(source);
+    g_list_free_full(chain, gst_object_unref);
+}
+
+void zero_copy_setup(ZeroCopy *zc, GstPipeline *pipeline, int allow_probe) {
+    zc->path = ZERO_COPY_NONE;
+    zc->reason[0] = '\0';
+
+    GstElement *encoder = gst_bin_get_by_name(GST_BIN(pipeline), "venc_bps");
+    if (encoder == NULL) encoder = gst_bin_get_by_name(GST_BIN(pipeline), "venc_kbps");
+    if (encoder == NULL) {
+        snprintf(zc->reason, sizeof(zc->reason), "no venc_bps / venc_kbps encoder");
+        return;
+    }
+
+    zero_copy_try(zc, encoder, allow_probe);
+    gst_object_unref(encoder);
+}
+
+const char *zero_copy_path_name(ZeroCopyPath path) {
+    switch (path) {
+        case ZERO_COPY_DMABUF: return "dmabuf";
+        case ZERO_COPY_NATIVE: return "native";
+        default:               return "none";
+    }
+}
@@ -64,6 +64,8 @@ void cli_options_print_usage(void) {
     fprintf(stderr, "  -s <streamid>       SRT stream ID\n");
     fprintf(stderr, "  -l <latency>        SRT latency in milliseconds\n");
     fprintf(stderr, "  -r                  Reduced SRT packet size\n");
+    fprintf(stderr, "  -L                  Low latency profile (see low_latency in the config)\n");
+    fprintf(stderr, "  -O <mode>           Stats overlay: off (default), auto or source\n");
     fprintf(stderr, "  -b <bitrate file>   Bitrate settings file (legacy, use -c instead)\n");
     fprintf(stderr, "  -a <algorithm>      Bitrate balancer algorithm (overrides config)\n\n");
     fprintf(stderr, "Config file example:\n");
@@ -84,7 +86,7 @@ int cli_options_parse(CliOptions *opts, int argc, char **argv) {
     opts->reduced_pkt_size = 0;
 
     int opt;
-    while ((opt = getopt(argc, argv, "a:c:d:b:s:l:rv")) != -1) {
+    while ((opt = getopt(argc, argv, "a:c:d:b:s:l:rLO:v")) != -1) {
         switch (opt) {
             case 'a':
                 opts->balancer_name = optarg;
@@ -122,6 +124,12 @@ int cli_options_parse(CliOptions *opts, int argc, char **argv) {
             case 'r':
                 opts->reduced_pkt_size = 1;
                 break;
+            case 'L':
+                opts->low_latency = 1;
+                break;
+            case 'O':
+                opts->overlay = optarg;
+                break;
             case 'v':
                 printf(VERSION "\n");
                 exit(EXIT_SUCCESS);
@@ -42,6 +42,8 @@ typedef struct {
     int srt_latency;           // SRT latency in ms
     int av_delay;              // Audio-video delay in ms
     int reduced_pkt_size;      // Use reduced SRT packet size (bool)
+    int low_latency;           // Low latency profile (bool, or set in config)
+    char *overlay;             // Overlay mode, overrides config
 } CliOptions;
 
 /*
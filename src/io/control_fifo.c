@@ -0,0 +1,129 @@
+/*
+    ceracoder - live video encoder with dynamic bitrate control
+    Copyright (C) 2020 BELABOX project
+    Copyright (C) 2026 CERALIVE
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "control_fifo.h"
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+int control_fifo_open(ControlFifo *cf, const char *path) {
+    memset(cf, 0, sizeof(*cf));
+    cf->fd = -1;
+
+    if (mkfifo(path, 0600) == 0) {
+        cf->created = 1;
+    } else if (errno != EEXIST) {
+        return -1;
+    }
+
+    // Also open for writing, so the FIFO doesn't hit EOF between writers
+    cf->fd = open(path, O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (cf->fd < 0) {
+        int err = errno;
+        if (cf->created) unlink(path);
+        errno = err;
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(cf->fd, &st) != 0 || !S_ISFIFO(st.st_mode)) {
+        close(cf->fd);
+        cf->fd = -1;
+        errno = EINVAL;
+        return -1;
+    }
+
+    snprintf(cf->path, sizeof(cf->path), "%s", path);
+    return 0;
+}
+
+int control_cmd_parse(const char *line, ControlCmd *cmd) {
+    while (isspace((unsigned char)*line)) line++;
+
+    const char *arg = line;
+    while (*arg != '\0' && !isspace((unsigned char)*arg)) arg++;
+    size_t name_len = arg - line;
+    while (isspace((unsigned char)*arg)) arg++;
+
+    size_t arg_len = strlen(arg);
+    while (arg_len > 0 && isspace((unsigned char)arg[arg_len - 1])) arg_len--;
+
+    if (name_len == 4 && strncmp(line, "swap", 4) == 0) {
+        if (arg_len == 0 || arg_len >= sizeof(cmd->arg)) return -1;
+        cmd->type = CONTROL_CMD_SWAP;
+        memcpy(cmd->arg, arg, arg_len);
+        cmd->arg[arg_len] = '\0';
+        return 0;
+    }
+
+    return -1;
+}
+
+int control_fifo_read(ControlFifo *cf, ControlCmd *cmds, int max) {
+    int count = 0;
+
+    for (;;) {
+        // Complete lines first; past max they stay buffered for the next call
+        char *start = cf->line;
+        char *nl;
+        while (count < max && (nl = memchr(start, '\n', cf->len - (start - cf->line))) != NULL) {
+            *nl = '\0';
+            if (*start != '\0') {
+                if (control_cmd_parse(start, &cmds[count]) == 0) {
+                    count++;
+                } else {
+                    fprintf(stderr, "Ignoring control command: %s\n", start);
+                }
+            }
+            start = nl + 1;
+        }
+        cf->len -= (int)(start - cf->line);
+        memmove(cf->line, start, cf->len);
+        if (count == max) break;
+
+        // A line longer than the buffer can't be a valid command
+        if (cf->len == (int)sizeof(cf->line) - 1) {
+            fprintf(stderr, "Ignoring an overlong control command\n");
+            cf->len = 0;
+        }
+
+        ssize_t ret = read(cf->fd, cf->line + cf->len, sizeof(cf->line) - 1 - cf->len);
+        if (ret < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            return -1;
+        }
+        if (ret == 0) break;
+        cf->len += (int)ret;
+    }
+
+    return count;
+}
+
+void control_fifo_close(ControlFifo *cf) {
+    if (cf->fd < 0) return;
+
+    close(cf->fd);
+    cf->fd = -1;
+    if (cf->created) unlink(cf->path);
+}
@@ -0,0 +1,86 @@
+/*
+    ceracoder - live video encoder with dynamic bitrate control
+    Copyright (C) 2020 BELABOX project
+    Copyright (C) 2026 CERALIVE
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef CONTROL_FIFO_H
+#define CONTROL_FIFO_H
+
+/*
+ * Control FIFO - runtime commands written to a named pipe, one per line
+ *
+ *   echo "swap pipeline/jetson/h265_camlink_720p30" > /run/ceracoder.ctl
+ *
+ * Commands:
+ *   swap <pipeline file>   Switch to another pipeline without dropping the
+ *                          SRT connection (see the pipeline hot-swap in
+ *                          ceracoder.c)
+ *
+ * The FIFO is created if missing and opened for reading and writing, so it
+ * never reports end of file when a writer closes it. Reads never block.
+ */
+
+#define CONTROL_ARG_SIZE    256
+#define CONTROL_LINE_SIZE   512
+
+typedef enum {
+    CONTROL_CMD_SWAP,
+} ControlCmdType;
+
+typedef struct {
+    ControlCmdType type;
+    char arg[CONTROL_ARG_SIZE];
+} ControlCmd;
+
+typedef struct {
+    int fd;
+    int created;                    // Unlinked on close
+    char path[256];
+    char line[CONTROL_LINE_SIZE];   // Partial line carried over between reads
+    int len;
+} ControlFifo;
+
+/*
+ * Create (if needed) and open the FIFO
+ *
+ * Returns 0 on success, -1 on error (errno is set).
+ */
+int control_fifo_open(ControlFifo *cf, const char *path);
+
+/*
+ * Parse one command line
+ *
+ * Returns 0 on success, -1 for an unknown or malformed command.
+ */
+int control_cmd_parse(const char *line, ControlCmd *cmd);
+
+/*
+ * Read what is available and parse the complete lines, up to max commands
+ *
+ * Malformed lines are reported and skipped. Once max commands are parsed,
+ * the rest is left for the next call, which may not need the FIFO to be
+ * readable again: call it until it returns fewer than max. Returns the
+ * number of commands, or -1 on a read error.
+ */
+int control_fifo_read(ControlFifo *cf, ControlCmd *cmds, int max);
+
+/*
+ * Close the FIFO, removing it if it was created by control_fifo_open
+ */
+void control_fifo_close(ControlFifo *cf);
+
+#endif /* CONTROL_FIFO_H */
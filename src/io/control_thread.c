@@ -0,0 +1,95 @@
+/*
+    ceracoder - live video encoder with dynamic bitrate control
+    Copyright (C) 2020 BELABOX project
+    Copyright (C) 2026 CERALIVE
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "control_thread.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+static void set_thread_priority(ControlThread *ct) {
+    struct sched_param param = { .sched_priority = CONTROL_THREAD_RT_PRIORITY };
+    if (pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0) {
+        snprintf(ct->sched, sizeof(ct->sched), "SCHED_FIFO %d", CONTROL_THREAD_RT_PRIORITY);
+        return;
+    }
+
+    // On Linux the nice value is per thread
+    if (setpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid), CONTROL_THREAD_NICE) == 0) {
+        snprintf(ct->sched, sizeof(ct->sched), "nice %d", CONTROL_THREAD_NICE);
+        return;
+    }
+
+    snprintf(ct->sched, sizeof(ct->sched), "default");
+}
+
+static gpointer control_thread_run(gpointer data) {
+    ControlThread *ct = (ControlThread *)data;
+
+    set_thread_priority(ct);
+    fprintf(stderr, "Control thread running with %s scheduling\n", ct->sched);
+
+    g_main_context_push_thread_default(ct->context);
+    g_main_loop_run(ct->loop);
+    g_main_context_pop_thread_default(ct->context);
+
+    return NULL;
+}
+
+int control_thread_start(ControlThread *ct) {
+    memset(ct, 0, sizeof(*ct));
+
+    ct->context = g_main_context_new();
+    ct->loop = g_main_loop_new(ct->context, FALSE);
+    GError *error = NULL;
+    ct->thread = g_thread_try_new("control", control_thread_run, ct, &error);
+    if (ct->thread == NULL) {
+        fprintf(stderr, "Failed to create the control thread: %s\n", error->message);
+        g_error_free(error);
+        g_main_loop_unref(ct->loop);
+        g_main_context_unref(ct->context);
+        ct->loop = NULL;
+        ct->context = NULL;
+        return -1;
+    }
+
+    return 0;
+}
+
+static gboolean quit_loop(gpointer data) {
+    g_main_loop_quit((GMainLoop *)data);
+    return G_SOURCE_REMOVE;
+}
+
+void control_thread_stop(ControlThread *ct) {
+    if (ct->thread == NULL) return;
+
+    // Quit from inside the loop, so a stop right after the start isn't lost
+    g_main_context_invoke(ct->context, quit_loop, ct->loop);
+    g_thread_join(ct->thread);
+    ct->thread = NULL;
+
+    g_main_loop_unref(ct->loop);
+    g_main_context_unref(ct->context);
+    ct->loop = NULL;
+    ct->context = NULL;
+}
@@ -0,0 +1,61 @@
+/*
+    ceracoder - live video encoder with dynamic bitrate control
+    Copyright (C) 2020 BELABOX project
+    Copyright (C) 2026 CERALIVE
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef CONTROL_THREAD_H
+#define CONTROL_THREAD_H
+
+#include <glib.h>
+
+/*
+ * Control thread - a dedicated thread and GMainContext for the balancer tick
+ *
+ * The default main context also dispatches bus messages, the stall check
+ * and the stats file writes, so a slow callback there delays the 20 ms
+ * balancer tick. Timers added here run on their own thread instead, at
+ * real-time priority (SCHED_FIFO) when the process is allowed to, or at a
+ * raised nice level otherwise. Anything that may block on GStreamer locks
+ * (encoder / overlay property sets) must be handed back to the default
+ * context, e.g. with g_idle_add().
+ *
+ * Timers are added to the context with timer_monitor_add().
+ */
+
+#define CONTROL_THREAD_RT_PRIORITY  10      // SCHED_FIFO priority
+#define CONTROL_THREAD_NICE         -10     // Fallback without CAP_SYS_NICE / RLIMIT_RTPRIO
+
+typedef struct {
+    GThread *thread;
+    GMainContext *context;
+    GMainLoop *loop;
+    char sched[32];             // Scheduling applied to the thread, for the log
+} ControlThread;
+
+/*
+ * Create the context and start the thread
+ *
+ * Returns 0 on success, -1 on error.
+ */
+int control_thread_start(ControlThread *ct);
+
+/*
+ * Stop and join the thread, then free the context
+ */
+void control_thread_stop(ControlThread *ct);
+
+#endif /* CONTROL_THREAD_H */
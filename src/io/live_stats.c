@@ -0,0 +1,156 @@
+/*
+    ceracoder - live video encoder with dynamic bitrate control
+    Copyright (C) 2020 BELABOX project
+    Copyright (C) 2026 CERALIVE
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "live_stats.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// The feed of another process that is still running
+static int owned_by_other(const char *path) {
+    LiveStats other;
+    if (live_stats_open(&other, path) != 0) return 0;
+    pid_t pid = other.shm->pid;
+    live_stats_close(&other);
+    return pid != getpid() && (kill(pid, 0) == 0 || errno == EPERM);
+}
+
+int live_stats_create(LiveStats *ls, const char *path, const char *balancer, int srt_latency) {
+    memset(ls, 0, sizeof(*ls));
+
+    if (owned_by_other(path)) {
+        errno = EBUSY;
+        return -1;
+    }
+
+    // Replace rather than truncate, a viewer may still map the old file
+    unlink(path);
+    int fd = open(path, O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (fd < 0) return -1;
+    void *map = MAP_FAILED;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && ftruncate(fd, sizeof(LiveStatsShm)) == 0) {
+        map = mmap(NULL, sizeof(LiveStatsShm), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    if (map == MAP_FAILED) {
+        int err = errno;
+        close(fd);
+        unlink(path);
+        errno = err;
+        return -1;
+    }
+    close(fd);
+
+    LiveStatsShm *shm = (LiveStatsShm *)map;
+    shm->version = LIVE_STATS_VERSION;
+    shm->slots = LIVE_STATS_SLOTS;
+    shm->sample_size = sizeof(LiveStatsSample);
+    shm->pid = (int32_t)getpid();
+    shm->srt_latency = srt_latency;
+    snprintf(shm->balancer, sizeof(shm->balancer), "%s", balancer);
+    __atomic_store_n(&shm->magic, LIVE_STATS_MAGIC, __ATOMIC_RELEASE);
+
+    ls->shm = shm;
+    ls->writer = 1;
+    ls->dev = st.st_dev;
+    ls->ino = st.st_ino;
+    snprintf(ls->path, sizeof(ls->path), "%s", path);
+    return 0;
+}
+
+void live_stats_publish(LiveStats *ls, LiveStatsSample *sample, uint64_t timestamp_ms) {
+    if (ls->shm == NULL) return;
+
+    LiveStatsShm *shm = ls->shm;
+    uint64_t seq = shm->head + 1;
+    LiveStatsSample *slot = &shm->ring[seq % LIVE_STATS_SLOTS];
+
+    // Invalidate the slot before overwriting it, publish it once complete
+    __atomic_store_n(&slot->seq, 0, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    sample->seq = 0;
+    sample->timestamp_ms = timestamp_ms;
+    memcpy(slot, sample, sizeof(*slot));
+    __atomic_store_n(&slot->seq, seq, __ATOMIC_RELEASE);
+    __atomic_store_n(&shm->head, seq, __ATOMIC_RELEASE);
+}
+
+int live_stats_open(LiveStats *ls, const char *path) {
+    memset(ls, 0, sizeof(*ls));
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return -1;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(LiveStatsShm)) {
+        close(fd);
+        return -1;
+    }
+
+    void *map = mmap(NULL, sizeof(LiveStatsShm), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return -1;
+
+    LiveStatsShm *shm = (LiveStatsShm *)map;
+    if (__atomic_load_n(&shm->magic, __ATOMIC_ACQUIRE) != LIVE_STATS_MAGIC ||
+        shm->version != LIVE_STATS_VERSION || shm->slots != LIVE_STATS_SLOTS ||
+        shm->sample_size != sizeof(LiveStatsSample)) {
+        munmap(map, sizeof(LiveStatsShm));
+        return -1;
+    }
+
+    ls->shm = shm;
+    snprintf(ls->path, sizeof(ls->path), "%s", path);
+    return 0;
+}
+
+uint64_t live_stats_head(const LiveStats *ls) {
+    if (ls->shm == NULL) return 0;
+    return __atomic_load_n(&ls->shm->head, __ATOMIC_ACQUIRE);
+}
+
+int live_stats_read(const LiveStats *ls, uint64_t seq, LiveStatsSample *out) {
+    if (ls->shm == NULL || seq == 0) return -1;
+
+    const LiveStatsSample *slot = &ls->shm->ring[seq % LIVE_STATS_SLOTS];
+    if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != seq) return -1;
+    memcpy(out, slot, sizeof(*out));
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+    // Overwritten while copying
+    if (__atomic_load_n(&slot->seq, __ATOMIC_RELAXED) != seq) return -1;
+    out->seq = seq;
+    return 0;
+}
+
+void live_stats_close(LiveStats *ls) {
+    if (ls->shm == NULL) return;
+
+    munmap(ls->shm, sizeof(LiveStatsShm));
+    struct stat st;
+    if (ls->writer && stat(ls->path, &st) == 0 && st.st_dev == ls->dev && st.st_ino == ls->ino) {
+        unlink(ls->path);
+    }
+    ls->shm = NULL;
+}
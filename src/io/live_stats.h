@@ -0,0 +1,136 @@
+/*
+    ceracoder - live video encoder with dynamic bitrate control
+    Copyright (C) 2020 BELABOX project
+    Copyright (C) 2026 CERALIVE
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef LIVE_STATS_H
+#define LIVE_STATS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+/*
+ * Live stats feed - a ring of per-tick samples in a shared memory file
+ *
+ * ceracoder writes one sample per balancer tick (every 20 ms) into a file
+ * mapped in memory, normally on /dev/shm; viewers such as ceratop map it
+ * read-only. The writer never waits for the readers: each slot carries its
+ * sample number, written last, so a reader can tell a complete sample from
+ * one being overwritten and skips the latter.
+ *
+ * The layout is fixed-size and versioned; a reader rejects a file with a
+ * different magic, version or sample size. The feed is off by default: each
+ * instance needs a path of its own, the file of another running writer is
+ * not replaced.
+ */
+
+#define LIVE_STATS_MAGIC        0x43455241u     // "CERA"
+#define LIVE_STATS_VERSION      1
+#define LIVE_STATS_SLOTS        512             // ~10 s at 50 Hz
+#define LIVE_STATS_DEF_PATH     "/dev/shm/ceracoder.live"
+
+typedef struct {
+    uint64_t seq;               // Sample number (from 1), 0 while being written
+    uint64_t timestamp_ms;      // CLOCK_MONOTONIC
+
+    // Bitrates (bps)
+    int32_t target_bps;         // Balancer output
+    int32_t encoder_bps;        // Last applied to the encoder
+    int32_t output_bps;         // Measured encoder output
+    int32_t send_bps;           // SRT send rate
+    int32_t min_bps;            // Balancer bounds, can change on a config reload
+    int32_t max_bps;
+
+    // Balancer input / decision
+    float rtt_ms;
+    float rtt_th_min_ms;
+    float rtt_th_max_ms;
+    int32_t bs;                 // SRT send buffer (packets)
+    int32_t bs_th1;
+    int32_t bs_th2;
+    int32_t bs_th3;
+    int32_t state;              // BalancerState
+    int32_t reason;             // BalancerReason
+    int64_t pkt_loss_total;
+    int64_t pkt_retrans_total;
+
+    // Mux (-1 without a monitored mux)
+    int32_t mux_lag_ms;         // Worst input arrival lag
+    int32_t mux_delay_ms;       // Output delay
+    int32_t mux_latency_ms;     // Aggregator latency property
+    int32_t reserved;
+} LiveStatsSample;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slots;
+    uint32_t sample_size;
+    int32_t pid;
+    int32_t srt_latency;        // ms
+    char balancer[32];
+    uint64_t head;              // Latest complete sample number, 0 = none yet
+    LiveStatsSample ring[LIVE_STATS_SLOTS];
+} LiveStatsShm;
+
+typedef struct {
+    LiveStatsShm *shm;
+    char path[256];
+    int writer;
+    dev_t dev;                  // Created file, only removed if still in place
+    ino_t ino;
+} LiveStats;
+
+/*
+ * Create (or replace) the file and map it for writing
+ *
+ * Returns 0 on success, -1 on error (errno is EBUSY if the file is the feed
+ * of another running process).
+ */
+int live_stats_create(LiveStats *ls, const char *path, const char *balancer, int srt_latency);
+
+/*
+ * Append a sample; seq and timestamp_ms are filled in
+ */
+void live_stats_publish(LiveStats *ls, LiveStatsSample *sample, uint64_t timestamp_ms);
+
+/*
+ * Map an existing file read-only
+ *
+ * Returns 0 on success, -1 if it can't be opened or has another layout.
+ */
+int live_stats_open(LiveStats *ls, const char *path);
+
+/*
+ * Latest complete sample number, 0 if none
+ */
+uint64_t live_stats_head(const LiveStats *ls);
+
+/*
+ * Copy sample number seq
+ *
+ * Returns 0 on success, -1 if it was overwritten (or not written yet).
+ */
+int live_stats_read(const LiveStats *ls, uint64_t seq, LiveStatsSample *out);
+
+/*
+ * Unmap; the writer also removes the file, unless it was replaced since
+ */
+void live_stats_close(LiveStats *ls);
+
+#endif /* LIVE_STATS_H */
@@ -0,0 +1,158 @@
+/*
+    ceracoder - live video encoder with dynamic bitrate control
+    Copyright (C) 2020 BELABOX project
+    Copyright (C) 2026 CERALIVE
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "notify.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stddef.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#define NOTIFY_MSG_SIZE 512
+
+static int parse_env_long(const char *name, long *value) {
+    const char *str = getenv(name);
+    if (str == NULL || *str == '\0') return -1;
+
+    char *end;
+    errno = 0;
+    long v = strtol(str, &end, 10);
+    if (errno != 0 || *end != '\0' || v < 0) return -1;
+
+    *value = v;
+    return 0;
+}
+
+static void init_socket(Notifier *n) {
+    const char *path = getenv("NOTIFY_SOCKET");
+    if (path == NULL || path[0] == '\0') return;
+
+    size_t len = strlen(path);
+    if ((path[0] != '/' && path[0] != '@') || len >= sizeof(n->sock_path)) {
+        fprintf(stderr, "Ignoring invalid NOTIFY_SOCKET: %s\n", path);
+        return;
+    }
+
+    memcpy(n->sock_path, path, len);
+    if (path[0] == '@') n->sock_path[0] = '\0';  // abstract namespace
+    n->sock_path_len = (int)len;
+
+    n->sock = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+    if (n->sock < 0) {
+        fprintf(stderr, "Failed to open the notification socket: %s\n", strerror(errno));
+    }
+}
+
+static void init_fd(Notifier *n) {
+    long fd;
+    if (parse_env_long("CERACODER_NOTIFY_FD", &fd) != 0) return;
+
+    if (fd <= 2 || fd > 65535 || fcntl((int)fd, F_GETFD) < 0) {
+        fprintf(stderr, "Ignoring invalid CERACODER_NOTIFY_FD: %ld\n", fd);
+        return;
+    }
+
+    n->fd = (int)fd;
+    fcntl(n->fd, F_SETFD, FD_CLOEXEC);
+    fcntl(n->fd, F_SETFL, fcntl(n->fd, F_GETFL) | O_NONBLOCK);
+
+    // A supervisor that goes away must not kill us via SIGPIPE
+    signal(SIGPIPE, SIG_IGN);
+}
+
+int notify_init(Notifier *n) {
+    memset(n, 0, sizeof(*n));
+    n->sock = -1;
+    n->fd = -1;
+    n->watchdog_interval = NOTIFY_DEF_WATCHDOG_INT;
+    g_mutex_init(&n->fd_lock);
+
+    long watchdog_usec;
+    if (parse_env_long("WATCHDOG_USEC", &watchdog_usec) == 0 && watchdog_usec > 0) {
+        n->watchdog_interval = (int)(watchdog_usec / 2000);
+        if (n->watchdog_interval < 1) n->watchdog_interval = 1;
+    }
+
+    init_socket(n);
+    init_fd(n);
+
+    return notify_enabled(n) ? 0 : -1;
+}
+
+int notify_enabled(const Notifier *n) {
+    return (n->sock >= 0 || g_atomic_int_get(&n->fd) >= 0) ? 1 : 0;
+}
+
+int notify_send(Notifier *n, const char *fmt, ...) {
+    if (!notify_enabled(n)) return 0;
+
+    char msg[NOTIFY_MSG_SIZE];
+    va_list args;
+    va_start(args, fmt);
+    int len = vsnprintf(msg, sizeof(msg) - 1, fmt, args);
+    va_end(args);
+    if (len < 0) return -1;
+    if (len > (int)sizeof(msg) - 2) len = sizeof(msg) - 2;
+
+    int ret = 0;
+
+    if (n->sock >= 0) {
+        struct sockaddr_un addr = { .sun_family = AF_UNIX };
+        memcpy(addr.sun_path, n->sock_path, n->sock_path_len);
+        socklen_t addr_len = offsetof(struct sockaddr_un, sun_path) + n->sock_path_len;
+        if (sendto(n->sock, msg, len, MSG_NOSIGNAL, (struct sockaddr *)&addr, addr_len) != len) {
+            ret = -1;
+        }
+    }
+
+    // Serialized with closing the fd, so a write can't reach a reused fd number
+    g_mutex_lock(&n->fd_lock);
+    if (n->fd >= 0) {
+        // One assignment per line, terminated by a newline
+        msg[len] = '\n';
+        if (write(n->fd, msg, len + 1) != len + 1) {
+            if (errno == EPIPE || errno == EBADF) {
+                // The reader is gone, stop writing
+                close(n->fd);
+                g_atomic_int_set(&n->fd, -1);
+            }
+            ret = -1;
+        }
+    }
+    g_mutex_unlock(&n->fd_lock);
+
+    return ret;
+}
+
+void notify_cleanup(Notifier *n) {
+    if (n->sock >= 0) close(n->sock);
+    n->sock = -1;
+
+    g_mutex_lock(&n->fd_lock);
+    if (n->fd >= 0) close(n->fd);
+    g_atomic_int_set(&n->fd, -1);
+    g_mutex_unlock(&n->fd_lock);
+    g_mutex_clear(&n->fd_lock);
+}
@@ -0,0 +1,77 @@
+/*
+    ceracoder - live video encoder with dynamic bitrate control
+    Copyright (C) 2020 BELABOX project
+    Copyright (C) 2026 CERALIVE
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef NOTIFY_H
+#define NOTIFY_H
+
+#include <glib.h>
+#include <stdint.h>
+
+/*
+ * Notify module - readiness and liveness signalling for supervisors
+ *
+ * Sends sd_notify(3) style messages ("READY=1", "WATCHDOG=1",
+ * "STATUS=...", "STOPPING=1") to:
+ * - the systemd notification socket in $NOTIFY_SOCKET (no libsystemd needed)
+ * - an inherited file descriptor given in $CERACODER_NOTIFY_FD, one
+ *   assignment per line (used by the TypeScript bindings)
+ *
+ * The watchdog interval is half of $WATCHDOG_USEC when systemd sets it,
+ * NOTIFY_DEF_WATCHDOG_INT otherwise. notify_send() can be called from any
+ * thread.
+ */
+
+#define NOTIFY_DEF_WATCHDOG_INT 1000 // ms
+
+typedef struct {
+    int sock;                   // AF_UNIX datagram socket, -1 if unused
+    char sock_path[108];        // sun_path, leading '\0' for abstract sockets
+    int sock_path_len;
+    int fd;                     // Inherited fd, -1 if unused or closed, under fd_lock
+    GMutex fd_lock;
+    int watchdog_interval;      // ms
+} Notifier;
+
+/*
+ * Initialize from the environment
+ *
+ * Returns 0 if at least one target is configured, -1 otherwise
+ * (all notify calls are then no-ops).
+ */
+int notify_init(Notifier *n);
+
+/*
+ * Check if any target is configured
+ */
+int notify_enabled(const Notifier *n);
+
+/*
+ * Send a notification, printf-style, e.g. notify_send(n, "STATUS=%s", text)
+ *
+ * Multiple assignments are separated by newlines. Delivery is best effort
+ * and never blocks. Returns 0 if sent to all targets, -1 otherwise.
+ */
+int notify_send(Notifier *n, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+
+/*
+ * Close the socket and inherited fd
+ */
+void notify_cleanup(Notifier *n);
+
+#endif /* NOTIFY_H */
@@ -0,0 +1,229 @@
+/*
+    ceracoder - live video encoder with dynamic bitrate control
+    Copyright (C) 2020 BELABOX project
+    Copyright (C) 2026 CERALIVE
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "perf_counters.h"
+#include <linux/perf_event.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+static const struct {
+    const char *name;       // Stats name part
+    const char *help;
+    PerfSource source;      // Where the counter comes from when available
+    uint64_t config;        // PERF_TYPE_HARDWARE event
+} counters[PERF_COUNTER_COUNT] = {
+    [PERF_COUNTER_CYCLES] = { "cycles", "CPU cycles in user space",
+                              PERF_SOURCE_PERF, PERF_COUNT_HW_CPU_CYCLES },
+    [PERF_COUNTER_INSTRUCTIONS] = { "instructions", "Instructions retired in user space",
+                                    PERF_SOURCE_PERF, PERF_COUNT_HW_INSTRUCTIONS },
+    [PERF_COUNTER_CACHE_MISSES] = { "cache_misses", "Last level cache misses in user space",
+                                    PERF_SOURCE_PERF, PERF_COUNT_HW_CACHE_MISSES },
+    [PERF_COUNTER_CONTEXT_SWITCHES] = { "context_switches",
+                                        "Voluntary and involuntary context switches",
+                                        PERF_SOURCE_RUSAGE, 0 },
+    [PERF_COUNTER_CPU_TIME] = { "cpu_time", "User and system CPU time (us)",
+                                PERF_SOURCE_RUSAGE, 0 },
+};
+
+static int perf_event_open_thread(uint64_t config, pid_t tid) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = config;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    return (int)syscall(SYS_perf_event_open, &attr, tid, -1, -1, PERF_FLAG_FD_CLOEXEC);
+}
+
+// Reads an event, scaled up if it was multiplexed with other events
+static int perf_event_read(int fd, uint64_t *value) {
+    uint64_t buf[3];
+    if (read(fd, buf, sizeof(buf)) != (ssize_t)sizeof(buf)) return -1;
+
+    uint64_t enabled = buf[1];
+    uint64_t running = buf[2];
+    if (running > 0 && running < enabled) {
+        *value = (uint64_t)((double)buf[0] * enabled / running);
+    } else {
+        *value = buf[0];
+    }
+    return 0;
+}
+
+static int read_counters(PerfCounters *pc, uint64_t *values) {
+    struct rusage ru;
+    if (getrusage(RUSAGE_THREAD, &ru) != 0) return -1;
+    values[PERF_COUNTER_CONTEXT_SWITCHES] = (uint64_t)(ru.ru_nvcsw + ru.ru_nivcsw);
+    values[PERF_COUNTER_CPU_TIME] =
+        (uint64_t)(ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * 1000000 +
+        (uint64_t)(ru.ru_utime.tv_usec + ru.ru_stime.tv_usec);
+
+    for (int i = 0; i < PERF_COUNTER_COUNT; i++) {
+        if (pc->source[i] != PERF_SOURCE_PERF) continue;
+        if (perf_event_read(pc->fd[i], &values[i]) != 0) return -1;
+    }
+    return 0;
+}
+
+static void detach(PerfCounters *pc) {
+    for (int i = 0; i < PERF_COUNTER_COUNT; i++) {
+        if (pc->fd[i] >= 0) close(pc->fd[i]);
+        pc->fd[i] = -1;
+    }
+    pc->attached = 0;
+}
+
+static void attach(PerfCounters *pc, pid_t tid) {
+    int n_perf = 0;
+    for (int i = 0; i < PERF_COUNTER_COUNT; i++) {
+        if (counters[i].source == PERF_SOURCE_RUSAGE) {
+            pc->source[i] = PERF_SOURCE_RUSAGE;
+            continue;
+        }
+        if (pc->mode != PERF_MODE_AUTO) continue;
+
+        pc->fd[i] = perf_event_open_thread(counters[i].config, tid);
+        if (pc->fd[i] >= 0) {
+            pc->source[i] = PERF_SOURCE_PERF;
+            n_perf++;
+        } else {
+            pc->source[i] = PERF_SOURCE_NONE;
+        }
+    }
+
+    fprintf(stderr, "Performance counters for the %s thread: %s\n", pc->thread,
+            n_perf > 0 ? "perf events" : "getrusage (perf events unavailable)");
+    pc->tid = tid;
+    pc->attached = 1;
+}
+
+void perf_counters_init(PerfCounters *pc, const char *thread, PerfMode mode) {
+    memset(pc, 0, sizeof(*pc));
+    snprintf(pc->thread, sizeof(pc->thread), "%s", thread);
+    pc->mode = mode;
+    for (int i = 0; i < PERF_COUNTER_COUNT; i++) {
+        pc->fd[i] = -1;
+    }
+    g_mutex_init(&pc->lock);
+}
+
+void perf_counters_sample(PerfCounters *pc, uint64_t now_ms) {
+    if (pc->mode == PERF_MODE_OFF) return;
+    if (pc->attached && now_ms - pc->prev_ms < PERF_COUNTERS_INTERVAL_MS) return;
+
+    // The measured thread changes when a swapped in pipeline takes over the
+    // output: attach to the new one and start again from a baseline
+    pid_t tid = (pid_t)syscall(SYS_gettid);
+    if (pc->attached && tid != pc->tid) {
+        detach(pc);
+        pc->prev_ms = 0;
+    }
+    if (!pc->attached) attach(pc, tid);
+
+    uint64_t values[PERF_COUNTER_COUNT] = {0};
+    if (read_counters(pc, values) != 0) return;
+
+    // The first sample is the baseline
+    if (pc->prev_ms != 0) {
+        g_mutex_lock(&pc->lock);
+        for (int i = 0; i < PERF_COUNTER_COUNT; i++) {
+            pc->delta[i] = values[i] - pc->prev[i];
+            pc->total[i] += pc->delta[i];
+        }
+        pc->delta_ms = now_ms - pc->prev_ms;
+        pc->total_ms += pc->delta_ms;
+        g_mutex_unlock(&pc->lock);
+    }
+
+    memcpy(pc->prev, values, sizeof(values));
+    pc->prev_ms = now_ms;
+}
+
+static int has_ipc(const PerfCounters *pc) {
+    return pc->source[PERF_COUNTER_CYCLES] == PERF_SOURCE_PERF &&
+           pc->source[PERF_COUNTER_INSTRUCTIONS] == PERF_SOURCE_PERF;
+}
+
+void perf_counters_publish(PerfCounters *pc, Stats *stats) {
+    if (pc->mode == PERF_MODE_OFF) return;
+
+    char labels[32];
+    char name[STATS_NAME_LEN];
+    snprintf(labels, sizeof(labels), "thread=\"%s\"", pc->thread);
+
+    g_mutex_lock(&pc->lock);
+    if (pc->delta_ms == 0) {
+        g_mutex_unlock(&pc->lock);
+        return;
+    }
+    double secs = pc->delta_ms / 1000.0;
+
+    // CPU time is published as a percentage
+    for (int i = 0; i < PERF_COUNTER_CPU_TIME; i++) {
+        if (pc->source[i] == PERF_SOURCE_NONE) continue;
+        snprintf(name, sizeof(name), "ceracoder_thread_%s_per_second{%s}",
+                 counters[i].name, labels);
+        stats_set(stats, name, STATS_GAUGE, counters[i].help, pc->delta[i] / secs);
+    }
+
+    snprintf(name, sizeof(name), "ceracoder_thread_cpu_percent{%s}", labels);
+    stats_set(stats, name, STATS_GAUGE, "Share of one CPU used by the thread",
+              pc->delta[PERF_COUNTER_CPU_TIME] / (secs * 10000.0));
+
+    if (has_ipc(pc) && pc->delta[PERF_COUNTER_CYCLES] > 0) {
+        snprintf(name, sizeof(name), "ceracoder_thread_ipc{%s}", labels);
+        stats_set(stats, name, STATS_GAUGE, "Instructions per cycle",
+                  (double)pc->delta[PERF_COUNTER_INSTRUCTIONS] / pc->delta[PERF_COUNTER_CYCLES]);
+    }
+    g_mutex_unlock(&pc->lock);
+}
+
+void perf_counters_report(PerfCounters *pc) {
+    if (pc->mode == PERF_MODE_OFF) return;
+
+    g_mutex_lock(&pc->lock);
+    if (pc->total_ms == 0) {
+        g_mutex_unlock(&pc->lock);
+        return;
+    }
+    double secs = pc->total_ms / 1000.0;
+
+    fprintf(stderr, "%s thread over %.0f s:", pc->thread, secs);
+    for (int i = 0; i < PERF_COUNTER_CPU_TIME; i++) {
+        if (pc->source[i] == PERF_SOURCE_NONE) continue;
+        fprintf(stderr, " %s %.0f/s", counters[i].name, pc->total[i] / secs);
+    }
+    if (has_ipc(pc) && pc->total[PERF_COUNTER_CYCLES] > 0) {
+        fprintf(stderr, " ipc %.2f",
+                (double)pc->total[PERF_COUNTER_INSTRUCTIONS] / pc->total[PERF_COUNTER_CYCLES]);
+    }
+    fprintf(stderr, " cpu %.1f%%\n", pc->total[PERF_COUNTER_CPU_TIME] / (secs * 10000.0));
+    g_mutex_unlock(&pc->lock);
+}
+
+void perf_counters_cleanup(PerfCounters *pc) {
+    detach(pc);
+    g_mutex_clear(&pc->lock);
+}
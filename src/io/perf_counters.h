@@ -0,0 +1,121 @@
+/*
+    ceracoder - live video encoder with dynamic bitrate control
+    Copyright (C) 2020 BELABOX project
+    Copyright (C) 2026 CERALIVE
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <glib.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include "stats.h"
+
+/*
+ * Per-thread performance counters
+ *
+ * Counts cycles, instructions and cache misses of one thread with
+ * perf_event_open(), user space only, so it works with the default
+ * perf_event_paranoid level. Context switches and CPU time come from
+ * getrusage(RUSAGE_THREAD) (a context switch happens in the kernel, it
+ * isn't visible to a user space only event). When the perf events can't be
+ * opened (no PMU, seccomp, paranoid level 3) only the getrusage counters
+ * are reported.
+ *
+ * The counters are attached to, and sampled from, the thread being measured:
+ * perf_counters_sample() is called from its hot path and takes a sample at
+ * most once per PERF_COUNTERS_INTERVAL_MS. When it is called from another
+ * thread, the counters move to that thread (one caller at a time). Publishing
+ * and the exit report can be done from any thread.
+ */
+
+#define PERF_COUNTERS_INTERVAL_MS  1000
+
+typedef enum {
+    PERF_COUNTER_CYCLES,
+    PERF_COUNTER_INSTRUCTIONS,
+    PERF_COUNTER_CACHE_MISSES,
+    PERF_COUNTER_CONTEXT_SWITCHES,
+    PERF_COUNTER_CPU_TIME,          // User + system CPU time (us)
+    PERF_COUNTER_COUNT
+} PerfCounterId;
+
+typedef enum {
+    PERF_MODE_OFF,                  // Not sampled
+    PERF_MODE_AUTO,                 // perf events, getrusage for what can't be opened
+    PERF_MODE_RUSAGE                // getrusage only
+} PerfMode;
+
+typedef enum {
+    PERF_SOURCE_NONE,
+    PERF_SOURCE_PERF,
+    PERF_SOURCE_RUSAGE
+} PerfSource;
+
+typedef struct {
+    char thread[16];                // Thread label for the stats and the report
+    PerfMode mode;
+    int attached;
+    pid_t tid;                      // Thread the counters are attached to
+
+    // Owned by the measured thread
+    int fd[PERF_COUNTER_COUNT];
+    PerfSource source[PERF_COUNTER_COUNT];
+    uint64_t prev[PERF_COUNTER_COUNT];
+    uint64_t prev_ms;
+
+    // Shared, under lock
+    GMutex lock;
+    uint64_t delta[PERF_COUNTER_COUNT];     // Last complete interval
+    uint64_t delta_ms;
+    uint64_t total[PERF_COUNTER_COUNT];     // Since the first sample
+    uint64_t total_ms;
+} PerfCounters;
+
+/*
+ * Initialize, nothing is opened until the first sample
+ */
+void perf_counters_init(PerfCounters *pc, const char *thread, PerfMode mode);
+
+/*
+ * Sample the counters of the calling thread
+ *
+ * The first call attaches the counters to the calling thread. A call from
+ * another thread re-attaches them and takes a new baseline; calls must not
+ * overlap. Cheap when the interval hasn't elapsed.
+ */
+void perf_counters_sample(PerfCounters *pc, uint64_t now_ms);
+
+/*
+ * Publish the per-second rates of the last interval:
+ *   ceracoder_thread_<counter>_per_second{thread="..."}
+ *   ceracoder_thread_cpu_percent{thread="..."}
+ *   ceracoder_thread_ipc{thread="..."}
+ */
+void perf_counters_publish(PerfCounters *pc, Stats *stats);
+
+/*
+ * Print the averages since the first sample to stderr
+ */
+void perf_counters_report(PerfCounters *pc);
+
+/*
+ * Close the perf events
+ */
+void perf_counters_cleanup(PerfCounters *pc);
+
+#endif /* PERF_COUNTERS_H */
@@ -19,6 +19,7 @@
 
 #include "pipeline_loader.h"
 #include <stdio.h>
+#include <string.h>
 #include <fcntl.h>
 #include <unistd.h>
 #include <sys/mman.h>
@@ -71,6 +72,92 @@ GstPipeline* pipeline_create(const PipelineFile *pfile) {
     return pipeline;
 }
 
+int pipeline_limit_queues(GstPipeline *pipeline, int max_ms) {
+    int count = 0;
+    GstIterator *it = gst_bin_iterate_recurse(GST_BIN(pipeline));
+    GValue item = G_VALUE_INIT;
+
+    while (gst_iterator_next(it, &item) == GST_ITERATOR_OK) {
+        GstElement *elem = GST_ELEMENT(g_value_get_object(&item));
+        GstElementFactory *factory = gst_element_get_factory(elem);
+        if (factory != NULL &&
+            strcmp(gst_plugin_feature_get_name(GST_PLUGIN_FEATURE(factory)), "queue") == 0) {
+            g_object_set(G_OBJECT(elem),
+                         "max-size-time", (guint64)max_ms * GST_MSECOND,
+                         "max-size-buffers", 0,
+                         "max-size-bytes", 0,
+                         NULL);
+            count++;
+        }
+        g_value_reset(&item);
+    }
+
+    g_value_unset(&item);
+    gst_iterator_free(it);
+    return count;
+}
+
+// Capture device of a source element, NULL if it doesn't name one
+static gchar *source_device(GstElement *elem) {
+    static const char *number_props[] = {"sensor-id", "device-number"};
+    GObjectClass *klass = G_OBJECT_GET_CLASS(elem);
+
+    GParamSpec *spec = g_object_class_find_property(klass, "device");
+    if (spec != NULL && spec->value_type == G_TYPE_STRING) {
+        gchar *device = NULL;
+        g_object_get(G_OBJECT(elem), "device", &device, NULL);
+        return device;
+    }
+
+    for (size_t i = 0; i < sizeof(number_props) / sizeof(number_props[0]); i++) {
+        spec = g_object_class_find_property(klass, number_props[i]);
+        if (spec != NULL && spec->value_type == G_TYPE_INT) {
+            GstElementFactory *factory = gst_element_get_factory(elem);
+            gint number = 0;
+            g_object_get(G_OBJECT(elem), number_props[i], &number, NULL);
+            return g_strdup_printf("%s:%d", factory != NULL ?
+                                   gst_plugin_feature_get_name(GST_PLUGIN_FEATURE(factory)) : "",
+                                   number);
+        }
+    }
+    return NULL;
+}
+
+static GPtrArray *pipeline_devices(GstPipeline *pipeline) {
+    GPtrArray *devices = g_ptr_array_new_with_free_func(g_free);
+    GstIterator *it = gst_bin_iterate_recurse(GST_BIN(pipeline));
+    GValue item = G_VALUE_INIT;
+
+    while (gst_iterator_next(it, &item) == GST_ITERATOR_OK) {
+        GstElement *elem = GST_ELEMENT(g_value_get_object(&item));
+        if (GST_OBJECT_FLAG_IS_SET(elem, GST_ELEMENT_FLAG_SOURCE)) {
+            gchar *device = source_device(elem);
+            if (device != NULL) g_ptr_array_add(devices, device);
+        }
+        g_value_reset(&item);
+    }
+
+    g_value_unset(&item);
+    gst_iterator_free(it);
+    return devices;
+}
+
+int pipeline_shares_device(GstPipeline *a, GstPipeline *b) {
+    GPtrArray *da = pipeline_devices(a);
+    GPtrArray *db = pipeline_devices(b);
+    int shared = 0;
+
+    for (guint i = 0; i < da->len && !shared; i++) {
+        for (guint j = 0; j < db->len && !shared; j++) {
+            shared = strcmp(g_ptr_array_index(da, i), g_ptr_array_index(db, j)) == 0;
+        }
+    }
+
+    g_ptr_array_unref(da);
+    g_ptr_array_unref(db);
+    return shared;
+}
+
 void pipeline_file_unload(PipelineFile *pfile) {
     if (pfile->launch_string != NULL) {
         munmap(pfile->launch_string, pfile->length);
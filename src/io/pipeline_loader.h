@@ -49,6 +49,24 @@ int pipeline_file_load(PipelineFile *pfile, const char *filename);
  */
 GstPipeline* pipeline_create(const PipelineFile *pfile);
 
+/*
+ * Limit every queue element of the pipeline to max_ms of data
+ *
+ * The templates size their queues for 10 s to ride out stalls; this caps
+ * max-size-time and lifts the buffer and byte limits so time is the only
+ * bound. Returns the number of queues changed.
+ */
+int pipeline_limit_queues(GstPipeline *pipeline, int max_ms);
+
+/*
+ * Check whether two pipelines capture from the same device
+ *
+ * Compares the devices of their source elements: the "device" property
+ * (v4l2src, alsasrc, ...), or "sensor-id" / "device-number" (Argus and
+ * DeckLink sources). Returns 1 if a device is shared, 0 otherwise.
+ */
+int pipeline_shares_device(GstPipeline *a, GstPipeline *b);
+
 /*
  * Unload pipeline file
  */
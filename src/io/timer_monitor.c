@@ -0,0 +1,110 @@
+/*
+    ceracoder - live video encoder with dynamic bitrate control
+    Copyright (C) 2020 BELABOX project
+    Copyright (C) 2026 CERALIVE
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "timer_monitor.h"
+#include <stdio.h>
+#include <string.h>
+
+typedef struct {
+    TimerMonitor *mon;
+    TimerStats *stats;
+    GSourceFunc func;
+    gpointer data;
+} MonitoredTimer;
+
+static gboolean timer_dispatch(gpointer data) {
+    MonitoredTimer *timer = (MonitoredTimer *)data;
+
+    // A timeout source is rescheduled after its callback returns, so its
+    // ready time is still the time it was due
+    gint64 due = g_source_get_ready_time(g_main_current_source());
+    gint64 start = g_get_monotonic_time();
+    gboolean ret = timer->func(timer->data);
+    gint64 end = g_get_monotonic_time();
+
+    g_mutex_lock(&timer->mon->lock);
+    timer_stats_record(timer->stats, (start - due) / 1000.0, (end - start) / 1000.0);
+    g_mutex_unlock(&timer->mon->lock);
+
+    return ret;
+}
+
+void timer_monitor_init(TimerMonitor *mon, double warn_ms) {
+    memset(mon, 0, sizeof(*mon));
+    g_mutex_init(&mon->lock);
+    mon->warn_ms = warn_ms;
+}
+
+guint timer_monitor_add(TimerMonitor *mon, GMainContext *context, const char *name,
+                        guint interval_ms, gint priority, GSourceFunc func, gpointer data) {
+    g_mutex_lock(&mon->lock);
+    if (mon->n_timers >= TIMER_MONITOR_MAX) {
+        g_mutex_unlock(&mon->lock);
+        fprintf(stderr, "Too many monitored timers, not adding %s\n", name);
+        return 0;
+    }
+    TimerStats *stats = &mon->timers[mon->n_timers++];
+    timer_stats_init(stats, name, (int)interval_ms);
+    g_mutex_unlock(&mon->lock);
+
+    MonitoredTimer *timer = g_new0(MonitoredTimer, 1);
+    timer->mon = mon;
+    timer->stats = stats;
+    timer->func = func;
+    timer->data = data;
+
+    GSource *source = g_timeout_source_new(interval_ms);
+    g_source_set_priority(source, priority);
+    g_source_set_callback(source, timer_dispatch, timer, g_free);
+    guint id = g_source_attach(source, context);
+    g_source_unref(source);
+
+    return id;
+}
+
+void timer_monitor_update(TimerMonitor *mon, uint64_t now_ms, Stats *stats) {
+    g_mutex_lock(&mon->lock);
+
+    for (int i = 0; i < mon->n_timers; i++) {
+        timer_stats_publish(&mon->timers[i], stats);
+    }
+
+    if (mon->window_start == 0) {
+        mon->window_start = now_ms;
+    } else if (now_ms - mon->window_start >= TIMER_MONITOR_WINDOW_MS) {
+        mon->window_start = now_ms;
+        for (int i = 0; i < mon->n_timers; i++) {
+            TimerStats *ts = &mon->timers[i];
+            double lateness_p99, runtime_p99;
+            if (timer_stats_check(ts, mon->warn_ms, &lateness_p99, &runtime_p99) &&
+                mon->warn_ms > 0) {
+                fprintf(stderr, "Timer %s (every %d ms): p99 lateness %.1f ms, "
+                        "p99 runtime %.1f ms over the last %d s\n",
+                        ts->name, ts->interval_ms, lateness_p99, runtime_p99,
+                        TIMER_MONITOR_WINDOW_MS / 1000);
+            }
+        }
+    }
+
+    g_mutex_unlock(&mon->lock);
+}
+
+void timer_monitor_cleanup(TimerMonitor *mon) {
+    g_mutex_clear(&mon->lock);
+}
@@ -0,0 +1,75 @@
+/*
+    ceracoder - live video encoder with dynamic bitrate control
+    Copyright (C) 2020 BELABOX project
+    Copyright (C) 2026 CERALIVE
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef TIMER_MONITOR_H
+#define TIMER_MONITOR_H
+
+#include <stdint.h>
+#include <glib.h>
+
+#include "stats.h"
+#include "timer_stats.h"
+
+/*
+ * Timer monitor - instrumented GLib timeout sources
+ *
+ * timer_monitor_add() is g_timeout_add() on any main context, with each
+ * callback's lateness (fire time vs. the time it was due) and runtime
+ * recorded in TimerStats. timer_monitor_update(), called from the main
+ * loop, exports them and every TIMER_MONITOR_WINDOW_MS logs the timers
+ * whose p99 lateness or runtime exceeded the warning threshold.
+ *
+ * Timers may run on different threads; the stats are under one lock.
+ */
+
+#define TIMER_MONITOR_MAX        8
+#define TIMER_MONITOR_WINDOW_MS  10000
+
+typedef struct {
+    GMutex lock;
+    TimerStats timers[TIMER_MONITOR_MAX];
+    int n_timers;
+    double warn_ms;             // p99 warning threshold, 0 = no warnings
+    uint64_t window_start;      // ms
+} TimerMonitor;
+
+/*
+ * Initialize with the p99 warning threshold (ms, 0 disables the warnings)
+ */
+void timer_monitor_init(TimerMonitor *mon, double warn_ms);
+
+/*
+ * Call func every interval_ms on context (NULL: the default context)
+ *
+ * Returns the source id, or 0 if TIMER_MONITOR_MAX timers exist already.
+ */
+guint timer_monitor_add(TimerMonitor *mon, GMainContext *context, const char *name,
+                        guint interval_ms, gint priority, GSourceFunc func, gpointer data);
+
+/*
+ * Export the timer stats and check the p99 thresholds (main loop)
+ */
+void timer_monitor_update(TimerMonitor *mon, uint64_t now_ms, Stats *stats);
+
+/*
+ * Free the lock; the sources must have been removed
+ */
+void timer_monitor_cleanup(TimerMonitor *mon);
+
+#endif /* TIMER_MONITOR_H */
@@ -0,0 +1,69 @@
+/*
+    ceracoder - live video encoder with dynamic bitrate control
+    Copyright (C) 2020 BELABOX project
+    Copyright (C) 2026 CERALIVE
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "ts_cc.h"
+#include <string.h>
+
+#define TS_CC_UNKNOWN 0xff
+
+void ts_cc_init(TsCc *cc) {
+    memset(cc, 0, sizeof(*cc));
+    memset(cc->next, TS_CC_UNKNOWN, sizeof(cc->next));
+}
+
+void ts_cc_new_source(TsCc *cc) {
+    memset(cc->mapped, 0, sizeof(cc->mapped));
+    cc->restamp = 1;
+}
+
+void ts_cc_process(TsCc *cc, const TsIndex *idx, uint8_t *data) {
+    for (int i = 0; i < idx->count; i++) {
+        const TsPacketInfo *pkt = &idx->pkts[i];
+        if (pkt->flags & TS_PKT_SYNC_ERROR || pkt->pid == TS_INDEX_NULL_PID) continue;
+
+        int payload = (pkt->flags & TS_PKT_PAYLOAD) != 0;
+        uint8_t out = pkt->cc;
+        if (cc->restamp) {
+            // First packet of this PID from the new source: continue from the last one
+            // sent. The counter only advances on packets with a payload
+            if (!cc->mapped[pkt->pid]) {
+                uint8_t want = cc->next[pkt->pid];
+                if (want == TS_CC_UNKNOWN) {
+                    want = pkt->cc;
+                } else if (!payload) {
+                    want = (want - 1) & 0x0f;
+                }
+                cc->delta[pkt->pid] = (want - pkt->cc) & 0x0f;
+                cc->mapped[pkt->pid] = 1;
+            }
+            out = (pkt->cc + cc->delta[pkt->pid]) & 0x0f;
+            if (out != pkt->cc) {
+                uint8_t *p = data + i * TS_INDEX_PKT_SIZE;
+                p[3] = (p[3] & 0xf0) | out;
+                cc->restamped++;
+            }
+        }
+
+        if (payload) {
+            cc->next[pkt->pid] = (out + 1) & 0x0f;
+        } else if (cc->next[pkt->pid] == TS_CC_UNKNOWN) {
+            cc->next[pkt->pid] = out;
+        }
+    }
+}
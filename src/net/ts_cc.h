@@ -0,0 +1,65 @@
+/*
+    ceracoder - live video encoder with dynamic bitrate control
+    Copyright (C) 2020 BELABOX project
+    Copyright (C) 2026 CERALIVE
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef TS_CC_H
+#define TS_CC_H
+
+#include <stdint.h>
+#include "ts_index.h"
+
+/*
+ * MPEG-TS continuity counter restamping
+ *
+ * When the muxer feeding the SRT connection is replaced (a pipeline
+ * hot-swap), the new one starts its continuity counters from scratch and
+ * receivers would see a discontinuity on every PID. This keeps the
+ * counters of the stream going out: the counters of the outgoing packets
+ * are tracked, and after ts_cc_new_source() each PID's counters are offset
+ * so they carry on from the last one sent.
+ */
+
+#define TS_CC_PIDS 8192
+
+typedef struct {
+    uint8_t next[TS_CC_PIDS];     // Next counter sent per PID, 0xff = not seen yet
+    uint8_t delta[TS_CC_PIDS];    // Offset added to the source's counters
+    uint8_t mapped[TS_CC_PIDS];   // Offset known for the current source
+    int restamp;                  // Counters are being rewritten (after a source change)
+    uint64_t restamped;           // Packets rewritten
+} TsCc;
+
+/*
+ * Initialize with no PIDs seen
+ */
+void ts_cc_init(TsCc *cc);
+
+/*
+ * The next packets come from a new muxer
+ */
+void ts_cc_new_source(TsCc *cc);
+
+/*
+ * Track (and, after a source change, rewrite) the counters of the packets
+ * in idx, built from data
+ *
+ * data may be NULL while cc->restamp is 0; it must be writable otherwise.
+ */
+void ts_cc_process(TsCc *cc, const TsIndex *idx, uint8_t *data);
+
+#endif /* TS_CC_H */
@@ -0,0 +1,217 @@
+/*
+    ceracoder - live video encoder with dynamic bitrate control
+    Copyright (C) 2020 BELABOX project
+    Copyright (C) 2026 CERALIVE
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "ts_index.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define TS_SYNC_BYTE 0x47
+
+// The vector decoders treat a packed TsPacketInfo as a little-endian 32-bit lane
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define TS_INDEX_SSE2
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define TS_INDEX_NEON
+#endif
+#endif
+
+_Static_assert(sizeof(TsPacketInfo) == 4, "TsPacketInfo must pack into 32 bits");
+
+/*
+ * Lane layout, shared by all decoders
+ *
+ * in:  h = packet bytes 0-3, a = bytes 4-7 (adaptation_field_length, flags, ...)
+ * out: pid in bits 0-15, flags in bits 16-23, cc in bits 24-27
+ */
+#define LANE_FLAG(f) ((uint32_t)(f) << 16)
+
+static inline uint32_t decode_scalar(const uint8_t *p) {
+    if (p[0] != TS_SYNC_BYTE) return LANE_FLAG(TS_PKT_SYNC_ERROR);
+
+    uint32_t pid = ((p[1] & 0x1f) << 8) | p[2];
+    uint32_t flags = 0;
+    if (p[1] & 0x40) flags |= TS_PKT_PUSI;
+    if (p[1] & 0x80) flags |= TS_PKT_TEI;
+    if (p[3] & 0x10) flags |= TS_PKT_PAYLOAD;
+    if (p[3] & 0x20) {
+        flags |= TS_PKT_ADAPTATION;
+        // An empty adaptation field has no flags byte
+        if (p[4] > 0) {
+            if (p[5] & 0x10) flags |= TS_PKT_PCR;
+            if (p[5] & 0x40) flags |= TS_PKT_RAI;
+            if (p[5] & 0x80) flags |= TS_PKT_DISCONT;
+        }
+    }
+    return pid | (flags << 16) | ((uint32_t)(p[3] & 0x0f) << 24);
+}
+
+#if defined(TS_INDEX_SSE2)
+// Returns the header words of four packets: h = bytes 0-3, a = bytes 4-7
+static inline void gather4(const uint8_t *p, __m128i *h, __m128i *a) {
+    __m128i p01 = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i *)p),
+                                     _mm_loadl_epi64((const __m128i *)(p + TS_INDEX_PKT_SIZE)));
+    __m128i p23 = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i *)(p + 2 * TS_INDEX_PKT_SIZE)),
+                                     _mm_loadl_epi64((const __m128i *)(p + 3 * TS_INDEX_PKT_SIZE)));
+    *h = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(p01), _mm_castsi128_ps(p23),
+                                         _MM_SHUFFLE(2, 0, 2, 0)));
+    *a = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(p01), _mm_castsi128_ps(p23),
+                                         _MM_SHUFFLE(3, 1, 3, 1)));
+}
+
+// Decodes four packets, returns the number of sync errors among them
+static int decode4(const uint8_t *p, TsPacketInfo *out) {
+    __m128i h, a;
+    gather4(p, &h, &a);
+    __m128i zero = _mm_setzero_si128();
+
+    __m128i v = _mm_or_si128(_mm_and_si128(h, _mm_set1_epi32(0x1f00)),
+                             _mm_and_si128(_mm_srli_epi32(h, 16), _mm_set1_epi32(0xff)));
+    v = _mm_or_si128(v, _mm_and_si128(_mm_slli_epi32(h, 2), _mm_set1_epi32(LANE_FLAG(TS_PKT_PUSI))));
+    v = _mm_or_si128(v, _mm_and_si128(_mm_slli_epi32(h, 4), _mm_set1_epi32(LANE_FLAG(TS_PKT_TEI))));
+    v = _mm_or_si128(v, _mm_and_si128(_mm_srli_epi32(h, 12), _mm_set1_epi32(LANE_FLAG(TS_PKT_ADAPTATION))));
+    v = _mm_or_si128(v, _mm_and_si128(_mm_srli_epi32(h, 10), _mm_set1_epi32(LANE_FLAG(TS_PKT_PAYLOAD))));
+    v = _mm_or_si128(v, _mm_and_si128(h, _mm_set1_epi32(0x0f000000)));
+
+    // Adaptation field flags, where there is a non-empty adaptation field
+    __m128i af = _mm_or_si128(
+        _mm_and_si128(_mm_slli_epi32(a, 8), _mm_set1_epi32(LANE_FLAG(TS_PKT_PCR))),
+        _mm_and_si128(_mm_slli_epi32(a, 7), _mm_set1_epi32(LANE_FLAG(TS_PKT_RAI | TS_PKT_DISCONT))));
+    __m128i no_af = _mm_or_si128(
+        _mm_cmpeq_epi32(_mm_and_si128(h, _mm_set1_epi32(0x20000000)), zero),
+        _mm_cmpeq_epi32(_mm_and_si128(a, _mm_set1_epi32(0xff)), zero));
+    v = _mm_or_si128(v, _mm_andnot_si128(no_af, af));
+
+    __m128i sync = _mm_cmpeq_epi32(_mm_and_si128(h, _mm_set1_epi32(0xff)),
+                                   _mm_set1_epi32(TS_SYNC_BYTE));
+    v = _mm_or_si128(_mm_and_si128(sync, v),
+                     _mm_andnot_si128(sync, _mm_set1_epi32(LANE_FLAG(TS_PKT_SYNC_ERROR))));
+
+    _mm_storeu_si128((__m128i *)out, v);
+    return 4 - __builtin_popcount(_mm_movemask_ps(_mm_castsi128_ps(sync)));
+}
+#elif defined(TS_INDEX_NEON)
+// Returns the header words of four packets: h = bytes 0-3, a = bytes 4-7
+static inline void gather4(const uint8_t *p, uint32x4_t *h, uint32x4_t *a) {
+    uint32x4_t p01 = vcombine_u32(vreinterpret_u32_u8(vld1_u8(p)),
+                                  vreinterpret_u32_u8(vld1_u8(p + TS_INDEX_PKT_SIZE)));
+    uint32x4_t p23 = vcombine_u32(vreinterpret_u32_u8(vld1_u8(p + 2 * TS_INDEX_PKT_SIZE)),
+                                  vreinterpret_u32_u8(vld1_u8(p + 3 * TS_INDEX_PKT_SIZE)));
+    uint32x4x2_t u = vuzpq_u32(p01, p23);
+    *h = u.val[0];
+    *a = u.val[1];
+}
+
+// Decodes four packets, returns the number of sync errors among them
+static int decode4(const uint8_t *p, TsPacketInfo *out) {
+    uint32x4_t h, a;
+    gather4(p, &h, &a);
+
+    uint32x4_t v = vorrq_u32(vandq_u32(h, vdupq_n_u32(0x1f00)),
+                             vandq_u32(vshrq_n_u32(h, 16), vdupq_n_u32(0xff)));
+    v = vorrq_u32(v, vandq_u32(vshlq_n_u32(h, 2), vdupq_n_u32(LANE_FLAG(TS_PKT_PUSI))));
+    v = vorrq_u32(v, vandq_u32(vshlq_n_u32(h, 4), vdupq_n_u32(LANE_FLAG(TS_PKT_TEI))));
+    v = vorrq_u32(v, vandq_u32(vshrq_n_u32(h, 12), vdupq_n_u32(LANE_FLAG(TS_PKT_ADAPTATION))));
+    v = vorrq_u32(v, vandq_u32(vshrq_n_u32(h, 10), vdupq_n_u32(LANE_FLAG(TS_PKT_PAYLOAD))));
+    v = vorrq_u32(v, vandq_u32(h, vdupq_n_u32(0x0f000000)));
+
+    // Adaptation field flags, where there is a non-empty adaptation field
+    uint32x4_t af = vorrq_u32(
+        vandq_u32(vshlq_n_u32(a, 8), vdupq_n_u32(LANE_FLAG(TS_PKT_PCR))),
+        vandq_u32(vshlq_n_u32(a, 7), vdupq_n_u32(LANE_FLAG(TS_PKT_RAI | TS_PKT_DISCONT))));
+    uint32x4_t has_af = vandq_u32(vtstq_u32(h, vdupq_n_u32(0x20000000)),
+                                  vtstq_u32(a, vdupq_n_u32(0xff)));
+    v = vorrq_u32(v, vandq_u32(has_af, af));
+
+    uint32x4_t sync = vceqq_u32(vandq_u32(h, vdupq_n_u32(0xff)), vdupq_n_u32(TS_SYNC_BYTE));
+    v = vbslq_u32(sync, v, vdupq_n_u32(LANE_FLAG(TS_PKT_SYNC_ERROR)));
+
+    vst1q_u32((uint32_t *)out, v);
+    uint32x4_t bad = vandq_u32(vmvnq_u32(sync), vdupq_n_u32(1));
+    uint32x2_t sum = vadd_u32(vget_low_u32(bad), vget_high_u32(bad));
+    return (int)vget_lane_u32(vpadd_u32(sum, sum), 0);
+}
+#endif
+
+static int index_reserve(TsIndex *idx, int n) {
+    if (n <= idx->capacity) return 0;
+
+    int cap = idx->capacity > 0 ? idx->capacity : 64;
+    while (cap < n) cap *= 2;
+    TsPacketInfo *pkts = realloc(idx->pkts, (size_t)cap * sizeof(*pkts));
+    if (pkts == NULL) return -1;
+    idx->pkts = pkts;
+    idx->capacity = cap;
+    return 0;
+}
+
+static int index_build(TsIndex *idx, const uint8_t *data, int len, int vector) {
+    int n = len > 0 ? len / TS_INDEX_PKT_SIZE : 0;
+    idx->count = 0;
+    idx->sync_errors = 0;
+    idx->tail = len > 0 ? len - n * TS_INDEX_PKT_SIZE : 0;
+    if (index_reserve(idx, n) != 0) return -1;
+
+    int i = 0;
+#if defined(TS_INDEX_SSE2) || defined(TS_INDEX_NEON)
+    if (vector) {
+        for (; i + 4 <= n; i += 4) {
+            idx->sync_errors += decode4(data + i * TS_INDEX_PKT_SIZE, idx->pkts + i);
+        }
+    }
+#else
+    (void)vector;
+#endif
+    for (; i < n; i++) {
+        uint32_t lane = decode_scalar(data + i * TS_INDEX_PKT_SIZE);
+        memcpy(idx->pkts + i, &lane, sizeof(lane));
+        idx->sync_errors += lane == LANE_FLAG(TS_PKT_SYNC_ERROR);
+    }
+    idx->count = n;
+    return n;
+}
+
+void ts_index_init(TsIndex *idx) {
+    memset(idx, 0, sizeof(*idx));
+}
+
+int ts_index_build(TsIndex *idx, const uint8_t *data, int len) {
+    return index_build(idx, data, len, 1);
+}
+
+int ts_index_build_scalar(TsIndex *idx, const uint8_t *data, int len) {
+    return index_build(idx, data, len, 0);
+}
+
+const char *ts_index_impl(void) {
+#if defined(TS_INDEX_SSE2)
+    return "sse2";
+#elif defined(TS_INDEX_NEON)
+    return "neon";
+#else
+    return "scalar";
+#endif
+}
+
+void ts_index_cleanup(TsIndex *idx) {
+    free(idx->pkts);
+    memset(idx, 0, sizeof(*idx));
+}
@@ -0,0 +1,99 @@
+/*
+    ceracoder - live video encoder with dynamic bitrate control
+    Copyright (C) 2020 BELABOX project
+    Copyright (C) 2026 CERALIVE
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef TS_INDEX_H
+#define TS_INDEX_H
+
+#include <stdint.h>
+
+/*
+ * MPEG-TS packet indexer
+ *
+ * One pass over a buffer of TS packets validates the sync bytes and
+ * extracts the header fields of every packet into a compact array, so
+ * TS-aware stages (stats, null packet handling, PCR / continuity checks)
+ * look at the index instead of re-parsing the packet headers each.
+ *
+ * Headers of four packets are decoded at a time with SSE2 or NEON when
+ * the target has them, with a scalar fallback that gives identical
+ * results.
+ */
+
+#define TS_INDEX_PKT_SIZE  188
+#define TS_INDEX_NULL_PID  0x1fff
+
+// TsPacketInfo.flags
+#define TS_PKT_PUSI        0x01  // payload_unit_start_indicator
+#define TS_PKT_ADAPTATION  0x02  // adaptation field present
+#define TS_PKT_PAYLOAD     0x04  // payload present
+#define TS_PKT_TEI         0x08  // transport_error_indicator
+#define TS_PKT_PCR         0x10  // adaptation field carries a PCR
+#define TS_PKT_RAI         0x20  // random_access_indicator
+#define TS_PKT_DISCONT     0x40  // discontinuity_indicator
+#define TS_PKT_SYNC_ERROR  0x80  // sync byte is not 0x47, other fields are garbage
+
+/*
+ * One indexed packet, 4 bytes. Packet i starts at data + i * TS_INDEX_PKT_SIZE
+ */
+typedef struct {
+    uint16_t pid;
+    uint8_t flags;
+    uint8_t cc;           // continuity_counter
+} TsPacketInfo;
+
+/*
+ * Reusable index - the entry array only grows, so a long-lived index
+ * stops allocating once it has seen the largest buffer
+ */
+typedef struct {
+    TsPacketInfo *pkts;
+    int count;            // Packets indexed by the last build
+    int capacity;
+    int sync_errors;      // Packets with a bad sync byte in the last build
+    int tail;             // Trailing bytes that don't make a whole packet
+} TsIndex;
+
+/*
+ * Initialize an empty index
+ */
+void ts_index_init(TsIndex *idx);
+
+/*
+ * Index all whole packets in data
+ *
+ * Returns the number of packets indexed, or -1 on allocation failure.
+ */
+int ts_index_build(TsIndex *idx, const uint8_t *data, int len);
+
+/*
+ * Same, always using the scalar decoder (for tests and benchmarks)
+ */
+int ts_index_build_scalar(TsIndex *idx, const uint8_t *data, int len);
+
+/*
+ * Name of the decoder used by ts_index_build ("sse2", "neon" or "scalar")
+ */
+const char *ts_index_impl(void);
+
+/*
+ * Free the entry array
+ */
+void ts_index_cleanup(TsIndex *idx);
+
+#endif /* TS_INDEX_H */
@@ -0,0 +1,468 @@
+/*
+    ceracoder - live video encoder with dynamic bitrate control
+    Copyright (C) 2020 BELABOX project
+    Copyright (C) 2026 CERALIVE
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "ts_mux.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define TS_SYNC_BYTE        0x47
+#define TS_PAYLOAD_SIZE     (TS_PKT_SIZE - 4)
+#define TS_PAT_PID          0x0000
+#define TS_PROGRAM_NUMBER   1
+#define TS_33BIT_MASK       ((1LL << 33) - 1)
+
+// MPEG-2 stream types
+#define STREAM_TYPE_H264    0x1b
+#define STREAM_TYPE_H265    0x24
+#define STREAM_TYPE_AAC     0x0f    // ADTS
+#define STREAM_TYPE_PRIVATE 0x06    // Opus (with registration descriptor)
+
+// PES stream ids
+#define STREAM_ID_VIDEO     0xe0
+#define STREAM_ID_AUDIO     0xc0
+#define STREAM_ID_PRIVATE_1 0xbd
+
+// Access unit delimiters, prepended when the encoder didn't emit one
+static const uint8_t h264_aud[] = {0x00, 0x00, 0x00, 0x01, 0x09, 0xf0};
+static const uint8_t h265_aud[] = {0x00, 0x00, 0x00, 0x01, 0x46, 0x01, 0x50};
+
+static int codec_is_video(TsMuxCodec codec) {
+    return codec == TS_CODEC_H264 || codec == TS_CODEC_H265;
+}
+
+static uint8_t codec_stream_type(TsMuxCodec codec) {
+    switch (codec) {
+        case TS_CODEC_H264: return STREAM_TYPE_H264;
+        case TS_CODEC_H265: return STREAM_TYPE_H265;
+        case TS_CODEC_AAC:  return STREAM_TYPE_AAC;
+        case TS_CODEC_OPUS: return STREAM_TYPE_PRIVATE;
+    }
+    return STREAM_TYPE_PRIVATE;
+}
+
+/*
+ * CRC-32/MPEG-2 (poly 0x04c11db7, no reflection, no final xor)
+ */
+static uint32_t crc32_mpeg2(const uint8_t *data, int len) {
+    uint32_t crc = 0xffffffff;
+    for (int i = 0; i < len; i++) {
+        crc ^= (uint32_t)data[i] << 24;
+        for (int b = 0; b < 8; b++) {
+            crc = (crc & 0x80000000) ? (crc << 1) ^ 0x04c11db7 : (crc << 1);
+        }
+    }
+    return crc;
+}
+
+/*
+ * Payload slot handling
+ */
+static int payload_send(TsMux *mux) {
+    if (mux->payload_len == 0) {
+        return 0;
+    }
+    int ret = mux->output(mux->payload, mux->payload_len, mux->user_data);
+    mux->payload_len = 0;
+    mux->payloads++;
+    return (ret < 0) ? -1 : 0;
+}
+
+// Returns the next free TS packet in the payload slot
+static uint8_t *next_packet(TsMux *mux) {
+    uint8_t *pkt = mux->payload + mux->payload_len;
+    mux->payload_len += TS_PKT_SIZE;
+    return pkt;
+}
+
+// Sends the payload once the last packet slot has been filled
+static int packet_done(TsMux *mux) {
+    if (mux->payload_len >= mux->payload_size) {
+        return payload_send(mux);
+    }
+    return 0;
+}
+
+static void write_ts_header(uint8_t *pkt, uint16_t pid, int pusi, int has_af, uint8_t cc) {
+    pkt[0] = TS_SYNC_BYTE;
+    pkt[1] = (pusi ? 0x40 : 0x00) | ((pid >> 8) & 0x1f);
+    pkt[2] = pid & 0xff;
+    pkt[3] = (has_af ? 0x30 : 0x10) | (cc & 0x0f);
+}
+
+static void write_pcr(uint8_t *p, int64_t pcr) {
+    uint64_t base = (uint64_t)pcr & TS_33BIT_MASK;
+    p[0] = (base >> 25) & 0xff;
+    p[1] = (base >> 17) & 0xff;
+    p[2] = (base >> 9) & 0xff;
+    p[3] = (base >> 1) & 0xff;
+    p[4] = ((base & 1) << 7) | 0x7e;  // 6 reserved bits, extension MSB = 0
+    p[5] = 0x00;
+}
+
+static int write_pes_timestamp(uint8_t *p, uint8_t prefix, int64_t ts) {
+    uint64_t v = (uint64_t)ts & TS_33BIT_MASK;
+    p[0] = (prefix << 4) | (((v >> 30) & 0x07) << 1) | 1;
+    p[1] = (v >> 22) & 0xff;
+    p[2] = (((v >> 15) & 0x7f) << 1) | 1;
+    p[3] = (v >> 7) & 0xff;
+    p[4] = ((v & 0x7f) << 1) | 1;
+    return 5;
+}
+
+/*
+ * PSI (PAT / PMT)
+ */
+static int write_section(TsMux *mux, uint16_t pid, uint8_t *cc,
+                         const uint8_t *section, int len) {
+    uint8_t *pkt = next_packet(mux);
+    write_ts_header(pkt, pid, 1, 0, *cc);
+    *cc = (*cc + 1) & 0x0f;
+    pkt[4] = 0x00;  // pointer_field
+    memcpy(pkt + 5, section, len);
+    memset(pkt + 5 + len, 0xff, TS_PKT_SIZE - 5 - len);
+    return packet_done(mux);
+}
+
+static int finish_section(uint8_t *sec, int len) {
+    // section_length covers everything after the length field, including the CRC
+    int section_length = len - 3 + 4;
+    sec[1] = 0xb0 | ((section_length >> 8) & 0x0f);
+    sec[2] = section_length & 0xff;
+    uint32_t crc = crc32_mpeg2(sec, len);
+    sec[len++] = (crc >> 24) & 0xff;
+    sec[len++] = (crc >> 16) & 0xff;
+    sec[len++] = (crc >> 8) & 0xff;
+    sec[len++] = crc & 0xff;
+    return len;
+}
+
+static int write_psi(TsMux *mux) {
+    uint8_t sec[TS_PKT_SIZE];
+    int len = 0;
+
+    // PAT
+    sec[len++] = 0x00;                       // table_id
+    len += 2;                                // section_length (filled in later)
+    sec[len++] = 0x00; sec[len++] = 0x01;    // transport_stream_id
+    sec[len++] = 0xc1;                       // version 0, current_next
+    sec[len++] = 0x00;                       // section_number
+    sec[len++] = 0x00;                       // last_section_number
+    sec[len++] = (TS_PROGRAM_NUMBER >> 8) & 0xff;
+    sec[len++] = TS_PROGRAM_NUMBER & 0xff;
+    sec[len++] = 0xe0 | ((TS_MUX_PMT_PID >> 8) & 0x1f);
+    sec[len++] = TS_MUX_PMT_PID & 0xff;
+    len = finish_section(sec, len);
+    if (write_section(mux, TS_PAT_PID, &mux->pat_cc, sec, len) != 0) {
+        return -1;
+    }
+
+    // PMT
+    uint16_t pcr_pid = mux->streams[mux->pcr_stream].pid;
+    len = 0;
+    sec[len++] = 0x02;                       // table_id
+    len += 2;
+    sec[len++] = (TS_PROGRAM_NUMBER >> 8) & 0xff;
+    sec[len++] = TS_PROGRAM_NUMBER & 0xff;
+    sec[len++] = 0xc1 | ((mux->pmt_version & 0x1f) << 1);
+    sec[len++] = 0x00;
+    sec[len++] = 0x00;
+    sec[len++] = 0xe0 | ((pcr_pid >> 8) & 0x1f);
+    sec[len++] = pcr_pid & 0xff;
+    sec[len++] = 0xf0;                       // program_info_length = 0
+    sec[len++] = 0x00;
+
+    for (int i = 0; i < mux->n_streams; i++) {
+        TsMuxStream *s = &mux->streams[i];
+        sec[len++] = codec_stream_type(s->codec);
+        sec[len++] = 0xe0 | ((s->pid >> 8) & 0x1f);
+        sec[len++] = s->pid & 0xff;
+
+        if (s->codec == TS_CODEC_OPUS) {
+            // registration_descriptor("Opus") + extension descriptor (channel config)
+            static const uint8_t opus_reg[] = {0x05, 0x04, 'O', 'p', 'u', 's'};
+            sec[len++] = 0xf0;
+            sec[len++] = sizeof(opus_reg) + 4;
+            memcpy(sec + len, opus_reg, sizeof(opus_reg));
+            len += sizeof(opus_reg);
+            sec[len++] = 0x7f;
+            sec[len++] = 0x02;
+            sec[len++] = 0x80;
+            sec[len++] = (uint8_t)s->channels;
+        } else {
+            sec[len++] = 0xf0;
+            sec[len++] = 0x00;
+        }
+    }
+    len = finish_section(sec, len);
+    if (write_section(mux, TS_MUX_PMT_PID, &mux->pmt_cc, sec, len) != 0) {
+        return -1;
+    }
+
+    mux->psi_count++;
+    return 0;
+}
+
+/*
+ * PES packetization
+ */
+typedef struct {
+    const uint8_t *ptr[3];
+    int len[3];
+    int seg;
+} PesSource;
+
+static void pes_copy(PesSource *src, uint8_t *dst, int n) {
+    while (n > 0) {
+        if (src->len[src->seg] == 0) {
+            src->seg++;
+            continue;
+        }
+        int chunk = (n < src->len[src->seg]) ? n : src->len[src->seg];
+        memcpy(dst, src->ptr[src->seg], chunk);
+        dst += chunk;
+        src->ptr[src->seg] += chunk;
+        src->len[src->seg] -= chunk;
+        n -= chunk;
+    }
+}
+
+static int has_aud(TsMuxCodec codec, const uint8_t *data, int len) {
+    int off;
+    if (len >= 4 && data[0] == 0 && data[1] == 0 && data[2] == 0 && data[3] == 1) {
+        off = 4;
+    } else if (len >= 3 && data[0] == 0 && data[1] == 0 && data[2] == 1) {
+        off = 3;
+    } else {
+        return 0;
+    }
+    if (off >= len) return 0;
+    if (codec == TS_CODEC_H264) {
+        return (data[off] & 0x1f) == 9;
+    }
+    return ((data[off] >> 1) & 0x3f) == 35;
+}
+
+int ts_mux_init(TsMux *mux, int payload_size, TsMuxOutputFunc output, void *user_data) {
+    memset(mux, 0, sizeof(*mux));
+
+    payload_size = payload_size / TS_PKT_SIZE * TS_PKT_SIZE;
+    if (payload_size <= 0 || output == NULL) {
+        return -1;
+    }
+
+    mux->payload = malloc(payload_size);
+    if (mux->payload == NULL) {
+        return -1;
+    }
+    mux->payload_size = payload_size;
+    mux->output = output;
+    mux->user_data = user_data;
+    mux->pcr_stream = -1;
+    mux->psi_pending = 1;
+
+    return 0;
+}
+
+int ts_mux_add_stream(TsMux *mux, TsMuxCodec codec) {
+    if (mux->n_streams >= TS_MUX_MAX_STREAMS) {
+        return -1;
+    }
+
+    int idx = mux->n_streams++;
+    TsMuxStream *s = &mux->streams[idx];
+    memset(s, 0, sizeof(*s));
+    s->pid = TS_MUX_FIRST_ES_PID + idx;
+    s->codec = codec;
+    s->channels = 2;
+    s->last_dts = -1;
+
+    if (codec_is_video(codec)) {
+        s->stream_id = STREAM_ID_VIDEO + idx;
+    } else if (codec == TS_CODEC_AAC) {
+        s->stream_id = STREAM_ID_AUDIO + idx;
+    } else {
+        s->stream_id = STREAM_ID_PRIVATE_1;
+    }
+
+    // The first video stream carries the PCR
+    if (mux->pcr_stream < 0 ||
+        (codec_is_video(codec) && !codec_is_video(mux->streams[mux->pcr_stream].codec))) {
+        mux->pcr_stream = idx;
+    }
+
+    // Announce the new layout
+    if (mux->psi_count > 0) {
+        mux->pmt_version = (mux->pmt_version + 1) & 0x1f;
+    }
+    mux->psi_pending = 1;
+
+    return idx;
+}
+
+int ts_mux_write_frame(TsMux *mux, int stream, const uint8_t *data, int len,
+                       int64_t pts, int64_t dts, int keyframe) {
+    if (stream < 0 || stream >= mux->n_streams || len <= 0) {
+        return -1;
+    }
+    TsMuxStream *s = &mux->streams[stream];
+    int is_pcr = (stream == mux->pcr_stream);
+    // Audio frames are all flagged as keyframes; only video ones are random
+    // access points
+    int random_access = keyframe && codec_is_video(s->codec);
+
+    if (dts < 0) dts = pts;
+    pts += TS_MUX_TS_OFFSET;
+    dts += TS_MUX_TS_OFFSET;
+
+    // PAT/PMT ahead of random access points and periodically
+    if (mux->psi_pending || (is_pcr && random_access) ||
+        (is_pcr && dts - mux->last_psi >= TS_MUX_PSI_INTERVAL)) {
+        if (write_psi(mux) != 0) {
+            return -1;
+        }
+        mux->psi_pending = 0;
+        mux->last_psi = dts;
+    }
+
+    // Codec specific prefix: AUD for video, control header for Opus, whose
+    // au_size takes one 0xff byte per 255 bytes of the frame
+    int prefix_size = s->codec == TS_CODEC_OPUS ? 3 + len / 255 : (int)sizeof(h265_aud);
+    uint8_t prefix[prefix_size];
+    int prefix_len = 0;
+    if (s->codec == TS_CODEC_H264 && !has_aud(s->codec, data, len)) {
+        memcpy(prefix, h264_aud, sizeof(h264_aud));
+        prefix_len = sizeof(h264_aud);
+    } else if (s->codec == TS_CODEC_H265 && !has_aud(s->codec, data, len)) {
+        memcpy(prefix, h265_aud, sizeof(h265_aud));
+        prefix_len = sizeof(h265_aud);
+    } else if (s->codec == TS_CODEC_OPUS) {
+        prefix[prefix_len++] = 0x7f;
+        prefix[prefix_len++] = 0xe0;
+        int au_size = len;
+        while (au_size >= 255) {
+            prefix[prefix_len++] = 0xff;
+            au_size -= 255;
+        }
+        prefix[prefix_len++] = (uint8_t)au_size;
+    }
+
+    // PES header
+    uint8_t hdr[19];
+    int hdr_len = 0;
+    int with_dts = codec_is_video(s->codec) && dts != pts;
+    hdr[hdr_len++] = 0x00;
+    hdr[hdr_len++] = 0x00;
+    hdr[hdr_len++] = 0x01;
+    hdr[hdr_len++] = s->stream_id;
+    int pes_len = 3 + (with_dts ? 10 : 5) + prefix_len + len;
+    if (codec_is_video(s->codec) || pes_len > 0xffff) {
+        pes_len = 0;  // unbounded
+    }
+    hdr[hdr_len++] = (pes_len >> 8) & 0xff;
+    hdr[hdr_len++] = pes_len & 0xff;
+    hdr[hdr_len++] = 0x84;  // marker bits, data_alignment_indicator
+    hdr[hdr_len++] = with_dts ? 0xc0 : 0x80;
+    hdr[hdr_len++] = with_dts ? 10 : 5;
+    hdr_len += write_pes_timestamp(hdr + hdr_len, with_dts ? 0x3 : 0x2, pts);
+    if (with_dts) {
+        hdr_len += write_pes_timestamp(hdr + hdr_len, 0x1, dts);
+    }
+
+    PesSource src = {
+        .ptr = {hdr, prefix, data},
+        .len = {hdr_len, prefix_len, len},
+        .seg = 0,
+    };
+    int remaining = hdr_len + prefix_len + len;
+    int first = 1;
+
+    while (remaining > 0) {
+        uint8_t *pkt = next_packet(mux);
+
+        // Adaptation field: PCR / random access flag on the first packet
+        int with_pcr = first && is_pcr;
+        int af_len = 0;  // total adaptation field size, including the length byte
+        if (with_pcr) {
+            af_len = 8;
+        } else if (first && random_access) {
+            af_len = 2;
+        }
+        int space = TS_PAYLOAD_SIZE - af_len;
+        int stuffing = 0;
+        if (remaining < space) {
+            stuffing = space - remaining;
+            if (af_len == 0 && stuffing == 1) {
+                af_len = 1;       // length byte only
+                stuffing = 0;
+            } else if (af_len == 0) {
+                af_len = 2;       // length + flags
+                stuffing -= 2;
+            }
+            space = remaining;
+        }
+
+        write_ts_header(pkt, s->pid, first, af_len > 0, s->cc);
+        s->cc = (s->cc + 1) & 0x0f;
+
+        uint8_t *p = pkt + 4;
+        if (af_len > 0) {
+            p[0] = (uint8_t)(af_len - 1 + stuffing);
+            if (af_len > 1) {
+                p[1] = 0x00;
+                if (first && random_access) p[1] |= 0x40;  // random_access_indicator
+                if (with_pcr) {
+                    p[1] |= 0x10;
+                    write_pcr(p + 2, dts - TS_MUX_PCR_DELAY);
+                    mux->pcr_count++;
+                }
+            }
+            p += af_len;
+            memset(p, 0xff, stuffing);
+            p += stuffing;
+            mux->stuffing_bytes += stuffing;
+        }
+
+        pes_copy(&src, p, space);
+        remaining -= space;
+        first = 0;
+        s->packets++;
+
+        if (packet_done(mux) != 0) {
+            return -1;
+        }
+    }
+
+    s->frames++;
+    s->bytes += len;
+    s->last_dts = dts - TS_MUX_TS_OFFSET;
+    if (random_access) s->keyframes++;
+
+    return 0;
+}
+
+int ts_mux_flush(TsMux *mux) {
+    return payload_send(mux);
+}
+
+void ts_mux_cleanup(TsMux *mux) {
+    free(mux->payload);
+    mux->payload = NULL;
+    mux->payload_size = 0;
+    mux->payload_len = 0;
+}
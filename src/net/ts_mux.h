@@ -0,0 +1,150 @@
+/*
+    ceracoder - live video encoder with dynamic bitrate control
+    Copyright (C) 2020 BELABOX project
+    Copyright (C) 2026 CERALIVE
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef TS_MUX_H
+#define TS_MUX_H
+
+#include <stdint.h>
+
+/*
+ * Minimal MPEG-TS muxer - writes TS packets straight into SRT payloads
+ *
+ * This is an optional replacement for mpegtsmux + appsink. Elementary
+ * stream frames are packetized into PES/TS and written directly into a
+ * pre-allocated payload buffer; a full payload is handed to the output
+ * callback (normally srt_client_send). It handles PAT/PMT and PCR itself
+ * and keeps per-PID counters.
+ *
+ * Supported codecs: H.264 / H.265 (byte-stream, AU aligned),
+ * AAC (ADTS) and Opus.
+ *
+ * Not thread-safe: the caller must serialize access when frames arrive
+ * from several streaming threads.
+ */
+
+#define TS_PKT_SIZE         188
+#define TS_MUX_MAX_STREAMS  4
+
+// PIDs used by the muxer
+#define TS_MUX_PMT_PID      0x1000
+#define TS_MUX_FIRST_ES_PID 0x100
+
+// Timing (90 kHz units)
+#define TS_MUX_TS_OFFSET    90000   // added to all timestamps to keep them positive
+#define TS_MUX_PCR_DELAY    18000   // PCR runs 200 ms behind the PCR stream's DTS
+#define TS_MUX_PSI_INTERVAL 9000    // PAT/PMT at least every 100 ms
+
+typedef enum {
+    TS_CODEC_H264,
+    TS_CODEC_H265,
+    TS_CODEC_AAC,
+    TS_CODEC_OPUS,
+} TsMuxCodec;
+
+/*
+ * Output callback - called with a full payload (or a partial one on flush)
+ *
+ * Returns the number of bytes sent, or < 0 on error.
+ */
+typedef int (*TsMuxOutputFunc)(const uint8_t *data, int len, void *user_data);
+
+/*
+ * Per-PID state and counters
+ */
+typedef struct {
+    uint16_t pid;
+    TsMuxCodec codec;
+    uint8_t stream_id;    // PES stream_id
+    uint8_t cc;           // Next continuity counter
+    int channels;         // Opus channel count
+
+    uint64_t frames;      // Access units written
+    uint64_t keyframes;   // Random access points written
+    uint64_t packets;     // TS packets written
+    uint64_t bytes;       // Elementary stream bytes written
+    int64_t last_dts;     // Last DTS written (90 kHz, without offset)
+} TsMuxStream;
+
+typedef struct {
+    TsMuxStream streams[TS_MUX_MAX_STREAMS];
+    int n_streams;
+    int pcr_stream;       // Index of the stream carrying the PCR
+
+    // PSI state
+    uint8_t pat_cc;
+    uint8_t pmt_cc;
+    uint8_t pmt_version;
+    int psi_pending;      // Force PAT/PMT before the next PES
+    int64_t last_psi;     // DTS of the last PAT/PMT (90 kHz)
+
+    // Pre-allocated payload slot
+    uint8_t *payload;
+    int payload_size;     // Multiple of TS_PKT_SIZE
+    int payload_len;
+
+    TsMuxOutputFunc output;
+    void *user_data;
+
+    // Mux-wide counters
+    uint64_t psi_count;
+    uint64_t pcr_count;
+    uint64_t payloads;
+    uint64_t stuffing_bytes;
+} TsMux;
+
+/*
+ * Initialize the muxer
+ *
+ * payload_size is rounded down to a multiple of TS_PKT_SIZE.
+ * Returns 0 on success, -1 on error.
+ */
+int ts_mux_init(TsMux *mux, int payload_size, TsMuxOutputFunc output, void *user_data);
+
+/*
+ * Add an elementary stream, returns its index or -1 on error
+ *
+ * PIDs are assigned in order from TS_MUX_FIRST_ES_PID. The first video
+ * stream carries the PCR (the first stream if there is no video).
+ * Adding a stream after output has started bumps the PMT version.
+ */
+int ts_mux_add_stream(TsMux *mux, TsMuxCodec codec);
+
+/*
+ * Write one access unit
+ *
+ * pts / dts are in 90 kHz units (dts < 0 means same as pts). keyframe marks
+ * a random access point on video streams and is ignored on audio ones.
+ * Returns 0 on success, -1 if the output callback failed.
+ */
+int ts_mux_write_frame(TsMux *mux, int stream, const uint8_t *data, int len,
+                       int64_t pts, int64_t dts, int keyframe);
+
+/*
+ * Send any partially filled payload
+ *
+ * Returns 0 on success, -1 if the output callback failed.
+ */
+int ts_mux_flush(TsMux *mux);
+
+/*
+ * Free the payload buffer
+ */
+void ts_mux_cleanup(TsMux *mux);
+
+#endif /* TS_MUX_H */
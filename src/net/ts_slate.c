@@ -0,0 +1,237 @@
+/*
+    ceracoder - live video encoder with dynamic bitrate control
+    Copyright (C) 2020 BELABOX project
+    Copyright (C) 2026 CERALIVE
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#include "ts_slate.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TS_SLATE_PKT_SIZE   188
+#define TS_SYNC_BYTE        0x47
+#define TS_33BIT_MASK       ((1ULL << 33) - 1)
+
+int ts_packet_pcr(const uint8_t *pkt, uint64_t *pcr) {
+    // Adaptation field with at least the flags and a PCR, PCR_flag set
+    if (!(pkt[3] & 0x20) || pkt[4] < 7 || !(pkt[5] & 0x10)) return -1;
+
+    const uint8_t *p = pkt + 6;
+    uint64_t base = ((uint64_t)p[0] << 25) | ((uint64_t)p[1] << 17) |
+                    ((uint64_t)p[2] << 9) | ((uint64_t)p[3] << 1) | (p[4] >> 7);
+    uint32_t ext = ((uint32_t)(p[4] & 0x01) << 8) | p[5];
+    *pcr = base * 300 + ext;
+    return 0;
+}
+
+static void write_pcr(uint8_t *pkt, uint64_t pcr) {
+    uint64_t base = pcr / 300;
+    uint32_t ext = pcr % 300;
+    uint8_t *p = pkt + 6;
+    p[0] = (base >> 25) & 0xff;
+    p[1] = (base >> 17) & 0xff;
+    p[2] = (base >> 9) & 0xff;
+    p[3] = (base >> 1) & 0xff;
+    p[4] = ((base & 1) << 7) | 0x7e | ((ext >> 8) & 0x01);
+    p[5] = ext & 0xff;
+}
+
+static uint64_t read_pes_timestamp(const uint8_t *p) {
+    return ((uint64_t)((p[0] >> 1) & 0x07) << 30) | ((uint64_t)p[1] << 22) |
+           ((uint64_t)(p[2] >> 1) << 15) | ((uint64_t)p[3] << 7) | (p[4] >> 1);
+}
+
+// Keeps the '0010' / '0011' / '0001' prefix and the marker bits
+static void write_pes_timestamp(uint8_t *p, uint64_t ts) {
+    p[0] = (p[0] & 0xf1) | (((ts >> 30) & 0x07) << 1);
+    p[1] = (ts >> 22) & 0xff;
+    p[2] = (((ts >> 15) & 0x7f) << 1) | 1;
+    p[3] = (ts >> 7) & 0xff;
+    p[4] = ((ts & 0x7f) << 1) | 1;
+}
+
+// Shifts the PTS / DTS of a PES header starting in this packet
+static void shift_pes_timestamps(uint8_t *pkt, uint64_t offset) {
+    if (!(pkt[1] & 0x40) || !(pkt[3] & 0x10)) return;
+
+    int start = 4;
+    if (pkt[3] & 0x20) start += 1 + pkt[4];
+    if (start + 14 > TS_SLATE_PKT_SIZE) return;
+
+    // PSI sections don't start with a PES start code
+    uint8_t *pes = pkt + start;
+    if (pes[0] != 0 || pes[1] != 0 || pes[2] != 1) return;
+
+    // Streams without the optional PES header
+    uint8_t sid = pes[3];
+    if (sid == 0xbc || sid == 0xbe || sid == 0xbf || sid == 0xf0 || sid == 0xf1 ||
+        sid == 0xf2 || sid == 0xf8 || sid == 0xff) return;
+
+    int pts_dts = pes[7] >> 6;
+    if (pts_dts & 0x02) {
+        write_pes_timestamp(pes + 9, (read_pes_timestamp(pes + 9) + offset) & TS_33BIT_MASK);
+    }
+    if (pts_dts == 0x03 && start + 19 <= TS_SLATE_PKT_SIZE) {
+        write_pes_timestamp(pes + 14, (read_pes_timestamp(pes + 14) + offset) & TS_33BIT_MASK);
+    }
+}
+
+// Takes ownership of data
+static int load_packets(TsSlate *slate, uint8_t *data, int len) {
+    memset(slate, 0, sizeof(*slate));
+    slate->data = data;
+    if (len <= 0 || len % TS_SLATE_PKT_SIZE != 0) goto fail;
+    slate->n_pkts = len / TS_SLATE_PKT_SIZE;
+    slate->pkt_time = malloc(slate->n_pkts * sizeof(*slate->pkt_time));
+    if (slate->pkt_time == NULL) goto fail;
+
+    // Send times: the PCR for the packets carrying one, interpolated in between
+    int first = -1;
+    int prev = -1;
+    int n_pcr = 0;
+    uint64_t prev_pcr = 0;
+    for (int i = 0; i < slate->n_pkts; i++) {
+        const uint8_t *pkt = data + i * TS_SLATE_PKT_SIZE;
+        if (pkt[0] != TS_SYNC_BYTE) goto fail;
+
+        uint64_t pcr;
+        if (ts_packet_pcr(pkt, &pcr) != 0) continue;
+        if (first < 0) {
+            first = i;
+            slate->pcr0 = pcr;
+            for (int j = 0; j < i; j++) slate->pkt_time[j] = 0;
+        } else {
+            if (pcr <= prev_pcr) goto fail;
+            for (int j = prev + 1; j < i; j++) {
+                slate->pkt_time[j] = (prev_pcr - slate->pcr0) +
+                                     (pcr - prev_pcr) * (j - prev) / (i - prev);
+            }
+        }
+        slate->pkt_time[i] = pcr - slate->pcr0;
+        prev = i;
+        prev_pcr = pcr;
+        n_pcr++;
+    }
+    if (n_pcr < 2) goto fail;
+
+    // The loop lasts one average PCR interval past the last PCR, the packets
+    // after it are spread over that interval
+    uint64_t span = prev_pcr - slate->pcr0;
+    slate->duration = span + span / (n_pcr - 1);
+    for (int j = prev + 1; j < slate->n_pkts; j++) {
+        slate->pkt_time[j] = span + (slate->duration - span) * (j - prev) / (slate->n_pkts - prev);
+    }
+    return 0;
+
+fail:
+    ts_slate_cleanup(slate);
+    return -1;
+}
+
+int ts_slate_load_buffer(TsSlate *slate, const uint8_t *data, int len) {
+    uint8_t *copy = len > 0 ? malloc(len) : NULL;
+    if (copy == NULL) {
+        memset(slate, 0, sizeof(*slate));
+        return -1;
+    }
+    memcpy(copy, data, len);
+    return load_packets(slate, copy, len);
+}
+
+int ts_slate_load(TsSlate *slate, const char *path) {
+    memset(slate, 0, sizeof(*slate));
+
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        fprintf(stderr, "Failed to open the slate %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    long size = -1;
+    if (fseek(f, 0, SEEK_END) == 0) size = ftell(f);
+    if (size <= 0 || size > TS_SLATE_MAX_SIZE || fseek(f, 0, SEEK_SET) != 0) {
+        fprintf(stderr, "The slate %s is empty or larger than %d MB\n",
+                path, TS_SLATE_MAX_SIZE / (1024 * 1024));
+        fclose(f);
+        return -1;
+    }
+
+    uint8_t *data = malloc(size);
+    if (data == NULL || fread(data, 1, size, f) != (size_t)size) {
+        fprintf(stderr, "Failed to read the slate %s\n", path);
+        free(data);
+        fclose(f);
+        return -1;
+    }
+    fclose(f);
+
+    if (load_packets(slate, data, (int)size) != 0) {
+        fprintf(stderr, "The slate %s is not an MPEG-TS clip with at least two PCRs\n", path);
+        return -1;
+    }
+    return 0;
+}
+
+void ts_slate_start(TsSlate *slate, uint64_t pcr) {
+    slate->pos = 0;
+    slate->base = pcr;
+}
+
+int ts_slate_read(TsSlate *slate, uint64_t now, uint8_t *out, int max_pkts, int *new_loop) {
+    *new_loop = 0;
+    if (slate->n_pkts == 0) return 0;
+
+    if (slate->pos == slate->n_pkts) {
+        slate->pos = 0;
+        slate->base += slate->duration;
+    }
+
+    // Clip time to output time, for the PCR (27 MHz) and the PES timestamps (90 kHz)
+    uint64_t pcr_offset = (slate->base % TS_PCR_WRAP) + TS_PCR_WRAP - slate->pcr0;
+    uint64_t pes_offset = slate->base / 300 - slate->pcr0 / 300;
+
+    int start = slate->pos;
+    int n = 0;
+    while (n < max_pkts && slate->pos < slate->n_pkts &&
+           slate->base + slate->pkt_time[slate->pos] <= now) {
+        uint8_t *pkt = out + n * TS_SLATE_PKT_SIZE;
+        memcpy(pkt, slate->data + slate->pos * TS_SLATE_PKT_SIZE, TS_SLATE_PKT_SIZE);
+
+        uint64_t pcr;
+        if (ts_packet_pcr(pkt, &pcr) == 0) {
+            write_pcr(pkt, (pcr + pcr_offset) % TS_PCR_WRAP);
+        }
+        shift_pes_timestamps(pkt, pes_offset);
+
+        slate->pos++;
+        n++;
+    }
+
+    if (n > 0 && start == 0) {
+        *new_loop = 1;
+        slate->loops++;
+    }
+    slate->packets += n;
+    return n;
+}
+
+void ts_slate_cleanup(TsSlate *slate) {
+    free(slate->data);
+    free(slate->pkt_time);
+    memset(slate, 0, sizeof(*slate));
+}
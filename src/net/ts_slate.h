@@ -0,0 +1,93 @@
+/*
+    ceracoder - live video encoder with dynamic bitrate control
+    Copyright (C) 2020 BELABOX project
+    Copyright (C) 2026 CERALIVE
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef TS_SLATE_H
+#define TS_SLATE_H
+
+#include <stdint.h>
+
+/*
+ * Slate - a pre-encoded MPEG-TS clip looped from memory
+ *
+ * Sent instead of the pipeline output while the input signal is lost, so
+ * the receiver keeps getting a stream without anything being encoded. The
+ * clip is paced by its own PCRs; each loop has its PCRs and PES PTS / DTS
+ * shifted to carry on from the previous one, starting from the PCR given
+ * to ts_slate_start(). Continuity counters are left to the caller (each
+ * loop restarts them, see ts_cc.h).
+ *
+ * The clip must use the PIDs and codecs of the live stream, e.g. recorded
+ * from the same pipeline template into a file, and have at least two PCRs.
+ */
+
+#define TS_SLATE_MAX_SIZE   (64 * 1024 * 1024)
+#define TS_PCR_HZ           27000000ULL
+#define TS_PCR_WRAP         ((1ULL << 33) * 300)    // PCR range (27 MHz)
+
+typedef struct {
+    uint8_t *data;          // Clip, whole packets
+    int n_pkts;
+    uint64_t *pkt_time;     // Send time of each packet from the first PCR (27 MHz)
+    uint64_t pcr0;          // First PCR of the clip
+    uint64_t duration;      // Loop length (27 MHz)
+
+    // Playback
+    int pos;                // Next packet
+    uint64_t base;          // Output time of the first PCR of the current loop (27 MHz, unwrapped)
+    uint64_t loops;         // Loops started
+    uint64_t packets;       // Packets read
+} TsSlate;
+
+/*
+ * Load a clip from a buffer (copied) or a file
+ *
+ * Returns 0 on success, -1 if it is not whole TS packets, has fewer than
+ * two PCRs or their PCRs go backwards (a message is printed for files).
+ */
+int ts_slate_load_buffer(TsSlate *slate, const uint8_t *data, int len);
+int ts_slate_load(TsSlate *slate, const char *path);
+
+/*
+ * Start from the first packet, with the first PCR at pcr (27 MHz)
+ */
+void ts_slate_start(TsSlate *slate, uint64_t pcr);
+
+/*
+ * Copy the packets due by now (27 MHz, on the ts_slate_start() time line)
+ * to out, with their timestamps rewritten, up to max_pkts and never past
+ * the end of the clip. *new_loop is set when the packets start a loop.
+ *
+ * Returns the number of packets copied.
+ */
+int ts_slate_read(TsSlate *slate, uint64_t now, uint8_t *out, int max_pkts, int *new_loop);
+
+/*
+ * PCR of a packet (27 MHz)
+ *
+ * Returns 0 on success, -1 if the packet carries no PCR.
+ */
+int ts_packet_pcr(const uint8_t *pkt, uint64_t *pcr);
+
+/*
+ * Free the clip
+ */
+void ts_slate_cleanup(TsSlate *slate);
+
+#endif /* TS_SLATE_H */
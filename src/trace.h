@@ -0,0 +1,68 @@
+/*
+    ceracoder - live video encoder with dynamic bitrate control
+    Copyright (C) 2020 BELABOX project
+    Copyright (C) 2026 CERALIVE
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef TRACE_H
+#define TRACE_H
+
+/*
+ * USDT (user statically defined tracing) probes, provider "ceracoder"
+ *
+ * Each probe compiles to a single nop plus an ELF note, so they stay in
+ * release builds; bpftrace / perf / systemtap attach to them at runtime
+ * (see tools/bpftrace/). Arguments must be integers or pointers and
+ * cheap to compute, they are evaluated even when no tracer is attached.
+ *
+ * Probes are built in when <sys/sdt.h> is available (systemtap-sdt-dev),
+ * unless CERACODER_NO_SDT is defined; otherwise they compile to nothing.
+ *
+ *   sample_start(size, pts)          new_buf_cb: appsink sample pulled
+ *   sample_done(size, ret)           new_buf_cb: sample sent / failed
+ *   pkt_send_start(len)              SRT payload send
+ *   pkt_send_done(len, ret)
+ *   pts_adjust(in_pts, out_pts, period)    cb_ptsfixup
+ *   pts_drop(in_pts, out_pts, diff)
+ *   balancer_input(rtt_ms, buffer_size, send_rate_kbps, timestamp)
+ *   balancer_output(bitrate, throughput, state, reason)
+ *   encoder_set_start(bitrate)       encoder property set
+ *   encoder_set_done(bitrate)
+ *   srt_connect_start(attempt)
+ *   srt_connect_done(attempt, ret)
+ *   stall(position)                  pipeline stall detected
+ */
+
+#if !defined(CERACODER_NO_SDT) && defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define CERACODER_HAVE_SDT 1
+#endif
+#endif
+
+#ifdef CERACODER_HAVE_SDT
+#define TRACE1(name, a)             DTRACE_PROBE1(ceracoder, name, a)
+#define TRACE2(name, a, b)          DTRACE_PROBE2(ceracoder, name, a, b)
+#define TRACE3(name, a, b, c)       DTRACE_PROBE3(ceracoder, name, a, b, c)
+#define TRACE4(name, a, b, c, d)    DTRACE_PROBE4(ceracoder, name, a, b, c, d)
+#else
+#define TRACE1(name, a)             do {} while (0)
+#define TRACE2(name, a, b)          do {} while (0)
+#define TRACE3(name, a, b, c)       do {} while (0)
+#define TRACE4(name, a, b, c, d)    do {} while (0)
+#endif
+
+#endif /* TRACE_H */
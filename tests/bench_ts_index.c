@@ -0,0 +1,106 @@
+/*
+    ceracoder - live video encoder with dynamic bitrate control
+    Copyright (C) 2020 BELABOX project
+    Copyright (C) 2026 CERALIVE
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * Microbenchmark for the MPEG-TS packet indexer
+ *
+ * Indexes a buffer of SRT-payload-sized chunks (the size new_buf_cb sees)
+ * and a single large buffer, with the vector and the scalar decoder, and
+ * prints the single-core throughput in MB/s.
+ *
+ * Usage: bench_ts_index [seconds per case]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "ts_index.h"
+
+#define BENCH_BUF_PKTS 8192   // ~1.5 MB
+
+typedef int (*BuildFunc)(TsIndex *idx, const uint8_t *data, int len);
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static double bench(BuildFunc build, const uint8_t *buf, int len, int chunk, double secs) {
+    TsIndex idx;
+    ts_index_init(&idx);
+    volatile int sink = 0;
+    uint64_t bytes = 0;
+
+    double start = now_s();
+    double elapsed;
+    do {
+        for (int i = 0; i < 64; i++) {
+            for (int off = 0; off + chunk <= len; off += chunk) {
+                build(&idx, buf + off, chunk);
+                sink += idx.pkts[idx.count - 1].cc;
+            }
+            bytes += (uint64_t)(len / chunk) * chunk;
+        }
+        elapsed = now_s() - start;
+    } while (elapsed < secs);
+
+    ts_index_cleanup(&idx);
+    (void)sink;
+    return bytes / elapsed / 1e6;
+}
+
+int main(int argc, char **argv) {
+    double secs = argc > 1 ? atof(argv[1]) : 1.0;
+    if (secs <= 0) secs = 1.0;
+
+    int len = BENCH_BUF_PKTS * TS_INDEX_PKT_SIZE;
+    uint8_t *buf = malloc(len);
+    if (buf == NULL) return 1;
+
+    // A plausible mix: mostly video payload, some adaptation fields
+    srand(1);
+    for (int i = 0; i < len; i++) buf[i] = (uint8_t)rand();
+    for (int i = 0; i < BENCH_BUF_PKTS; i++) {
+        uint8_t *pkt = buf + i * TS_INDEX_PKT_SIZE;
+        pkt[0] = 0x47;
+        pkt[3] = (pkt[3] & 0x0f) | (i % 8 == 0 ? 0x30 : 0x10);
+    }
+
+    const struct {
+        const char *name;
+        int chunk;
+    } cases[] = {
+        {"1316 B chunks", TS_INDEX_PKT_SIZE * 7},
+        {"1.5 MB buffer", len},
+    };
+
+    printf("ts_index: %s decoder, %.1f s per case\n", ts_index_impl(), secs);
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        double vec = bench(ts_index_build, buf, len, cases[i].chunk, secs);
+        double sca = bench(ts_index_build_scalar, buf, len, cases[i].chunk, secs);
+        printf("  %-14s %-6s %9.0f MB/s   scalar %9.0f MB/s   (x%.2f)\n",
+               cases[i].name, ts_index_impl(), vec, sca, vec / sca);
+    }
+
+    free(buf);
+    return 0;
+}
@@ -0,0 +1,153 @@
+/*
+    ceracoder - live video encoder with dynamic bitrate control
+    Copyright (C) 2020 BELABOX project
+    Copyright (C) 2026 CERALIVE
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "impair.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+void impair_config_init(ImpairConfig *cfg) {
+    memset(cfg, 0, sizeof(*cfg));
+    cfg->queue_ms = 200;
+    cfg->seed = 1;
+}
+
+int impair_add_trace(ImpairConfig *cfg, uint32_t duration_ms, int rate_kbps) {
+    if (cfg->trace_len >= IMPAIR_TRACE_MAX || duration_ms == 0) return -1;
+
+    cfg->trace[cfg->trace_len].start_ms = cfg->trace_period_ms;
+    cfg->trace[cfg->trace_len].rate_kbps = rate_kbps;
+    cfg->trace_len++;
+    cfg->trace_period_ms += duration_ms;
+    return 0;
+}
+
+int impair_load_trace(ImpairConfig *cfg, const char *filename) {
+    FILE *f = fopen(filename, "r");
+    if (f == NULL) return -1;
+
+    cfg->trace_len = 0;
+    cfg->trace_period_ms = 0;
+
+    char line[128];
+    int lineno = 0;
+    while (fgets(line, sizeof(line), f) != NULL) {
+        lineno++;
+        char *comment = strchr(line, '#');
+        if (comment) *comment = '\0';
+
+        unsigned duration;
+        int rate;
+        char extra;
+        int n = sscanf(line, "%u %d %c", &duration, &rate, &extra);
+        if (n <= 0) continue;   // Blank line
+        if (n != 2 || rate < 0 || impair_add_trace(cfg, duration, rate) != 0) {
+            fprintf(stderr, "%s:%d: invalid trace segment\n", filename, lineno);
+            fclose(f);
+            return -1;
+        }
+    }
+
+    fclose(f);
+    return cfg->trace_len > 0 ? 0 : -1;
+}
+
+void impair_init(Impair *im, const ImpairConfig *cfg) {
+    memset(im, 0, sizeof(*im));
+    im->cfg = *cfg;
+    im->rng = cfg->seed ? cfg->seed : 1;
+    im->start_us = -1;
+}
+
+// xorshift64*, uniform in [0, 1)
+static double impair_random(Impair *im) {
+    im->rng ^= im->rng >> 12;
+    im->rng ^= im->rng << 25;
+    im->rng ^= im->rng >> 27;
+    return (double)((im->rng * 2685821657736338717ULL) >> 11) / (double)(1ULL << 53);
+}
+
+static int impair_lost(Impair *im) {
+    const ImpairConfig *cfg = &im->cfg;
+    if (cfg->ge_p_bad <= 0) {
+        return cfg->loss > 0 && impair_random(im) < cfg->loss;
+    }
+
+    if (im->ge_bad) {
+        if (impair_random(im) < cfg->ge_p_good) im->ge_bad = 0;
+    } else {
+        if (impair_random(im) < cfg->ge_p_bad) im->ge_bad = 1;
+    }
+    double loss = im->ge_bad ? cfg->ge_loss_bad : cfg->ge_loss_good;
+    return loss > 0 && impair_random(im) < loss;
+}
+
+int impair_rate(const Impair *im, int64_t now_us) {
+    const ImpairConfig *cfg = &im->cfg;
+    if (cfg->trace_len == 0 || cfg->trace_period_ms == 0) return cfg->rate_kbps;
+
+    int64_t start = im->start_us < 0 ? now_us : im->start_us;
+    uint32_t t = (uint32_t)(((now_us - start) / 1000) % cfg->trace_period_ms);
+    int i = cfg->trace_len - 1;
+    while (i > 0 && cfg->trace[i].start_ms > t) i--;
+    return cfg->trace[i].rate_kbps;
+}
+
+int64_t impair_packet(Impair *im, int64_t now_us, int len) {
+    const ImpairConfig *cfg = &im->cfg;
+    if (im->start_us < 0) im->start_us = now_us;
+
+    im->packets++;
+    im->bytes += len;
+
+    if (impair_lost(im)) {
+        im->lost++;
+        return -1;
+    }
+
+    // Bottleneck queue; a zero rate in a trace is an outage, everything is dropped
+    int64_t sent_us = now_us;
+    if (cfg->rate_kbps > 0 || cfg->trace_len > 0) {
+        int rate = impair_rate(im, now_us);
+        int64_t queued_us = im->link_free_us > now_us ? im->link_free_us - now_us : 0;
+        if (rate <= 0 || queued_us > (int64_t)cfg->queue_ms * 1000) {
+            im->queue_drops++;
+            return -1;
+        }
+        int64_t tx_us = (int64_t)len * 8 * 1000 / rate;
+        im->link_free_us = now_us + queued_us + tx_us;
+        sent_us = im->link_free_us;
+    }
+
+    int64_t deliver_us = sent_us + (int64_t)cfg->delay_ms * 1000;
+    if (cfg->jitter_ms > 0) {
+        deliver_us += (int64_t)(impair_random(im) * cfg->jitter_ms * 1000);
+    }
+
+    // Jitter alone keeps the order, like a real path with variable queueing
+    if (deliver_us < im->last_deliver_us) deliver_us = im->last_deliver_us;
+
+    if (cfg->reorder > 0 && impair_random(im) < cfg->reorder) {
+        im->reordered++;
+        return deliver_us + (int64_t)cfg->reorder_ms * 1000;
+    }
+
+    im->last_deliver_us = deliver_us;
+    return deliver_us;
+}
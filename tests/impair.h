@@ -0,0 +1,122 @@
+/*
+    ceracoder - live video encoder with dynamic bitrate control
+    Copyright (C) 2020 BELABOX project
+    Copyright (C) 2026 CERALIVE
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef IMPAIR_H
+#define IMPAIR_H
+
+#include <stdint.h>
+
+/*
+ * Network impairment model - decides the fate of each packet on one
+ * direction of a link, for the UDP proxy (udp_proxy.h)
+ *
+ * A packet is first subject to random loss (Bernoulli, or a two-state
+ * Gilbert-Elliott chain for bursts), then queued at the bottleneck rate
+ * (tail drop once the queue holds more than queue_ms worth of data), then
+ * delayed by the base delay plus a uniform jitter. Jitter doesn't reorder
+ * packets by itself; reordered packets are held back an extra reorder_ms.
+ * The bottleneck rate is either fixed or follows a trace that repeats.
+ *
+ * Deterministic for a given seed and packet timing.
+ */
+
+#define IMPAIR_TRACE_MAX 1024
+
+typedef struct {
+    uint32_t start_ms;      // Offset from the start of the trace
+    int rate_kbps;          // Rate until the next point
+} ImpairTracePoint;
+
+typedef struct {
+    int rate_kbps;          // Bottleneck rate, 0 = unlimited
+    int queue_ms;           // Bottleneck queue limit (ms of data at the rate, default: 200)
+    int delay_ms;           // Base one-way delay
+    int jitter_ms;          // Uniform extra delay, 0 to jitter_ms
+    double loss;            // Bernoulli loss probability
+
+    // Gilbert-Elliott loss, used instead of loss when ge_p_bad > 0
+    double ge_p_bad;        // P(good -> bad) per packet
+    double ge_p_good;       // P(bad -> good) per packet
+    double ge_loss_good;    // Loss probability in the good state
+    double ge_loss_bad;     // Loss probability in the bad state
+
+    double reorder;         // Probability of holding a packet back
+    int reorder_ms;         // Extra delay of held back packets
+
+    // Rate trace, overrides rate_kbps when trace_len > 0
+    ImpairTracePoint trace[IMPAIR_TRACE_MAX];
+    int trace_len;
+    uint32_t trace_period_ms;   // Trace length, it repeats after this
+
+    uint32_t seed;
+} ImpairConfig;
+
+typedef struct {
+    ImpairConfig cfg;
+
+    // State
+    uint64_t rng;
+    int ge_bad;             // Gilbert-Elliott chain in the bad state
+    int64_t start_us;       // First packet, origin of the trace
+    int64_t link_free_us;   // When the bottleneck has sent everything queued
+    int64_t last_deliver_us;
+
+    // Counters
+    uint64_t packets;
+    uint64_t bytes;
+    uint64_t lost;          // Random loss
+    uint64_t queue_drops;   // Bottleneck queue overflow
+    uint64_t reordered;
+} Impair;
+
+/*
+ * Default config: no impairment, 200 ms queue
+ */
+void impair_config_init(ImpairConfig *cfg);
+
+/*
+ * Append a segment of duration_ms at rate_kbps to the rate trace
+ *
+ * Returns 0 on success, -1 if the trace is full.
+ */
+int impair_add_trace(ImpairConfig *cfg, uint32_t duration_ms, int rate_kbps);
+
+/*
+ * Load a rate trace, one "<duration_ms> <rate_kbps>" segment per line.
+ * '#' starts a comment.
+ *
+ * Returns 0 on success, -1 on error.
+ */
+int impair_load_trace(ImpairConfig *cfg, const char *filename);
+
+void impair_init(Impair *im, const ImpairConfig *cfg);
+
+/*
+ * Bottleneck rate at time now_us, kbps (0 = unlimited)
+ */
+int impair_rate(const Impair *im, int64_t now_us);
+
+/*
+ * Submit a packet of len bytes arriving at now_us
+ *
+ * Returns the time to deliver it (us, same clock), or -1 if it is dropped.
+ */
+int64_t impair_packet(Impair *im, int64_t now_us, int len);
+
+#endif /* IMPAIR_H */
@@ -0,0 +1,68 @@
+/*
+    ceracoder - live video encoder with dynamic bitrate control
+    Copyright (C) 2020 BELABOX project
+    Copyright (C) 2026 CERALIVE
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "link_sim.h"
+#include <string.h>
+
+void link_sim_init(LinkSim *sim, int capacity, double base_rtt, double queue_limit,
+                   int pkt_size) {
+    memset(sim, 0, sizeof(*sim));
+    sim->capacity = capacity;
+    sim->base_rtt = base_rtt;
+    sim->queue_limit = queue_limit;
+    sim->pkt_size = pkt_size;
+    sim->timestamp = 1000;
+}
+
+BalancerInput link_sim_step(LinkSim *sim, int bitrate, int interval) {
+    double in = (double)bitrate * interval / 1000.0;
+    double out = (double)sim->capacity * interval / 1000.0;
+
+    sim->queue_bits += in;
+    double sent = sim->queue_bits < out ? sim->queue_bits : out;
+    sim->queue_bits -= sent;
+
+    // Tail drop on overflow, SRT retransmits the dropped packets
+    double limit = (double)sim->capacity * sim->queue_limit / 1000.0;
+    if (sim->queue_bits > limit) {
+        sim->lost_bits += sim->queue_bits - limit;
+        sim->queue_bits = limit;
+    }
+    double pkt_bits = sim->pkt_size * 8.0;
+    int64_t lost = (int64_t)(sim->lost_bits / pkt_bits);
+    sim->pkt_loss_total += lost;
+    sim->lost_bits -= lost * pkt_bits;
+
+    sim->timestamp += interval;
+    double rtt = sim->base_rtt + sim->queue_bits * 1000.0 / sim->capacity;
+
+    // Unacknowledged packets: everything sent within the last RTT
+    double rate = sent * 1000.0 / interval;
+    int buffer_size = (int)(rate * rtt / 1000.0 / pkt_bits);
+
+    BalancerInput input = {
+        .buffer_size = buffer_size,
+        .rtt = rtt,
+        .send_rate_mbps = rate / (1000.0 * 1000.0),
+        .timestamp = sim->timestamp,
+        .pkt_loss_total = sim->pkt_loss_total,
+        .pkt_retrans_total = 0,
+    };
+    return input;
+}
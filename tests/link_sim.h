@@ -0,0 +1,58 @@
+/*
+    ceracoder - live video encoder with dynamic bitrate control
+    Copyright (C) 2020 BELABOX project
+    Copyright (C) 2026 CERALIVE
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef LINK_SIM_H
+#define LINK_SIM_H
+
+#include <stdint.h>
+#include "balancer.h"
+
+/*
+ * Link simulator - single bottleneck link for balancer tests
+ *
+ * The encoder output (the balancer bitrate) enters a FIFO queue drained at
+ * the link capacity. The RTT is the base RTT plus the queueing delay, the
+ * SRT send buffer holds the packets in flight, and queue overflow is
+ * counted as packet loss (recovered by SRT retransmission). Produces the
+ * BalancerInput SRT stats would give for each update interval.
+ */
+
+typedef struct {
+    // Link
+    int capacity;           // Bottleneck capacity (bps)
+    double base_rtt;        // RTT without queueing (ms)
+    double queue_limit;     // Queue length before overflow (ms at capacity)
+    int pkt_size;           // SRT packet size (bytes)
+
+    // State
+    double queue_bits;      // Bits in the bottleneck queue
+    double lost_bits;       // Overflow not yet counted as a whole packet
+    int64_t pkt_loss_total;
+    uint64_t timestamp;     // ms
+} LinkSim;
+
+void link_sim_init(LinkSim *sim, int capacity, double base_rtt, double queue_limit,
+                   int pkt_size);
+
+/*
+ * Send at bitrate for interval ms and return the resulting SRT stats
+ */
+BalancerInput link_sim_step(LinkSim *sim, int bitrate, int interval);
+
+#endif /* LINK_SIM_H */
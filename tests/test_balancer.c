@@ -28,18 +28,24 @@
 #include <stddef.h>
 #include <setjmp.h>
 #include <cmocka.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include "balancer.h"
 #include "config.h"
 #include "balancer_runner.h"
+#include "ceracoder_core.h"
+#include "slow_start.h"
+#include "rtt_filter.h"
+#include "link_sim.h"
 
 /*
  * Test: Adaptive balancer recovers bitrate after congestion on good network
  *
- * The adaptive algorithm starts at max_bitrate. This test verifies that
- * after congestion reduces bitrate, good conditions allow recovery.
+ * Without slow start the adaptive algorithm starts at max_bitrate. This
+ * test verifies that after congestion reduces bitrate, good conditions
+ * allow recovery.
  */
 static void test_adaptive_recovers_on_good_network(void **state) {
     (void) state;
@@ -48,6 +54,7 @@ static void test_adaptive_recovers_on_good_network(void **state) {
     config_init_defaults(&cfg);
     cfg.min_bitrate = 500;   // 500 Kbps
     cfg.max_bitrate = 6000;  // 6000 Kbps
+    cfg.slow_start = 0;
     strcpy(cfg.balancer, "adaptive");
 
     BalancerRunner runner;
@@ -200,6 +207,7 @@ static void test_aimd_additive_increase(void **state) {
     cfg.max_bitrate = 6000;
     strcpy(cfg.balancer, "aimd");
     cfg.aimd.incr_step = 100;  // 100 Kbps per step
+    cfg.slow_start = 0;        // Additive increase from the first step
 
     BalancerRunner runner;
     int ret = balancer_runner_init(&runner, &cfg, NULL, 2000, 1316);
@@ -384,6 +392,99 @@ static void test_packet_loss_triggers_reduction(void **state) {
     balancer_runner_cleanup(&runner);
 }
 
+// Runs the adaptive balancer on a steady link with random loss, returns the final bitrate
+static int run_random_loss(int loss_classify, BalancerTelemetry *telemetry) {
+    BelacoderConfig cfg;
+    config_init_defaults(&cfg);
+    cfg.min_bitrate = 500;
+    cfg.max_bitrate = 6000;
+    cfg.adaptive.loss_classify = loss_classify;
+
+    BalancerRunner runner;
+    assert_int_equal(balancer_runner_init(&runner, &cfg, "adaptive", 2000, 1316), 0);
+
+    BalancerInput input = { .buffer_size = 10, .rtt = 40.0, .send_rate_mbps = 5.0, .timestamp = 1000 };
+    BalancerOutput out = {0};
+    for (int i = 0; i < 1500; i++) {
+        input.timestamp += 20;
+        // After 6 s: 3 packets lost every 4 updates (~8%), RTT and buffer flat
+        if (i >= 300 && i % 4 == 0) {
+            input.pkt_loss_total += 2;
+            input.pkt_retrans_total += 1;
+        }
+        out = balancer_runner_step(&runner, &input);
+    }
+
+    *telemetry = runner.telemetry;
+    balancer_runner_cleanup(&runner);
+    return out.new_bitrate;
+}
+
+/*
+ * Test: Random loss without queue build-up doesn't reduce the bitrate
+ */
+static void test_random_loss_ignored(void **state) {
+    (void) state;
+
+    BalancerTelemetry classified, unclassified;
+    int br_classified = run_random_loss(1, &classified);
+    int br_unclassified = run_random_loss(0, &unclassified);
+
+    // Without classification, the loss alone drives the bitrate down
+    assert_true(br_unclassified < 3000000);
+    assert_true(unclassified.reason_count[BALANCER_REASON_HEAVY_LOSS] > 0);
+    assert_int_equal(unclassified.loss_random_pkts, 0);
+
+    // With classification, it stays at the maximum
+    assert_int_equal(br_classified, 6000000);
+    assert_int_equal(classified.reason_count[BALANCER_REASON_HEAVY_LOSS], 0);
+    assert_int_equal(classified.loss_random_pkts, 900);
+    assert_int_equal(classified.loss_random_events, 300);
+    assert_int_equal(classified.loss_congestive_pkts, 0);
+}
+
+/*
+ * Test: Loss together with a rising RTT is congestive
+ */
+static void test_congestive_loss_detected(void **state) {
+    (void) state;
+
+    BelacoderConfig cfg;
+    config_init_defaults(&cfg);
+    cfg.min_bitrate = 500;
+    cfg.max_bitrate = 6000;
+
+    BalancerRunner runner;
+    assert_int_equal(balancer_runner_init(&runner, &cfg, "adaptive", 2000, 1316), 0);
+
+    BalancerInput input = { .buffer_size = 10, .rtt = 40.0, .send_rate_mbps = 5.0, .timestamp = 1000 };
+    for (int i = 0; i < 300; i++) {
+        input.timestamp += 20;
+        balancer_runner_step(&runner, &input);
+    }
+
+    // Queue building up: RTT and send buffer grow, with loss
+    for (int i = 0; i < 50; i++) {
+        input.timestamp += 20;
+        input.rtt += 5.0;
+        input.buffer_size += 4;
+        input.pkt_loss_total += 2;
+        balancer_runner_step(&runner, &input);
+    }
+
+    assert_true(runner.telemetry.loss_congestive_pkts >= 90);
+    assert_true(runner.telemetry.loss_random_pkts <= 10);
+    assert_true(runner.telemetry.reason_count[BALANCER_REASON_HOLD] > 0);
+
+    static Stats stats;
+    stats_init(&stats);
+    balancer_telemetry_publish(&runner.telemetry, &stats);
+    assert_true(stats_get(&stats, "ceracoder_balancer_loss_packets_total{class=\"congestive\"}") ==
+                (double)runner.telemetry.loss_congestive_pkts);
+
+    balancer_runner_cleanup(&runner);
+}
+
 /*
  * Test: Min equals max enforces fixed bitrate
  */
@@ -418,6 +519,635 @@ static void test_min_equals_max_fixed_range(void **state) {
     balancer_runner_cleanup(&runner);
 }
 
+/*
+ * Test: Every algorithm reports why it changed the bitrate
+ */
+static void test_decision_reasons(void **state) {
+    (void) state;
+
+    BelacoderConfig cfg;
+    config_init_defaults(&cfg);
+    cfg.min_bitrate = 500;
+    cfg.max_bitrate = 6000;
+    cfg.slow_start = 0;
+
+    BalancerRunner runner;
+    assert_int_equal(balancer_runner_init(&runner, &cfg, "adaptive", 2000, 1316), 0);
+    BalancerInput input = { .buffer_size = 10, .rtt = 40.0, .send_rate_mbps = 4.0, .timestamp = 1000 };
+
+    // Settle, then RTT above latency/5: heavy, RTT-triggered
+    for (int i = 0; i < 50; i++) {
+        input.timestamp += 20;
+        balancer_runner_step(&runner, &input);
+    }
+    input.rtt = 450.0;
+    input.timestamp += 300;
+    BalancerOutput out = balancer_runner_step(&runner, &input);
+    assert_int_equal(out.reason, BALANCER_REASON_HEAVY_RTT);
+    assert_int_equal(out.state, BALANCER_STATE_HEAVY);
+
+    // Still congested within the decrease interval: hold, but heavy state
+    input.timestamp += 20;
+    out = balancer_runner_step(&runner, &input);
+    assert_int_equal(out.reason, BALANCER_REASON_HOLD);
+    assert_int_equal(out.state, BALANCER_STATE_HEAVY);
+
+    // RTT close to the latency: emergency drop
+    input.rtt = 700.0;
+    input.timestamp += 20;
+    out = balancer_runner_step(&runner, &input);
+    assert_int_equal(out.reason, BALANCER_REASON_EMERGENCY_RTT);
+    assert_int_equal(out.state, BALANCER_STATE_EMERGENCY);
+    assert_int_equal(out.new_bitrate, 500000);
+    assert_string_equal(balancer_reason_name(out.reason), "emergency_rtt");
+    assert_string_equal(balancer_state_name(out.state), "emergency");
+
+    assert_int_equal(runner.telemetry.reason_count[BALANCER_REASON_HEAVY_RTT], 1);
+    assert_int_equal(runner.telemetry.reason_count[BALANCER_REASON_EMERGENCY_RTT], 1);
+    balancer_runner_cleanup(&runner);
+
+    // AIMD: congested by the send buffer
+    assert_int_equal(balancer_runner_init(&runner, &cfg, "aimd", 2000, 1316), 0);
+    input = (BalancerInput){ .buffer_size = 10, .rtt = 40.0, .timestamp = 1000 };
+    out = balancer_runner_step(&runner, &input);
+    assert_int_equal(out.reason, BALANCER_REASON_INCREASE);
+    assert_int_equal(out.state, BALANCER_STATE_STABLE);
+    input.buffer_size = 500;
+    input.timestamp += 20;
+    out = balancer_runner_step(&runner, &input);
+    assert_int_equal(out.reason, BALANCER_REASON_HEAVY_BUFFER);
+    balancer_runner_cleanup(&runner);
+
+    // Fixed
+    assert_int_equal(balancer_runner_init(&runner, &cfg, "fixed", 2000, 1316), 0);
+    out = balancer_runner_step(&runner, &input);
+    assert_int_equal(out.reason, BALANCER_REASON_FIXED);
+    balancer_runner_cleanup(&runner);
+
+    assert_string_equal(balancer_reason_name(BALANCER_REASON_COUNT), "unknown");
+}
+
+/*
+ * Test: Time in state and state episode histogram
+ */
+static void test_telemetry_state_time(void **state) {
+    (void) state;
+
+    BalancerTelemetry t;
+    balancer_telemetry_init(&t);
+    BalancerOutput out = { .reason = BALANCER_REASON_HOLD, .state = BALANCER_STATE_STABLE };
+
+    // 2 s stable, 300 ms heavy, then stable again
+    for (uint64_t ts = 0; ts <= 2000; ts += 20) {
+        balancer_telemetry_update(&t, &out, ts);
+    }
+    out.state = BALANCER_STATE_HEAVY;
+    out.reason = BALANCER_REASON_HEAVY_BUFFER;
+    for (uint64_t ts = 2020; ts <= 2300; ts += 20) {
+        balancer_telemetry_update(&t, &out, ts);
+    }
+    out.state = BALANCER_STATE_STABLE;
+    out.reason = BALANCER_REASON_INCREASE;
+    balancer_telemetry_update(&t, &out, 2320);
+
+    assert_int_equal(t.state_time_ms[BALANCER_STATE_STABLE], 2020);
+    assert_int_equal(t.state_time_ms[BALANCER_STATE_HEAVY], 300);
+    assert_int_equal(t.state_entries[BALANCER_STATE_STABLE], 2);
+    assert_int_equal(t.state_entries[BALANCER_STATE_HEAVY], 1);
+    assert_int_equal(t.reason_count[BALANCER_REASON_HEAVY_BUFFER], 15);
+
+    // Stable episode of 2.02 s -> le 2.5 bucket, heavy episode of 0.3 s -> le 0.5
+    assert_int_equal(t.state_hist[BALANCER_STATE_STABLE][4], 1);
+    assert_int_equal(t.state_hist[BALANCER_STATE_HEAVY][2], 1);
+    assert_int_equal(t.state_hist_sum_ms[BALANCER_STATE_HEAVY], 300);
+    assert_int_equal(t.state, BALANCER_STATE_STABLE);
+
+    static Stats stats;
+    stats_init(&stats);
+    balancer_telemetry_publish(&t, &stats);
+    assert_true(stats_get(&stats, "ceracoder_balancer_decisions_total{reason=\"heavy_buffer\"}") == 15);
+    assert_true(stats_get(&stats, "ceracoder_balancer_state_seconds_total{state=\"heavy\"}") == 0.3);
+    assert_true(stats_get(&stats,
+        "ceracoder_balancer_state_duration_seconds_bucket{state=\"heavy\",le=\"0.5\"}") == 1);
+    assert_true(stats_get(&stats,
+        "ceracoder_balancer_state_duration_seconds_count{state=\"stable\"}") == 1);
+}
+
+/*
+ * Test: Public core API matches the balancer runner step for step
+ */
+static void test_core_api_matches_runner(void **state) {
+    (void) state;
+
+    assert_int_equal(ceracoder_core_version() >> 16, CERACODER_CORE_VERSION_MAJOR);
+    assert_int_equal(ceracoder_balancer_algorithm_count(), 3);
+    assert_string_equal(ceracoder_balancer_algorithm_name(0), "adaptive");
+    assert_null(ceracoder_balancer_algorithm_name(3));
+
+    BelacoderConfig cfg;
+    config_init_defaults(&cfg);
+    cfg.min_bitrate = 500;
+    cfg.max_bitrate = 6000;
+
+    BalancerRunner runner;
+    assert_int_equal(balancer_runner_init(&runner, &cfg, "adaptive", 2000, 1316), 0);
+    CeracoderBalancer *b = ceracoder_balancer_new("adaptive", 500000, 6000000, 2000, 1316);
+    assert_non_null(b);
+    assert_string_equal(ceracoder_balancer_name(b), "adaptive");
+
+    BalancerInput input = {
+        .buffer_size = 10,
+        .rtt = 40.0,
+        .send_rate_mbps = 4.0,
+        .timestamp = 1000,
+    };
+    for (int i = 0; i < 200; i++) {
+        input.timestamp += 20;
+        // Congestion in the middle of the run
+        input.buffer_size = (i >= 80 && i < 120) ? 400 : 10;
+        input.rtt = (i >= 80 && i < 120) ? 700.0 : 40.0;
+        // Scene cuts, then a static scene with a ceiling; random loss
+        input.scene_cut = (i == 30 || i == 150);
+        input.motion = i < 160 ? 40 : 0;
+        input.ceiling = i >= 170 ? 2000000 : 0;
+        input.pkt_loss_total = i / 10;
+
+        BalancerOutput expected = balancer_runner_step(&runner, &input);
+        ceracoder_balancer_set_hints(b, input.scene_cut, input.motion, input.ceiling);
+        int32_t br = ceracoder_balancer_step(b, input.buffer_size, input.rtt, input.send_rate_mbps,
+                                             input.timestamp, input.pkt_loss_total, 0);
+        assert_int_equal(br, expected.new_bitrate);
+
+        CeracoderBalancerOutput out;
+        assert_int_equal(ceracoder_balancer_get_output(b, &out, sizeof(out)), sizeof(out));
+        assert_int_equal(out.new_bitrate, expected.new_bitrate);
+        assert_int_equal(out.rtt_th_max, expected.rtt_th_max);
+        assert_int_equal(out.bs_th3, expected.bs_th3);
+        assert_int_equal(out.reason, expected.reason);
+        assert_int_equal(out.state, expected.state);
+        assert_int_equal(out.loss_congestive, expected.loss_congestive);
+        assert_int_equal(out.loss_random, expected.loss_random);
+        assert_int_equal(out.rtt_change, expected.rtt_change);
+    }
+
+    ceracoder_balancer_free(b);
+    balancer_runner_cleanup(&runner);
+}
+
+/*
+ * Test: Public core API options, bounds and error handling
+ */
+static void test_core_api_options(void **state) {
+    (void) state;
+
+    assert_null(ceracoder_balancer_new("no_such_algorithm", 500000, 6000000, 2000, 1316));
+    assert_null(ceracoder_balancer_new(NULL, 6000000, 500000, 2000, 1316));
+
+    CeracoderBalancer *b = ceracoder_balancer_new("fixed", 500000, 6000000, 2000, 1316);
+    assert_non_null(b);
+    assert_int_equal(ceracoder_balancer_step(b, 10, 40.0, 4.0, 1000, 0, 0), 6000000);
+
+    // Bounds are rounded to whole Kbps
+    ceracoder_balancer_update_bounds(b, 500000, 2999600);
+    assert_int_equal(ceracoder_balancer_step(b, 10, 40.0, 4.0, 1020, 0, 0), 3000000);
+
+    // Tuning options use the config file sections and keys
+    assert_int_equal(ceracoder_balancer_set_option(b, "aimd", "decr_mult", "0.5"), 0);
+    assert_int_equal(ceracoder_balancer_set_option(b, "aimd", "no_such_key", "1"), -1);
+    assert_int_equal(ceracoder_balancer_set_option(b, "general", "max_bitrate", "1"), -1);
+    assert_int_equal(ceracoder_balancer_set_option(b, "general", "slow_start", "0"), 0);
+    assert_int_equal(ceracoder_balancer_step(b, 10, 40.0, 4.0, 1040, 0, 0), 3000000);
+
+    // Short output buffers only receive the fields they know about
+    CeracoderBalancerOutput out;
+    memset(&out, 0xff, sizeof(out));
+    assert_int_equal(ceracoder_balancer_get_output(b, &out, 12), 12);
+    assert_int_equal(out.new_bitrate, 3000000);
+    assert_int_equal(out.rtt, -1);
+
+    ceracoder_balancer_free(b);
+    ceracoder_balancer_free(NULL);
+
+    // Slow start by default, the initial bitrate is known before the first step
+    b = ceracoder_balancer_new("adaptive", 500000, 6000000, 2000, 1316);
+    assert_int_equal(ceracoder_balancer_get_bitrate(b), 1000000);
+    assert_int_equal(ceracoder_balancer_set_option(b, "general", "start_bitrate", "2000"), 0);
+    assert_int_equal(ceracoder_balancer_get_bitrate(b), 2000000);
+    assert_int_equal(ceracoder_balancer_set_option(b, "general", "slow_start", "0"), 0);
+    assert_int_equal(ceracoder_balancer_get_bitrate(b), 6000000);
+    ceracoder_balancer_free(b);
+}
+
+/*
+ * Test: Slow start doubles per round and hands over on congestion
+ */
+static void test_slow_start_ramp(void **state) {
+    (void) state;
+
+    SlowStart ss;
+    slow_start_init(&ss, 1, 100000, 500000, 6000000);
+    assert_true(ss.active);
+    assert_int_equal(ss.bitrate, 500000);  // Clamped to min_bitrate
+
+    // One doubling per round, the round is at least SLOW_START_MIN_ROUND
+    assert_int_equal(slow_start_step(&ss, 0, 40.0, 1000, 6000000), 500000);
+    assert_int_equal(slow_start_step(&ss, 0, 40.0, 1000 + SLOW_START_MIN_ROUND - 20, 6000000), 500000);
+    assert_int_equal(slow_start_step(&ss, 0, 40.0, 1000 + SLOW_START_MIN_ROUND, 6000000), 1000000);
+    assert_int_equal(slow_start_step(&ss, 0, 40.0, 1000 + 2 * SLOW_START_MIN_ROUND, 6000000), 2000000);
+
+    // Congestion falls back to the last bitrate that completed a round
+    assert_int_equal(slow_start_step(&ss, 1, 40.0, 1000 + 2 * SLOW_START_MIN_ROUND + 20, 6000000), 1000000);
+    assert_false(ss.active);
+    assert_int_equal(slow_start_step(&ss, 0, 40.0, 5000, 6000000), 1000000);
+
+    // Ends after max_bitrate completes a round
+    slow_start_init(&ss, 1, 4000000, 500000, 6000000);
+    assert_int_equal(slow_start_step(&ss, 0, 40.0, 1000, 6000000), 4000000);
+    assert_int_equal(slow_start_step(&ss, 0, 40.0, 1500, 6000000), 6000000);
+    assert_true(ss.active);
+    slow_start_step(&ss, 0, 40.0, 2000, 6000000);
+    assert_false(ss.active);
+
+    // Disabled: start at max_bitrate
+    slow_start_init(&ss, 0, 1000000, 500000, 6000000);
+    assert_false(ss.active);
+    assert_int_equal(ss.bitrate, 6000000);
+}
+
+/*
+ * Run the balancer against a simulated bottleneck link from startup
+ *
+ * Returns the time (ms) after which the bitrate stays within 60-110% of the
+ * link capacity for the rest of the run.
+ */
+static int sim_time_to_stable(const char *algo, int slow_start, int capacity,
+                              int *emergencies, double *peak_rtt) {
+    BelacoderConfig cfg;
+    config_init_defaults(&cfg);
+    cfg.min_bitrate = 500;
+    cfg.max_bitrate = 6000;
+    cfg.slow_start = slow_start;
+
+    BalancerRunner runner;
+    assert_int_equal(balancer_runner_init(&runner, &cfg, algo, 2000, 1316), 0);
+    LinkSim sim;
+    link_sim_init(&sim, capacity, 60.0, 1000.0, 1316);
+
+    int bitrate = balancer_runner_get_bitrate(&runner);
+    int unstable_until = 0;
+    *emergencies = 0;
+    *peak_rtt = 0;
+    for (int t = 0; t < 30000; t += 20) {
+        BalancerInput input = link_sim_step(&sim, bitrate, 20);
+        BalancerOutput output = balancer_runner_step(&runner, &input);
+        bitrate = output.new_bitrate;
+
+        if (output.reason == BALANCER_REASON_EMERGENCY_RTT ||
+            output.reason == BALANCER_REASON_EMERGENCY_BUFFER) {
+            (*emergencies)++;
+        }
+        if (input.rtt > *peak_rtt) *peak_rtt = input.rtt;
+        if (bitrate < capacity * 0.6 || bitrate > capacity * 1.1) {
+            unstable_until = t + 20;
+        }
+    }
+
+    balancer_runner_cleanup(&runner);
+    return unstable_until;
+}
+
+/*
+ * Test: Slow start settles faster than starting at max_bitrate
+ *
+ * On a 2 Mbps link with max_bitrate at 6 Mbps, starting at max builds a
+ * queue until the emergency drop to min_bitrate and then recovers slowly.
+ * Slow start overshoots by at most one doubling.
+ */
+static void test_slow_start_time_to_stable(void **state) {
+    (void) state;
+
+    int ss_emergencies, max_emergencies;
+    double ss_peak_rtt, max_peak_rtt;
+    int ss_time = sim_time_to_stable("adaptive", 1, 2000000, &ss_emergencies, &ss_peak_rtt);
+    int max_time = sim_time_to_stable("adaptive", 0, 2000000, &max_emergencies, &max_peak_rtt);
+    fprintf(stderr, "  2 Mbps link: slow start stable after %d ms (peak RTT %.0f ms), "
+            "max_bitrate start after %d ms (peak RTT %.0f ms)\n",
+            ss_time, ss_peak_rtt, max_time, max_peak_rtt);
+
+    assert_true(ss_time < max_time);
+    assert_true(ss_time <= 2000);
+    assert_int_equal(ss_emergencies, 0);
+    assert_true(max_emergencies > 0);
+    assert_true(ss_peak_rtt < max_peak_rtt);
+
+    // A 3 Mbps link: no emergency either way, but a much smaller queue
+    ss_time = sim_time_to_stable("adaptive", 1, 3000000, &ss_emergencies, &ss_peak_rtt);
+    sim_time_to_stable("adaptive", 0, 3000000, &max_emergencies, &max_peak_rtt);
+    assert_true(ss_time <= 2000);
+    assert_true(ss_peak_rtt * 2 < max_peak_rtt);
+}
+
+/*
+ * Test: Bounds updates resume from the current bitrate
+ */
+static void test_slow_start_update_bounds(void **state) {
+    (void) state;
+
+    BelacoderConfig cfg;
+    config_init_defaults(&cfg);
+    cfg.min_bitrate = 500;
+    cfg.max_bitrate = 6000;
+
+    BalancerRunner runner;
+    assert_int_equal(balancer_runner_init(&runner, &cfg, "aimd", 2000, 1316), 0);
+    assert_int_equal(balancer_runner_get_bitrate(&runner), 1000000);
+
+    BalancerInput input = { .buffer_size = 10, .rtt = 40.0, .send_rate_mbps = 2.0, .timestamp = 1000 };
+    BalancerOutput out = balancer_runner_step(&runner, &input);
+    assert_int_equal(out.reason, BALANCER_REASON_SLOW_START);
+    input.timestamp += SLOW_START_MIN_ROUND;
+    out = balancer_runner_step(&runner, &input);
+    assert_int_equal(out.new_bitrate, 2000000);
+
+    // Not back to 1 Mbps, nor up to the new max_bitrate at once
+    balancer_runner_update_bounds(&runner, 500000, 8000000);
+    assert_int_equal(balancer_runner_get_bitrate(&runner), 2000000);
+
+    // Without slow start the old behaviour is kept
+    balancer_runner_cleanup(&runner);
+    cfg.slow_start = 0;
+    assert_int_equal(balancer_runner_init(&runner, &cfg, "aimd", 2000, 1316), 0);
+    assert_int_equal(balancer_runner_get_bitrate(&runner), 6000000);
+    balancer_runner_cleanup(&runner);
+}
+
+/*
+ * Test: Windowed min matches a brute force minimum over the window
+ */
+static void test_windowed_min(void **state) {
+    (void) state;
+
+    static double values[2000];
+    WindowedMin wm;
+    windowed_min_init(&wm, 1000);
+    assert_true(windowed_min_get(&wm, 200.0) == 200.0);
+
+    unsigned int seed = 1;
+    for (int i = 0; i < 2000; i++) {
+        seed = seed * 1103515245 + 12345;
+        // Noise on a slow sawtooth, so both rising and falling runs occur
+        values[i] = 40.0 + (i % 300) / 5.0 + (seed >> 16) % 20;
+        uint64_t ts = (uint64_t)i * 20;
+        double got = windowed_min_update(&wm, values[i], ts);
+
+        double expected = values[i];
+        for (int j = i; j >= 0 && (uint64_t)j * 20 + 1000 > ts; j--) {
+            if (values[j] < expected) expected = values[j];
+        }
+        assert_true(got == expected);
+    }
+    assert_in_range(wm.count, 1, 50);
+
+    windowed_min_reset(&wm);
+    assert_true(windowed_min_get(&wm, 200.0) == 200.0);
+}
+
+/*
+ * Test: RTT change detector confirms steps, not ramps or spikes
+ */
+static void test_rtt_change_detector(void **state) {
+    (void) state;
+
+    RttChangeDetector det;
+    rtt_change_init(&det);
+
+    // Flat: nothing
+    for (int i = 0; i < 100; i++) {
+        assert_int_equal(rtt_change_update(&det, 40.0, 1.0), 0);
+    }
+
+    // Step 40 -> 120 ms: confirmed after RTT_CHANGE_CONFIRM flat samples
+    int confirmed_at = -1;
+    for (int i = 0; i < 50 && confirmed_at < 0; i++) {
+        if (rtt_change_update(&det, 120.0, 1.0) == 1) confirmed_at = i;
+    }
+    assert_in_range(confirmed_at, RTT_CHANGE_CONFIRM - 1, RTT_CHANGE_CONFIRM + 2);
+    assert_true(det.level == 120.0);
+    assert_true(det.min == 120.0);
+
+    // And back down
+    confirmed_at = -1;
+    for (int i = 0; i < 50 && confirmed_at < 0; i++) {
+        if (rtt_change_update(&det, 40.0, 1.0) == -1) confirmed_at = i;
+    }
+    assert_true(confirmed_at >= 0);
+
+    // Queue building up: 3 ms per sample, then a plateau
+    rtt_change_init(&det);
+    for (int i = 0; i < 300; i++) {
+        double rtt = i < 60 ? 40.0 + i * 3 : 220.0;
+        assert_int_equal(rtt_change_update(&det, rtt, 1.0), 0);
+    }
+
+    // Single spike settling back at the baseline
+    rtt_change_init(&det);
+    assert_int_equal(rtt_change_update(&det, 40.0, 1.0), 0);
+    assert_int_equal(rtt_change_update(&det, 400.0, 1.0), 0);
+    for (int i = 0; i < 300; i++) {
+        assert_int_equal(rtt_change_update(&det, 40.0, 1.0), 0);
+    }
+}
+
+/*
+ * Run the adaptive balancer through a handover at 20 s from a 3 Mbps link
+ * with a 40 ms RTT to a 5 Mbps link with a 120 ms RTT
+ *
+ * Returns the time (ms) from the handover until the bitrate reaches 90% of
+ * the new capacity, or -1.
+ */
+static int sim_handover_recovery(int rtt_change_detect, uint64_t *rtt_changes_up) {
+    BelacoderConfig cfg;
+    config_init_defaults(&cfg);
+    cfg.min_bitrate = 500;
+    cfg.max_bitrate = 6000;
+    cfg.adaptive.rtt_change_detect = rtt_change_detect;
+
+    BalancerRunner runner;
+    assert_int_equal(balancer_runner_init(&runner, &cfg, "adaptive", 2000, 1316), 0);
+    LinkSim sim;
+    link_sim_init(&sim, 3000000, 40.0, 1000.0, 1316);
+
+    int bitrate = balancer_runner_get_bitrate(&runner);
+    int recovered = -1;
+    for (int t = 0; t < 60000 && recovered < 0; t += 20) {
+        if (t == 20000) {
+            sim.capacity = 5000000;
+            sim.base_rtt = 120.0;
+        }
+        BalancerInput input = link_sim_step(&sim, bitrate, 20);
+        bitrate = balancer_runner_step(&runner, &input).new_bitrate;
+        if (t >= 20000 && bitrate >= 4500000) recovered = t - 20000;
+    }
+
+    *rtt_changes_up = runner.telemetry.rtt_changes_up;
+    balancer_runner_cleanup(&runner);
+    return recovered;
+}
+
+/*
+ * Test: The RTT baseline follows a handover instead of blocking increases
+ */
+static void test_handover_recovery(void **state) {
+    (void) state;
+
+    uint64_t changes_detect, changes_drift;
+    int with_detect = sim_handover_recovery(1, &changes_detect);
+    int without = sim_handover_recovery(0, &changes_drift);
+    fprintf(stderr, "  Handover: recovered after %d ms with RTT change detection, "
+            "%d ms without\n", with_detect, without);
+
+    assert_true(with_detect >= 0);
+    assert_true(without < 0 || with_detect * 2 < without);
+    assert_int_equal(changes_detect, 1);
+    assert_int_equal(changes_drift, 0);
+}
+
+/*
+ * Test: A scene cut holds increases while its burst goes out
+ *
+ * With the network able to take more, both adaptive and AIMD keep raising
+ * the bitrate; a scene cut hint pauses that for BALANCER_SCENE_HOLD.
+ */
+static void test_scene_cut_holds_increase(void **state) {
+    (void) state;
+
+    const char *algos[] = { "adaptive", "aimd" };
+    for (int a = 0; a < 2; a++) {
+        BelacoderConfig cfg;
+        config_init_defaults(&cfg);
+        cfg.min_bitrate = 500;
+        cfg.max_bitrate = 20000;
+        cfg.slow_start = 0;
+        strcpy(cfg.balancer, algos[a]);
+
+        BalancerRunner runner;
+        assert_int_equal(balancer_runner_init(&runner, &cfg, NULL, 2000, 1316), 0);
+
+        // Knock the bitrate down, then let it climb on a clean link
+        BalancerInput input = {
+            .buffer_size = 300,
+            .rtt = 600.0,
+            .send_rate_mbps = 2.0,
+            .timestamp = 1000
+        };
+        for (int i = 0; i < 20; i++) {
+            input.timestamp += 250;
+            balancer_runner_step(&runner, &input);
+        }
+        input.buffer_size = 5;
+        input.rtt = 30.0;
+        input.send_rate_mbps = 10.0;
+        for (int i = 0; i < 100; i++) {
+            input.timestamp += 20;
+            balancer_runner_step(&runner, &input);
+        }
+
+        // Cut: no increase for the hold period
+        input.scene_cut = 1;
+        input.timestamp += 20;
+        int held = balancer_runner_step(&runner, &input).new_bitrate;
+        input.scene_cut = 0;
+        uint64_t cut_ts = input.timestamp;
+        while (input.timestamp + 20 < cut_ts + BALANCER_SCENE_HOLD) {
+            input.timestamp += 20;
+            assert_true(balancer_runner_step(&runner, &input).new_bitrate <= held);
+        }
+
+        // Climbing again afterwards
+        int after = 0;
+        for (int i = 0; i < 100; i++) {
+            input.timestamp += 20;
+            after = balancer_runner_step(&runner, &input).new_bitrate;
+        }
+        assert_true(after > held);
+
+        balancer_runner_cleanup(&runner);
+    }
+}
+
+/*
+ * Test: A static scene ceiling lowers the bitrate, lifting it restores
+ * the bitrate from before at once
+ */
+static void test_content_ceiling(void **state) {
+    (void) state;
+
+    const char *algos[] = { "adaptive", "aimd" };
+    for (int a = 0; a < 2; a++) {
+        BelacoderConfig cfg;
+        config_init_defaults(&cfg);
+        cfg.min_bitrate = 500;
+        cfg.max_bitrate = 6000;
+        cfg.slow_start = 0;
+        strcpy(cfg.balancer, algos[a]);
+
+        BalancerRunner runner;
+        assert_int_equal(balancer_runner_init(&runner, &cfg, NULL, 2000, 1316), 0);
+
+        // Clean link, at max_bitrate
+        BalancerInput input = {
+            .buffer_size = 5,
+            .rtt = 30.0,
+            .send_rate_mbps = 6.0,
+            .timestamp = 1000
+        };
+        for (int i = 0; i < 50; i++) {
+            input.timestamp += 20;
+            balancer_runner_step(&runner, &input);
+        }
+        assert_int_equal(balancer_runner_get_bitrate(&runner), 6000000);
+
+        // Ceiling: lowered at once, and held there
+        input.ceiling = 1500000;
+        input.timestamp += 20;
+        BalancerOutput out = balancer_runner_step(&runner, &input);
+        assert_int_equal(out.new_bitrate, 1500000);
+        assert_int_equal(out.reason, BALANCER_REASON_CONTENT_CAP);
+        for (int i = 0; i < 100; i++) {
+            input.timestamp += 20;
+            assert_int_equal(balancer_runner_step(&runner, &input).new_bitrate, 1500000);
+        }
+
+        // Never below min_bitrate
+        input.ceiling = 100000;
+        input.timestamp += 20;
+        assert_int_equal(balancer_runner_step(&runner, &input).new_bitrate, 500000);
+
+        // Lifted: straight back up
+        input.ceiling = 0;
+        input.timestamp += 20;
+        out = balancer_runner_step(&runner, &input);
+        assert_int_equal(out.new_bitrate, 6000000);
+        assert_int_equal(out.reason, BALANCER_REASON_INCREASE);
+
+        // Congestion under the ceiling: no jump back when it lifts
+        input.ceiling = 1500000;
+        input.timestamp += 20;
+        balancer_runner_step(&runner, &input);
+        input.rtt = 600.0;
+        input.buffer_size = 300;
+        input.timestamp += 20;
+        balancer_runner_step(&runner, &input);
+        input.rtt = 30.0;
+        input.buffer_size = 5;
+        input.ceiling = 0;
+        input.timestamp += 20;
+        assert_true(balancer_runner_step(&runner, &input).new_bitrate <= 1500000);
+
+        balancer_runner_cleanup(&runner);
+    }
+}
+
 int main(void) {
     const struct CMUnitTest tests[] = {
         cmocka_unit_test(test_adaptive_recovers_on_good_network),
@@ -428,6 +1158,20 @@ int main(void) {
         cmocka_unit_test(test_balancer_respects_bounds),
         cmocka_unit_test(test_packet_loss_triggers_reduction),
         cmocka_unit_test(test_min_equals_max_fixed_range),
+        cmocka_unit_test(test_random_loss_ignored),
+        cmocka_unit_test(test_congestive_loss_detected),
+        cmocka_unit_test(test_decision_reasons),
+        cmocka_unit_test(test_telemetry_state_time),
+        cmocka_unit_test(test_slow_start_ramp),
+        cmocka_unit_test(test_slow_start_time_to_stable),
+        cmocka_unit_test(test_slow_start_update_bounds),
+        cmocka_unit_test(test_windowed_min),
+        cmocka_unit_test(test_rtt_change_detector),
+        cmocka_unit_test(test_handover_recovery),
+        cmocka_unit_test(test_scene_cut_holds_increase),
+        cmocka_unit_test(test_content_ceiling),
+        cmocka_unit_test(test_core_api_matches_runner),
+        cmocka_unit_test(test_core_api_options),
     };
 
     return cmocka_run_group_tests(tests, NULL, NULL);
@@ -0,0 +1,591 @@
+/*
+    ceracoder - live video encoder with dynamic bitrate control
+    Copyright (C) 2020 BELABOX project
+    Copyright (C) 2026 CERALIVE
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * End-to-end tests over an impaired link
+ *
+ * The SRT sender runs the same loop as ceracoder without GStreamer: every
+ * 20 ms it feeds the SRT stats to the balancer, and it sends paced payloads
+ * at the balancer bitrate. The payloads go through the UDP impairment proxy
+ * (udp_proxy.h) to a local SRT listener, which measures the goodput and the
+ * send to receive latency from a timestamp in each payload.
+ *
+ * Test structure:
+ * 1. Impairment model: loss, bursts, rate limit, rate trace, reordering
+ * 2. UDP proxy: delay and ordering over the loopback
+ * 3. SRT + balancer: throughput and latency for each balancer
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include <srt.h>
+#include "srt_client.h"
+#include "balancer_runner.h"
+#include "config.h"
+#include "impair.h"
+#include "udp_proxy.h"
+
+#define E2E_PORT 19940
+#define E2E_PKT_SIZE 1316
+#define E2E_LATENCY 1000          // SRT latency (ms)
+#define E2E_UPDATE_INT 20         // Balancer update interval (ms), as in ceracoder
+#define E2E_DURATION 20000        // Run length (ms)
+#define E2E_WARMUP 8000           // Not measured, while the balancer converges (ms)
+#define E2E_MAX_LATENCY 10000     // Latency histogram range (ms)
+
+static int64_t now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/*
+ * Impairment model
+ */
+
+static void test_impair_bernoulli_loss(void **state) {
+    (void)state;
+
+    ImpairConfig cfg;
+    impair_config_init(&cfg);
+    cfg.loss = 0.05;
+    Impair im;
+    impair_init(&im, &cfg);
+
+    for (int i = 0; i < 100000; i++) {
+        impair_packet(&im, i * 1000, E2E_PKT_SIZE);
+    }
+    assert_true(im.lost > 4500 && im.lost < 5500);
+    assert_int_equal(im.queue_drops, 0);
+}
+
+static void test_impair_gilbert_elliott_bursts(void **state) {
+    (void)state;
+
+    // Mean bad state length 1 / 0.25 = 4 packets, all lost
+    ImpairConfig cfg;
+    impair_config_init(&cfg);
+    cfg.ge_p_bad = 0.01;
+    cfg.ge_p_good = 0.25;
+    cfg.ge_loss_good = 0;
+    cfg.ge_loss_bad = 1;
+    Impair im;
+    impair_init(&im, &cfg);
+
+    int bursts = 0;
+    int prev_lost = 0;
+    for (int i = 0; i < 100000; i++) {
+        int lost = impair_packet(&im, i * 1000, E2E_PKT_SIZE) < 0;
+        if (lost && !prev_lost) bursts++;
+        prev_lost = lost;
+    }
+    double mean_burst = (double)im.lost / bursts;
+    assert_true(mean_burst > 3.0 && mean_burst < 5.0);
+
+    // Stationary loss rate p_bad / (p_bad + p_good) = 3.8%
+    assert_true(im.lost > 3000 && im.lost < 4700);
+}
+
+static void test_impair_rate_limit(void **state) {
+    (void)state;
+
+    // Offer 4 Mbps to a 2 Mbps link with a 100 ms queue and 30 ms of delay
+    ImpairConfig cfg;
+    impair_config_init(&cfg);
+    cfg.rate_kbps = 2000;
+    cfg.queue_ms = 100;
+    cfg.delay_ms = 30;
+    Impair im;
+    impair_init(&im, &cfg);
+
+    int64_t interval_us = (int64_t)E2E_PKT_SIZE * 8 * 1000 / 4000;
+    int64_t last_deliver = 0;
+    int64_t max_delay = 0;
+    int delivered = 0;
+    for (int i = 0; i < 4000; i++) {
+        int64_t t = i * interval_us;
+        int64_t deliver = impair_packet(&im, t, E2E_PKT_SIZE);
+        if (deliver < 0) continue;
+        assert_true(deliver >= t + 30000);
+        if (deliver - t > max_delay) max_delay = deliver - t;
+        last_deliver = deliver;
+        delivered++;
+    }
+
+    // Half gets through at the link rate, queueing is bounded by the limit
+    double kbps = (double)delivered * E2E_PKT_SIZE * 8 / (last_deliver / 1000.0);
+    assert_true(kbps > 1900 && kbps < 2100);
+    assert_true(im.queue_drops > 1800 && im.queue_drops < 2200);
+    assert_true(max_delay <= (30 + 100) * 1000 + interval_us * 2);
+}
+
+static void test_impair_rate_trace(void **state) {
+    (void)state;
+
+    ImpairConfig cfg;
+    impair_config_init(&cfg);
+    assert_int_equal(impair_add_trace(&cfg, 1000, 4000), 0);
+    assert_int_equal(impair_add_trace(&cfg, 500, 0), 0);      // Outage
+    assert_int_equal(impair_add_trace(&cfg, 1000, 1000), 0);
+    Impair im;
+    impair_init(&im, &cfg);
+
+    impair_packet(&im, 0, E2E_PKT_SIZE);
+    assert_int_equal(impair_rate(&im, 999999), 4000);
+    assert_int_equal(impair_rate(&im, 1200000), 0);
+    assert_int_equal(impair_rate(&im, 2000000), 1000);
+    assert_int_equal(impair_rate(&im, 2600000), 4000);          // Repeats
+
+    // Everything sent during the outage is dropped
+    uint64_t drops = im.queue_drops;
+    for (int i = 0; i < 10; i++) {
+        assert_true(impair_packet(&im, 3600000 + i * 10000, E2E_PKT_SIZE) < 0);
+    }
+    assert_int_equal(im.queue_drops - drops, 10);
+}
+
+static void test_impair_reorder(void **state) {
+    (void)state;
+
+    ImpairConfig cfg;
+    impair_config_init(&cfg);
+    cfg.delay_ms = 20;
+    cfg.jitter_ms = 10;
+    cfg.reorder = 0.02;
+    cfg.reorder_ms = 15;
+    Impair im;
+    impair_init(&im, &cfg);
+
+    int64_t prev = 0;
+    int out_of_order = 0;
+    for (int i = 0; i < 10000; i++) {
+        int64_t deliver = impair_packet(&im, i * 1000, E2E_PKT_SIZE);
+        assert_true(deliver >= i * 1000 + 20000);
+        if (deliver < prev) out_of_order++;
+        if (deliver > prev) prev = deliver;
+    }
+
+    // Jitter alone never reorders, held back packets are overtaken
+    assert_true(im.reordered > 150 && im.reordered < 250);
+    assert_int_equal(im.lost, 0);
+    assert_true(out_of_order > 0);
+}
+
+/*
+ * UDP proxy
+ */
+
+static int udp_socket(int port) {
+    int sock = socket(AF_INET, SOCK_DGRAM, 0);
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+    if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        close(sock);
+        return -1;
+    }
+    struct timeval tv = { .tv_sec = 1, .tv_usec = 0 };
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    return sock;
+}
+
+static void test_udp_proxy_delay(void **state) {
+    (void)state;
+
+    int target = udp_socket(E2E_PORT);
+    int sender = udp_socket(0);
+    assert_true(target >= 0 && sender >= 0);
+
+    UdpProxyConfig cfg;
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.listen_port = E2E_PORT + 1;
+    cfg.target_port = E2E_PORT;
+    impair_config_init(&cfg.impair[UDP_PROXY_FORWARD]);
+    impair_config_init(&cfg.impair[UDP_PROXY_REVERSE]);
+    cfg.impair[UDP_PROXY_FORWARD].delay_ms = 30;
+    cfg.impair[UDP_PROXY_REVERSE].delay_ms = 10;
+
+    UdpProxy proxy;
+    assert_int_equal(udp_proxy_start(&proxy, &cfg), 0);
+
+    struct sockaddr_in proxy_addr;
+    memset(&proxy_addr, 0, sizeof(proxy_addr));
+    proxy_addr.sin_family = AF_INET;
+    proxy_addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    proxy_addr.sin_port = htons(E2E_PORT + 1);
+
+    // Forward: 100 datagrams, in order, each at least 30 ms late
+    for (int i = 0; i < 100; i++) {
+        int64_t buf[2] = { i, now_us() };
+        sendto(sender, buf, sizeof(buf), 0, (struct sockaddr *)&proxy_addr, sizeof(proxy_addr));
+        usleep(1000);
+    }
+    struct sockaddr_in from;
+    socklen_t fromlen = sizeof(from);
+    for (int i = 0; i < 100; i++) {
+        int64_t buf[2];
+        fromlen = sizeof(from);
+        assert_int_equal(recvfrom(target, buf, sizeof(buf), 0, (struct sockaddr *)&from, &fromlen),
+                         sizeof(buf));
+        assert_int_equal(buf[0], i);
+        assert_true(now_us() - buf[1] >= 30000);
+    }
+
+    // Reverse: replies reach the sender
+    int64_t reply[2] = { -1, now_us() };
+    sendto(target, reply, sizeof(reply), 0, (struct sockaddr *)&from, fromlen);
+    int64_t buf[2];
+    assert_int_equal(recv(sender, buf, sizeof(buf), 0), sizeof(buf));
+    assert_int_equal(buf[0], -1);
+    assert_true(now_us() - buf[1] >= 10000);
+
+    Impair counters;
+    udp_proxy_get_counters(&proxy, UDP_PROXY_FORWARD, &counters);
+    assert_int_equal(counters.packets, 100);
+
+    udp_proxy_stop(&proxy);
+    close(target);
+    close(sender);
+}
+
+/*
+ * SRT + balancer over the proxy
+ */
+
+typedef struct {
+    int port;
+    volatile int running;
+    volatile int ready;
+    volatile int64_t window_start_us;   // Measure from here, 0 = not yet
+    pthread_t thread;
+
+    // Results, valid after the thread is joined
+    uint64_t bytes;                     // Received in the window
+    int64_t first_us;
+    int64_t last_us;
+    uint64_t received;                  // Payloads received in the window
+    uint64_t missing;                   // Sequence gaps in the window (too late drops)
+    uint32_t latency_ms[E2E_MAX_LATENCY + 1];
+} E2eReceiver;
+
+static void *e2e_receiver_thread(void *arg) {
+    E2eReceiver *rx = (E2eReceiver *)arg;
+
+    SRTSOCKET listener = srt_create_socket();
+    int latency = E2E_LATENCY;
+    srt_setsockflag(listener, SRTO_LATENCY, &latency, sizeof(latency));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(rx->port);
+    if (srt_bind(listener, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+        srt_listen(listener, 1) != 0) {
+        fprintf(stderr, "Receiver: %s\n", srt_getlasterror_str());
+        srt_close(listener);
+        return NULL;
+    }
+    rx->ready = 1;
+
+    int epid = srt_epoll_create();
+    int events = SRT_EPOLL_IN;
+    srt_epoll_add_usock(epid, listener, &events);
+    SRTSOCKET ready[2];
+    int rlen = 2;
+    if (srt_epoll_wait(epid, ready, &rlen, NULL, NULL, 5000, NULL, NULL, NULL, NULL) < 0) {
+        srt_epoll_release(epid);
+        srt_close(listener);
+        return NULL;
+    }
+    SRTSOCKET client = srt_accept(listener, NULL, NULL);
+    srt_epoll_release(epid);
+
+    int timeout = 200;
+    srt_setsockflag(client, SRTO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    char buf[2048];
+    int64_t prev_seq = -1;
+    while (rx->running) {
+        int len = srt_recv(client, buf, sizeof(buf));
+        if (len < 0) {
+            if (srt_getsockstate(client) >= SRTS_BROKEN) break;
+            continue;
+        }
+        if (len < 16) continue;
+
+        int64_t t = now_us();
+        int64_t sent_us, seq;
+        memcpy(&sent_us, buf, sizeof(sent_us));
+        memcpy(&seq, buf + 8, sizeof(seq));
+
+        int64_t start = rx->window_start_us;
+        if (start > 0 && t >= start) {
+            if (rx->first_us == 0) rx->first_us = t;
+            rx->last_us = t;
+            rx->bytes += len;
+            rx->received++;
+            if (prev_seq >= 0 && seq > prev_seq + 1) rx->missing += seq - prev_seq - 1;
+
+            int64_t ms = (t - sent_us) / 1000;
+            if (ms < 0) ms = 0;
+            if (ms > E2E_MAX_LATENCY) ms = E2E_MAX_LATENCY;
+            rx->latency_ms[ms]++;
+        }
+        prev_seq = seq;
+    }
+
+    srt_close(client);
+    srt_close(listener);
+    return NULL;
+}
+
+static int latency_quantile(const E2eReceiver *rx, double q) {
+    uint64_t target = (uint64_t)(q * rx->received);
+    uint64_t seen = 0;
+    for (int ms = 0; ms <= E2E_MAX_LATENCY; ms++) {
+        seen += rx->latency_ms[ms];
+        if (seen > target) return ms;
+    }
+    return E2E_MAX_LATENCY;
+}
+
+typedef struct {
+    double goodput_kbps;
+    int latency_p50;
+    int latency_p95;
+    double missing_ratio;
+    int final_bitrate;      // bps
+} E2eResult;
+
+/*
+ * Stream for E2E_DURATION ms through a proxy with the given forward
+ * impairment, with the bitrate driven by the named balancer
+ */
+static int run_e2e(const char *balancer, int min_kbps, int max_kbps,
+                   const ImpairConfig *forward, int port, E2eResult *result) {
+    E2eReceiver *rx = calloc(1, sizeof(*rx));
+    rx->port = port;
+    rx->running = 1;
+    pthread_create(&rx->thread, NULL, e2e_receiver_thread, rx);
+    for (int i = 0; i < 50 && !rx->ready; i++) usleep(100000);
+
+    UdpProxyConfig pcfg;
+    memset(&pcfg, 0, sizeof(pcfg));
+    pcfg.listen_port = port + 1;
+    pcfg.target_port = port;
+    pcfg.impair[UDP_PROXY_FORWARD] = *forward;
+    impair_config_init(&pcfg.impair[UDP_PROXY_REVERSE]);
+    pcfg.impair[UDP_PROXY_REVERSE].delay_ms = forward->delay_ms;
+
+    UdpProxy proxy;
+    int ret = -1;
+    if (!rx->ready || udp_proxy_start(&proxy, &pcfg) != 0) goto stop_rx;
+
+    char port_str[16];
+    snprintf(port_str, sizeof(port_str), "%d", port + 1);
+    SrtClient client;
+    if (srt_client_connect(&client, "127.0.0.1", port_str, NULL, E2E_LATENCY, E2E_PKT_SIZE) != 0) {
+        goto stop_proxy;
+    }
+
+    BelacoderConfig cfg;
+    config_init_defaults(&cfg);
+    cfg.min_bitrate = min_kbps;
+    cfg.max_bitrate = max_kbps;
+    strcpy(cfg.balancer, balancer);
+    BalancerRunner runner;
+    if (balancer_runner_init(&runner, &cfg, NULL, client.latency, E2E_PKT_SIZE) != 0) {
+        srt_client_close(&client);
+        goto stop_proxy;
+    }
+
+    int bitrate = balancer_runner_get_bitrate(&runner);
+    int64_t start = now_us();
+    int64_t last_update = start;
+    int64_t last_send = start;
+    double credit = 0;
+    int64_t seq = 0;
+    char pkt[E2E_PKT_SIZE];
+    memset(pkt, 0, sizeof(pkt));
+
+    for (int64_t t = start; t - start < (int64_t)E2E_DURATION * 1000; t = now_us()) {
+        if (rx->window_start_us == 0 && t - start >= (int64_t)E2E_WARMUP * 1000) {
+            rx->window_start_us = t;
+        }
+
+        // Balancer tick, as in connection_housekeeping() / do_bitrate_update()
+        if (t - last_update >= E2E_UPDATE_INT * 1000) {
+            last_update = t;
+            SRT_TRACEBSTATS stats;
+            int bs = -1;
+            int sz = sizeof(bs);
+            if (srt_client_get_stats(&client, &stats) == 0 &&
+                srt_client_get_sockopt(&client, SRTO_SNDDATA, &bs, &sz) == 0 && bs >= 0) {
+                BalancerInput input = {
+                    .buffer_size = bs,
+                    .rtt = stats.msRTT,
+                    .send_rate_mbps = stats.mbpsSendRate,
+                    .timestamp = (uint64_t)((t - start) / 1000),
+                    .pkt_loss_total = stats.pktSndLossTotal,
+                    .pkt_retrans_total = stats.pktRetransTotal
+                };
+                bitrate = balancer_runner_step(&runner, &input).new_bitrate;
+            }
+        }
+
+        // Paced sending at the balancer bitrate, like an encoder with a perfect rate control
+        credit += (double)bitrate / 8 * (t - last_send) / 1000000.0;
+        last_send = t;
+        if (credit > 4 * E2E_PKT_SIZE) credit = 4 * E2E_PKT_SIZE;
+        while (credit >= E2E_PKT_SIZE) {
+            int64_t sent_us = now_us();
+            memcpy(pkt, &sent_us, sizeof(sent_us));
+            memcpy(pkt + 8, &seq, sizeof(seq));
+            if (srt_client_send(&client, pkt, E2E_PKT_SIZE) != E2E_PKT_SIZE) goto done;
+            seq++;
+            credit -= E2E_PKT_SIZE;
+        }
+        usleep(1000);
+    }
+    ret = 0;
+
+done:
+    // Let the last payloads arrive before stopping the receiver
+    usleep((E2E_LATENCY + 200) * 1000);
+    result->final_bitrate = bitrate;
+    balancer_runner_cleanup(&runner);
+    srt_client_close(&client);
+
+stop_proxy:
+    udp_proxy_stop(&proxy);
+stop_rx:
+    rx->running = 0;
+    pthread_join(rx->thread, NULL);
+
+    if (ret == 0) {
+        double secs = (rx->last_us - rx->first_us) / 1000000.0;
+        result->goodput_kbps = secs > 0 ? rx->bytes * 8 / secs / 1000 : 0;
+        result->latency_p50 = latency_quantile(rx, 0.50);
+        result->latency_p95 = latency_quantile(rx, 0.95);
+        uint64_t expected = rx->received + rx->missing;
+        result->missing_ratio = expected > 0 ? (double)rx->missing / expected : 1;
+        fprintf(stderr, "  %s: goodput %.0f Kbps, latency p50 %d ms / p95 %d ms, "
+                "missing %.2f%%, final bitrate %d Kbps\n",
+                balancer, result->goodput_kbps, result->latency_p50, result->latency_p95,
+                result->missing_ratio * 100, result->final_bitrate / 1000);
+    }
+    free(rx);
+    return ret;
+}
+
+// 3 Mbps bottleneck with a 300 ms queue, 40 ms RTT, jitter and bursty loss
+static void e2e_link(ImpairConfig *cfg) {
+    impair_config_init(cfg);
+    cfg->rate_kbps = 3000;
+    cfg->queue_ms = 300;
+    cfg->delay_ms = 20;
+    cfg->jitter_ms = 5;
+    cfg->ge_p_bad = 0.002;
+    cfg->ge_p_good = 0.3;
+    cfg->ge_loss_good = 0;
+    cfg->ge_loss_bad = 0.5;
+}
+
+static void assert_e2e_latency(const E2eResult *r) {
+    // SRT delivers at the send time plus the latency; later payloads are dropped
+    assert_true(r->latency_p50 >= E2E_LATENCY - 100);
+    assert_true(r->latency_p95 <= E2E_LATENCY + 250);
+    assert_true(r->missing_ratio < 0.02);
+}
+
+static void test_e2e_adaptive(void **state) {
+    (void)state;
+
+    ImpairConfig link;
+    e2e_link(&link);
+    E2eResult r;
+    assert_int_equal(run_e2e("adaptive", 500, 6000, &link, E2E_PORT + 10, &r), 0);
+
+    // Converges below the bottleneck without giving most of it up
+    assert_true(r.goodput_kbps > 0.4 * link.rate_kbps);
+    assert_true(r.goodput_kbps < 1.05 * link.rate_kbps);
+    assert_e2e_latency(&r);
+}
+
+static void test_e2e_aimd(void **state) {
+    (void)state;
+
+    ImpairConfig link;
+    e2e_link(&link);
+    E2eResult r;
+    assert_int_equal(run_e2e("aimd", 500, 6000, &link, E2E_PORT + 20, &r), 0);
+
+    assert_true(r.goodput_kbps > 0.4 * link.rate_kbps);
+    assert_true(r.goodput_kbps < 1.05 * link.rate_kbps);
+    assert_e2e_latency(&r);
+}
+
+static void test_e2e_fixed(void **state) {
+    (void)state;
+
+    // Fixed at max_bitrate, below the bottleneck
+    ImpairConfig link;
+    e2e_link(&link);
+    E2eResult r;
+    assert_int_equal(run_e2e("fixed", 500, 2000, &link, E2E_PORT + 30, &r), 0);
+
+    assert_int_equal(r.final_bitrate, 2000 * 1000);
+    assert_true(r.goodput_kbps > 1800 && r.goodput_kbps < 2200);
+    assert_e2e_latency(&r);
+}
+
+int main(void) {
+    srt_client_init();
+
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_impair_bernoulli_loss),
+        cmocka_unit_test(test_impair_gilbert_elliott_bursts),
+        cmocka_unit_test(test_impair_rate_limit),
+        cmocka_unit_test(test_impair_rate_trace),
+        cmocka_unit_test(test_impair_reorder),
+        cmocka_unit_test(test_udp_proxy_delay),
+        cmocka_unit_test(test_e2e_adaptive),
+        cmocka_unit_test(test_e2e_aimd),
+        cmocka_unit_test(test_e2e_fixed),
+    };
+
+    int ret = cmocka_run_group_tests(tests, NULL, NULL);
+    srt_client_cleanup();
+    return ret;
+}
@@ -31,10 +31,22 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
 
 #include "config.h"
+#include "content_cap.h"
 #include "balancer_runner.h"
 #include "cli_options.h"
+#include "control_fifo.h"
+#include "encoder_policy.h"
+#include "live_stats.h"
+#include "notify.h"
+#include "perf_counters.h"
+#include "scene_detect.h"
+#include "stats.h"
 
 /*
  * Test: Config loading and parsing
@@ -60,6 +72,76 @@ static void test_config_load(void **state) {
     // AIMD defaults
     assert_int_equal(cfg.aimd.incr_step, 50);
     assert_true(cfg.aimd.decr_mult > 0.74 && cfg.aimd.decr_mult < 0.76);
+
+    // Mux / stats defaults
+    assert_int_equal(cfg.mux.auto_latency, 1);
+    assert_int_equal(cfg.mux.latency_margin, 20);
+    assert_string_equal(cfg.stats_file, "");
+    assert_int_equal(cfg.timer_warn_ms, 10);
+    assert_int_equal(cfg.perf_counters, 0);
+    assert_string_equal(cfg.live_stats, "");
+    assert_int_equal(cfg.low_latency, 0);
+    assert_string_equal(cfg.control_fifo, "");
+    assert_string_equal(cfg.slate, "");
+    assert_int_equal(cfg.slate_timeout, 1000);
+    assert_int_equal(cfg.scene_detect, 1);
+    assert_int_equal(cfg.content_cap, 1);
+
+    // Overlay off unless requested
+    assert_int_equal(cfg.overlay, OVERLAY_OFF);
+    assert_int_equal(config_set_value(&cfg, "general", "overlay", "auto"), 0);
+    assert_int_equal(cfg.overlay, OVERLAY_AUTO);
+    assert_int_equal(config_set_value(&cfg, "general", "overlay", "source"), 0);
+    assert_int_equal(cfg.overlay, OVERLAY_SOURCE);
+    assert_int_equal(config_set_value(&cfg, "general", "overlay", "sideways"), -1);
+    assert_int_equal(cfg.overlay, OVERLAY_SOURCE);
+
+    // Zero-copy capture probed unless turned off
+    assert_int_equal(cfg.zero_copy, ZERO_COPY_AUTO);
+    assert_int_equal(config_set_value(&cfg, "general", "zero_copy", "off"), 0);
+    assert_int_equal(cfg.zero_copy, ZERO_COPY_OFF);
+    assert_int_equal(config_set_value(&cfg, "general", "zero_copy", "always"), -1);
+
+    // Opus audio control
+    assert_int_equal(cfg.audio.min_bitrate, 32);
+    assert_int_equal(cfg.audio.complexity, -1);
+    assert_int_equal(cfg.audio.frame_size, 20);
+    assert_int_equal(config_set_value(&cfg, "audio", "frame_size", "10"), 0);
+    assert_int_equal(cfg.audio.frame_size, 10);
+    assert_int_equal(config_set_value(&cfg, "audio", "frame_size", "15"), -1);
+    assert_int_equal(config_set_value(&cfg, "audio", "complexity", "5"), 0);
+    assert_int_equal(cfg.audio.complexity, 5);
+    assert_int_equal(config_set_value(&cfg, "audio", "complexity", "11"), -1);
+}
+
+/*
+ * Test: Low latency profile replaces defaults, keeps explicit settings
+ */
+static void test_config_low_latency(void **state) {
+    (void) state;
+
+    BelacoderConfig cfg;
+    config_init_defaults(&cfg);
+    assert_int_equal(config_set_value(&cfg, "general", "low_latency", "1"), 0);
+    assert_int_equal(cfg.low_latency, 1);
+    config_apply_low_latency(&cfg);
+    assert_int_equal(cfg.srt_latency, LOW_LATENCY_SRT_LATENCY);
+    assert_int_equal(cfg.adaptive.decr_interval, LOW_LATENCY_DECR_INTERVAL);
+    assert_int_equal(cfg.aimd.decr_interval, LOW_LATENCY_DECR_INTERVAL);
+    assert_int_equal(cfg.mux.latency_margin, LOW_LATENCY_MUX_MARGIN);
+    assert_int_equal(cfg.audio.frame_size, LOW_LATENCY_AUDIO_FRAME);
+
+    // Untouched by the profile
+    assert_int_equal(cfg.adaptive.incr_interval, 500);
+    assert_int_equal(cfg.encoder.min_interval, 1000);
+
+    config_init_defaults(&cfg);
+    assert_int_equal(config_set_value(&cfg, "srt", "latency", "500"), 0);
+    assert_int_equal(config_set_value(&cfg, "adaptive", "decr_interval", "150"), 0);
+    config_apply_low_latency(&cfg);
+    assert_int_equal(cfg.srt_latency, 500);
+    assert_int_equal(cfg.adaptive.decr_interval, 150);
+    assert_int_equal(cfg.aimd.decr_interval, LOW_LATENCY_DECR_INTERVAL);
 }
 
 /*
@@ -324,9 +406,451 @@ static void test_rapid_network_changes(void **state) {
     balancer_runner_cleanup(&runner);
 }
 
+/*
+ * Test: Encoder policy applies decreases at once and rate-limits increases
+ */
+static void test_encoder_policy_fast_decrease(void **state) {
+    (void) state;
+
+    EncoderPolicyConfig pcfg = { .min_interval = 1000, .min_delta = 100000, .max_hold = 2000 };
+    EncoderPolicy policy;
+    encoder_policy_init(&policy, &pcfg);
+
+    // The first bitrate is always applied
+    assert_int_equal(encoder_policy_decide(&policy, 6000000, 0), ENCODER_POLICY_APPLY);
+    assert_int_equal(encoder_policy_decide(&policy, 6000000, 20), ENCODER_POLICY_NONE);
+
+    // Decreases go through the fast path, even back to back
+    assert_int_equal(encoder_policy_decide(&policy, 4000000, 40), ENCODER_POLICY_APPLY_FAST);
+    assert_int_equal(encoder_policy_decide(&policy, 3000000, 60), ENCODER_POLICY_APPLY_FAST);
+
+    // Increases wait for min_interval since the last change
+    assert_int_equal(encoder_policy_decide(&policy, 3500000, 500), ENCODER_POLICY_HOLD);
+    assert_int_equal(encoder_policy_decide(&policy, 3500000, 1059), ENCODER_POLICY_HOLD);
+    assert_int_equal(encoder_policy_decide(&policy, 3500000, 1060), ENCODER_POLICY_APPLY);
+    assert_int_equal(policy.applied, 3500000);
+
+    assert_int_equal(policy.changes, 4);
+    assert_int_equal(policy.fast_changes, 2);
+    assert_int_equal(policy.coalesced, 1);
+}
+
+/*
+ * Test: Encoder policy coalesces a burst of increases into one change
+ */
+static void test_encoder_policy_coalescing(void **state) {
+    (void) state;
+
+    EncoderPolicyConfig pcfg = { .min_interval = 1000, .min_delta = 100000, .max_hold = 2000 };
+    EncoderPolicy policy;
+    encoder_policy_init(&policy, &pcfg);
+
+    assert_int_equal(encoder_policy_decide(&policy, 1000000, 0), ENCODER_POLICY_APPLY);
+
+    // A ramp of 100 kbps steps every 200 ms, offered every 20 ms
+    int target = 1000000;
+    int applied_changes = 0;
+    for (uint64_t t = 20; t <= 2000; t += 20) {
+        if (t % 200 == 0) target += 100000;
+        EncoderPolicyDecision d = encoder_policy_decide(&policy, target, t);
+        if (d == ENCODER_POLICY_APPLY) applied_changes++;
+    }
+
+    // 10 distinct targets, applied at most once per second
+    assert_int_equal(applied_changes, 2);
+    assert_int_equal(policy.applied, 2000000);
+    assert_true(policy.coalesced >= 8);
+}
+
+/*
+ * Test: Small changes are held back, then applied once max_hold expires
+ */
+static void test_encoder_policy_min_delta(void **state) {
+    (void) state;
+
+    EncoderPolicyConfig pcfg = { .min_interval = 1000, .min_delta = 100000, .max_hold = 2000 };
+    EncoderPolicy policy;
+    encoder_policy_init(&policy, &pcfg);
+
+    assert_int_equal(encoder_policy_decide(&policy, 2000000, 0), ENCODER_POLICY_APPLY);
+
+    // 50 kbps decrease: below min_delta, held even though it is a decrease
+    assert_int_equal(encoder_policy_decide(&policy, 1950000, 5000), ENCODER_POLICY_HOLD);
+    assert_int_equal(encoder_policy_decide(&policy, 1950000, 6999), ENCODER_POLICY_HOLD);
+    assert_int_equal(encoder_policy_decide(&policy, 1950000, 7000), ENCODER_POLICY_APPLY_FAST);
+    assert_int_equal(policy.applied, 1950000);
+
+    // A held change that returns to the applied value clears the hold
+    assert_int_equal(encoder_policy_decide(&policy, 2000000, 9000), ENCODER_POLICY_HOLD);
+    assert_int_equal(encoder_policy_decide(&policy, 1950000, 9020), ENCODER_POLICY_NONE);
+    assert_int_equal(encoder_policy_decide(&policy, 2000000, 10000), ENCODER_POLICY_HOLD);
+}
+
+/*
+ * Test: H.264 passthrough falls back to transcoding below the camera's
+ * minimum and returns only once the target clears it by the hysteresis
+ */
+static void test_encoder_passthrough_select(void **state) {
+    (void) state;
+
+    // Range not known yet: stay on passthrough
+    assert_int_equal(encoder_passthrough_select(0, 100000, 0), 0);
+
+    assert_int_equal(encoder_passthrough_select(0, 1000000, 1000000), 0);
+    assert_int_equal(encoder_passthrough_select(0, 999999, 1000000), 1);
+
+    // Transcoding until the target reaches 1.2x the minimum
+    assert_int_equal(encoder_passthrough_select(1, 1000000, 1000000), 1);
+    assert_int_equal(encoder_passthrough_select(1, 1199999, 1000000), 1);
+    assert_int_equal(encoder_passthrough_select(1, 1200000, 1000000), 0);
+}
+
+/*
+ * Test: Opus bitrate follows the video target between its bounds
+ */
+static void test_audio_bitrate_select(void **state) {
+    (void) state;
+
+    // 1/16 of the target, in 8 Kbps steps
+    assert_int_equal(audio_bitrate_select(1000000, 32000, 96000), 56000);
+    assert_int_equal(audio_bitrate_select(1100000, 32000, 96000), 64000);
+    assert_int_equal(audio_bitrate_select(1027000, 32000, 96000), 64000);
+
+    // Bounded by the minimum and the pipeline's bitrate
+    assert_int_equal(audio_bitrate_select(300000, 32000, 96000), 32000);
+    assert_int_equal(audio_bitrate_select(6000000, 32000, 96000), 96000);
+    assert_int_equal(audio_bitrate_select(6000000, 32000, 50000), 50000);
+}
+
+/*
+ * Test: Supervisor notifications are written to the inherited fd, one per line
+ */
+static void test_notify_fd(void **state) {
+    (void) state;
+
+    int fds[2];
+    assert_int_equal(pipe(fds), 0);
+
+    char fd_str[16];
+    snprintf(fd_str, sizeof(fd_str), "%d", fds[1]);
+    unsetenv("NOTIFY_SOCKET");
+    setenv("CERACODER_NOTIFY_FD", fd_str, 1);
+    setenv("WATCHDOG_USEC", "6000000", 1);
+
+    Notifier n;
+    assert_int_equal(notify_init(&n), 0);
+    assert_true(notify_enabled(&n));
+    assert_int_equal(n.watchdog_interval, 3000);
+
+    assert_int_equal(notify_send(&n, "READY=1\nSTATUS=Streaming at %d Kbps", 6000), 0);
+    assert_int_equal(notify_send(&n, "WATCHDOG=1"), 0);
+
+    char buf[128] = {0};
+    ssize_t len = read(fds[0], buf, sizeof(buf) - 1);
+    assert_string_equal(buf, "READY=1\nSTATUS=Streaming at 6000 Kbps\nWATCHDOG=1\n");
+    assert_int_equal(len, (ssize_t)strlen(buf));
+
+    // Invalid fds are ignored, leaving the notifier disabled
+    setenv("CERACODER_NOTIFY_FD", "not-a-fd", 1);
+    unsetenv("WATCHDOG_USEC");
+    Notifier disabled;
+    assert_int_equal(notify_init(&disabled), -1);
+    assert_false(notify_enabled(&disabled));
+    assert_int_equal(disabled.watchdog_interval, NOTIFY_DEF_WATCHDOG_INT);
+    assert_int_equal(notify_send(&disabled, "READY=1"), 0);
+
+    unsetenv("CERACODER_NOTIFY_FD");
+    notify_cleanup(&n);
+    close(fds[0]);
+}
+
+/*
+ * Test: Control commands are read from the FIFO line by line, across
+ * partial writes, malformed ones are skipped and those past max are kept
+ */
+static void test_control_fifo(void **state) {
+    (void) state;
+
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/ceracoder_test_ctl_%d", (int)getpid());
+    unlink(path);
+
+    ControlFifo cf;
+    assert_int_equal(control_fifo_open(&cf, path), 0);
+    assert_true(cf.created);
+
+    ControlCmd cmds[4];
+    assert_int_equal(control_fifo_read(&cf, cmds, 4), 0);
+
+    int wfd = open(path, O_WRONLY | O_NONBLOCK);
+    assert_true(wfd >= 0);
+    const char *first = "swap pipeline/jetson/h265_camlink_720p30 \nbogus\nswap\nswap /tmp/p";
+    assert_int_equal(write(wfd, first, strlen(first)), (ssize_t)strlen(first));
+    assert_int_equal(control_fifo_read(&cf, cmds, 4), 1);
+    assert_int_equal(cmds[0].type, CONTROL_CMD_SWAP);
+    assert_string_equal(cmds[0].arg, "pipeline/jetson/h265_camlink_720p30");
+
+    // The rest of the partial line
+    assert_int_equal(write(wfd, "ipe\n", 4), 4);
+    close(wfd);
+    assert_int_equal(control_fifo_read(&cf, cmds, 4), 1);
+    assert_string_equal(cmds[0].arg, "/tmp/pipe");
+
+    // The writer closing isn't an end of file
+    assert_int_equal(control_fifo_read(&cf, cmds, 4), 0);
+
+    // More commands than fit in one call are returned by the next ones
+    wfd = open(path, O_WRONLY | O_NONBLOCK);
+    assert_true(wfd >= 0);
+    const char *batch = "swap /tmp/a\nswap /tmp/b\nswap /tmp/c\n";
+    assert_int_equal(write(wfd, batch, strlen(batch)), (ssize_t)strlen(batch));
+    close(wfd);
+    assert_int_equal(control_fifo_read(&cf, cmds, 2), 2);
+    assert_string_equal(cmds[1].arg, "/tmp/b");
+    assert_int_equal(control_fifo_read(&cf, cmds, 2), 1);
+    assert_string_equal(cmds[0].arg, "/tmp/c");
+    assert_int_equal(control_fifo_read(&cf, cmds, 2), 0);
+
+    control_fifo_close(&cf);
+    assert_int_not_equal(access(path, F_OK), 0);
+}
+
+/*
+ * Test: Thread counters in getrusage mode report CPU time and context
+ * switches per second, and nothing that needs perf events
+ */
+static void test_perf_counters_rusage(void **state) {
+    (void) state;
+
+    PerfCounters pc;
+    perf_counters_init(&pc, "test", PERF_MODE_RUSAGE);
+
+    perf_counters_sample(&pc, 1000);
+    volatile uint64_t x = 0;
+    for (int i = 0; i < 20000000; i++) x += i;
+    perf_counters_sample(&pc, 1500);    // Within the interval, skipped
+    usleep(10000);
+    perf_counters_sample(&pc, 2000);
+    assert_int_equal(pc.delta_ms, 1000);
+    assert_true(pc.delta[PERF_COUNTER_CPU_TIME] > 0);
+    assert_true(pc.delta[PERF_COUNTER_CONTEXT_SWITCHES] > 0);
+
+    Stats stats;
+    stats_init(&stats);
+    perf_counters_publish(&pc, &stats);
+    assert_true(stats_get(&stats, "ceracoder_thread_cpu_percent{thread=\"test\"}") > 0);
+    assert_true(stats_get(&stats,
+                "ceracoder_thread_context_switches_per_second{thread=\"test\"}") > 0);
+
+    char buf[4096];
+    assert_true(stats_format(&stats, buf, sizeof(buf)) > 0);
+    assert_null(strstr(buf, "ceracoder_thread_cycles"));
+    assert_null(strstr(buf, "ceracoder_thread_ipc"));
+
+    // Disabled counters publish nothing
+    PerfCounters off;
+    perf_counters_init(&off, "off", PERF_MODE_OFF);
+    perf_counters_sample(&off, 1000);
+    perf_counters_sample(&off, 2000);
+    Stats empty;
+    stats_init(&empty);
+    perf_counters_publish(&off, &empty);
+    assert_int_equal(empty.n_metrics, 0);
+
+    perf_counters_cleanup(&pc);
+    perf_counters_cleanup(&off);
+}
+
+static void *perf_counters_other_thread(void *arg) {
+    PerfCounters *pc = (PerfCounters *)arg;
+    perf_counters_sample(pc, 3000);     // Re-attached, new baseline
+    volatile uint64_t x = 0;
+    for (int i = 0; i < 20000000; i++) x += i;
+    perf_counters_sample(pc, 4000);
+    return NULL;
+}
+
+/*
+ * Test: Thread counters sampled from another thread (a swapped in
+ * pipeline's streaming thread) move to it instead of mixing both threads
+ */
+static void test_perf_counters_thread_change(void **state) {
+    (void) state;
+
+    PerfCounters pc;
+    perf_counters_init(&pc, "test", PERF_MODE_RUSAGE);
+
+    // Lots of CPU time on this thread, which the other one must not see
+    volatile uint64_t x = 0;
+    for (int i = 0; i < 50000000; i++) x += i;
+    perf_counters_sample(&pc, 1000);
+    perf_counters_sample(&pc, 2000);
+
+    pthread_t thread;
+    assert_int_equal(pthread_create(&thread, NULL, perf_counters_other_thread, &pc), 0);
+    pthread_join(thread, NULL);
+
+    assert_int_equal(pc.delta_ms, 1000);
+    assert_int_equal(pc.total_ms, 2000);
+    assert_true(pc.delta[PERF_COUNTER_CPU_TIME] > 0);
+    assert_true(pc.delta[PERF_COUNTER_CPU_TIME] < 10000000);    // No wrapped delta
+
+    perf_counters_cleanup(&pc);
+}
+
+static void test_live_stats_roundtrip(void **state) {
+    (void) state;
+
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/ceracoder_test_%d.live", (int)getpid());
+
+    LiveStats writer;
+    assert_int_equal(live_stats_create(&writer, path, "adaptive", 2000), 0);
+
+    LiveStats reader;
+    assert_int_equal(live_stats_open(&reader, path), 0);
+    assert_int_equal(reader.shm->pid, getpid());
+    assert_string_equal(reader.shm->balancer, "adaptive");
+    assert_int_equal(live_stats_head(&reader), 0);
+
+    LiveStatsSample sample;
+    memset(&sample, 0, sizeof(sample));
+    for (int i = 1; i <= LIVE_STATS_SLOTS + 10; i++) {
+        sample.target_bps = i * 1000;
+        live_stats_publish(&writer, &sample, 1000 + i * 20);
+    }
+    assert_int_equal(live_stats_head(&reader), LIVE_STATS_SLOTS + 10);
+
+    LiveStatsSample out;
+    assert_int_equal(live_stats_read(&reader, LIVE_STATS_SLOTS + 10, &out), 0);
+    assert_int_equal(out.seq, LIVE_STATS_SLOTS + 10);
+    assert_int_equal(out.target_bps, (LIVE_STATS_SLOTS + 10) * 1000);
+    assert_int_equal(out.timestamp_ms, 1000 + (LIVE_STATS_SLOTS + 10) * 20);
+    assert_int_equal(live_stats_read(&reader, 11, &out), 0);
+    assert_int_equal(out.target_bps, 11000);
+
+    // Overwritten and not yet written samples
+    assert_int_equal(live_stats_read(&reader, 10, &out), -1);
+    assert_int_equal(live_stats_read(&reader, LIVE_STATS_SLOTS + 11, &out), -1);
+
+    // The writer removes the file, the reader's mapping stays valid
+    live_stats_close(&writer);
+    assert_int_equal(access(path, F_OK), -1);
+    assert_int_equal(live_stats_read(&reader, LIVE_STATS_SLOTS + 10, &out), 0);
+    live_stats_close(&reader);
+    assert_int_equal(live_stats_open(&reader, path), -1);
+
+    // The feed of another running process isn't taken over (pid 1 is alive)
+    assert_int_equal(live_stats_create(&writer, path, "adaptive", 2000), 0);
+    writer.shm->pid = 1;
+    LiveStats second;
+    assert_int_equal(live_stats_create(&second, path, "aimd", 2000), -1);
+    assert_int_equal(errno, EBUSY);
+
+    // A writer doesn't remove a file that replaced its own
+    writer.shm->pid = getpid();
+    assert_int_equal(live_stats_create(&second, path, "aimd", 2000), 0);
+    live_stats_close(&writer);
+    assert_int_equal(access(path, F_OK), 0);
+    live_stats_close(&second);
+    assert_int_equal(access(path, F_OK), -1);
+}
+
+/*
+ * Test: Scene detector flags a cut but not motion, SIMD SAD matches scalar
+ */
+static void test_scene_detect(void **state) {
+    (void) state;
+
+    enum { W = 320, H = 180 };
+    static uint8_t frame[H][W];
+    SceneDetect sd;
+    scene_detect_init(&sd);
+
+    // Dark gradient panning slowly: motion, no cut
+    for (int f = 0; f < 30; f++) {
+        for (int y = 0; y < H; y++) {
+            for (int x = 0; x < W; x++) {
+                frame[y][x] = 16 + ((x + y + f * 2) % 64);
+            }
+        }
+        assert_int_equal(scene_detect_frame(&sd, &frame[0][0], W, H, W, 1), 0);
+    }
+    assert_true(sd.motion > 0);
+    assert_int_equal(sd.cuts, 0);
+
+    // Bright checkerboard: cut
+    for (int y = 0; y < H; y++) {
+        for (int x = 0; x < W; x++) {
+            frame[y][x] = ((x / 8 + y / 8) & 1) ? 235 : 128;
+        }
+    }
+    assert_int_equal(scene_detect_frame(&sd, &frame[0][0], W, H, W, 1), 1);
+
+    // Same frame again: static, no cut
+    assert_int_equal(scene_detect_frame(&sd, &frame[0][0], W, H, W, 1), 0);
+    assert_int_equal(sd.sad, 0);
+    assert_int_equal(sd.cuts, 1);
+    assert_int_equal(sd.frames, 32);
+
+    // SAD, including the non-SIMD tail
+    static uint8_t a[1000], b[1000];
+    srand(1);
+    for (int i = 0; i < 1000; i++) {
+        a[i] = rand();
+        b[i] = rand();
+    }
+    for (int len = 0; len <= 1000; len += 37) {
+        assert_int_equal(scene_sad(a, b, len), scene_sad_scalar(a, b, len));
+    }
+}
+
+/*
+ * Test: Content cap engages on a static, undershooting scene, lifts on motion
+ */
+static void test_content_cap(void **state) {
+    (void) state;
+
+    ContentCap cc;
+    content_cap_init(&cc);
+    uint64_t ts = 1000;
+
+    // Static, but the encoder uses what it's given: no ceiling
+    for (int i = 0; i < 250; i++, ts += 20) {
+        assert_int_equal(content_cap_update(&cc, 0, 0, 5800000, 6000000, ts), 0);
+    }
+
+    // Moving, then static with the encoder at 1 Mbps of 6: capped after the hold
+    assert_int_equal(content_cap_update(&cc, 40, 0, 1000000, 6000000, ts), 0);
+    ts += 20;
+    uint64_t static_start = ts;
+    while (ts < static_start + CONTENT_CAP_HOLD) {
+        assert_int_equal(content_cap_update(&cc, 2, 0, 1000000, 6000000, ts), 0);
+        ts += 20;
+    }
+    assert_int_equal(content_cap_update(&cc, 2, 0, 1000000, 6000000, ts), 1500000);
+    assert_int_equal(cc.engaged, 1);
+
+    // Held with the target at the ceiling, follows the output peak up
+    ts += 20;
+    assert_int_equal(content_cap_update(&cc, 2, 0, 1000000, 1500000, ts), 1500000);
+    ts += 20;
+    assert_int_equal(content_cap_update(&cc, 2, 0, 1200000, 1500000, ts), 1800000);
+    ts += 20;
+    assert_int_equal(content_cap_update(&cc, 2, 0, 900000, 1800000, ts), 1800000);
+
+    // Motion or a scene cut lifts it at once
+    ts += 20;
+    assert_int_equal(content_cap_update(&cc, 30, 0, 900000, 1800000, ts), 0);
+    assert_int_equal(content_cap_update(&cc, 0, 1, 900000, 6000000, ts + 20), 0);
+    assert_int_equal(cc.static_since, 0);
+    assert_true(cc.capped_ms >= 60);
+}
+
 int main(void) {
     const struct CMUnitTest tests[] = {
         cmocka_unit_test(test_config_load),
+        cmocka_unit_test(test_config_low_latency),
         cmocka_unit_test(test_balancer_init_from_config),
         cmocka_unit_test(test_balancer_cli_override),
         cmocka_unit_test(test_balancer_bounds_update),
@@ -334,6 +858,18 @@ int main(void) {
         cmocka_unit_test(test_config_bitrate_conversion),
         cmocka_unit_test(test_balancer_algorithm_switching),
         cmocka_unit_test(test_rapid_network_changes),
+        cmocka_unit_test(test_encoder_policy_fast_decrease),
+        cmocka_unit_test(test_encoder_policy_coalescing),
+        cmocka_unit_test(test_encoder_policy_min_delta),
+        cmocka_unit_test(test_encoder_passthrough_select),
+        cmocka_unit_test(test_audio_bitrate_select),
+        cmocka_unit_test(test_notify_fd),
+        cmocka_unit_test(test_control_fifo),
+        cmocka_unit_test(test_perf_counters_rusage),
+        cmocka_unit_test(test_perf_counters_thread_change),
+        cmocka_unit_test(test_live_stats_roundtrip),
+        cmocka_unit_test(test_scene_detect),
+        cmocka_unit_test(test_content_cap),
     };
 
     return cmocka_run_group_tests(tests, NULL, NULL);
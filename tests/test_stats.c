@@ -0,0 +1,248 @@
+/*
+    ceracoder - live video encoder with dynamic bitrate control
+    Copyright (C) 2020 BELABOX project
+    Copyright (C) 2026 CERALIVE
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * Tests for the runtime stats export
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include "stats.h"
+#include "timer_stats.h"
+
+/*
+ * Test: Set / add / get
+ */
+static void test_stats_set_add(void **state) {
+    (void) state;
+    static Stats stats;
+    stats_init(&stats);
+
+    assert_int_equal(stats_set(&stats, "a_gauge", STATS_GAUGE, NULL, 5), 0);
+    assert_int_equal(stats_set(&stats, "a_gauge", STATS_GAUGE, NULL, 7), 0);
+    assert_int_equal(stats_add(&stats, "a_counter", STATS_COUNTER, NULL, 2), 0);
+    assert_int_equal(stats_add(&stats, "a_counter", STATS_COUNTER, NULL, 3), 0);
+
+    assert_int_equal(stats.n_metrics, 2);
+    assert_true(stats_get(&stats, "a_gauge") == 7);
+    assert_true(stats_get(&stats, "a_counter") == 5);
+    assert_true(stats_get(&stats, "missing") == 0);
+
+    // Table full
+    char name[32];
+    for (int i = stats.n_metrics; i < STATS_MAX_METRICS; i++) {
+        snprintf(name, sizeof(name), "m%d", i);
+        assert_int_equal(stats_set(&stats, name, STATS_GAUGE, NULL, i), 0);
+    }
+    assert_int_equal(stats_set(&stats, "one_too_many", STATS_GAUGE, NULL, 1), -1);
+}
+
+/*
+ * Test: Prometheus text format, HELP/TYPE once per labelled family
+ */
+static void test_stats_format(void **state) {
+    (void) state;
+    static Stats stats;
+    stats_init(&stats);
+
+    stats_set(&stats, "lag_ms{input=\"sink_0\"}", STATS_GAUGE, "Input lag", 12);
+    stats_set(&stats, "lag_ms{input=\"sink_1\"}", STATS_GAUGE, "Input lag", 40);
+    stats_set(&stats, "changes_total", STATS_COUNTER, NULL, 3);
+
+    char buf[1024];
+    int len = stats_format(&stats, buf, sizeof(buf));
+    assert_true(len > 0);
+    assert_int_equal(len, (int)strlen(buf));
+
+    const char *expected =
+        "# HELP lag_ms Input lag\n"
+        "# TYPE lag_ms gauge\n"
+        "lag_ms{input=\"sink_0\"} 12\n"
+        "lag_ms{input=\"sink_1\"} 40\n"
+        "# TYPE changes_total counter\n"
+        "changes_total 3\n";
+    assert_string_equal(buf, expected);
+
+    // Buffer too small
+    assert_int_equal(stats_format(&stats, buf, 16), -1);
+}
+
+/*
+ * Test: Histograms are cumulative and share one HELP/TYPE
+ */
+static void test_stats_histogram(void **state) {
+    (void) state;
+    static Stats stats;
+    stats_init(&stats);
+
+    const double bounds[] = { 0.5, 1 };
+    const uint64_t counts[] = { 2, 1, 4 };
+    assert_int_equal(stats_set_histogram(&stats, "dur_seconds", "state=\"heavy\"", "Duration",
+                                         bounds, 2, counts, 12.5), 0);
+    const uint64_t empty[] = { 0, 0, 0 };
+    assert_int_equal(stats_set_histogram(&stats, "wait_seconds", NULL, NULL,
+                                         bounds, 2, empty, 0), 0);
+
+    char buf[1024];
+    assert_true(stats_format(&stats, buf, sizeof(buf)) > 0);
+
+    const char *expected =
+        "# HELP dur_seconds Duration\n"
+        "# TYPE dur_seconds histogram\n"
+        "dur_seconds_bucket{state=\"heavy\",le=\"0.5\"} 2\n"
+        "dur_seconds_bucket{state=\"heavy\",le=\"1\"} 3\n"
+        "dur_seconds_bucket{state=\"heavy\",le=\"+Inf\"} 7\n"
+        "dur_seconds_sum{state=\"heavy\"} 12.5\n"
+        "dur_seconds_count{state=\"heavy\"} 7\n"
+        "# TYPE wait_seconds histogram\n"
+        "wait_seconds_bucket{le=\"0.5\"} 0\n"
+        "wait_seconds_bucket{le=\"1\"} 0\n"
+        "wait_seconds_bucket{le=\"+Inf\"} 0\n"
+        "wait_seconds_sum 0\n"
+        "wait_seconds_count 0\n";
+    assert_string_equal(buf, expected);
+}
+
+/*
+ * Test: Writing the stats file
+ */
+static void test_stats_write_file(void **state) {
+    (void) state;
+    static Stats stats;
+    stats_init(&stats);
+    stats_set(&stats, "value", STATS_GAUGE, NULL, 1.5);
+
+    char filename[] = "/tmp/ceracoder_stats_XXXXXX";
+    int fd = mkstemp(filename);
+    assert_true(fd >= 0);
+    close(fd);
+
+    assert_int_equal(stats_write_file(&stats, filename), 0);
+
+    FILE *f = fopen(filename, "r");
+    assert_non_null(f);
+    char buf[256] = {0};
+    size_t len = fread(buf, 1, sizeof(buf) - 1, f);
+    fclose(f);
+    unlink(filename);
+
+    assert_true(len > 0);
+    assert_non_null(strstr(buf, "value 1.5\n"));
+
+    // Unwritable location
+    assert_int_equal(stats_write_file(&stats, "/nonexistent/dir/stats.prom"), -1);
+}
+
+/*
+ * Test: Timer histogram quantiles
+ */
+static void test_timer_hist_quantile(void **state) {
+    (void) state;
+    TimerHist hist;
+    memset(&hist, 0, sizeof(hist));
+    assert_true(timer_hist_quantile(&hist, 0.99) == 0);
+
+    // 98 on-time ticks, 2 that were 30 ms late
+    for (int i = 0; i < 98; i++) timer_hist_add(&hist, 0.2);
+    timer_hist_add(&hist, 30);
+    timer_hist_add(&hist, 30);
+    assert_int_equal(hist.count, 100);
+    assert_int_equal(hist.counts[0], 98);
+    assert_int_equal(hist.counts[6], 2);    // (20, 50]
+
+    // p50 inside the first bucket, p99 inside (20, 30] (capped at the max)
+    double p50 = timer_hist_quantile(&hist, 0.5);
+    assert_true(p50 > 0 && p50 <= 0.5);
+    double p99 = timer_hist_quantile(&hist, 0.99);
+    assert_true(p99 > 20 && p99 <= 30);
+
+    // Overflow bucket interpolates up to the max
+    memset(&hist, 0, sizeof(hist));
+    timer_hist_add(&hist, 900);
+    assert_true(timer_hist_quantile(&hist, 0.99) <= 900);
+    assert_true(timer_hist_quantile(&hist, 0.99) > 500);
+
+    // Negative values (clock granularity) count as on time
+    memset(&hist, 0, sizeof(hist));
+    timer_hist_add(&hist, -0.1);
+    assert_int_equal(hist.counts[0], 1);
+    assert_true(hist.sum == 0);
+}
+
+/*
+ * Test: p99 threshold checks reset the window, the totals are exported
+ */
+static void test_timer_stats_check(void **state) {
+    (void) state;
+    static Stats stats;
+    stats_init(&stats);
+
+    TimerStats ts;
+    timer_stats_init(&ts, "housekeeping", 20);
+    double late, run;
+
+    // Empty window
+    assert_int_equal(timer_stats_check(&ts, 10, &late, &run), 0);
+
+    // On time
+    for (int i = 0; i < 500; i++) timer_stats_record(&ts, 0.3, 0.1);
+    assert_int_equal(timer_stats_check(&ts, 10, &late, &run), 0);
+    assert_true(late <= 0.5);
+    assert_int_equal(ts.win_lateness.count, 0);
+
+    // 5% of the ticks 40 ms late
+    for (int i = 0; i < 500; i++) timer_stats_record(&ts, i % 20 == 0 ? 40 : 0.3, 0.1);
+    assert_int_equal(timer_stats_check(&ts, 10, &late, &run), 1);
+    assert_true(late > 20 && late <= 40);
+    assert_true(run <= 0.5);
+
+    // A slow callback
+    for (int i = 0; i < 100; i++) timer_stats_record(&ts, 0.3, i < 5 ? 15 : 0.1);
+    assert_int_equal(timer_stats_check(&ts, 10, &late, &run), 1);
+    assert_true(run > 10);
+
+    // Totals since startup
+    assert_int_equal(ts.lateness.count, 1100);
+    assert_true(ts.lateness.max == 40);
+    timer_stats_publish(&ts, &stats);
+    assert_true(stats_get(&stats, "ceracoder_timer_lateness_ms_count{timer=\"housekeeping\"}") == 1100);
+    assert_true(stats_get(&stats, "ceracoder_timer_lateness_ms_max{timer=\"housekeeping\"}") == 40);
+    assert_true(stats_get(&stats, "ceracoder_timer_runtime_ms_max{timer=\"housekeeping\"}") == 15);
+    assert_true(stats_get(&stats, "ceracoder_timer_interval_ms{timer=\"housekeeping\"}") == 20);
+}
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_stats_set_add),
+        cmocka_unit_test(test_stats_format),
+        cmocka_unit_test(test_stats_histogram),
+        cmocka_unit_test(test_stats_write_file),
+        cmocka_unit_test(test_timer_hist_quantile),
+        cmocka_unit_test(test_timer_stats_check),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
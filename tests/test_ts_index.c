@@ -0,0 +1,343 @@
+/*
+    ceracoder - live video encoder with dynamic bitrate control
+    Copyright (C) 2020 BELABOX project
+    Copyright (C) 2026 CERALIVE
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * Tests for the MPEG-TS packet indexer
+ *
+ * The index of real muxer output is checked against the packet headers,
+ * and the vector decoder against the scalar one on arbitrary headers.
+ * Continuity counter restamping is checked across a muxer change, and the
+ * slate timestamps across loops.
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ts_cc.h"
+#include "ts_index.h"
+#include "ts_mux.h"
+#include "ts_slate.h"
+
+#define CAPTURE_SIZE (TS_PKT_SIZE * 2000)
+
+typedef struct {
+    uint8_t data[CAPTURE_SIZE];
+    int len;
+} Capture;
+
+static Capture cap;
+
+static int capture_output(const uint8_t *data, int len, void *user_data) {
+    Capture *c = (Capture *)user_data;
+    if (c->len + len > CAPTURE_SIZE) return -1;
+    memcpy(c->data + c->len, data, len);
+    c->len += len;
+    return len;
+}
+
+static void assert_index_equal(const TsIndex *a, const TsIndex *b) {
+    assert_int_equal(a->count, b->count);
+    assert_int_equal(a->sync_errors, b->sync_errors);
+    assert_int_equal(a->tail, b->tail);
+    assert_memory_equal(a->pkts, b->pkts, a->count * sizeof(TsPacketInfo));
+}
+
+/*
+ * Test: Indexing muxer output matches the packet headers
+ */
+static void test_ts_index_mux_output(void **state) {
+    (void) state;
+    TsMux mux;
+    memset(&cap, 0, sizeof(cap));
+    assert_int_equal(ts_mux_init(&mux, TS_PKT_SIZE * 7, capture_output, &cap), 0);
+    int video = ts_mux_add_stream(&mux, TS_CODEC_H264);
+    int audio = ts_mux_add_stream(&mux, TS_CODEC_AAC);
+
+    uint8_t au[3000];
+    au[0] = 0; au[1] = 0; au[2] = 0; au[3] = 1;
+    for (int i = 4; i < (int)sizeof(au); i++) au[i] = (uint8_t)(i * 7);
+    for (int i = 0; i < 20; i++) {
+        au[4] = i == 0 ? 0x65 : 0x41;
+        assert_int_equal(ts_mux_write_frame(&mux, video, au, 1000 + i * 89, i * 3000, -1, i == 0), 0);
+        assert_int_equal(ts_mux_write_frame(&mux, audio, au, 300, i * 3000, -1, 0), 0);
+    }
+    assert_int_equal(ts_mux_flush(&mux), 0);
+
+    TsIndex idx;
+    ts_index_init(&idx);
+    int n = ts_index_build(&idx, cap.data, cap.len);
+    assert_int_equal(n, cap.len / TS_PKT_SIZE);
+    assert_int_equal(idx.sync_errors, 0);
+    assert_int_equal(idx.tail, 0);
+
+    int cc[0x2000];
+    memset(cc, -1, sizeof(cc));
+    int pusi = 0, pcr = 0, rai = 0;
+    for (int i = 0; i < n; i++) {
+        const uint8_t *pkt = cap.data + i * TS_PKT_SIZE;
+        const TsPacketInfo *info = &idx.pkts[i];
+        assert_int_equal(info->pid, ((pkt[1] & 0x1f) << 8) | pkt[2]);
+        assert_int_equal(info->cc, pkt[3] & 0x0f);
+        assert_int_equal(!!(info->flags & TS_PKT_PUSI), !!(pkt[1] & 0x40));
+        assert_int_equal(!!(info->flags & TS_PKT_ADAPTATION), !!(pkt[3] & 0x20));
+        assert_true(info->flags & TS_PKT_PAYLOAD);
+
+        // Continuity counters step by one per PID
+        if (cc[info->pid] >= 0) {
+            assert_int_equal(info->cc, (cc[info->pid] + 1) & 0x0f);
+        }
+        cc[info->pid] = info->cc;
+
+        pusi += (info->flags & TS_PKT_PUSI) != 0;
+        if (info->flags & TS_PKT_PCR) {
+            assert_int_equal(info->pid, TS_MUX_FIRST_ES_PID);
+            pcr++;
+        }
+        rai += (info->flags & TS_PKT_RAI) != 0;
+    }
+    // PAT + PMT + one PES per frame at least
+    assert_true(pusi >= 2 + 40);
+    assert_int_equal(pcr, (int)mux.pcr_count);
+    assert_true(rai >= 1);
+
+    // The vector and scalar decoders agree
+    TsIndex ref;
+    ts_index_init(&ref);
+    assert_int_equal(ts_index_build_scalar(&ref, cap.data, cap.len), n);
+    assert_index_equal(&idx, &ref);
+
+    ts_index_cleanup(&ref);
+    ts_index_cleanup(&idx);
+    ts_mux_cleanup(&mux);
+}
+
+/*
+ * Test: The vector decoder matches the scalar one on arbitrary headers
+ */
+static void test_ts_index_random_headers(void **state) {
+    (void) state;
+    enum { N = 1003 };  // not a multiple of the vector width
+    uint8_t *buf = malloc(N * TS_PKT_SIZE + 100);
+    assert_non_null(buf);
+
+    srand(1234);
+    for (int i = 0; i < N * TS_PKT_SIZE + 100; i++) buf[i] = (uint8_t)rand();
+    for (int i = 0; i < N; i++) {
+        // Mostly valid sync bytes, some adaptation fields empty
+        if (i % 37 != 0) buf[i * TS_PKT_SIZE] = 0x47;
+        if (i % 5 == 0) buf[i * TS_PKT_SIZE + 4] = 0;
+    }
+
+    TsIndex idx, ref;
+    ts_index_init(&idx);
+    ts_index_init(&ref);
+    for (int len = N * TS_PKT_SIZE + 100; len > 0; len -= 997) {
+        assert_int_equal(ts_index_build(&idx, buf, len), len / TS_PKT_SIZE);
+        assert_int_equal(ts_index_build_scalar(&ref, buf, len), len / TS_PKT_SIZE);
+        assert_index_equal(&idx, &ref);
+    }
+
+    // The array only grows
+    assert_true(idx.capacity >= N + 1);
+
+    ts_index_cleanup(&ref);
+    ts_index_cleanup(&idx);
+    free(buf);
+}
+
+/*
+ * Test: Bad sync bytes and partial packets are reported
+ */
+static void test_ts_index_sync_errors(void **state) {
+    (void) state;
+    uint8_t buf[TS_PKT_SIZE * 9 + 50];
+    memset(buf, 0xff, sizeof(buf));
+    for (int i = 0; i < 9; i++) {
+        uint8_t *pkt = buf + i * TS_PKT_SIZE;
+        pkt[0] = 0x47;
+        pkt[1] = 0x1f;   // null packet, PID 0x1fff
+        pkt[2] = 0xff;
+        pkt[3] = 0x10 | (i & 0x0f);
+    }
+    buf[2 * TS_PKT_SIZE] = 0x00;
+    buf[7 * TS_PKT_SIZE] = 0x46;
+
+    TsIndex idx;
+    ts_index_init(&idx);
+    assert_int_equal(ts_index_build(&idx, buf, sizeof(buf)), 9);
+    assert_int_equal(idx.sync_errors, 2);
+    assert_int_equal(idx.tail, 50);
+    for (int i = 0; i < 9; i++) {
+        if (i == 2 || i == 7) {
+            assert_int_equal(idx.pkts[i].flags, TS_PKT_SYNC_ERROR);
+            continue;
+        }
+        assert_int_equal(idx.pkts[i].pid, TS_INDEX_NULL_PID);
+        assert_int_equal(idx.pkts[i].flags, TS_PKT_PAYLOAD);
+        assert_int_equal(idx.pkts[i].cc, i);
+    }
+
+    // Less than a packet
+    assert_int_equal(ts_index_build(&idx, buf, 100), 0);
+    assert_int_equal(idx.count, 0);
+    assert_int_equal(idx.tail, 100);
+
+    ts_index_cleanup(&idx);
+}
+
+// Mux frames of a video and an audio stream with a new muxer
+static void mux_frames(Capture *c, int frames, int first) {
+    TsMux mux;
+    memset(c, 0, sizeof(*c));
+    assert_int_equal(ts_mux_init(&mux, TS_PKT_SIZE * 7, capture_output, c), 0);
+    int video = ts_mux_add_stream(&mux, TS_CODEC_H264);
+    int audio = ts_mux_add_stream(&mux, TS_CODEC_AAC);
+
+    uint8_t au[3000];
+    au[0] = 0; au[1] = 0; au[2] = 0; au[3] = 1;
+    for (int i = 4; i < (int)sizeof(au); i++) au[i] = (uint8_t)(i * 7);
+    for (int i = first; i < first + frames; i++) {
+        au[4] = i == first ? 0x65 : 0x41;
+        assert_int_equal(ts_mux_write_frame(&mux, video, au, 700 + (i * 131) % 2000,
+                                            i * 3000, -1, i == first), 0);
+        assert_int_equal(ts_mux_write_frame(&mux, audio, au, 300, i * 3000, -1, 0), 0);
+    }
+    assert_int_equal(ts_mux_flush(&mux), 0);
+    ts_mux_cleanup(&mux);
+}
+
+/*
+ * Test: Counters carry on across a muxer change once restamped
+ */
+static void test_ts_cc_restamp(void **state) {
+    (void) state;
+    static Capture second;
+    static uint8_t joined[CAPTURE_SIZE * 2];
+    TsIndex idx;
+    ts_index_init(&idx);
+    TsCc cc;
+    ts_cc_init(&cc);
+
+    // First muxer, tracked only
+    mux_frames(&cap, 23, 0);
+    assert_true(ts_index_build(&idx, cap.data, cap.len) > 0);
+    ts_cc_process(&cc, &idx, NULL);
+    assert_int_equal(cc.restamped, 0);
+
+    // Second muxer, counters restarting from 0
+    mux_frames(&second, 20, 23);
+    assert_true(ts_index_build(&idx, second.data, second.len) > 0);
+    ts_cc_new_source(&cc);
+    ts_cc_process(&cc, &idx, second.data);
+    assert_true(cc.restamped > 0);
+
+    memcpy(joined, cap.data, cap.len);
+    memcpy(joined + cap.len, second.data, second.len);
+    int n = ts_index_build(&idx, joined, cap.len + second.len);
+    assert_int_equal(n, (cap.len + second.len) / TS_PKT_SIZE);
+
+    int last[0x2000];
+    memset(last, -1, sizeof(last));
+    for (int i = 0; i < n; i++) {
+        const TsPacketInfo *info = &idx.pkts[i];
+        if (last[info->pid] >= 0) {
+            assert_int_equal(info->cc, (last[info->pid] + 1) & 0x0f);
+        }
+        last[info->pid] = info->cc;
+    }
+
+    ts_index_cleanup(&idx);
+}
+
+// PTS of a PES starting in the packet, -1 if none
+static int64_t pes_pts(const uint8_t *pkt) {
+    if (!(pkt[1] & 0x40) || !(pkt[3] & 0x10)) return -1;
+    const uint8_t *pes = pkt + 4 + ((pkt[3] & 0x20) ? 1 + pkt[4] : 0);
+    if (pes[0] != 0 || pes[1] != 0 || pes[2] != 1 || !(pes[7] & 0x80)) return -1;
+    return ((int64_t)((pes[9] >> 1) & 0x07) << 30) | ((int64_t)pes[10] << 22) |
+           ((int64_t)(pes[11] >> 1) << 15) | ((int64_t)pes[12] << 7) | (pes[13] >> 1);
+}
+
+/*
+ * Test: The slate is paced by its PCRs and its timestamps carry on across loops
+ */
+static void test_ts_slate_loop(void **state) {
+    (void) state;
+    static uint8_t out[TS_PKT_SIZE * 64];
+    TsSlate slate;
+
+    // 30 frames at 30 fps, a PCR on every video frame
+    mux_frames(&cap, 30, 0);
+    assert_int_equal(ts_slate_load_buffer(&slate, cap.data, cap.len - 1), -1);
+    assert_int_equal(ts_slate_load_buffer(&slate, cap.data, cap.len), 0);
+    assert_int_equal(slate.n_pkts, cap.len / TS_PKT_SIZE);
+    assert_true(slate.duration == 30ULL * 3000 * 300);
+
+    // Two and a half loops, read every 20 ms
+    const uint64_t start = 5ULL * TS_PCR_HZ;
+    ts_slate_start(&slate, start);
+    uint64_t prev_pcr = 0;
+    int64_t prev_pts = -1;
+    int frames = 0;
+    int loops = 0;
+    for (uint64_t now = start; now < start + slate.duration * 5 / 2; now += TS_PCR_HZ / 50) {
+        int n, new_loop;
+        while ((n = ts_slate_read(&slate, now, out, 64, &new_loop)) > 0) {
+            loops += new_loop;
+            for (int i = 0; i < n; i++) {
+                const uint8_t *pkt = out + i * TS_PKT_SIZE;
+                uint64_t pcr;
+                if (ts_packet_pcr(pkt, &pcr) == 0) {
+                    // Never ahead of the time it is sent at
+                    assert_true(pcr > prev_pcr);
+                    assert_true(pcr <= now);
+                    prev_pcr = pcr;
+                }
+                int pid = ((pkt[1] & 0x1f) << 8) | pkt[2];
+                int64_t pts = pes_pts(pkt);
+                if (pid == TS_MUX_FIRST_ES_PID && pts >= 0) {
+                    if (prev_pts >= 0) assert_int_equal(pts - prev_pts, 3000);
+                    prev_pts = pts;
+                    frames++;
+                }
+            }
+        }
+    }
+    assert_int_equal(loops, 3);
+    assert_int_equal(slate.loops, 3);
+    assert_true(frames >= 74 && frames <= 76);
+
+    ts_slate_cleanup(&slate);
+}
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_ts_index_mux_output),
+        cmocka_unit_test(test_ts_index_random_headers),
+        cmocka_unit_test(test_ts_index_sync_errors),
+        cmocka_unit_test(test_ts_cc_restamp),
+        cmocka_unit_test(test_ts_slate_loop),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
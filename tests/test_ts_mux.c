@@ -0,0 +1,330 @@
+/*
+    ceracoder - live video encoder with dynamic bitrate control
+    Copyright (C) 2020 BELABOX project
+    Copyright (C) 2026 CERALIVE
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * Tests for the in-tree MPEG-TS muxer
+ *
+ * These tests capture the muxer output and check the TS structure:
+ * sync bytes, PSI, continuity counters, PCR and PES reassembly.
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ts_mux.h"
+
+#define SRT_PAYLOAD (TS_PKT_SIZE * 7)
+#define CAPTURE_SIZE (TS_PKT_SIZE * 2000)
+
+typedef struct {
+    uint8_t data[CAPTURE_SIZE];
+    int len;
+    int calls;
+    int last_call_len;
+} Capture;
+
+static Capture cap;
+
+static int capture_output(const uint8_t *data, int len, void *user_data) {
+    Capture *c = (Capture *)user_data;
+    if (c->len + len > CAPTURE_SIZE) return -1;
+    memcpy(c->data + c->len, data, len);
+    c->len += len;
+    c->calls++;
+    c->last_call_len = len;
+    return len;
+}
+
+static int pkt_pid(const uint8_t *pkt) {
+    return ((pkt[1] & 0x1f) << 8) | pkt[2];
+}
+
+// Returns a pointer to the payload of a TS packet and its length
+static const uint8_t *pkt_payload(const uint8_t *pkt, int *len) {
+    int off = 4;
+    if (pkt[3] & 0x20) {
+        off += 1 + pkt[4];
+    }
+    *len = TS_PKT_SIZE - off;
+    return pkt + off;
+}
+
+// Fake H.264 access unit: start code + IDR slice NAL + filler
+static int make_h264_au(uint8_t *buf, int size, int idr) {
+    buf[0] = 0; buf[1] = 0; buf[2] = 0; buf[3] = 1;
+    buf[4] = idr ? 0x65 : 0x41;
+    for (int i = 5; i < size; i++) buf[i] = (uint8_t)(i * 7);
+    return size;
+}
+
+static void setup_mux(TsMux *mux, int *video, int *audio) {
+    memset(&cap, 0, sizeof(cap));
+    assert_int_equal(ts_mux_init(mux, SRT_PAYLOAD, capture_output, &cap), 0);
+    *video = ts_mux_add_stream(mux, TS_CODEC_H264);
+    *audio = ts_mux_add_stream(mux, TS_CODEC_AAC);
+    assert_int_equal(*video, 0);
+    assert_int_equal(*audio, 1);
+}
+
+/*
+ * Test: Output is a whole number of SRT payloads of valid TS packets
+ */
+static void test_ts_mux_payload_framing(void **state) {
+    (void) state;
+    TsMux mux;
+    int video, audio;
+    setup_mux(&mux, &video, &audio);
+
+    uint8_t au[5000];
+    for (int i = 0; i < 30; i++) {
+        int len = make_h264_au(au, 1000 + i * 97, i == 0);
+        assert_int_equal(ts_mux_write_frame(&mux, video, au, len, i * 3000, -1, i == 0), 0);
+        assert_int_equal(ts_mux_write_frame(&mux, audio, au, 300, i * 3000, -1, 0), 0);
+    }
+
+    // Only full payloads were sent
+    assert_true(cap.calls > 0);
+    assert_int_equal(cap.len % SRT_PAYLOAD, 0);
+    for (int off = 0; off < cap.len; off += TS_PKT_SIZE) {
+        assert_int_equal(cap.data[off], 0x47);
+    }
+
+    // Flush sends the partial payload
+    int before = cap.len;
+    assert_int_equal(ts_mux_flush(&mux), 0);
+    assert_int_equal(cap.len % TS_PKT_SIZE, 0);
+    assert_true(cap.len >= before);
+
+    ts_mux_cleanup(&mux);
+}
+
+/*
+ * Test: PAT and PMT come first and carry valid CRCs
+ */
+static void test_ts_mux_psi(void **state) {
+    (void) state;
+    TsMux mux;
+    int video, audio;
+    setup_mux(&mux, &video, &audio);
+
+    uint8_t au[500];
+    int len = make_h264_au(au, sizeof(au), 1);
+    assert_int_equal(ts_mux_write_frame(&mux, video, au, len, 0, -1, 1), 0);
+    assert_int_equal(ts_mux_flush(&mux), 0);
+
+    const uint8_t *pat = cap.data;
+    const uint8_t *pmt = cap.data + TS_PKT_SIZE;
+    assert_int_equal(pkt_pid(pat), 0);
+    assert_int_equal(pkt_pid(pmt), TS_MUX_PMT_PID);
+
+    // Section CRC: running the CRC over section + CRC yields zero
+    for (int t = 0; t < 2; t++) {
+        const uint8_t *sec = (t == 0 ? pat : pmt) + 5;
+        int sec_len = 3 + (((sec[1] & 0x0f) << 8) | sec[2]);
+        uint32_t crc = 0xffffffff;
+        for (int i = 0; i < sec_len; i++) {
+            crc ^= (uint32_t)sec[i] << 24;
+            for (int b = 0; b < 8; b++) {
+                crc = (crc & 0x80000000) ? (crc << 1) ^ 0x04c11db7 : (crc << 1);
+            }
+        }
+        assert_int_equal(crc, 0);
+    }
+
+    // PMT: PCR on the video PID, H.264 + AAC streams
+    const uint8_t *sec = pmt + 5;
+    int pcr_pid = ((sec[8] & 0x1f) << 8) | sec[9];
+    assert_int_equal(pcr_pid, TS_MUX_FIRST_ES_PID);
+    assert_int_equal(sec[12], 0x1b);
+    assert_int_equal(sec[17], 0x0f);
+
+    ts_mux_cleanup(&mux);
+}
+
+/*
+ * Test: Continuity counters increment per PID and the PES reassembles
+ */
+static void test_ts_mux_pes_reassembly(void **state) {
+    (void) state;
+    TsMux mux;
+    int video, audio;
+    setup_mux(&mux, &video, &audio);
+
+    uint8_t au[4000];
+    int len = make_h264_au(au, sizeof(au), 1);
+    assert_int_equal(ts_mux_write_frame(&mux, video, au, len, 9000, 6000, 1), 0);
+    assert_int_equal(ts_mux_flush(&mux), 0);
+
+    uint8_t pes[8000];
+    int pes_len = 0;
+    int expected_cc = -1;
+    int pcr_seen = 0;
+
+    for (int off = 0; off < cap.len; off += TS_PKT_SIZE) {
+        const uint8_t *pkt = cap.data + off;
+        if (pkt_pid(pkt) != TS_MUX_FIRST_ES_PID) continue;
+
+        int cc = pkt[3] & 0x0f;
+        if (expected_cc >= 0) {
+            assert_int_equal(cc, expected_cc);
+        }
+        expected_cc = (cc + 1) & 0x0f;
+
+        if (pkt[1] & 0x40) {
+            // First packet: random access + PCR
+            assert_true(pkt[3] & 0x20);
+            assert_true(pkt[5] & 0x40);
+            assert_true(pkt[5] & 0x10);
+            pcr_seen = 1;
+        }
+
+        int plen;
+        const uint8_t *payload = pkt_payload(pkt, &plen);
+        memcpy(pes + pes_len, payload, plen);
+        pes_len += plen;
+    }
+    assert_true(pcr_seen);
+
+    // PES start code, PTS + DTS flags
+    assert_int_equal(pes[0], 0x00);
+    assert_int_equal(pes[1], 0x00);
+    assert_int_equal(pes[2], 0x01);
+    assert_int_equal(pes[3], 0xe0);
+    assert_int_equal(pes[7], 0xc0);
+
+    // Payload: AUD inserted ahead of the access unit
+    int hdr_len = 9 + pes[8];
+    assert_int_equal(pes[hdr_len + 4], 0x09);
+    assert_int_equal(pes_len - hdr_len, len + 6);
+    assert_memory_equal(pes + hdr_len + 6, au, len);
+
+    assert_int_equal(mux.streams[video].frames, 1);
+    assert_int_equal(mux.streams[video].keyframes, 1);
+    assert_int_equal(mux.streams[video].bytes, len);
+
+    ts_mux_cleanup(&mux);
+}
+
+/*
+ * Test: Audio-only streams get PAT/PMT at the PSI interval, not before every
+ * frame, and no random access indicator although all frames are keyframes
+ */
+static void test_ts_mux_audio_only(void **state) {
+    (void) state;
+    TsMux mux;
+    memset(&cap, 0, sizeof(cap));
+    assert_int_equal(ts_mux_init(&mux, SRT_PAYLOAD, capture_output, &cap), 0);
+    int audio = ts_mux_add_stream(&mux, TS_CODEC_AAC);
+
+    // 50 AAC frames (1024 samples at 48 kHz), ~1 s
+    uint8_t au[300];
+    memset(au, 0x5a, sizeof(au));
+    for (int i = 0; i < 50; i++) {
+        assert_int_equal(ts_mux_write_frame(&mux, audio, au, sizeof(au), i * 1920, -1, 1), 0);
+    }
+    assert_int_equal(ts_mux_flush(&mux), 0);
+
+    int pats = 0;
+    for (int off = 0; off < cap.len; off += TS_PKT_SIZE) {
+        const uint8_t *pkt = cap.data + off;
+        if (pkt_pid(pkt) == 0) pats++;
+        if (pkt_pid(pkt) == mux.streams[audio].pid && (pkt[3] & 0x20) && pkt[4] > 0) {
+            assert_int_equal(pkt[5] & 0x40, 0);
+        }
+    }
+    assert_true(pats >= 10 && pats <= 12);  // 50 * 1920 / TS_MUX_PSI_INTERVAL + 1
+    assert_int_equal(mux.streams[audio].keyframes, 0);
+
+    ts_mux_cleanup(&mux);
+}
+
+/*
+ * Test: The Opus control header carries the size of frames over 3.3 KB
+ */
+static void test_ts_mux_opus_large_frame(void **state) {
+    (void) state;
+    TsMux mux;
+    memset(&cap, 0, sizeof(cap));
+    assert_int_equal(ts_mux_init(&mux, SRT_PAYLOAD, capture_output, &cap), 0);
+    int audio = ts_mux_add_stream(&mux, TS_CODEC_OPUS);
+
+    uint8_t au[4000];
+    for (int i = 0; i < (int)sizeof(au); i++) au[i] = (uint8_t)(i * 13);
+    assert_int_equal(ts_mux_write_frame(&mux, audio, au, sizeof(au), 0, -1, 1), 0);
+    assert_int_equal(ts_mux_flush(&mux), 0);
+
+    uint8_t pes[8000];
+    int pes_len = 0;
+    for (int off = 0; off < cap.len; off += TS_PKT_SIZE) {
+        const uint8_t *pkt = cap.data + off;
+        if (pkt_pid(pkt) != mux.streams[audio].pid) continue;
+        int plen;
+        const uint8_t *payload = pkt_payload(pkt, &plen);
+        memcpy(pes + pes_len, payload, plen);
+        pes_len += plen;
+    }
+
+    // 0x7f 0xe0, then 4000 = 15 * 255 + 175
+    int hdr_len = 9 + pes[8];
+    const uint8_t *ctrl = pes + hdr_len;
+    assert_int_equal(ctrl[0], 0x7f);
+    assert_int_equal(ctrl[1], 0xe0);
+    for (int i = 0; i < 15; i++) assert_int_equal(ctrl[2 + i], 0xff);
+    assert_int_equal(ctrl[17], 175);
+    assert_int_equal(pes_len - hdr_len, 18 + (int)sizeof(au));
+    assert_memory_equal(ctrl + 18, au, sizeof(au));
+
+    ts_mux_cleanup(&mux);
+}
+
+/*
+ * Test: Output callback failures are reported
+ */
+static void test_ts_mux_output_error(void **state) {
+    (void) state;
+    TsMux mux;
+    int video, audio;
+    setup_mux(&mux, &video, &audio);
+
+    // Nearly fill the capture buffer so the next payload fails
+    cap.len = CAPTURE_SIZE - TS_PKT_SIZE;
+
+    uint8_t au[3000];
+    int len = make_h264_au(au, sizeof(au), 1);
+    assert_int_equal(ts_mux_write_frame(&mux, video, au, len, 0, -1, 1), -1);
+
+    ts_mux_cleanup(&mux);
+}
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_ts_mux_payload_framing),
+        cmocka_unit_test(test_ts_mux_psi),
+        cmocka_unit_test(test_ts_mux_pes_reassembly),
+        cmocka_unit_test(test_ts_mux_audio_only),
+        cmocka_unit_test(test_ts_mux_opus_large_frame),
+        cmocka_unit_test(test_ts_mux_output_error),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,148 @@
+/*
+    ceracoder - live video encoder with dynamic bitrate control
+    Copyright (C) 2020 BELABOX project
+    Copyright (C) 2026 CERALIVE
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * UDP impairment proxy for manual testing (make udp_impair)
+ *
+ * Put it between ceracoder and an SRT listener on the same host:
+ *
+ *   srt-live-transmit srt://:4000 udp://:5000 &
+ *   ./tests/udp_impair -l 4001 -t 4000 -r 3000 -d 30 -j 10 -G 0.01,0.3,0,0.5 &
+ *   ./ceracoder pipeline/generic/x264_superfast_camlink 127.0.0.1 4001
+ *
+ * Prints the per direction counters every second.
+ */
+
+#include <getopt.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "udp_proxy.h"
+
+static volatile sig_atomic_t quit = 0;
+
+static void on_signal(int sig) {
+    (void)sig;
+    quit = 1;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "Usage: %s -l <listen port> -t <target port> [options]\n\n"
+            "Forward (sender -> target) impairment:\n"
+            "  -r <kbps>        Bottleneck rate (default: unlimited)\n"
+            "  -T <file>        Rate trace, \"<duration_ms> <rate_kbps>\" per line, repeats\n"
+            "  -q <ms>          Bottleneck queue limit (default: 200)\n"
+            "  -d <ms>          One-way delay\n"
+            "  -j <ms>          Jitter (uniform, 0 to <ms>)\n"
+            "  -p <prob>        Bernoulli loss probability\n"
+            "  -G <p_bad>,<p_good>,<loss_good>,<loss_bad>\n"
+            "                   Gilbert-Elliott loss\n"
+            "  -o <prob>,<ms>   Reorder: hold back packets with <prob> for <ms>\n"
+            "  -s <seed>        Random seed (default: 1)\n\n"
+            "Reverse (target -> sender) impairment:\n"
+            "  -D <ms>          One-way delay (default: same as -d)\n"
+            "  -P <prob>        Bernoulli loss probability\n",
+            prog);
+}
+
+static void print_counters(UdpProxy *proxy) {
+    static const char *names[UDP_PROXY_DIRECTIONS] = {"forward", "reverse"};
+    for (int dir = 0; dir < UDP_PROXY_DIRECTIONS; dir++) {
+        Impair im;
+        udp_proxy_get_counters(proxy, dir, &im);
+        fprintf(stderr, "%s: %llu pkts, %llu KB, lost %llu, queue drops %llu, reordered %llu\n",
+                names[dir], (unsigned long long)im.packets,
+                (unsigned long long)(im.bytes / 1000), (unsigned long long)im.lost,
+                (unsigned long long)im.queue_drops, (unsigned long long)im.reordered);
+    }
+}
+
+int main(int argc, char **argv) {
+    UdpProxyConfig cfg;
+    memset(&cfg, 0, sizeof(cfg));
+    ImpairConfig *fwd = &cfg.impair[UDP_PROXY_FORWARD];
+    ImpairConfig *rev = &cfg.impair[UDP_PROXY_REVERSE];
+    impair_config_init(fwd);
+    impair_config_init(rev);
+    int rev_delay = -1;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "l:t:r:T:q:d:j:p:G:o:s:D:P:h")) != -1) {
+        switch (opt) {
+        case 'l': cfg.listen_port = atoi(optarg); break;
+        case 't': cfg.target_port = atoi(optarg); break;
+        case 'r': fwd->rate_kbps = atoi(optarg); break;
+        case 'T':
+            if (impair_load_trace(fwd, optarg) != 0) {
+                fprintf(stderr, "Failed to load the rate trace %s\n", optarg);
+                return EXIT_FAILURE;
+            }
+            break;
+        case 'q': fwd->queue_ms = atoi(optarg); break;
+        case 'd': fwd->delay_ms = atoi(optarg); break;
+        case 'j': fwd->jitter_ms = atoi(optarg); break;
+        case 'p': fwd->loss = atof(optarg); break;
+        case 'G':
+            if (sscanf(optarg, "%lf,%lf,%lf,%lf", &fwd->ge_p_bad, &fwd->ge_p_good,
+                       &fwd->ge_loss_good, &fwd->ge_loss_bad) != 4) {
+                usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            break;
+        case 'o':
+            if (sscanf(optarg, "%lf,%d", &fwd->reorder, &fwd->reorder_ms) != 2) {
+                usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            break;
+        case 's': fwd->seed = (uint32_t)strtoul(optarg, NULL, 10); break;
+        case 'D': rev_delay = atoi(optarg); break;
+        case 'P': rev->loss = atof(optarg); break;
+        default:
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (cfg.listen_port <= 0 || cfg.target_port <= 0) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    rev->delay_ms = rev_delay >= 0 ? rev_delay : fwd->delay_ms;
+    rev->seed = fwd->seed + 1;
+
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+
+    UdpProxy proxy;
+    if (udp_proxy_start(&proxy, &cfg) != 0) return EXIT_FAILURE;
+    fprintf(stderr, "Relaying 127.0.0.1:%d -> 127.0.0.1:%d\n", cfg.listen_port, cfg.target_port);
+
+    while (!quit) {
+        sleep(1);
+        print_counters(&proxy);
+    }
+
+    udp_proxy_stop(&proxy);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,242 @@
+/*
+    ceracoder - live video encoder with dynamic bitrate control
+    Copyright (C) 2020 BELABOX project
+    Copyright (C) 2026 CERALIVE
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "udp_proxy.h"
+#include <arpa/inet.h>
+#include <errno.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+static int64_t now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static int pkt_before(const UdpProxyPacket *a, const UdpProxyPacket *b) {
+    if (a->deliver_us != b->deliver_us) return a->deliver_us < b->deliver_us;
+    return a->seq < b->seq;
+}
+
+static void heap_push(UdpProxy *proxy, UdpProxyPacket *pkt) {
+    int i = proxy->n_queued++;
+    proxy->heap[i] = pkt;
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (!pkt_before(proxy->heap[i], proxy->heap[parent])) break;
+        UdpProxyPacket *tmp = proxy->heap[i];
+        proxy->heap[i] = proxy->heap[parent];
+        proxy->heap[parent] = tmp;
+        i = parent;
+    }
+}
+
+static UdpProxyPacket *heap_pop(UdpProxy *proxy) {
+    UdpProxyPacket *top = proxy->heap[0];
+    proxy->heap[0] = proxy->heap[--proxy->n_queued];
+
+    int i = 0;
+    for (;;) {
+        int min = i;
+        int left = 2 * i + 1;
+        int right = left + 1;
+        if (left < proxy->n_queued && pkt_before(proxy->heap[left], proxy->heap[min])) min = left;
+        if (right < proxy->n_queued && pkt_before(proxy->heap[right], proxy->heap[min])) min = right;
+        if (min == i) break;
+        UdpProxyPacket *tmp = proxy->heap[i];
+        proxy->heap[i] = proxy->heap[min];
+        proxy->heap[min] = tmp;
+        i = min;
+    }
+    return top;
+}
+
+static int bind_loopback(int port) {
+    int sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sock < 0) return -1;
+
+    int bufsz = 4 * 1024 * 1024;
+    setsockopt(sock, SOL_SOCKET, SO_RCVBUF, &bufsz, sizeof(bufsz));
+    setsockopt(sock, SOL_SOCKET, SO_SNDBUF, &bufsz, sizeof(bufsz));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+    if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        close(sock);
+        return -1;
+    }
+    return sock;
+}
+
+// Reads one datagram from sock and queues it for its delivery time
+static void receive(UdpProxy *proxy, int sock, UdpProxyDirection dir) {
+    uint8_t buf[UDP_PROXY_MAX_PKT];
+    struct sockaddr_in from;
+    socklen_t fromlen = sizeof(from);
+    ssize_t len = recvfrom(sock, buf, sizeof(buf), MSG_DONTWAIT,
+                           (struct sockaddr *)&from, &fromlen);
+    if (len <= 0) return;
+
+    if (dir == UDP_PROXY_FORWARD && !proxy->have_peer) {
+        proxy->peer = from;
+        proxy->have_peer = 1;
+    }
+
+    pthread_mutex_lock(&proxy->lock);
+    int64_t deliver_us = impair_packet(&proxy->impair[dir], now_us(), (int)len);
+    pthread_mutex_unlock(&proxy->lock);
+    if (deliver_us < 0) return;
+
+    if (proxy->n_free == 0) {
+        proxy->overflows++;
+        return;
+    }
+    UdpProxyPacket *pkt = proxy->free_pkts[--proxy->n_free];
+    pkt->deliver_us = deliver_us;
+    pkt->seq = proxy->next_seq++;
+    pkt->dir = dir;
+    pkt->len = (int)len;
+    memcpy(pkt->data, buf, len);
+    heap_push(proxy, pkt);
+}
+
+// Sends the packets that are due, returns the time until the next one (ms, -1 if none)
+static int deliver(UdpProxy *proxy) {
+    int64_t now = now_us();
+    while (proxy->n_queued > 0 && proxy->heap[0]->deliver_us <= now) {
+        UdpProxyPacket *pkt = heap_pop(proxy);
+        if (pkt->dir == UDP_PROXY_FORWARD) {
+            send(proxy->sock_target, pkt->data, pkt->len, MSG_DONTWAIT);
+        } else if (proxy->have_peer) {
+            sendto(proxy->sock_listen, pkt->data, pkt->len, MSG_DONTWAIT,
+                   (struct sockaddr *)&proxy->peer, sizeof(proxy->peer));
+        }
+        proxy->free_pkts[proxy->n_free++] = pkt;
+    }
+
+    if (proxy->n_queued == 0) return -1;
+    int64_t wait_us = proxy->heap[0]->deliver_us - now;
+    return (int)((wait_us + 999) / 1000);
+}
+
+static void *proxy_thread(void *arg) {
+    UdpProxy *proxy = (UdpProxy *)arg;
+    struct pollfd fds[2] = {
+        { .fd = proxy->sock_listen, .events = POLLIN },
+        { .fd = proxy->sock_target, .events = POLLIN },
+    };
+
+    while (proxy->running) {
+        int timeout = deliver(proxy);
+        if (timeout < 0 || timeout > 100) timeout = 100;    // Check running
+
+        if (poll(fds, 2, timeout) < 0 && errno != EINTR) break;
+        if (fds[0].revents & POLLIN) receive(proxy, proxy->sock_listen, UDP_PROXY_FORWARD);
+        if (fds[1].revents & POLLIN) receive(proxy, proxy->sock_target, UDP_PROXY_REVERSE);
+    }
+
+    return NULL;
+}
+
+int udp_proxy_start(UdpProxy *proxy, const UdpProxyConfig *cfg) {
+    memset(proxy, 0, sizeof(*proxy));
+    proxy->cfg = *cfg;
+    proxy->sock_target = -1;
+
+    proxy->sock_listen = bind_loopback(cfg->listen_port);
+    if (proxy->sock_listen < 0) {
+        fprintf(stderr, "udp_proxy: failed to bind port %d: %s\n",
+                cfg->listen_port, strerror(errno));
+        return -1;
+    }
+
+    proxy->sock_target = bind_loopback(0);
+    struct sockaddr_in target;
+    memset(&target, 0, sizeof(target));
+    target.sin_family = AF_INET;
+    target.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    target.sin_port = htons(cfg->target_port);
+    if (proxy->sock_target < 0 ||
+        connect(proxy->sock_target, (struct sockaddr *)&target, sizeof(target)) != 0) {
+        fprintf(stderr, "udp_proxy: failed to connect to port %d\n", cfg->target_port);
+        udp_proxy_stop(proxy);
+        return -1;
+    }
+
+    for (int dir = 0; dir < UDP_PROXY_DIRECTIONS; dir++) {
+        impair_init(&proxy->impair[dir], &cfg->impair[dir]);
+    }
+
+    proxy->pool = calloc(UDP_PROXY_MAX_QUEUED, sizeof(UdpProxyPacket));
+    proxy->free_pkts = calloc(UDP_PROXY_MAX_QUEUED, sizeof(UdpProxyPacket *));
+    proxy->heap = calloc(UDP_PROXY_MAX_QUEUED, sizeof(UdpProxyPacket *));
+    if (!proxy->pool || !proxy->free_pkts || !proxy->heap) {
+        udp_proxy_stop(proxy);
+        return -1;
+    }
+    for (int i = 0; i < UDP_PROXY_MAX_QUEUED; i++) {
+        proxy->free_pkts[i] = &proxy->pool[i];
+    }
+    proxy->n_free = UDP_PROXY_MAX_QUEUED;
+
+    pthread_mutex_init(&proxy->lock, NULL);
+    proxy->running = 1;
+    if (pthread_create(&proxy->thread, NULL, proxy_thread, proxy) != 0) {
+        proxy->running = 0;
+        pthread_mutex_destroy(&proxy->lock);
+        udp_proxy_stop(proxy);
+        return -1;
+    }
+
+    return 0;
+}
+
+void udp_proxy_get_counters(UdpProxy *proxy, UdpProxyDirection dir, Impair *out) {
+    pthread_mutex_lock(&proxy->lock);
+    *out = proxy->impair[dir];
+    pthread_mutex_unlock(&proxy->lock);
+}
+
+void udp_proxy_stop(UdpProxy *proxy) {
+    if (proxy->running) {
+        proxy->running = 0;
+        pthread_join(proxy->thread, NULL);
+        pthread_mutex_destroy(&proxy->lock);
+    }
+
+    if (proxy->sock_listen >= 0) close(proxy->sock_listen);
+    if (proxy->sock_target >= 0) close(proxy->sock_target);
+    proxy->sock_listen = -1;
+    proxy->sock_target = -1;
+
+    free(proxy->pool);
+    free(proxy->free_pkts);
+    free(proxy->heap);
+    proxy->pool = NULL;
+    proxy->free_pkts = NULL;
+    proxy->heap = NULL;
+}
@@ -0,0 +1,100 @@
+/*
+    ceracoder - live video encoder with dynamic bitrate control
+    Copyright (C) 2020 BELABOX project
+    Copyright (C) 2026 CERALIVE
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef UDP_PROXY_H
+#define UDP_PROXY_H
+
+#include <pthread.h>
+#include <netinet/in.h>
+#include "impair.h"
+
+/*
+ * UDP impairment proxy - relays one UDP flow on the loopback through the
+ * impairment model, in user space (no root, no netem)
+ *
+ * The sender (e.g. ceracoder or srt_client) connects to 127.0.0.1:listen_port;
+ * its datagrams are forwarded to 127.0.0.1:target_port (e.g. an SRT listener)
+ * through the forward impairment, and the replies (SRT ACKs, NAKs) go back
+ * through the reverse impairment. The first sender address seen is the peer.
+ */
+
+#define UDP_PROXY_MAX_PKT       1500
+#define UDP_PROXY_MAX_QUEUED    8192    // Packets in flight in both directions
+
+typedef enum {
+    UDP_PROXY_FORWARD,      // Sender -> target
+    UDP_PROXY_REVERSE,      // Target -> sender
+    UDP_PROXY_DIRECTIONS
+} UdpProxyDirection;
+
+typedef struct {
+    int listen_port;
+    int target_port;
+    ImpairConfig impair[UDP_PROXY_DIRECTIONS];
+} UdpProxyConfig;
+
+typedef struct {
+    int64_t deliver_us;
+    uint64_t seq;           // Keeps packets due at the same time in order
+    UdpProxyDirection dir;
+    int len;
+    uint8_t data[UDP_PROXY_MAX_PKT];
+} UdpProxyPacket;
+
+typedef struct {
+    UdpProxyConfig cfg;
+    int sock_listen;        // Bound to listen_port, faces the sender
+    int sock_target;        // Connected to target_port
+    struct sockaddr_in peer;
+    int have_peer;
+
+    pthread_mutex_t lock;   // Guards impair, read by udp_proxy_get_counters()
+    Impair impair[UDP_PROXY_DIRECTIONS];
+
+    // Packets waiting for their delivery time, owned by the proxy thread
+    UdpProxyPacket *pool;
+    UdpProxyPacket **free_pkts;
+    int n_free;
+    UdpProxyPacket **heap;  // Min-heap on (deliver_us, seq)
+    int n_queued;
+    uint64_t next_seq;
+    uint64_t overflows;     // Dropped because the proxy queue was full
+
+    pthread_t thread;
+    volatile int running;
+} UdpProxy;
+
+/*
+ * Bind the sockets and start relaying on a background thread
+ *
+ * Returns 0 on success, -1 on error.
+ */
+int udp_proxy_start(UdpProxy *proxy, const UdpProxyConfig *cfg);
+
+/*
+ * Copy the impairment counters of one direction
+ */
+void udp_proxy_get_counters(UdpProxy *proxy, UdpProxyDirection dir, Impair *out);
+
+/*
+ * Stop relaying and close the sockets
+ */
+void udp_proxy_stop(UdpProxy *proxy);
+
+#endif /* UDP_PROXY_H */
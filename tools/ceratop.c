@@ -0,0 +1,363 @@
+/*
+    ceracoder - live video encoder with dynamic bitrate control
+    Copyright (C) 2020 BELABOX project
+    Copyright (C) 2026 CERALIVE
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * ceratop - live terminal view of a running ceracoder (make ceratop)
+ *
+ * Maps the live stats feed (see src/io/live_stats.h) read-only and redraws
+ * at up to 50 Hz: the balancer target against the encoder setting, the
+ * measured encoder output and the SRT send rate, the RTT and send buffer
+ * against the balancer thresholds, loss / retransmissions and the mux
+ * latency. ceracoder never waits for it, so it can be started, stopped and
+ * restarted at any time.
+ *
+ *   ./ceratop [-f /dev/shm/ceracoder.live] [-r 20]
+ */
+
+#include <errno.h>
+#include <getopt.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "balancer.h"
+#include "live_stats.h"
+
+#define CERATOP_DEF_RATE    10      // Hz
+#define CERATOP_MAX_RATE    50
+#define CERATOP_HISTORY     512     // Sparkline columns kept
+#define CERATOP_LABEL_W     30      // Label and value, before the sparkline
+#define CERATOP_OUT_SZ      65536
+
+typedef enum {
+    SERIES_TARGET = 0,
+    SERIES_ENCODER,
+    SERIES_OUTPUT,
+    SERIES_SEND,
+    SERIES_RTT,
+    SERIES_BS,
+    SERIES_LOSS,
+    SERIES_MUX,
+    SERIES_COUNT
+} Series;
+
+// One value per series and refresh, the mean over the samples read
+typedef struct {
+    double v[SERIES_COUNT][CERATOP_HISTORY];
+    int n;                  // Columns filled
+    int pos;                // Next column
+} History;
+
+typedef struct {
+    char buf[CERATOP_OUT_SZ];
+    size_t len;
+} Screen;
+
+static volatile sig_atomic_t quit = 0;
+static int ascii = 0;
+
+static void on_signal(int sig) {
+    (void)sig;
+    quit = 1;
+}
+
+static uint64_t now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static int process_alive(int pid) {
+    return kill(pid, 0) == 0 || errno != ESRCH;
+}
+
+static int term_width(void) {
+    struct winsize ws;
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == 0 && ws.ws_col > 0) return ws.ws_col;
+    return 80;
+}
+
+static void out(Screen *scr, const char *fmt, ...) {
+    if (scr->len >= sizeof(scr->buf)) return;
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(scr->buf + scr->len, sizeof(scr->buf) - scr->len, fmt, ap);
+    va_end(ap);
+    if (n > 0) scr->len += (size_t)n;
+    if (scr->len > sizeof(scr->buf)) scr->len = sizeof(scr->buf);
+}
+
+// End the current line, clearing what was left of the previous frame
+static void out_eol(Screen *scr) {
+    out(scr, "\033[K\n");
+}
+
+static void history_push(History *h, const double *values) {
+    for (int s = 0; s < SERIES_COUNT; s++) h->v[s][h->pos] = values[s];
+    h->pos = (h->pos + 1) % CERATOP_HISTORY;
+    if (h->n < CERATOP_HISTORY) h->n++;
+}
+
+static double history_max(const History *h, Series s, int cols) {
+    double max = 0;
+    for (int i = 0; i < cols && i < h->n; i++) {
+        double v = h->v[s][(h->pos - 1 - i + CERATOP_HISTORY) % CERATOP_HISTORY];
+        if (v > max) max = v;
+    }
+    return max;
+}
+
+// Latest values at the right, scaled to 0 - scale
+static void out_sparkline(Screen *scr, const History *h, Series s, int cols, double scale) {
+    static const char *blocks[] = {" ", "▁", "▂", "▃", "▄", "▅", "▆", "▇", "█"};
+    static const char levels[] = " .:-=+*#%@";
+    int n_levels = ascii ? (int)sizeof(levels) - 2 : 8;
+
+    int shown = h->n < cols ? h->n : cols;
+    for (int i = shown; i < cols; i++) out(scr, " ");
+    for (int i = shown - 1; i >= 0; i--) {
+        double v = h->v[s][(h->pos - 1 - i + CERATOP_HISTORY) % CERATOP_HISTORY];
+        int level = 0;
+        if (scale > 0 && v > 0) {
+            level = (int)(v / scale * n_levels + 0.5);
+            if (level < 1) level = 1;
+            if (level > n_levels) level = n_levels;
+        }
+        if (ascii) {
+            out(scr, "%c", levels[level]);
+        } else {
+            out(scr, "%s", blocks[level]);
+        }
+    }
+}
+
+static void out_row(Screen *scr, const History *h, Series s, int cols, double scale,
+                    const char *fmt, ...) {
+    char label[128];
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(label, sizeof(label), fmt, ap);
+    va_end(ap);
+
+    out(scr, "%-*.*s", CERATOP_LABEL_W, CERATOP_LABEL_W, label);
+    if (cols > 0) out_sparkline(scr, h, s, cols, scale);
+    out_eol(scr);
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "Usage: %s [options]\n\n"
+            "  -f <path>    Live stats feed (default: %s)\n"
+            "  -r <hz>      Refresh rate, 1 - %d (default: %d)\n"
+            "  -a           ASCII sparklines\n",
+            prog, LIVE_STATS_DEF_PATH, CERATOP_MAX_RATE, CERATOP_DEF_RATE);
+}
+
+int main(int argc, char **argv) {
+    const char *path = LIVE_STATS_DEF_PATH;
+    int rate = CERATOP_DEF_RATE;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "f:r:ah")) != -1) {
+        switch (opt) {
+        case 'f': path = optarg; break;
+        case 'r': rate = atoi(optarg); break;
+        case 'a': ascii = 1; break;
+        default:
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (rate < 1 || rate > CERATOP_MAX_RATE) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+
+    static History hist;
+    static Screen scr;
+    LiveStats ls = {0};
+    LiveStatsSample last = {0};
+    uint64_t last_seq = 0;
+    uint64_t prev_loss_ts = 0;
+    int64_t prev_loss = -1, prev_retrans = -1;
+    double loss_rate = 0, retrans_rate = 0;
+    int exited = 0;
+
+    printf("\033[?25l\033[2J");     // Hide the cursor, clear
+    while (!quit) {
+        uint64_t ctime = now_ms();
+
+        // (Re)attach; a restarted ceracoder replaces the file
+        if (ls.shm != NULL && !process_alive(ls.shm->pid)) {
+            exited = 1;
+            LiveStats fresh;
+            if (live_stats_open(&fresh, path) == 0) {
+                if (process_alive(fresh.shm->pid)) {
+                    live_stats_close(&ls);
+                    ls = fresh;
+                    memset(&hist, 0, sizeof(hist));
+                    memset(&last, 0, sizeof(last));
+                    last_seq = 0;
+                    prev_loss = prev_retrans = -1;
+                    exited = 0;
+                } else {
+                    live_stats_close(&fresh);
+                }
+            }
+        }
+        if (ls.shm == NULL) live_stats_open(&ls, path);
+
+        scr.len = 0;
+        out(&scr, "\033[H");
+        if (ls.shm == NULL) {
+            out(&scr, "ceratop - waiting for ceracoder (%s)", path);
+            out_eol(&scr);
+            out(&scr, "\033[J");
+            fwrite(scr.buf, 1, scr.len, stdout);
+            fflush(stdout);
+            usleep(1000000 / rate);
+            continue;
+        }
+
+        // Average the samples published since the last refresh
+        uint64_t head = live_stats_head(&ls);
+        uint64_t first = last_seq + 1;
+        if (head >= LIVE_STATS_SLOTS && first < head - LIVE_STATS_SLOTS + 1) {
+            first = head - LIVE_STATS_SLOTS + 1;
+        }
+        double sum[SERIES_COUNT] = {0};
+        int n = 0;
+        for (uint64_t seq = first; seq <= head; seq++) {
+            LiveStatsSample s;
+            if (live_stats_read(&ls, seq, &s) != 0) continue;
+            sum[SERIES_TARGET] += s.target_bps;
+            sum[SERIES_ENCODER] += s.encoder_bps;
+            sum[SERIES_OUTPUT] += s.output_bps;
+            sum[SERIES_SEND] += s.send_bps;
+            sum[SERIES_RTT] += s.rtt_ms;
+            sum[SERIES_BS] += s.bs;
+            sum[SERIES_MUX] += s.mux_lag_ms > 0 ? s.mux_lag_ms : 0;
+            last = s;
+            n++;
+        }
+        last_seq = head;
+
+        if (n > 0) {
+            // Loss / retransmissions per second, over at least 500 ms
+            if (prev_loss < 0 || last.pkt_loss_total < prev_loss) {
+                prev_loss = last.pkt_loss_total;
+                prev_retrans = last.pkt_retrans_total;
+                prev_loss_ts = last.timestamp_ms;
+            } else if (last.timestamp_ms - prev_loss_ts >= 500) {
+                double secs = (last.timestamp_ms - prev_loss_ts) / 1000.0;
+                loss_rate = (last.pkt_loss_total - prev_loss) / secs;
+                retrans_rate = (last.pkt_retrans_total - prev_retrans) / secs;
+                prev_loss = last.pkt_loss_total;
+                prev_retrans = last.pkt_retrans_total;
+                prev_loss_ts = last.timestamp_ms;
+            }
+
+            for (int s = 0; s < SERIES_COUNT; s++) sum[s] /= n;
+            sum[SERIES_LOSS] = loss_rate;
+            history_push(&hist, sum);
+        }
+
+        int cols = term_width() - CERATOP_LABEL_W - 1;
+        if (cols > CERATOP_HISTORY) cols = CERATOP_HISTORY;
+
+        const char *status = "live";
+        char stale[32];
+        if (exited) {
+            status = "exited";
+        } else if (last_seq == 0) {
+            status = "starting";
+        } else if (ctime > last.timestamp_ms + 1000) {
+            snprintf(stale, sizeof(stale), "stale %.1f s", (ctime - last.timestamp_ms) / 1000.0);
+            status = stale;
+        }
+        out(&scr, "ceratop - pid %d, %s balancer, SRT latency %d ms [%s]",
+            ls.shm->pid, ls.shm->balancer, ls.shm->srt_latency, status);
+        out_eol(&scr);
+        out(&scr, "state: %s (%s), bounds %d - %d Kbps",
+            balancer_state_name((BalancerState)last.state),
+            balancer_reason_name((BalancerReason)last.reason),
+            last.min_bps / 1000, last.max_bps / 1000);
+        out_eol(&scr);
+        out_eol(&scr);
+
+        double br_scale = last.max_bps;
+        for (int s = SERIES_TARGET; s <= SERIES_SEND; s++) {
+            double max = history_max(&hist, (Series)s, cols);
+            if (max > br_scale) br_scale = max;
+        }
+        out_row(&scr, &hist, SERIES_TARGET, cols, br_scale,
+                "target   %6d Kbps", last.target_bps / 1000);
+        out_row(&scr, &hist, SERIES_ENCODER, cols, br_scale,
+                "encoder  %6d Kbps", last.encoder_bps / 1000);
+        out_row(&scr, &hist, SERIES_OUTPUT, cols, br_scale,
+                "output   %6d Kbps", last.output_bps / 1000);
+        out_row(&scr, &hist, SERIES_SEND, cols, br_scale,
+                "srt send %6d Kbps", last.send_bps / 1000);
+        out_eol(&scr);
+
+        double rtt_scale = history_max(&hist, SERIES_RTT, cols);
+        if (last.rtt_th_max_ms * 1.5 > rtt_scale) rtt_scale = last.rtt_th_max_ms * 1.5;
+        out_row(&scr, &hist, SERIES_RTT, cols, rtt_scale,
+                "rtt      %6.0f ms (%.0f-%.0f)",
+                last.rtt_ms, last.rtt_th_min_ms, last.rtt_th_max_ms);
+
+        double bs_scale = history_max(&hist, SERIES_BS, cols);
+        if (last.bs_th3 > bs_scale) bs_scale = last.bs_th3;
+        out_row(&scr, &hist, SERIES_BS, cols, bs_scale,
+                "sndbuf   %6d (%d/%d/%d)", last.bs, last.bs_th1, last.bs_th2, last.bs_th3);
+
+        out_row(&scr, &hist, SERIES_LOSS, cols, history_max(&hist, SERIES_LOSS, cols),
+                "loss     %6.1f/s rtx %.1f/s", loss_rate, retrans_rate);
+
+        if (last.mux_lag_ms >= 0) {
+            out_row(&scr, &hist, SERIES_MUX, cols, history_max(&hist, SERIES_MUX, cols),
+                    "mux lag  %6d ms", last.mux_lag_ms);
+            out(&scr, "mux delay %d ms", last.mux_delay_ms);
+            if (last.mux_latency_ms >= 0) out(&scr, ", latency %d ms", last.mux_latency_ms);
+        } else {
+            out(&scr, "mux      (not monitored)");
+        }
+        out_eol(&scr);
+        out(&scr, "\033[J");
+
+        fwrite(scr.buf, 1, scr.len, stdout);
+        fflush(stdout);
+
+        uint64_t spent = now_ms() - ctime;
+        uint64_t period = 1000 / rate;
+        if (spent < period) usleep((useconds_t)(period - spent) * 1000);
+    }
+
+    printf("\033[?25h\n");          // Restore the cursor
+    live_stats_close(&ls);
+    return EXIT_SUCCESS;
+}
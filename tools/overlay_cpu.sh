@@ -0,0 +1,73 @@
+#!/bin/sh
+#
+#    ceracoder - live video encoder with dynamic bitrate control
+#    Copyright (C) 2020 BELABOX project
+#    Copyright (C) 2026 CERALIVE
+#
+#    This program is free software: you can redistribute it and/or modify
+#    it under the terms of the GNU General Public License as published by
+#    the Free Software Foundation, either version 3 of the License, or
+#    (at your option) any later version.
+#
+#    This program is distributed in the hope that it will be useful,
+#    but WITHOUT ANY WARRANTY; without even the implied warranty of
+#    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#    GNU General Public License for more details.
+#
+#    You should have received a copy of the GNU General Public License
+#    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#
+# CPU cost of the stats overlay per template, on the device with its capture
+# hardware attached:
+#
+#   tools/overlay_cpu.sh [-t <seconds>] <pipeline file>...
+#
+# Streams each template to a local srt-live-transmit listener with -O off,
+# source and auto, and prints the CPU time used by ceracoder (user + system,
+# % of one core) over the same window after a 5 s warm-up.
+
+set -e
+
+DURATION=30
+WARMUP=5
+PORT=4999
+CERACODER=${CERACODER:-./ceracoder}
+
+if [ "$1" = "-t" ]; then
+    DURATION=$2
+    shift 2
+fi
+if [ $# -eq 0 ]; then
+    echo "Usage: $0 [-t <seconds>] <pipeline file>..." >&2
+    exit 1
+fi
+
+CLK_TCK=$(getconf CLK_TCK)
+
+# utime + stime of a process, in clock ticks
+cpu_ticks() {
+    awk '{ print $14 + $15 }' "/proc/$1/stat"
+}
+
+srt-live-transmit -q "srt://:$PORT?mode=listener" file://con >/dev/null &
+LISTENER=$!
+trap 'kill $LISTENER 2>/dev/null' EXIT
+sleep 1
+
+printf '%-48s %8s %8s %8s\n' "template" "off" "source" "auto"
+for pipeline in "$@"; do
+    printf '%-48s' "$(basename "$pipeline")"
+    for mode in off source auto; do
+        "$CERACODER" "$pipeline" 127.0.0.1 $PORT -O $mode 2>/dev/null &
+        pid=$!
+        sleep $WARMUP
+        start=$(cpu_ticks $pid)
+        sleep "$DURATION"
+        end=$(cpu_ticks $pid)
+        kill -INT $pid
+        wait $pid 2>/dev/null || true
+        printf ' %7s%%' "$(echo "$start $end" |
+            awk -v hz="$CLK_TCK" -v t="$DURATION" '{ printf "%.1f", ($2 - $1) * 100 / hz / t }')"
+    done
+    printf '\n'
+done